@@ -59,15 +59,33 @@ std::unique_ptr< BlackOilMultiphaseSystem > BlackOilMultiphaseSystem::build( con
 void BlackOilMultiphaseSystem::Update( double pressure,
                                        double temperature,
                                        std::vector< double > feed )
+{
+  m_stateIndicator = solve( pressure, temperature, feed ) ? State::SUCCESS : State::NOT_CONVERGED;
+}
+
+bool BlackOilMultiphaseSystem::BatchUpdate( std::size_t nCells,
+                                            double const * pressures,
+                                            double const * temperatures,
+                                            double const * feeds,
+                                            pvt::MultiphaseSystemBatchProperties const & outputs )
+{
+  auto solver = [this]( double pressure, double temperature, std::vector< double > const & feed )
+  {
+    return solve( pressure, temperature, feed );
+  };
+  return batchUpdate( nCells, pressures, temperatures, feeds, m_bofmsp, outputs, solver );
+}
+
+bool BlackOilMultiphaseSystem::solve( double pressure,
+                                      double temperature,
+                                      std::vector< double > const & feed )
 {
   // Temperature unused
   (void) temperature;
   m_bofmsp.setPressure( pressure );
   m_bofmsp.setFeed( feed );
 
-  const bool res = computeEquilibriumAndDerivativesNoTemperature( m_blackOilFlash, m_bofmsp );
-
-  m_stateIndicator = res ? State::SUCCESS : State::NOT_CONVERGED;
+  return computeEquilibriumAndSelectedDerivativesNoTemperature( m_blackOilFlash, m_bofmsp );
 }
 
 const pvt::MultiphaseSystemProperties & BlackOilMultiphaseSystem::getMultiphaseSystemProperties() const
@@ -39,10 +39,24 @@ public:
                double temperature,
                std::vector< double > feed ) override;
 
+  bool BatchUpdate( std::size_t nCells,
+                    double const * pressures,
+                    double const * temperatures,
+                    double const * feeds,
+                    pvt::MultiphaseSystemBatchProperties const & outputs ) override;
+
   const pvt::MultiphaseSystemProperties & getMultiphaseSystemProperties() const override;
 
 private:
 
+  /**
+   * @brief Solves the system for given @p pressure, @p temperature and @p feed.
+   * @return True in case of success.
+   */
+  bool solve( double pressure,
+              double temperature,
+              std::vector< double > const & feed );
+
   BlackOilMultiphaseSystem( const std::vector< pvt::PHASE_TYPE > & phases,
                             const std::vector< std::vector< double > > & PVTO,
                             double oilSurfaceMassDensity,
@@ -26,20 +26,35 @@ ComponentProperties::ComponentProperties( const std::size_t & nComponents,
                                           const std::vector< double > & tc,
                                           const std::vector< double > & pc,
                                           const std::vector< double > & omega )
+  : ComponentProperties( nComponents, labels, mw, tc, pc, omega, {}, {} )
+{
+
+}
+
+ComponentProperties::ComponentProperties( const std::size_t & nComponents,
+                                          const std::vector< std::string > & labels,
+                                          const std::vector< double > & mw,
+                                          const std::vector< double > & tc,
+                                          const std::vector< double > & pc,
+                                          const std::vector< double > & omega,
+                                          const std::vector< std::vector< double > > & bic,
+                                          const std::vector< std::vector< double > > & volumeShift )
   : NComponents( nComponents ),
     Label( labels ),
     Mw( mw ),
     Pc( pc ),
     Tc( tc ),
     Omega( omega ),
-    BIC( std::vector< std::vector< double > >( NComponents, std::vector< double >( NComponents, 0 ) ) ),
-    VolumeShift( std::vector< std::vector< double > >( NComponents, std::vector< double >( 2, 0 ) ) ),
+    BIC( bic.empty() ? std::vector< std::vector< double > >( NComponents, std::vector< double >( NComponents, 0 ) ) : bic ),
+    VolumeShift( volumeShift.empty() ? std::vector< std::vector< double > >( NComponents, std::vector< double >( 2, 0 ) ) : volumeShift ),
     WaterIndex( std::size_t( -1 ) ) // FIXME use a lambda and declare WaterIndex const.
 {
   ASSERT( ( nComponents == labels.size() ) && ( nComponents == mw.size() ) && ( nComponents == tc.size() )
           && ( nComponents == pc.size() ) && ( nComponents == omega.size() ), "Dimension Mismatch." );
+  ASSERT( BIC.size() == nComponents && VolumeShift.size() == nComponents, "Dimension Mismatch." );
   for( std::size_t i = 0; i != NComponents; ++i )
   {
+    ASSERT( BIC[i].size() == nComponents && VolumeShift[i].size() == 2, "Dimension Mismatch." );
     if( Label[i] == "Water" || Label[i] == "water" || Label[i] == "H2O" || Label[i] == "h2o" )
     {
       WaterIndex = i;
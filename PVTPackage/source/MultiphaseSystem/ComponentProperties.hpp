@@ -31,6 +31,21 @@ struct ComponentProperties
                        const std::vector< double > & pc,
                        const std::vector< double > & omega );
 
+  /**
+   * @brief Same as above, with binary interaction coefficients and volume shifts.
+   * @param bic The nComponents x nComponents binary interaction coefficients. Empty means no interaction.
+   * @param volumeShift The nComponents x 2 volume shifts, such that c_i(T) = volumeShift[i][0] + volumeShift[i][1] T.
+   * Empty means no shift.
+   */
+  ComponentProperties( const std::size_t & nComponents,
+                       const std::vector< std::string > & labels,
+                       const std::vector< double > & mw,
+                       const std::vector< double > & tc,
+                       const std::vector< double > & pc,
+                       const std::vector< double > & omega,
+                       const std::vector< std::vector< double > > & bic,
+                       const std::vector< std::vector< double > > & volumeShift );
+
   bool operator==( const ComponentProperties & d ) const;
 
   const unsigned long NComponents;
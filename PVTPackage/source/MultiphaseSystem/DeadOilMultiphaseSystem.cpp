@@ -72,15 +72,59 @@ DeadOilMultiphaseSystem::DeadOilMultiphaseSystem( const std::vector< pvt::PHASE_
 void DeadOilMultiphaseSystem::Update( double pressure,
                                       double temperature,
                                       std::vector< double > feed )
+{
+  m_stateIndicator = solve( pressure, temperature, feed ) ? State::SUCCESS : State::NOT_CONVERGED;
+}
+
+bool DeadOilMultiphaseSystem::BatchUpdate( std::size_t nCells,
+                                           double const * pressures,
+                                           double const * temperatures,
+                                           double const * feeds,
+                                           pvt::MultiphaseSystemBatchProperties const & outputs )
+{
+  if( m_derivativesType == pvt::DERIVATIVES_TYPE::ANALYTICAL )
+  {
+    return batchEvaluate( nCells, pressures, temperatures, feeds, outputs );
+  }
+
+  auto solver = [this]( double pressure, double temperature, std::vector< double > const & feed )
+  {
+    return solve( pressure, temperature, feed );
+  };
+  return batchUpdate( nCells, pressures, temperatures, feeds, m_dofmsp, outputs, solver );
+}
+
+bool DeadOilMultiphaseSystem::solve( double pressure,
+                                     double temperature,
+                                     std::vector< double > const & feed )
 {
   // Temperature unused
   (void) temperature;
   m_dofmsp.setPressure( pressure );
   m_dofmsp.setFeed( feed );
 
-  const bool result = computeEquilibriumAndDerivativesNoTemperature( m_deadOilFlash, m_dofmsp );
+  return computeEquilibriumAndSelectedDerivativesNoTemperature( m_deadOilFlash, m_dofmsp );
+}
+
+bool DeadOilMultiphaseSystem::batchEvaluate( std::size_t nCells,
+                                             double const * pressures,
+                                             double const * temperatures,
+                                             double const * feeds,
+                                             pvt::MultiphaseSystemBatchProperties const & outputs )
+{
+  bool const success = m_deadOilFlash.computeEquilibriaAndDerivatives( nCells, pressures, feeds, outputs );
+
+  // The batched flash only fills the outputs, while the system properties must hold the last cell after a batch update
+  // (see pvt::MultiphaseSystem::BatchUpdate). This single cell flash gives the same success as the batched one.
+  if( nCells > 0 )
+  {
+    std::size_t const nComponents = m_dofmsp.getNComponents();
+    std::vector< double > const lastFeed( feeds + ( nCells - 1 ) * nComponents, feeds + nCells * nComponents );
+    solve( pressures[nCells - 1], temperatures[nCells - 1], lastFeed );
+  }
+  m_stateIndicator = success ? State::SUCCESS : State::NOT_CONVERGED;
 
-  m_stateIndicator = result ? State::SUCCESS : State::NOT_CONVERGED;
+  return success;
 }
 
 const pvt::MultiphaseSystemProperties & DeadOilMultiphaseSystem::getMultiphaseSystemProperties() const
@@ -37,10 +37,36 @@ public:
 
   virtual void Update( double pressure, double temperature, std::vector< double > feed ) override;
 
+  bool BatchUpdate( std::size_t nCells,
+                    double const * pressures,
+                    double const * temperatures,
+                    double const * feeds,
+                    pvt::MultiphaseSystemBatchProperties const & outputs ) override;
+
   const pvt::MultiphaseSystemProperties & getMultiphaseSystemProperties() const override;
 
 private:
 
+  /**
+   * @brief Solves the system for given @p pressure, @p temperature and @p feed.
+   * @return True in case of success.
+   */
+  bool solve( double pressure,
+              double temperature,
+              std::vector< double > const & feed );
+
+  /**
+   * @brief Batch update with analytical derivatives, through the batched kernel of the flash.
+   * @return True in case of success.
+   *
+   * @note The results are the same as the ones of the cell by cell batch update.
+   */
+  bool batchEvaluate( std::size_t nCells,
+                      double const * pressures,
+                      double const * temperatures,
+                      double const * feeds,
+                      pvt::MultiphaseSystemBatchProperties const & outputs );
+
   /**
    * @brief Constructor for the three-phase Dead-Oil system
    */
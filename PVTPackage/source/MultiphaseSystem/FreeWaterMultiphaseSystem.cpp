@@ -24,13 +24,17 @@ std::unique_ptr< FreeWaterMultiphaseSystem > FreeWaterMultiphaseSystem::build( c
                                                                                const std::vector< double > & componentMolarWeights,
                                                                                const std::vector< double > & componentCriticalTemperatures,
                                                                                const std::vector< double > & componentCriticalPressures,
-                                                                               const std::vector< double > & componentOmegas )
+                                                                               const std::vector< double > & componentOmegas,
+                                                                               const std::vector< std::vector< double > > & componentBinaryInteractionCoefficients,
+                                                                               const std::vector< std::vector< double > > & componentVolumeShifts )
 {
   if( not areComponentDataConsistent( componentNames,
                                       componentMolarWeights,
                                       componentCriticalTemperatures,
                                       componentCriticalPressures,
-                                      componentOmegas ) )
+                                      componentOmegas,
+                                      componentBinaryInteractionCoefficients,
+                                      componentVolumeShifts ) )
   {
     return std::unique_ptr< FreeWaterMultiphaseSystem >();
   }
@@ -40,7 +44,9 @@ std::unique_ptr< FreeWaterMultiphaseSystem > FreeWaterMultiphaseSystem::build( c
                           componentMolarWeights,
                           componentCriticalTemperatures,
                           componentCriticalPressures,
-                          componentOmegas );
+                          componentOmegas,
+                          componentBinaryInteractionCoefficients,
+                          componentVolumeShifts );
 
   // I am not using std::make_unique because I want the constructor to be private.
   auto * ptr = new FreeWaterMultiphaseSystem( phases, eosTypes, cp );
@@ -62,17 +68,61 @@ const pvt::MultiphaseSystemProperties & FreeWaterMultiphaseSystem::getMultiphase
   return m_fwfmsp;
 }
 
+void FreeWaterMultiphaseSystem::setPrecisionType( pvt::PRECISION_TYPE const & precisionType )
+{
+  m_freeWaterFlash.setPrecisionType( precisionType );
+}
+
 void FreeWaterMultiphaseSystem::Update( double pressure,
                                         double temperature,
                                         std::vector< double > feed )
+{
+  m_stateIndicator = solve( pressure, temperature, feed ) ? State::SUCCESS : State::NOT_CONVERGED;
+}
+
+bool FreeWaterMultiphaseSystem::BatchUpdate( std::size_t nCells,
+                                             double const * pressures,
+                                             double const * temperatures,
+                                             double const * feeds,
+                                             pvt::MultiphaseSystemBatchProperties const & outputs )
+{
+  auto solver = [this]( double pressure, double temperature, std::vector< double > const & feed )
+  {
+    return solve( pressure, temperature, feed );
+  };
+  return batchUpdate( nCells, pressures, temperatures, feeds, m_fwfmsp, outputs, solver );
+}
+
+bool FreeWaterMultiphaseSystem::solve( double pressure,
+                                       double temperature,
+                                       std::vector< double > const & feed )
 {
   m_fwfmsp.setTemperature( temperature );
   m_fwfmsp.setPressure( pressure );
   m_fwfmsp.setFeed( feed );
+  transferInitialKValues( m_fwfmsp );
 
-  const bool result = computeEquilibriumAndDerivativesWithTemperature( m_freeWaterFlash, m_fwfmsp );
+  return computeEquilibriumAndDerivatives( m_freeWaterFlash, m_fwfmsp );
+}
 
-  m_stateIndicator = result ? State::SUCCESS : State::NOT_CONVERGED;
+void FreeWaterMultiphaseSystem::setSsiAccelerationType( pvt::SSI_ACCELERATION_TYPE const & accelerationType )
+{
+  m_freeWaterFlash.setSsiAccelerationType( accelerationType );
+}
+
+pvt::FlashStatistics const & FreeWaterMultiphaseSystem::getFlashStatistics() const
+{
+  return m_freeWaterFlash.getStatistics();
+}
+
+void FreeWaterMultiphaseSystem::resetFlashStatistics()
+{
+  m_freeWaterFlash.resetStatistics();
+}
+
+std::vector< double > const & FreeWaterMultiphaseSystem::getKValues() const
+{
+  return m_fwfmsp.getKValues();
 }
 
 }
@@ -36,16 +36,42 @@ public:
                                                              const std::vector< double > & componentMolarWeights,
                                                              const std::vector< double > & componentCriticalTemperatures,
                                                              const std::vector< double > & componentCriticalPressures,
-                                                             const std::vector< double > & componentOmegas );
+                                                             const std::vector< double > & componentOmegas,
+                                                             const std::vector< std::vector< double > > & componentBinaryInteractionCoefficients,
+                                                             const std::vector< std::vector< double > > & componentVolumeShifts );
 
   void Update( double pressure,
                double temperature,
                std::vector< double > feed ) override;
 
+  bool BatchUpdate( std::size_t nCells,
+                    double const * pressures,
+                    double const * temperatures,
+                    double const * feeds,
+                    pvt::MultiphaseSystemBatchProperties const & outputs ) override;
+
   const pvt::MultiphaseSystemProperties & getMultiphaseSystemProperties() const override;
 
+  void setPrecisionType( pvt::PRECISION_TYPE const & precisionType ) override;
+
+  void setSsiAccelerationType( pvt::SSI_ACCELERATION_TYPE const & accelerationType ) override;
+
+  pvt::FlashStatistics const & getFlashStatistics() const override;
+
+  void resetFlashStatistics() override;
+
+  std::vector< double > const & getKValues() const override;
+
 private:
 
+  /**
+   * @brief Solves the system for given @p pressure, @p temperature and @p feed.
+   * @return True in case of success.
+   */
+  bool solve( double pressure,
+              double temperature,
+              std::vector< double > const & feed );
+
   FreeWaterMultiphaseSystem( const std::vector< pvt::PHASE_TYPE > & phases,
                              const std::vector< pvt::EOS_TYPE > & eosTypes,
                              const ComponentProperties & componentProperties );
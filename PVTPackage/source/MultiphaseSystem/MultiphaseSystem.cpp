@@ -18,6 +18,7 @@
 #include "Utils/FileUtils.hpp"
 
 #include <algorithm>
+#include <cmath>
 
 namespace PVTPackage
 {
@@ -27,83 +28,121 @@ bool MultiphaseSystem::hasSucceeded() const
   return m_stateIndicator == State::SUCCESS;
 }
 
-struct FiniteDifferenceDerivatives
+void MultiphaseSystem::setDerivativesType( pvt::DERIVATIVES_TYPE const & derivativesType )
 {
-  double dPhaseMoleFraction;
-  double dMolecularWeight;
-  double dMoleDensity;
-  double dMassDensity;
-  double dViscosity;
-  std::vector< double > dMoleComposition;
-};
+  m_derivativesType = derivativesType;
+}
 
-/**
- * @brief Computes the derivatives through finite difference process
- * @param phase The phase for which we compute the finite difference
- * @param reference Reference solution.
- * @param variation Variation solution.
- * @param delta Finite difference step.
- * @return A structure holding the finite difference computed values.
- *
- * Generic functions (pure code factorisation) that evaluates the derivatives
- * through finite differences process between @p reference and @p variation.
- */
-FiniteDifferenceDerivatives updateDerivativeFiniteDifference( const pvt::PHASE_TYPE & phase,
-                                                              const FactorMultiphaseSystemProperties & reference,
-                                                              const FactorMultiphaseSystemProperties & variation,
-                                                              double delta )
-{
-  FiniteDifferenceDerivatives result;
-
-  result.dPhaseMoleFraction = ( variation.getPhaseMoleFraction( phase ).value - reference.getPhaseMoleFraction( phase ).value ) / delta;
-  result.dMolecularWeight = ( variation.getMolecularWeight( phase ).value - reference.getMolecularWeight( phase ).value ) / delta;
-  result.dMoleDensity = ( variation.getMoleDensity( phase ).value - reference.getMoleDensity( phase ).value ) / delta;
-  result.dMassDensity = ( variation.getMassDensity( phase ).value - reference.getMassDensity( phase ).value ) / delta;
-  result.dViscosity = ( variation.getViscosity( phase ).value - reference.getViscosity( phase ).value ) / delta;  
-
-  const std::vector< double > & refMoleComposition = reference.getMoleComposition( phase ).value;
-  const std::vector< double > & varMoleComposition = variation.getMoleComposition( phase ).value;
-  result.dMoleComposition.resize( refMoleComposition.size() );
-  for( std::size_t i = 0; i < refMoleComposition.size(); ++i )
+void MultiphaseSystem::setShadowRegionCache( pvt::ShadowRegionCache * cache )
+{
+  m_shadowRegionCache = dynamic_cast< ShadowRegionCache * >( cache );
+  ASSERT( cache == nullptr or m_shadowRegionCache != nullptr, "Shadow region caches must be built by the MultiphaseSystemBuilder" );
+}
+
+void MultiphaseSystem::UpdateCell( std::size_t,
+                                   double pressure,
+                                   double temperature,
+                                   std::vector< double > feed )
+{
+  Update( pressure, temperature, feed );
+}
+
+pvt::FlashStatistics const & MultiphaseSystem::getFlashStatistics() const
+{
+  return m_flashStatistics;
+}
+
+void MultiphaseSystem::resetFlashStatistics()
+{
+  m_flashStatistics = pvt::FlashStatistics();
+}
+
+void MultiphaseSystem::setInitialKValues( std::vector< double > const & kValues )
+{
+  m_initialKValues = kValues;
+}
+
+std::vector< double > const & MultiphaseSystem::getKValues() const
+{
+  static const std::vector< double > noKValues;
+  return noKValues;
+}
+
+void MultiphaseSystem::preparePerturbedProperties( CompositionalMultiphaseSystemProperties & properties )
+{
+  using Stability = CompositionalMultiphaseSystemProperties::Stability;
+
+  const Stability testedStability = properties.getTestedStability();
+  if( testedStability != Stability::UNKNOWN )
   {
-    result.dMoleComposition[i] = ( varMoleComposition[i] - refMoleComposition[i] ) / delta;
+    properties.setStabilityHint( testedStability );
   }
-
-  return result;
+  // A warm-started flash has converged tightly enough for its solution to seed the finite differences flashes.
+  if( not properties.getInitialKValues().empty() )
+  {
+    properties.setInitialKValues( properties.getKValues() );
+  }
+  properties.setFiniteDifferencesPerturbation( true );
 }
 
-void MultiphaseSystem::updateDerivativeDPFiniteDifference( FactorMultiphaseSystemProperties & sysProps,
-                                                           const FactorMultiphaseSystemProperties & perturbedSysProps,
-                                                           double dPressure )
+std::vector< double const * > MultiphaseSystem::resolveBatchSources( FactorMultiphaseSystemProperties const & properties,
+                                                                   pvt::MultiphaseSystemBatchProperties const & outputs )
 {
-  for( const pvt::PHASE_TYPE & phase: sysProps.getPhases() )
+  std::vector< double const * > sources;
+  sources.reserve( outputs.phases.size() );
+  for( pvt::PHASE_TYPE const & phase: outputs.phases )
   {
-    const FiniteDifferenceDerivatives values = updateDerivativeFiniteDifference( phase, sysProps, perturbedSysProps, dPressure );
-
-    sysProps.setPhaseMoleFractionDP( phase, values.dPhaseMoleFraction );
-    sysProps.setMolecularWeightDP( phase, values.dMolecularWeight );
-    sysProps.setMoleDensityDP( phase, values.dMoleDensity );
-    sysProps.setMassDensityDP( phase, values.dMassDensity );
-    sysProps.setViscosityDP( phase, values.dViscosity );
-    sysProps.setMoleCompositionDP( phase, values.dMoleComposition );
+    sources.push_back( properties.getRecord( phase, FactorMultiphaseSystemProperties::PROPERTY::MASS_DENSITY ) );
   }
+  return sources;
 }
 
-void MultiphaseSystem::updateDerivativeDZFiniteDifference( std::size_t iComponent,
-                                                           FactorMultiphaseSystemProperties & sysProps,
-                                                           FactorMultiphaseSystemProperties const & perturbedSysProps,
-                                                           double dz )
+void MultiphaseSystem::writeBatchCell( std::size_t iCell,
+                                       std::size_t nComponents,
+                                       std::vector< double const * > const & sources,
+                                       pvt::MultiphaseSystemBatchProperties const & outputs )
 {
-  for( const pvt::PHASE_TYPE & phase: sysProps.getPhases() )
+  using PROPERTY = FactorMultiphaseSystemProperties::PROPERTY;
+
+  std::size_t const recordSize = pvt::MultiphaseSystemBatchProperties::recordSize( nComponents );
+  std::size_t const nPhases = sources.size();
+
+  // The records of one phase are stored contiguously, in the order of FactorMultiphaseSystemProperties::PROPERTY.
+  auto write = [&]( double const * phaseRecords, PROPERTY const & property, std::size_t nRecords, double * destination )
+  {
+    double const * record = phaseRecords + static_cast< std::size_t >( property ) * recordSize;
+    std::copy( record, record + nRecords * recordSize, destination );
+  };
+
+  for( std::size_t iPhase = 0; iPhase < nPhases; ++iPhase )
   {
-    const FiniteDifferenceDerivatives values = updateDerivativeFiniteDifference( phase, sysProps, perturbedSysProps, dz );
-
-    sysProps.setPhaseMoleFractionDZ( phase, iComponent, values.dPhaseMoleFraction );
-    sysProps.setMolecularWeightDZ( phase, iComponent, values.dMolecularWeight );
-    sysProps.setMoleDensityDZ( phase, iComponent, values.dMoleDensity );
-    sysProps.setMassDensityDZ( phase, iComponent, values.dMassDensity );
-    sysProps.setViscosityDZ( phase, iComponent, values.dViscosity );
-    sysProps.setMoleCompositionDZ( phase, iComponent, values.dMoleComposition );
+    double const * phaseRecords = sources[iPhase];
+    std::size_t const offset = ( iCell * nPhases + iPhase ) * recordSize;
+
+    if( outputs.massDensity != nullptr )
+    {
+      write( phaseRecords, PROPERTY::MASS_DENSITY, 1, outputs.massDensity + offset );
+    }
+    if( outputs.moleDensity != nullptr )
+    {
+      write( phaseRecords, PROPERTY::MOLE_DENSITY, 1, outputs.moleDensity + offset );
+    }
+    if( outputs.viscosity != nullptr )
+    {
+      write( phaseRecords, PROPERTY::VISCOSITY, 1, outputs.viscosity + offset );
+    }
+    if( outputs.molecularWeight != nullptr )
+    {
+      write( phaseRecords, PROPERTY::MOLECULAR_WEIGHT, 1, outputs.molecularWeight + offset );
+    }
+    if( outputs.phaseMoleFraction != nullptr )
+    {
+      write( phaseRecords, PROPERTY::PHASE_MOLE_FRACTION, 1, outputs.phaseMoleFraction + offset );
+    }
+    if( outputs.moleComposition != nullptr )
+    {
+      write( phaseRecords, PROPERTY::MOLE_COMPOSITION, nComponents, outputs.moleComposition + offset * nComponents );
+    }
   }
 }
 
@@ -187,30 +226,49 @@ bool CompositionalMultiphaseSystem::areComponentDataConsistent( std::vector< std
                                                                 std::vector< double > const & componentMolarWeights,
                                                                 std::vector< double > const & componentCriticalTemperatures,
                                                                 std::vector< double > const & componentCriticalPressures,
-                                                                std::vector< double > const & componentOmegas )
+                                                                std::vector< double > const & componentOmegas,
+                                                                std::vector< std::vector< double > > const & componentBinaryInteractionCoefficients,
+                                                                std::vector< std::vector< double > > const & componentVolumeShifts )
 {
   const std::size_t nComponents = componentNames.size();
+
+  auto isMatrixConsistent = [nComponents]( std::vector< std::vector< double > > const & matrix, std::size_t nColumns )
+  {
+    return matrix.empty() ||
+           ( matrix.size() == nComponents &&
+             std::all_of( matrix.cbegin(), matrix.cend(), [nColumns]( std::vector< double > const & row ) { return row.size() == nColumns; } ) );
+  };
+
+  // The mixing rule and its derivatives assume k_ij = k_ji.
+  auto isMatrixSymmetric = [nComponents]( std::vector< std::vector< double > > const & matrix )
+  {
+    const double tolerance = 1.e-12;
+    for( std::size_t i = 0; i < matrix.size(); ++i )
+    {
+      for( std::size_t j = 0; j < i; ++j )
+      {
+        if( std::fabs( matrix[i][j] - matrix[j][i] ) > tolerance * std::max( 1., std::fabs( matrix[i][j] ) ) )
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+
   return componentMolarWeights.size() == nComponents &&
          componentCriticalTemperatures.size() == nComponents &&
          componentCriticalPressures.size() == nComponents &&
-         componentOmegas.size() == nComponents;
+         componentOmegas.size() == nComponents &&
+         isMatrixConsistent( componentBinaryInteractionCoefficients, nComponents ) &&
+         isMatrixSymmetric( componentBinaryInteractionCoefficients ) &&
+         isMatrixConsistent( componentVolumeShifts, 2 );
 }
 
-void CompositionalMultiphaseSystem::updateDerivativeDTFiniteDifference( CompositionalMultiphaseSystemProperties & sysProps,
-                                                                        const CompositionalMultiphaseSystemProperties & perturbedSysProps,
-                                                                        double dTemperature )
+void CompositionalMultiphaseSystem::transferInitialKValues( CompositionalMultiphaseSystemProperties & properties )
 {
-  for( const pvt::PHASE_TYPE & phase: sysProps.getPhases() )
-  {
-    const FiniteDifferenceDerivatives values = updateDerivativeFiniteDifference( phase, sysProps, perturbedSysProps, dTemperature );
-
-    sysProps.setPhaseMoleFractionDT( phase, values.dPhaseMoleFraction );
-    sysProps.setMolecularWeightDT( phase, values.dMolecularWeight );
-    sysProps.setMoleDensityDT( phase, values.dMoleDensity );
-    sysProps.setMassDensityDT( phase, values.dMassDensity );
-    sysProps.setViscosityDT( phase, values.dViscosity );
-    sysProps.setMoleCompositionDT( phase, values.dMoleComposition );
-  }
+  properties.setInitialKValues( m_initialKValues );
+  m_initialKValues.clear();
 }
 
 }
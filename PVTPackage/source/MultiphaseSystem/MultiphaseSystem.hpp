@@ -17,13 +17,16 @@
 
 #include "MultiphaseSystem/MultiphaseSystemProperties/CompositionalMultiphaseSystemProperties.hpp"
 #include "MultiphaseSystem/MultiphaseSystemProperties/FactorMultiphaseSystemProperties.hpp"
+#include "MultiphaseSystem/ShadowRegionCache.hpp"
 
 #include "Utils/math.hpp"
 
 #include "pvt/pvt.hpp"
 
 #include <math.h>
+#include <algorithm>
 #include <limits>
+#include <memory>
 #include <vector>
 
 namespace PVTPackage
@@ -35,6 +38,25 @@ public:
 
   bool hasSucceeded() const final;
 
+  void setDerivativesType( pvt::DERIVATIVES_TYPE const & derivativesType ) final;
+
+  void setShadowRegionCache( pvt::ShadowRegionCache * cache ) final;
+
+  /// Calls Update by default, systems running a stability test override it.
+  void UpdateCell( std::size_t cellIndex,
+                   double pressure,
+                   double temperature,
+                   std::vector< double > feed ) override;
+
+  pvt::FlashStatistics const & getFlashStatistics() const override;
+
+  void resetFlashStatistics() override;
+
+  void setInitialKValues( std::vector< double > const & kValues ) final;
+
+  /// Empty by default, systems with K-values override it.
+  std::vector< double > const & getKValues() const override;
+
 protected:
 
   enum class State
@@ -45,6 +67,85 @@ protected:
   /// Success indicator for system state update
   State m_stateIndicator;
 
+  /// How the derivatives are computed
+  pvt::DERIVATIVES_TYPE m_derivativesType = pvt::DERIVATIVES_TYPE::FINITE_DIFFERENCES;
+
+  /// Counters of the systems without iterative flash, which stay to zero
+  pvt::FlashStatistics m_flashStatistics;
+
+  /// The K-values the next flash starts from, empty for the default initialization
+  std::vector< double > m_initialKValues;
+
+  /// The shadow region cache used by UpdateCell, not owned
+  ShadowRegionCache * m_shadowRegionCache = nullptr;
+
+  /**
+   * @brief Solves the @p nCells cells one after the other and copies the results into @p outputs.
+   * @tparam S The solver type (S stands for solve), called as `bool( double, double, std::vector< double > const & )`.
+   * @param nCells Number of cells.
+   * @param pressures Contiguous pressures.
+   * @param temperatures Contiguous temperatures.
+   * @param feeds Contiguous feeds, laid out as [cell][component].
+   * @param properties The data filled by @p solve for each cell.
+   * @param outputs The caller-owned buffers.
+   * @param solve The (non virtual) single cell solver.
+   * @return True if all the cells succeeded.
+   *
+   * @note The phase lookups are done once for the whole batch, and the feed buffer is reused from cell to cell.
+   * When @p outputs provides K-values, each cell starts from its own K-values and gets them updated.
+   */
+  template< class S >
+  bool batchUpdate( std::size_t nCells,
+                    double const * pressures,
+                    double const * temperatures,
+                    double const * feeds,
+                    FactorMultiphaseSystemProperties const & properties,
+                    pvt::MultiphaseSystemBatchProperties const & outputs,
+                    S && solve )
+  {
+    std::size_t const nComponents = properties.getNComponents();
+    std::vector< double const * > const sources = resolveBatchSources( properties, outputs );
+
+    m_batchFeed.resize( nComponents );
+
+    bool allSucceeded = true;
+    for( std::size_t iCell = 0; iCell < nCells; ++iCell )
+    {
+      std::copy( feeds + iCell * nComponents, feeds + ( iCell + 1 ) * nComponents, m_batchFeed.begin() );
+      double * const cellKValues = outputs.kValues != nullptr ? outputs.kValues + iCell * nComponents : nullptr;
+      if( cellKValues != nullptr )
+      {
+        if( cellKValues[0] > 0. )
+        {
+          m_initialKValues.assign( cellKValues, cellKValues + nComponents );
+        }
+        else
+        {
+          m_initialKValues.clear();
+        }
+      }
+      bool const success = solve( pressures[iCell], temperatures[iCell], m_batchFeed );
+      writeBatchCell( iCell, nComponents, sources, outputs );
+      if( cellKValues != nullptr )
+      {
+        std::vector< double > const & kValues = getKValues();
+        if( kValues.size() == nComponents )
+        {
+          std::copy( kValues.cbegin(), kValues.cend(), cellKValues );
+        }
+      }
+      if( outputs.succeeded != nullptr )
+      {
+        outputs.succeeded[iCell] = success;
+      }
+      allSucceeded &= success;
+    }
+
+    m_stateIndicator = allSucceeded ? State::SUCCESS : State::NOT_CONVERGED;
+
+    return allSucceeded;
+  }
+
   /**
    * @brief Computes the equilibrium and some derivatives for given @p flash.
    * @tparam F The flash type (F stands for flash).
@@ -56,24 +157,72 @@ protected:
    * @note This function computes the derivatives w.r.t. pressure, components. Not temperature.
    */
   template< class F, class MSP >
-  static bool computeEquilibriumAndDerivativesNoTemperature( const F & flash,
-                                                             MSP & properties )
+  bool computeEquilibriumAndDerivativesNoTemperature( const F & flash,
+                                                      MSP & properties ) const
   {
     bool success = flash.computeEquilibrium( properties );
+    success &= computeFiniteDifferenceDerivativesNoTemperature( flash, properties );
+    return success;
+  }
+
+  /**
+   * @brief Computes the equilibrium and some derivatives for given @p flash, according to the selected derivatives type.
+   * @tparam F The flash type (F stands for flash), which must provide analytical derivatives.
+   * @tparam MSP The MultiphaseSystemProperties type.
+   * @param flash The flash instance.
+   * @param properties The data the flash algorithm will be using.
+   * @return True in case of success.
+   *
+   * @note This function computes the derivatives w.r.t. pressure, components. Not temperature.
+   * Finite differences are used when the flash could not compute the analytical derivatives.
+   */
+  template< class F, class MSP >
+  bool computeEquilibriumAndSelectedDerivativesNoTemperature( const F & flash,
+                                                              MSP & properties ) const
+  {
+    if( m_derivativesType != pvt::DERIVATIVES_TYPE::ANALYTICAL )
+    {
+      return computeEquilibriumAndDerivativesNoTemperature( flash, properties );
+    }
+
+    bool derivativesComputed = false;
+    bool success = flash.computeEquilibriumAndDerivatives( properties, derivativesComputed );
+    if( not derivativesComputed )
+    {
+      success &= computeFiniteDifferenceDerivativesNoTemperature( flash, properties );
+    }
+    return success;
+  }
+
+  /**
+   * @brief Computes the derivatives of an already computed equilibrium by finite differences.
+   * @tparam F The flash type (F stands for flash).
+   * @tparam MSP The MultiphaseSystemProperties type.
+   * @param flash The flash instance.
+   * @param properties The data holding the equilibrium.
+   * @return True if all the perturbed equilibria succeeded.
+   *
+   * @note This function computes the derivatives w.r.t. pressure, components. Not temperature.
+   */
+  template< class F, class MSP >
+  bool computeFiniteDifferenceDerivativesNoTemperature( const F & flash,
+                                                        MSP & properties ) const
+  {
+    bool success = true;
 
     double const & pressure = properties.getPressure();
 
     double const sqrtPrecision = sqrt( std::numeric_limits< double >::epsilon() );
 
     // Copying for finite difference process
-    MSP pEps = properties;
+    MSP & pEps = getPerturbedProperties( properties );
 
     // Pressure
     {
       const double dPressure = sqrtPrecision * ( std::fabs( pressure ) + sqrtPrecision );
       pEps.setPressure( pressure + dPressure );
       success &= flash.computeEquilibrium( pEps );
-      updateDerivativeDPFiniteDifference( properties, pEps, dPressure );
+      properties.setFiniteDifferenceDerivatives( pEps, FactorMultiphaseSystemProperties::DP, dPressure );
       pEps.setPressure( pressure );
     }
 
@@ -87,11 +236,12 @@ protected:
         {
           dz = -dz;
         }
-        std::vector< double > newFeed( savedFeed );
-        newFeed[iComponent] += dz;
-        pEps.setFeed( math::Normalize( newFeed ) );
+        m_perturbedFeed = savedFeed;
+        m_perturbedFeed[iComponent] += dz;
+        math::NormalizeInPlace( m_perturbedFeed );
+        pEps.setFeed( m_perturbedFeed );
         success &= flash.computeEquilibrium( pEps );
-        updateDerivativeDZFiniteDifference( iComponent, properties, pEps, dz );
+        properties.setFiniteDifferenceDerivatives( pEps, FactorMultiphaseSystemProperties::DZ + iComponent, dz );
         pEps.setFeed( savedFeed );
       }
     }
@@ -99,27 +249,137 @@ protected:
     return success;
   }
 
+  /**
+   * @brief Copies @p properties into the properties reused by the finite differences flashes.
+   * @tparam MSP The MultiphaseSystemProperties type, which must remain the same for a given system.
+   * @param properties The data holding the equilibrium.
+   * @return The copy. Its storage is only allocated the first time, and then reused from one update to the other.
+   */
+  template< class MSP >
+  MSP & getPerturbedProperties( MSP const & properties ) const
+  {
+    if( m_perturbedProperties == nullptr )
+    {
+      m_perturbedProperties.reset( new MSP( properties ) );
+    }
+    MSP & perturbed = static_cast< MSP & >( *m_perturbedProperties );
+    perturbed = properties;
+    preparePerturbedProperties( perturbed );
+    return perturbed;
+  }
+
+  /// Nothing to prepare for the properties of the systems without stability test.
+  static void preparePerturbedProperties( FactorMultiphaseSystemProperties & )
+  { }
+
+  /**
+   * @brief Prepares the copy of the properties of a base flash for the finite differences flashes.
+   * @param properties The copy.
+   *
+   * The finite differences flashes are left out of the statistics. They start from the stability of the base flash,
+   * instead of running the stability test again. They start from the same K-values as a cold-started base flash,
+   * and from the solution of a warm-started one (see CompositionalFlash::computeFugacityTolerance).
+   */
+  static void preparePerturbedProperties( CompositionalMultiphaseSystemProperties & properties );
+
 private:
 
-  static void updateDerivativeDPFiniteDifference( FactorMultiphaseSystemProperties & sysProps,
-                                                  const FactorMultiphaseSystemProperties & perturbedSysProps,
-                                                  double dPressure );
+  /**
+   * @brief Resolves, once per batch, the first record of each output phase.
+   * @param properties The data filled for each cell.
+   * @param outputs The caller-owned buffers.
+   * @return Pointers to the records of each phase of @p outputs, which remain valid during the whole batch.
+   */
+  static std::vector< double const * > resolveBatchSources( FactorMultiphaseSystemProperties const & properties,
+                                                            pvt::MultiphaseSystemBatchProperties const & outputs );
+
+  static void writeBatchCell( std::size_t iCell,
+                              std::size_t nComponents,
+                              std::vector< double const * > const & sources,
+                              pvt::MultiphaseSystemBatchProperties const & outputs );
+
+  /// Feed buffer reused by all the cells of a batch.
+  std::vector< double > m_batchFeed;
+
+  /// The properties of the finite differences flashes, see getPerturbedProperties.
+  mutable std::unique_ptr< FactorMultiphaseSystemProperties > m_perturbedProperties;
+  /// Feed buffer of the finite differences flashes.
+  mutable std::vector< double > m_perturbedFeed;
 
-  static void updateDerivativeDZFiniteDifference( std::size_t iComponent,
-                                                  FactorMultiphaseSystemProperties & sysProps,
-                                                  const FactorMultiphaseSystemProperties & perturbedSysProps,
-                                                  double dz );
 };
 
 class CompositionalMultiphaseSystem : public MultiphaseSystem
 {
 protected:
 
+  /**
+   * @brief Checks that all the component inputs have the same size.
+   *
+   * The binary interaction coefficients (nComponents x nComponents) and the volume shifts (nComponents x 2)
+   * may be left empty, meaning no interaction and no shift.
+   * The binary interaction coefficients must be symmetric (k_ij = k_ji, up to a relative 1e-12).
+   */
   static bool areComponentDataConsistent( std::vector< std::string > const & componentNames,
                                           std::vector< double > const & componentMolarWeights,
                                           std::vector< double > const & componentCriticalTemperatures,
                                           std::vector< double > const & componentCriticalPressures,
-                                          std::vector< double > const & componentOmegas );
+                                          std::vector< double > const & componentOmegas,
+                                          std::vector< std::vector< double > > const & componentBinaryInteractionCoefficients,
+                                          std::vector< std::vector< double > > const & componentVolumeShifts );
+
+  /**
+   * @brief Hands the K-values set through #setInitialKValues over to @p properties, for the next flash only.
+   * @param properties The data the flash algorithm will be using.
+   */
+  void transferInitialKValues( CompositionalMultiphaseSystemProperties & properties );
+
+  /**
+   * @brief Solves a cell with the help of the shadow region cache, then stores the outcome of its stability test into the cache.
+   * @tparam S The solver type (S stands for solve), called as `bool( double, double, std::vector< double > const & )`.
+   * @param cellIndex The cell.
+   * @param pressure The pressure.
+   * @param temperature The temperature.
+   * @param feed The feed.
+   * @param properties The data filled by @p solve.
+   * @param solve The single cell solver.
+   * @return True in case of success.
+   */
+  template< class S >
+  bool solveCell( std::size_t cellIndex,
+                  double pressure,
+                  double temperature,
+                  std::vector< double > const & feed,
+                  CompositionalMultiphaseSystemProperties & properties,
+                  S && solve )
+  {
+    using Stability = CompositionalMultiphaseSystemProperties::Stability;
+
+    if( m_shadowRegionCache == nullptr )
+    {
+      return solve( pressure, temperature, feed );
+    }
+
+    ASSERT( m_shadowRegionCache->getNComponents() == feed.size(), "The shadow region cache does not match the number of components" );
+    ASSERT( cellIndex < m_shadowRegionCache->size(), "Cell index out of the shadow region cache" );
+
+    properties.setStabilityHint( m_shadowRegionCache->getStability( cellIndex, pressure, temperature, feed ) );
+    const bool success = solve( pressure, temperature, feed );
+    properties.setStabilityHint( Stability::UNKNOWN );
+
+    const Stability stability = properties.getTestedStability();
+    if( stability == Stability::UNSTABLE )
+    {
+      const double gasPhaseMoleFraction = properties.getPhaseMoleFraction( pvt::PHASE_TYPE::GAS ).value;
+      const double distance = std::min( gasPhaseMoleFraction, 1. - gasPhaseMoleFraction );
+      m_shadowRegionCache->setStability( cellIndex, pressure, temperature, feed, stability, distance );
+    }
+    else if( stability != Stability::UNKNOWN )
+    {
+      m_shadowRegionCache->setStability( cellIndex, pressure, temperature, feed, stability, properties.getTangentPlaneDistance() );
+    }
+
+    return success;
+  }
 
   /**
    * @brief Computes the equilibrium and derivatives for given @p flash.
@@ -132,32 +392,73 @@ protected:
    * @note This function computes the derivatives w.r.t. pressure, temperature, components.
    */
   template< class F, class MSP >
-  static bool computeEquilibriumAndDerivativesWithTemperature( const F & flash,
-                                                               MSP & properties )
+  bool computeEquilibriumAndDerivativesWithTemperature( const F & flash,
+                                                        MSP & properties ) const
+  {
+    bool success = flash.computeEquilibrium( properties );
+    success &= computeFiniteDifferenceDerivativesWithTemperature( flash, properties );
+    return success;
+  }
+
+  /**
+   * @brief Computes the derivatives of an already computed equilibrium by finite differences.
+   * @tparam F The flash type (F stands for flash).
+   * @tparam MSP The MultiphaseSystemProperties type.
+   * @param flash The flash instance.
+   * @param properties The data holding the equilibrium.
+   * @return True if all the perturbed equilibria succeeded.
+   *
+   * @note This function computes the derivatives w.r.t. pressure, temperature, components.
+   */
+  template< class F, class MSP >
+  bool computeFiniteDifferenceDerivativesWithTemperature( const F & flash,
+                                                          MSP & properties ) const
   {
-    bool success = computeEquilibriumAndDerivativesNoTemperature( flash, properties );
+    bool success = computeFiniteDifferenceDerivativesNoTemperature( flash, properties );
 
     double const sqrtPrecision = sqrt( std::numeric_limits< double >::epsilon() );
 
     // Copying for finite difference process
-    MSP pEps = properties;
+    MSP & pEps = getPerturbedProperties( properties );
 
     // Temperature finite difference process
     double const & temperature = properties.getTemperature();
     const double dTemperature = sqrtPrecision * ( std::fabs( temperature ) + sqrtPrecision );
     pEps.setTemperature( temperature + dTemperature );
     success &= flash.computeEquilibrium( pEps );
-    updateDerivativeDTFiniteDifference( properties, pEps, dTemperature );
+    properties.setFiniteDifferenceDerivatives( pEps, FactorMultiphaseSystemProperties::DT, dTemperature );
     pEps.setTemperature( temperature );
 
     return success;
   }
 
-private:
+  /**
+   * @brief Computes the equilibrium and derivatives for given @p flash, according to the selected derivatives type.
+   * @tparam F The flash type (F stands for flash), which must provide analytical derivatives.
+   * @tparam MSP The MultiphaseSystemProperties type.
+   * @param flash The flash instance.
+   * @param properties The data the flash algorithm will be using.
+   * @return True in case of success.
+   *
+   * @note Finite differences are used when the flash could not compute the analytical derivatives.
+   */
+  template< class F, class MSP >
+  bool computeEquilibriumAndDerivatives( const F & flash,
+                                         MSP & properties ) const
+  {
+    if( m_derivativesType != pvt::DERIVATIVES_TYPE::ANALYTICAL )
+    {
+      return computeEquilibriumAndDerivativesWithTemperature( flash, properties );
+    }
 
-  static void updateDerivativeDTFiniteDifference( CompositionalMultiphaseSystemProperties & sysProps,
-                                                  const CompositionalMultiphaseSystemProperties & perturbedSysProps,
-                                                  double dTemperature );
+    bool derivativesComputed = false;
+    bool success = flash.computeEquilibriumAndDerivatives( properties, derivativesComputed );
+    if( not derivativesComputed )
+    {
+      success &= computeFiniteDifferenceDerivativesWithTemperature( flash, properties );
+    }
+    return success;
+  }
 };
 
 /**
@@ -33,10 +33,39 @@ BlackOilDeadOilMultiphaseSystemProperties::BlackOilDeadOilMultiphaseSystemProper
 void BlackOilDeadOilMultiphaseSystemProperties::setModelProperties( pvt::PHASE_TYPE const & phase,
                                                                     BlackOilDeadOilProperties const & props )
 {
-  m_massDensity.at( phase ).value = props.massDensity;
-  m_moleDensity.at( phase ).value = props.moleDensity;
-  m_viscosity.at( phase ).value = props.viscosity;
-  m_molecularWeight.at( phase ).value = props.moleDensity > 0 ? props.massDensity / props.moleDensity : 0.0;
+  setRecordEntry( phase, PROPERTY::MASS_DENSITY, VALUE, props.massDensity );
+  setRecordEntry( phase, PROPERTY::MOLE_DENSITY, VALUE, props.moleDensity );
+  setRecordEntry( phase, PROPERTY::VISCOSITY, VALUE, props.viscosity );
+  setRecordEntry( phase, PROPERTY::MOLECULAR_WEIGHT, VALUE, props.moleDensity > 0 ? props.massDensity / props.moleDensity : 0.0 );
+}
+
+void BlackOilDeadOilMultiphaseSystemProperties::setModelProperties( pvt::PHASE_TYPE const & phase,
+                                                                    BlackOilDeadOilPropertiesAndDerivatives const & props,
+                                                                    std::vector< double > const & dRs_dz )
+{
+  setModelProperties( phase, props.value );
+
+  // The molecular weight is the ratio of the densities
+  const double massDensity = props.value.massDensity;
+  const double moleDensity = props.value.moleDensity;
+  const double molecularWeight = moleDensity > 0 ? massDensity / moleDensity : 0.0;
+  auto const dMolecularWeight = [&]( double dMass, double dMole )
+  {
+    return moleDensity > 0 ? ( dMass - molecularWeight * dMole ) / moleDensity : 0.0;
+  };
+
+  setRecordEntry( phase, PROPERTY::MASS_DENSITY, DP, props.dP.massDensity );
+  setRecordEntry( phase, PROPERTY::MOLE_DENSITY, DP, props.dP.moleDensity );
+  setRecordEntry( phase, PROPERTY::VISCOSITY, DP, props.dP.viscosity );
+  setRecordEntry( phase, PROPERTY::MOLECULAR_WEIGHT, DP, dMolecularWeight( props.dP.massDensity, props.dP.moleDensity ) );
+
+  for( std::size_t i = 0; i < dRs_dz.size(); ++i )
+  {
+    setRecordEntry( phase, PROPERTY::MASS_DENSITY, DZ + i, props.dRs.massDensity * dRs_dz[i] );
+    setRecordEntry( phase, PROPERTY::MOLE_DENSITY, DZ + i, props.dRs.moleDensity * dRs_dz[i] );
+    setRecordEntry( phase, PROPERTY::VISCOSITY, DZ + i, props.dRs.viscosity * dRs_dz[i] );
+    setRecordEntry( phase, PROPERTY::MOLECULAR_WEIGHT, DZ + i, dMolecularWeight( props.dRs.massDensity, props.dRs.moleDensity ) * dRs_dz[i] );
+  }
 }
 
 void BlackOilDeadOilMultiphaseSystemProperties::setOilModelProperties( BlackOilDeadOilProperties const & props )
@@ -54,10 +83,25 @@ void BlackOilDeadOilMultiphaseSystemProperties::setWaterModelProperties( BlackOi
   setModelProperties( pvt::PHASE_TYPE::LIQUID_WATER_RICH, props );
 }
 
-std::size_t BlackOilDeadOilMultiphaseSystemProperties::getNComponents() const
+void BlackOilDeadOilMultiphaseSystemProperties::setOilModelProperties( BlackOilDeadOilPropertiesAndDerivatives const & props,
+                                                                       std::vector< double > const & dRs_dz )
 {
-  // for Black-Oil and Dead-Oil the number of components is equal to the number of phases
-  return getPhases().size(); 
+  setModelProperties( pvt::PHASE_TYPE::OIL, props, dRs_dz );
 }
-  
+
+void BlackOilDeadOilMultiphaseSystemProperties::setOilModelProperties( BlackOilDeadOilPropertiesAndDerivatives const & props )
+{
+  setModelProperties( pvt::PHASE_TYPE::OIL, props, {} );
+}
+
+void BlackOilDeadOilMultiphaseSystemProperties::setGasModelProperties( BlackOilDeadOilPropertiesAndDerivatives const & props )
+{
+  setModelProperties( pvt::PHASE_TYPE::GAS, props, {} );
+}
+
+void BlackOilDeadOilMultiphaseSystemProperties::setWaterModelProperties( BlackOilDeadOilPropertiesAndDerivatives const & props )
+{
+  setModelProperties( pvt::PHASE_TYPE::LIQUID_WATER_RICH, props, {} );
+}
+
 }
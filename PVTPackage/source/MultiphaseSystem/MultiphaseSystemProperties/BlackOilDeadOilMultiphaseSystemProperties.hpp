@@ -35,13 +35,20 @@ public:
 
   void setWaterModelProperties( BlackOilDeadOilProperties const & props );
 
-protected:
-  
   /**
-   * @brief Returns the number of components (here, it is equal to the number of phases) 
-   */  
-  std::size_t getNComponents() const;
-  
+   * @brief Sets the oil properties and their pressure and feed derivatives.
+   * @param props The values and derivatives computed by the oil model.
+   * @param dRs_dz The derivatives of Rs w.r.t. feed, for the undersaturated oil. Empty if Rs follows the pressure.
+   */
+  void setOilModelProperties( BlackOilDeadOilPropertiesAndDerivatives const & props,
+                              std::vector< double > const & dRs_dz );
+
+  void setOilModelProperties( BlackOilDeadOilPropertiesAndDerivatives const & props );
+
+  void setGasModelProperties( BlackOilDeadOilPropertiesAndDerivatives const & props );
+
+  void setWaterModelProperties( BlackOilDeadOilPropertiesAndDerivatives const & props );
+
 private:
 
   /**
@@ -54,6 +61,16 @@ private:
   void setModelProperties( pvt::PHASE_TYPE const & phase,
                            BlackOilDeadOilProperties const & props );
 
+  /**
+   * @brief Sets the properties of @p phase and their derivatives.
+   * @param phase The phase for which we want to set properties.
+   * @param props The values and derivatives computed by the model.
+   * @param dRs_dz The derivatives of Rs w.r.t. feed, combined with the Rs derivatives of @p props. May be empty.
+   */
+  void setModelProperties( pvt::PHASE_TYPE const & phase,
+                           BlackOilDeadOilPropertiesAndDerivatives const & props,
+                           std::vector< double > const & dRs_dz );
+
 };
 
 }
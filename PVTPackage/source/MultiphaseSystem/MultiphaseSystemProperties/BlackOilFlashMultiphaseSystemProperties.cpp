@@ -22,14 +22,7 @@ BlackOilFlashMultiphaseSystemProperties::BlackOilFlashMultiphaseSystemProperties
   :
   BlackOilDeadOilMultiphaseSystemProperties( phases )
 {
-  size_t const nComponents = getNComponents();
-  
-  for( pvt::PHASE_TYPE pt: getPhases() )
-  {
-    m_lnFugacity.insert( { pt, pvt::VectorPropertyAndDerivatives< double >( nComponents, nComponents ) } );
-  }
-  
-  m_moleComposition.at( pvt::PHASE_TYPE::LIQUID_WATER_RICH ).value = { 0., 0., 1. };
+  setMoleComposition( pvt::PHASE_TYPE::LIQUID_WATER_RICH, { 0., 0., 1. } );
 }
 
 void BlackOilFlashMultiphaseSystemProperties::setOilFraction( double const & fraction )
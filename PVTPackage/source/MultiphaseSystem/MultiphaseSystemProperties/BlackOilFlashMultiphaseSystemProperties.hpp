@@ -40,10 +40,6 @@ public:
   void setOilMoleComposition( std::vector< double > const & moleComposition );
 
   void setGasMoleComposition( std::vector< double > const & moleComposition );
-
-private:
-
-  std::map< pvt::PHASE_TYPE, pvt::VectorPropertyAndDerivatives< double > > m_lnFugacity;
 };
 
 }
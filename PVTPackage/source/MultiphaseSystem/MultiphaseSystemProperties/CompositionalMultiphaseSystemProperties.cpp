@@ -20,15 +20,15 @@ namespace PVTPackage
 CompositionalMultiphaseSystemProperties::CompositionalMultiphaseSystemProperties( const std::vector< pvt::PHASE_TYPE > & phases,
                                                                                   std::size_t nComponents )
   :
-  FactorMultiphaseSystemProperties( phases, nComponents )
-{
-  for( pvt::PHASE_TYPE pt: phases )
-  {
-    // FIXME not so sure that all models use those two following data.
-    m_lnFugacity.insert( { pt, std::vector< double >( nComponents, 0. ) } );
-    m_compressibilityFactor.insert( { pt, 0. } );
-  }
-}
+  FactorMultiphaseSystemProperties( phases, nComponents ),
+  // FIXME not so sure that all models use those two following data.
+  m_compressibilityFactor( phases.size(), 0. ),
+  m_lnFugacity( phases.size(), std::vector< double >( nComponents, 0. ) ),
+  m_stabilityHint( Stability::UNKNOWN ),
+  m_testedStability( Stability::UNKNOWN ),
+  m_tangentPlaneDistance( 0. ),
+  m_isFiniteDifferencesPerturbation( false )
+{ }
 
 double const & CompositionalMultiphaseSystemProperties::getTemperature() const
 {
@@ -63,13 +63,71 @@ void CompositionalMultiphaseSystemProperties::setGasFraction( double const & fra
 void CompositionalMultiphaseSystemProperties::setModelProperties( const pvt::PHASE_TYPE & phase,
                                                                   CubicEoSPhaseModel::Properties const & properties )
 {
-  m_massDensity.at( phase ).value = properties.massDensity;
-  m_moleDensity.at( phase ).value = properties.moleDensity;
-  m_viscosity.at( phase ).value = properties.viscosity;
-  m_molecularWeight.at( phase ).value = properties.molecularWeight;
+  setRecordEntry( phase, PROPERTY::MASS_DENSITY, VALUE, properties.massDensity );
+  setRecordEntry( phase, PROPERTY::MOLE_DENSITY, VALUE, properties.moleDensity );
+  setRecordEntry( phase, PROPERTY::VISCOSITY, VALUE, properties.viscosity );
+  setRecordEntry( phase, PROPERTY::MOLECULAR_WEIGHT, VALUE, properties.molecularWeight );
   // FIXME not so sure that all models use those two following data.
-  m_compressibilityFactor.at( phase ) = properties.compressibilityFactor;
-  m_lnFugacity.at( phase ) = properties.lnFugacityCoefficients;
+  const std::size_t phaseIndex = getPhaseIndex( phase );
+  m_compressibilityFactor[phaseIndex] = properties.compressibilityFactor;
+  m_lnFugacity[phaseIndex] = properties.lnFugacityCoefficients;
+}
+
+void CompositionalMultiphaseSystemProperties::setInitialKValues( std::vector< double > const & kValues )
+{
+  m_initialKValues = kValues;
+}
+
+std::vector< double > const & CompositionalMultiphaseSystemProperties::getInitialKValues() const
+{
+  return m_initialKValues;
+}
+
+void CompositionalMultiphaseSystemProperties::setKValues( std::vector< double > const & kValues )
+{
+  m_kValues = kValues;
+}
+
+std::vector< double > const & CompositionalMultiphaseSystemProperties::getKValues() const
+{
+  return m_kValues;
+}
+
+void CompositionalMultiphaseSystemProperties::setStabilityHint( Stability stability )
+{
+  m_stabilityHint = stability;
+}
+
+CompositionalMultiphaseSystemProperties::Stability CompositionalMultiphaseSystemProperties::getStabilityHint() const
+{
+  return m_stabilityHint;
+}
+
+void CompositionalMultiphaseSystemProperties::setStabilityTestResult( Stability stability,
+                                                                      double tangentPlaneDistance )
+{
+  m_testedStability = stability;
+  m_tangentPlaneDistance = tangentPlaneDistance;
+}
+
+CompositionalMultiphaseSystemProperties::Stability CompositionalMultiphaseSystemProperties::getTestedStability() const
+{
+  return m_testedStability;
+}
+
+double CompositionalMultiphaseSystemProperties::getTangentPlaneDistance() const
+{
+  return m_tangentPlaneDistance;
+}
+
+void CompositionalMultiphaseSystemProperties::setFiniteDifferencesPerturbation( bool isPerturbation )
+{
+  m_isFiniteDifferencesPerturbation = isPerturbation;
+}
+
+bool CompositionalMultiphaseSystemProperties::isFiniteDifferencesPerturbation() const
+{
+  return m_isFiniteDifferencesPerturbation;
 }
 
 /// DT
@@ -77,37 +135,37 @@ void CompositionalMultiphaseSystemProperties::setModelProperties( const pvt::PHA
 void CompositionalMultiphaseSystemProperties::setPhaseMoleFractionDT( pvt::PHASE_TYPE const & phase,
                                                                       double const & value )
 {
-  m_phaseMoleFraction.at( phase ).dT = value;
+  setRecordEntry( phase, PROPERTY::PHASE_MOLE_FRACTION, DT, value );
 }
 
 void CompositionalMultiphaseSystemProperties::setMolecularWeightDT( pvt::PHASE_TYPE const & phase,
                                                                     double const & value )
 {
-  m_molecularWeight.at( phase ).dT = value;
+  setRecordEntry( phase, PROPERTY::MOLECULAR_WEIGHT, DT, value );
 }
 
 void CompositionalMultiphaseSystemProperties::setMoleDensityDT( pvt::PHASE_TYPE const & phase,
                                                                 double const & value )
 {
-  m_moleDensity.at( phase ).dT = value;
+  setRecordEntry( phase, PROPERTY::MOLE_DENSITY, DT, value );
 }
 
 void CompositionalMultiphaseSystemProperties::setMassDensityDT( pvt::PHASE_TYPE const & phase,
                                                                 double const & value )
 {
-  m_massDensity.at( phase ).dT = value;
+  setRecordEntry( phase, PROPERTY::MASS_DENSITY, DT, value );
 }
 
 void CompositionalMultiphaseSystemProperties::setViscosityDT( pvt::PHASE_TYPE const & phase,
                                                               double const & value )
 {
-  m_viscosity.at( phase ).dT = value;
+  setRecordEntry( phase, PROPERTY::VISCOSITY, DT, value );
 }
 
 void CompositionalMultiphaseSystemProperties::setMoleCompositionDT( pvt::PHASE_TYPE const & phase,
                                                                     std::vector< double > const & value )
 {
-  m_moleComposition.at( phase ).dT = value;
+  setMoleCompositionEntry( phase, DT, value );
 }
 
 }
@@ -21,7 +21,6 @@
 #include "MultiphaseSystem/PhaseModel/CubicEOS/CubicEoSPhaseModel.hpp"
 
 #include "pvt/pvt.hpp"
-#include <map>
 
 #include <vector>
 
@@ -32,6 +31,14 @@ class CompositionalMultiphaseSystemProperties : public FactorMultiphaseSystemPro
 {
 public:
 
+  /**
+   * @brief What is known of the stability of the feed.
+   */
+  enum class Stability
+  {
+    UNKNOWN, STABLE_OIL, STABLE_GAS, UNSTABLE
+  };
+
   CompositionalMultiphaseSystemProperties( const std::vector< pvt::PHASE_TYPE > & phases,
                                            std::size_t nComponents );
 
@@ -76,12 +83,73 @@ public:
   void setMoleCompositionDT( pvt::PHASE_TYPE const & phase,
                              std::vector< double > const & value );
 
+  /**
+   * @brief Sets the K-values the flash starts from.
+   * @param kValues One K-value per component. Empty means the default initialization of the flash.
+   */
+  void setInitialKValues( std::vector< double > const & kValues );
+
+  std::vector< double > const & getInitialKValues() const;
+
+  /**
+   * @brief Stores the K-values the flash ended with.
+   * @param kValues One K-value per component.
+   *
+   * The initial K-values are left unchanged. The finite differences flashes performed on copies of these properties
+   * start from the same K-values as a cold-started base flash, so that they follow its iterations and their convergence errors
+   * cancel in the differences. A warm-started base flash converges below the perturbations instead,
+   * and its finite differences flashes start from this solution.
+   */
+  void setKValues( std::vector< double > const & kValues );
+
+  std::vector< double > const & getKValues() const;
+
+  /**
+   * @brief Sets the stability of the feed known before the flash, e.g. from a previous stability test.
+   * @param stability The known stability. A stable feed skips the stability test and the flash iterations,
+   * an unstable one skips the stability test. UNKNOWN leaves the flash unchanged.
+   */
+  void setStabilityHint( Stability stability );
+
+  Stability getStabilityHint() const;
+
+  /**
+   * @brief Stores the outcome of the stability test run by the flash.
+   * @param stability The outcome, UNKNOWN if no test was run.
+   * @param tangentPlaneDistance The tangent plane distance of the test.
+   */
+  void setStabilityTestResult( Stability stability,
+                               double tangentPlaneDistance );
+
+  Stability getTestedStability() const;
+
+  double getTangentPlaneDistance() const;
+
+  /**
+   * @brief Marks these properties as the ones of a finite differences flash.
+   * @param isPerturbation True for the finite differences flashes, which the flash statistics leave out.
+   */
+  void setFiniteDifferencesPerturbation( bool isPerturbation );
+
+  bool isFiniteDifferencesPerturbation() const;
+
 protected:
 
-  std::map< pvt::PHASE_TYPE, double > m_compressibilityFactor;
-  std::map< pvt::PHASE_TYPE, std::vector< double > > m_lnFugacity;
+  /// Compressibility factor of each phase, indexed by getPhaseIndex.
+  std::vector< double > m_compressibilityFactor;
+  /// Ln fugacity coefficients of each phase, indexed by getPhaseIndex.
+  std::vector< std::vector< double > > m_lnFugacity;
 
   double m_temperature;
+
+  std::vector< double > m_initialKValues;
+  std::vector< double > m_kValues;
+
+  Stability m_stabilityHint;
+  Stability m_testedStability;
+  double m_tangentPlaneDistance;
+
+  bool m_isFiniteDifferencesPerturbation;
 };
 
 }
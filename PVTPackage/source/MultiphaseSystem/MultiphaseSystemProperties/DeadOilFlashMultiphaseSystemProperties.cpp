@@ -17,7 +17,6 @@
 
 #include "pvt/pvt.hpp"
 
-#include <cmath>
 #include <algorithm>
 
 namespace PVTPackage
@@ -27,61 +26,47 @@ DeadOilFlashMultiphaseSystemProperties::DeadOilFlashMultiphaseSystemProperties(
   :
   BlackOilDeadOilMultiphaseSystemProperties( phases )
 {
-  size_t const nComponents = getNComponents();
-  
-  for( pvt::PHASE_TYPE pt: getPhases() )
-  {
-    m_lnFugacity.insert( { pt, pvt::VectorPropertyAndDerivatives< double >( nComponents, nComponents ) } );
-  }
-
   size_t const nPhases = phases.size();
 
   // TODO: ultimately, all these if statements should go away
   
   if( nPhases == 3 )
   {
-    m_moleComposition.at( pvt::PHASE_TYPE::OIL ).value = { 1., 0., 0. };
-    m_moleComposition.at( pvt::PHASE_TYPE::GAS ).value = { 0., 1., 0. };
-    m_moleComposition.at( pvt::PHASE_TYPE::LIQUID_WATER_RICH ).value = { 0., 0., 1. };
-
-    m_lnFugacity.at( pvt::PHASE_TYPE::OIL ).value = { std::log( 1. ), std::log( 1. ), std::log( 1. ) };
-    m_lnFugacity.at( pvt::PHASE_TYPE::GAS ).value = { std::log( 1. ), std::log( 1. ), std::log( 1. ) };
-    m_lnFugacity.at( pvt::PHASE_TYPE::LIQUID_WATER_RICH ).value = { std::log( 1. ), std::log( 1. ), std::log( 1. ) };
+    setMoleComposition( pvt::PHASE_TYPE::OIL, { 1., 0., 0. } );
+    setMoleComposition( pvt::PHASE_TYPE::GAS, { 0., 1., 0. } );
+    setMoleComposition( pvt::PHASE_TYPE::LIQUID_WATER_RICH, { 0., 0., 1. } );
   }
   else // nPhases = 2 
   {
     // the system is either oil-water or oil-gas
     
-    m_moleComposition.at( pvt::PHASE_TYPE::OIL ).value = { 1., 0. };
-    m_lnFugacity.at( pvt::PHASE_TYPE::OIL ).value = { std::log( 1. ), std::log( 1. ) };
+    setMoleComposition( pvt::PHASE_TYPE::OIL, { 1., 0. } );
 
     bool const containsGas = std::find( phases.cbegin(), phases.cend(), pvt::PHASE_TYPE::GAS ) != phases.cend();
     if( containsGas )
     {      
-      m_moleComposition.at( pvt::PHASE_TYPE::GAS ).value = { 0., 1. };
-      m_lnFugacity.at( pvt::PHASE_TYPE::GAS ).value = { std::log( 1. ), std::log( 1. ) };
+      setMoleComposition( pvt::PHASE_TYPE::GAS, { 0., 1. } );
     }
     else
     {     
-      m_moleComposition.at( pvt::PHASE_TYPE::LIQUID_WATER_RICH ).value = { 0., 1. };
-      m_lnFugacity.at( pvt::PHASE_TYPE::LIQUID_WATER_RICH ).value = { std::log( 1. ), std::log( 1. ) };
+      setMoleComposition( pvt::PHASE_TYPE::LIQUID_WATER_RICH, { 0., 1. } );
     }
   }
 }
 
 double DeadOilFlashMultiphaseSystemProperties::getOilPhaseMoleFraction() const
 {
-  return m_phaseMoleFraction.at( pvt::PHASE_TYPE::OIL ).value;
+  return getRecord( pvt::PHASE_TYPE::OIL, PROPERTY::PHASE_MOLE_FRACTION )[VALUE];
 }
 
 double DeadOilFlashMultiphaseSystemProperties::getGasPhaseMoleFraction() const
 {
-  return m_phaseMoleFraction.at( pvt::PHASE_TYPE::GAS ).value;
+  return getRecord( pvt::PHASE_TYPE::GAS, PROPERTY::PHASE_MOLE_FRACTION )[VALUE];
 }
 
 double DeadOilFlashMultiphaseSystemProperties::getWaterPhaseMoleFraction() const
 {
-  return m_phaseMoleFraction.at( pvt::PHASE_TYPE::LIQUID_WATER_RICH ).value;
+  return getRecord( pvt::PHASE_TYPE::LIQUID_WATER_RICH, PROPERTY::PHASE_MOLE_FRACTION )[VALUE];
 }
 
 void DeadOilFlashMultiphaseSystemProperties::setFeed( std::vector< double > const & feed )
@@ -93,11 +78,11 @@ void DeadOilFlashMultiphaseSystemProperties::setFeed( std::vector< double > cons
 
   // TODO: ultimately, all these if statements should go away
   
-  m_phaseMoleFraction.at( pvt::PHASE_TYPE::OIL ).value = feed[0];
+  setPhaseMoleFraction( pvt::PHASE_TYPE::OIL, feed[0] );
   if( nPhases == 3 )
   {  
-    m_phaseMoleFraction.at( pvt::PHASE_TYPE::GAS ).value = feed[1];
-    m_phaseMoleFraction.at( pvt::PHASE_TYPE::LIQUID_WATER_RICH ).value = feed[2];
+    setPhaseMoleFraction( pvt::PHASE_TYPE::GAS, feed[1] );
+    setPhaseMoleFraction( pvt::PHASE_TYPE::LIQUID_WATER_RICH, feed[2] );
   }
   else // nPhases = 2 
   {
@@ -105,11 +90,11 @@ void DeadOilFlashMultiphaseSystemProperties::setFeed( std::vector< double > cons
     bool const containsGas = std::find( getPhases().cbegin(), getPhases().cend(), pvt::PHASE_TYPE::GAS ) != getPhases().end();
     if( containsGas )
     {
-      m_phaseMoleFraction.at( pvt::PHASE_TYPE::GAS ).value = feed[1];
+      setPhaseMoleFraction( pvt::PHASE_TYPE::GAS, feed[1] );
     }
     else
     {
-      m_phaseMoleFraction.at( pvt::PHASE_TYPE::LIQUID_WATER_RICH ).value = feed[1];
+      setPhaseMoleFraction( pvt::PHASE_TYPE::LIQUID_WATER_RICH, feed[1] );
     }
     
   }
@@ -22,7 +22,6 @@
 
 #include "pvt/pvt.hpp"
 
-#include <map>
 #include <vector>
 
 namespace PVTPackage
@@ -41,11 +40,6 @@ public:
   double getWaterPhaseMoleFraction() const;
 
   void setFeed( std::vector< double > const & feed ) final;
-
-private:
-
-  // I shall not need this because values are constants
-  std::map< pvt::PHASE_TYPE, pvt::VectorPropertyAndDerivatives< double > > m_lnFugacity;
 };
 
 }
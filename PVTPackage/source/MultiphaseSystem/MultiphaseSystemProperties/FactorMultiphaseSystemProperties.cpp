@@ -15,53 +15,81 @@
 
 #include "FactorMultiphaseSystemProperties.hpp"
 
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
 namespace PVTPackage
 {
 
 FactorMultiphaseSystemProperties::FactorMultiphaseSystemProperties( std::vector< pvt::PHASE_TYPE > const & phases,
                                                                     std::size_t nComponents )
   :
-  m_phases( phases )
+  m_phases( phases ),
+  m_nComponents( nComponents ),
+  m_data( phases.size() * ( s_nScalarProperties + nComponents ) * ( DZ + nComponents ), 0. )
+{
+  m_phaseIndices.fill( m_phases.size() );
+  for( std::size_t i = 0; i < m_phases.size(); ++i )
+  {
+    const int phaseValue = static_cast< int >( m_phases[i] );
+    if( phaseValue >= 0 and phaseValue < static_cast< int >( m_phaseIndices.size() ) )
+    {
+      m_phaseIndices[phaseValue] = i;
+    }
+  }
+}
+
+std::size_t FactorMultiphaseSystemProperties::getPhaseIndex( pvt::PHASE_TYPE const & phase ) const
 {
-  for( pvt::PHASE_TYPE pt: m_phases )
+  const int phaseValue = static_cast< int >( phase );
+  if( phaseValue < 0 or phaseValue >= static_cast< int >( m_phaseIndices.size() ) or m_phaseIndices[phaseValue] == m_phases.size() )
   {
-    m_massDensity.insert( { pt, pvt::ScalarPropertyAndDerivatives< double >( nComponents ) } );
-    m_moleComposition.insert( { pt, pvt::VectorPropertyAndDerivatives< double >( nComponents, nComponents ) } );
-    m_moleDensity.insert( { pt, pvt::ScalarPropertyAndDerivatives< double >( nComponents ) } );
-    m_viscosity.insert( {pt, pvt::ScalarPropertyAndDerivatives< double >( nComponents ) } ); 
-    m_molecularWeight.insert( { pt, pvt::ScalarPropertyAndDerivatives< double >( nComponents ) } );
-    m_phaseMoleFraction.insert( { pt, pvt::ScalarPropertyAndDerivatives< double >( nComponents ) } );
+    throw std::out_of_range( "Phase " + std::to_string( phaseValue ) + " is not defined" );
   }
+  return m_phaseIndices[phaseValue];
 }
 
-pvt::ScalarPropertyAndDerivatives< double > const & FactorMultiphaseSystemProperties::getMassDensity( pvt::PHASE_TYPE const & phase ) const
+std::size_t FactorMultiphaseSystemProperties::getRecordOffset( std::size_t phaseIndex,
+                                                               PROPERTY const & property ) const
 {
-  return m_massDensity.at( phase );
+  return ( phaseIndex * ( s_nScalarProperties + m_nComponents ) + static_cast< std::size_t >( property ) ) * getRecordSize();
 }
 
-pvt::VectorPropertyAndDerivatives< double > const & FactorMultiphaseSystemProperties::getMoleComposition( pvt::PHASE_TYPE const & phase ) const
+pvt::ScalarPropertyAndDerivativesView< double > FactorMultiphaseSystemProperties::getScalarView( pvt::PHASE_TYPE const & phase,
+                                                                                                PROPERTY const & property ) const
 {
-  return m_moleComposition.at( phase );
+  return pvt::ScalarPropertyAndDerivativesView< double >( getRecord( phase, property ), m_nComponents );
 }
 
-pvt::ScalarPropertyAndDerivatives< double > const & FactorMultiphaseSystemProperties::getMoleDensity( pvt::PHASE_TYPE const & phase ) const
+pvt::ScalarPropertyAndDerivativesView< double > FactorMultiphaseSystemProperties::getMassDensity( pvt::PHASE_TYPE const & phase ) const
 {
-  return m_moleDensity.at( phase );
+  return getScalarView( phase, PROPERTY::MASS_DENSITY );
 }
 
-pvt::ScalarPropertyAndDerivatives< double > const & FactorMultiphaseSystemProperties::getViscosity( pvt::PHASE_TYPE const & phase ) const
+pvt::VectorPropertyAndDerivativesView< double > FactorMultiphaseSystemProperties::getMoleComposition( pvt::PHASE_TYPE const & phase ) const
 {
-  return m_viscosity.at( phase );
+  return pvt::VectorPropertyAndDerivativesView< double >( getRecord( phase, PROPERTY::MOLE_COMPOSITION ), m_nComponents, m_nComponents );
 }
-  
-pvt::ScalarPropertyAndDerivatives< double > const & FactorMultiphaseSystemProperties::getMolecularWeight( pvt::PHASE_TYPE const & phase ) const
+
+pvt::ScalarPropertyAndDerivativesView< double > FactorMultiphaseSystemProperties::getMoleDensity( pvt::PHASE_TYPE const & phase ) const
+{
+  return getScalarView( phase, PROPERTY::MOLE_DENSITY );
+}
+
+pvt::ScalarPropertyAndDerivativesView< double > FactorMultiphaseSystemProperties::getViscosity( pvt::PHASE_TYPE const & phase ) const
 {
-  return m_molecularWeight.at( phase );
+  return getScalarView( phase, PROPERTY::VISCOSITY );
 }
 
-pvt::ScalarPropertyAndDerivatives< double > const & FactorMultiphaseSystemProperties::getPhaseMoleFraction( pvt::PHASE_TYPE const & phase ) const
+pvt::ScalarPropertyAndDerivativesView< double > FactorMultiphaseSystemProperties::getMolecularWeight( pvt::PHASE_TYPE const & phase ) const
 {
-  return m_phaseMoleFraction.at( phase );
+  return getScalarView( phase, PROPERTY::MOLECULAR_WEIGHT );
+}
+
+pvt::ScalarPropertyAndDerivativesView< double > FactorMultiphaseSystemProperties::getPhaseMoleFraction( pvt::PHASE_TYPE const & phase ) const
+{
+  return getScalarView( phase, PROPERTY::PHASE_MOLE_FRACTION );
 }
 
 double const & FactorMultiphaseSystemProperties::getPressure() const
@@ -89,53 +117,108 @@ const std::vector< pvt::PHASE_TYPE > & FactorMultiphaseSystemProperties::getPhas
   return m_phases;
 }
 
+std::size_t FactorMultiphaseSystemProperties::getNComponents() const
+{
+  return m_nComponents;
+}
+
+std::size_t FactorMultiphaseSystemProperties::getRecordSize() const
+{
+  return DZ + m_nComponents;
+}
+
+double const * FactorMultiphaseSystemProperties::getRecord( pvt::PHASE_TYPE const & phase,
+                                                            PROPERTY const & property ) const
+{
+  return &m_data[getRecordOffset( getPhaseIndex( phase ), property )];
+}
+
+void FactorMultiphaseSystemProperties::setFiniteDifferenceDerivatives( FactorMultiphaseSystemProperties const & perturbed,
+                                                                       std::size_t entry,
+                                                                       double delta )
+{
+  const std::size_t recordSize = getRecordSize();
+  for( std::size_t offset = 0; offset < m_data.size(); offset += recordSize )
+  {
+    m_data[offset + entry] = ( perturbed.m_data[offset + VALUE] - m_data[offset + VALUE] ) / delta;
+  }
+}
+
+void FactorMultiphaseSystemProperties::resetDerivatives()
+{
+  const std::size_t recordSize = getRecordSize();
+  for( std::size_t offset = 0; offset < m_data.size(); offset += recordSize )
+  {
+    std::fill( m_data.begin() + offset + DP, m_data.begin() + offset + recordSize, 0. );
+  }
+}
+
+void FactorMultiphaseSystemProperties::setRecordEntry( pvt::PHASE_TYPE const & phase,
+                                                       PROPERTY const & property,
+                                                       std::size_t entry,
+                                                       double const & value )
+{
+  m_data[getRecordOffset( getPhaseIndex( phase ), property ) + entry] = value;
+}
+
+void FactorMultiphaseSystemProperties::setMoleCompositionEntry( pvt::PHASE_TYPE const & phase,
+                                                                std::size_t entry,
+                                                                std::vector< double > const & values )
+{
+  const std::size_t recordSize = getRecordSize();
+  double * record = &m_data[getRecordOffset( getPhaseIndex( phase ), PROPERTY::MOLE_COMPOSITION )];
+  for( std::size_t ic = 0; ic < m_nComponents; ++ic, record += recordSize )
+  {
+    record[entry] = values[ic];
+  }
+}
+
 void FactorMultiphaseSystemProperties::setPhaseMoleFraction( pvt::PHASE_TYPE const & phase,
                                                              double const & phaseMoleFraction )
 {
-  m_phaseMoleFraction.at( phase ).value = phaseMoleFraction;
-
+  setRecordEntry( phase, PROPERTY::PHASE_MOLE_FRACTION, VALUE, phaseMoleFraction );
 }
 
 void FactorMultiphaseSystemProperties::setMoleComposition( const pvt::PHASE_TYPE & phase,
                                                            const std::vector< double > & moleComposition )
 {
-  m_moleComposition.at( phase ).value = moleComposition;
+  setMoleCompositionEntry( phase, VALUE, moleComposition );
 }
 
 void FactorMultiphaseSystemProperties::setPhaseMoleFractionDP( pvt::PHASE_TYPE const & phase,
                                                                double const & value )
 {
-  m_phaseMoleFraction.at( phase ).dP = value;
+  setRecordEntry( phase, PROPERTY::PHASE_MOLE_FRACTION, DP, value );
 }
 
 void FactorMultiphaseSystemProperties::setMolecularWeightDP( pvt::PHASE_TYPE const & phase,
                                                              double const & value )
 {
-  m_molecularWeight.at( phase ).dP = value;
+  setRecordEntry( phase, PROPERTY::MOLECULAR_WEIGHT, DP, value );
 }
 
 void FactorMultiphaseSystemProperties::setMoleDensityDP( pvt::PHASE_TYPE const & phase,
                                                          double const & value )
 {
-  m_moleDensity.at( phase ).dP = value;
+  setRecordEntry( phase, PROPERTY::MOLE_DENSITY, DP, value );
 }
 
 void FactorMultiphaseSystemProperties::setMassDensityDP( pvt::PHASE_TYPE const & phase,
                                                          double const & value )
 {
-  m_massDensity.at( phase ).dP = value;
+  setRecordEntry( phase, PROPERTY::MASS_DENSITY, DP, value );
 }
 
 void FactorMultiphaseSystemProperties::setViscosityDP( pvt::PHASE_TYPE const & phase,
                                                        double const & value )
 {
-  m_viscosity.at( phase ).dP = value;
+  setRecordEntry( phase, PROPERTY::VISCOSITY, DP, value );
 }
-  
+
 void FactorMultiphaseSystemProperties::setMoleCompositionDP( pvt::PHASE_TYPE const & phase,
                                                              std::vector< double > const & value )
 {
-  m_moleComposition.at( phase ).dP = value;
+  setMoleCompositionEntry( phase, DP, value );
 }
 
 /// DZ
@@ -144,47 +227,42 @@ void FactorMultiphaseSystemProperties::setPhaseMoleFractionDZ( pvt::PHASE_TYPE c
                                                                std::size_t i,
                                                                double const & value )
 {
-  m_phaseMoleFraction.at( phase ).dz[i] = value;
+  setRecordEntry( phase, PROPERTY::PHASE_MOLE_FRACTION, DZ + i, value );
 }
 
 void FactorMultiphaseSystemProperties::setMolecularWeightDZ( pvt::PHASE_TYPE const & phase,
                                                              std::size_t i,
                                                              double const & value )
 {
-  m_molecularWeight.at( phase ).dz[i] = value;
+  setRecordEntry( phase, PROPERTY::MOLECULAR_WEIGHT, DZ + i, value );
 }
 
 void FactorMultiphaseSystemProperties::setMoleDensityDZ( pvt::PHASE_TYPE const & phase,
                                                          std::size_t i,
                                                          double const & value )
 {
-  m_moleDensity.at( phase ).dz[i] = value;
+  setRecordEntry( phase, PROPERTY::MOLE_DENSITY, DZ + i, value );
 }
 
 void FactorMultiphaseSystemProperties::setMassDensityDZ( pvt::PHASE_TYPE const & phase,
                                                          std::size_t i,
                                                          double const & value )
 {
-  m_massDensity.at( phase ).dz[i] = value;
+  setRecordEntry( phase, PROPERTY::MASS_DENSITY, DZ + i, value );
 }
 
 void FactorMultiphaseSystemProperties::setViscosityDZ( pvt::PHASE_TYPE const & phase,
                                                        std::size_t i,
                                                        double const & value )
 {
-  m_viscosity.at( phase ).dz[i] = value;
+  setRecordEntry( phase, PROPERTY::VISCOSITY, DZ + i, value );
 }
 
 void FactorMultiphaseSystemProperties::setMoleCompositionDZ( pvt::PHASE_TYPE const & phase,
                                                              std::size_t i,
                                                              std::vector< double > const & value )
 {
-  // FIXME That would be more elegant with indices in the opposite order and a direct vector assignment.
-  pvt::VectorPropertyAndDerivatives< double > & mcp = m_moleComposition.at( phase );
-  for( std::size_t j = 0; j < mcp.value.size(); ++j )
-  {
-    mcp.dz[j][i] = value[j];
-  }
+  setMoleCompositionEntry( phase, DZ + i, value );
 }
 
 }
@@ -18,29 +18,53 @@
 
 #include "pvt/pvt.hpp"
 
-#include <map>
+#include <array>
+#include <vector>
 
 namespace PVTPackage
 {
 
+/**
+ * @brief Phase properties and their derivatives, stored in one contiguous buffer.
+ *
+ * Each property of each phase is stored as a record of getRecordSize() doubles:
+ * the value, its pressure and temperature derivatives, then its derivatives w.r.t. feed.
+ * The buffer is laid out as [phase][property][record], phases being in the order of getPhases().
+ * The mole composition, last property of a phase, holds one record per component.
+ *
+ * The public getters return views of the buffer, which is allocated once at construction:
+ * they remain valid as long as the properties, and reflect the last computation.
+ */
 class FactorMultiphaseSystemProperties : public pvt::MultiphaseSystemProperties
 {
 public:
 
+  /// The properties stored for each phase, in storage order.
+  enum class PROPERTY : std::size_t
+  {
+    MASS_DENSITY = 0, MOLE_DENSITY = 1, VISCOSITY = 2, MOLECULAR_WEIGHT = 3, PHASE_MOLE_FRACTION = 4, MOLE_COMPOSITION = 5
+  };
+
+  /// The positions of the value and its derivatives in a record.
+  enum RECORD_ENTRY : std::size_t
+  {
+    VALUE = 0, DP = 1, DT = 2, DZ = 3
+  };
+
   FactorMultiphaseSystemProperties( const std::vector< pvt::PHASE_TYPE > & phases,
                                     std::size_t nComponents );
 
-  pvt::ScalarPropertyAndDerivatives< double > const & getMassDensity( pvt::PHASE_TYPE const & phase ) const final;
+  pvt::ScalarPropertyAndDerivativesView< double > getMassDensity( pvt::PHASE_TYPE const & phase ) const final;
 
-  pvt::ScalarPropertyAndDerivatives< double > const & getViscosity( pvt::PHASE_TYPE const & phase ) const final;
+  pvt::ScalarPropertyAndDerivativesView< double > getViscosity( pvt::PHASE_TYPE const & phase ) const final;
   
-  pvt::VectorPropertyAndDerivatives< double > const & getMoleComposition( pvt::PHASE_TYPE const & phase ) const final;
+  pvt::VectorPropertyAndDerivativesView< double > getMoleComposition( pvt::PHASE_TYPE const & phase ) const final;
 
-  pvt::ScalarPropertyAndDerivatives< double > const & getMoleDensity( pvt::PHASE_TYPE const & phase ) const final;
+  pvt::ScalarPropertyAndDerivativesView< double > getMoleDensity( pvt::PHASE_TYPE const & phase ) const final;
 
-  pvt::ScalarPropertyAndDerivatives< double > const & getMolecularWeight( pvt::PHASE_TYPE const & phase ) const final;
+  pvt::ScalarPropertyAndDerivativesView< double > getMolecularWeight( pvt::PHASE_TYPE const & phase ) const final;
 
-  pvt::ScalarPropertyAndDerivatives< double > const & getPhaseMoleFraction( pvt::PHASE_TYPE const & phase ) const final;
+  pvt::ScalarPropertyAndDerivativesView< double > getPhaseMoleFraction( pvt::PHASE_TYPE const & phase ) const final;
 
   double const & getPressure() const;
 
@@ -52,6 +76,40 @@ public:
 
   const std::vector< pvt::PHASE_TYPE > & getPhases() const;
 
+  std::size_t getNComponents() const;
+
+  /**
+   * @brief Number of doubles of one record (value and derivatives).
+   * @return The record size.
+   */
+  std::size_t getRecordSize() const;
+
+  /**
+   * @brief Direct access to the record of @p property for @p phase.
+   * @param phase The phase.
+   * @param property The property. For the mole composition, the getNComponents() records are consecutive.
+   * @return A pointer to the first entry of the record.
+   * @throw std::out_of_range if @p phase does not exist.
+   */
+  double const * getRecord( pvt::PHASE_TYPE const & phase,
+                            PROPERTY const & property ) const;
+
+  /**
+   * @brief Sets the derivatives at @p entry of all the records, by finite differences with @p perturbed.
+   * @param perturbed The properties computed for a perturbed input, with the same phases.
+   * @param entry The derivative to set: DP, DT or DZ plus the component index.
+   * @param delta The finite difference step.
+   */
+  void setFiniteDifferenceDerivatives( FactorMultiphaseSystemProperties const & perturbed,
+                                       std::size_t entry,
+                                       double delta );
+
+  /**
+   * @brief Zeroes the derivatives of all the records, the values being kept.
+   * @note Analytical flashes call it before setting the derivatives they compute.
+   */
+  void resetDerivatives();
+
   void setPhaseMoleFractionDP( pvt::PHASE_TYPE const & phase,
                                double const & value );
 
@@ -96,24 +154,62 @@ public:
 
 protected:
 
-  std::map< pvt::PHASE_TYPE, pvt::ScalarPropertyAndDerivatives< double > > m_massDensity;
-  std::map< pvt::PHASE_TYPE, pvt::VectorPropertyAndDerivatives< double > > m_moleComposition;
-  std::map< pvt::PHASE_TYPE, pvt::ScalarPropertyAndDerivatives< double > > m_moleDensity;
-  std::map< pvt::PHASE_TYPE, pvt::ScalarPropertyAndDerivatives< double > > m_viscosity;  
-  std::map< pvt::PHASE_TYPE, pvt::ScalarPropertyAndDerivatives< double > > m_molecularWeight;
-  std::map< pvt::PHASE_TYPE, pvt::ScalarPropertyAndDerivatives< double > > m_phaseMoleFraction;
-  
+  /**
+   * @brief Sets one entry of the record of @p property for @p phase.
+   * @param phase The phase.
+   * @param property A scalar property (not the mole composition).
+   * @param entry The entry of the record (VALUE, DP, DT or DZ plus the component index).
+   * @param value The new value.
+   */
+  void setRecordEntry( pvt::PHASE_TYPE const & phase,
+                       PROPERTY const & property,
+                       std::size_t entry,
+                       double const & value );
+
+  /**
+   * @brief Sets one entry of the mole composition records of @p phase.
+   * @param phase The phase.
+   * @param entry The entry of the records (VALUE, DP, DT or DZ plus the component index).
+   * @param values The new values, one per component.
+   */
+  void setMoleCompositionEntry( pvt::PHASE_TYPE const & phase,
+                                std::size_t entry,
+                                std::vector< double > const & values );
+
   void setPhaseMoleFraction( pvt::PHASE_TYPE const & phase,
                              const double & phaseMoleFraction );
 
   void setMoleComposition( pvt::PHASE_TYPE const & phase,
                            const std::vector< double > & moleComposition );
 
+  /**
+   * @brief Position of @p phase in the phases of the system.
+   * @param phase The phase.
+   * @return The index, in [0, number of phases).
+   * @throw std::out_of_range if @p phase is not defined.
+   */
+  std::size_t getPhaseIndex( pvt::PHASE_TYPE const & phase ) const;
+
 private:
 
+  /// Number of scalar properties, stored before the mole composition.
+  static constexpr std::size_t s_nScalarProperties = static_cast< std::size_t >( PROPERTY::MOLE_COMPOSITION );
+
+  std::size_t getRecordOffset( std::size_t phaseIndex,
+                               PROPERTY const & property ) const;
+
+  pvt::ScalarPropertyAndDerivativesView< double > getScalarView( pvt::PHASE_TYPE const & phase,
+                                                                PROPERTY const & property ) const;
+
   std::vector< pvt::PHASE_TYPE > m_phases;
+  std::size_t m_nComponents;
   double m_pressure;
   std::vector< double > m_feed;
+
+  /// Index in m_phases of each pvt::PHASE_TYPE (by value), or m_phases.size() if the phase is not defined.
+  std::array< std::size_t, 3 > m_phaseIndices;
+  /// The records of all the properties of all the phases.
+  std::vector< double > m_data;
 };
 
 }
@@ -38,17 +38,17 @@ void FreeWaterFlashMultiphaseSystemProperties::setWaterFraction( double const &
 
 std::vector< double > const & FreeWaterFlashMultiphaseSystemProperties::getOilLnFugacity() const
 {
-  return m_lnFugacity.at( pvt::PHASE_TYPE::OIL );
+  return m_lnFugacity[getPhaseIndex( pvt::PHASE_TYPE::OIL )];
 }
 
 std::vector< double > const & FreeWaterFlashMultiphaseSystemProperties::getGasLnFugacity() const
 {
-  return m_lnFugacity.at( pvt::PHASE_TYPE::GAS );
+  return m_lnFugacity[getPhaseIndex( pvt::PHASE_TYPE::GAS )];
 }
 
 std::vector< double > const & FreeWaterFlashMultiphaseSystemProperties::getWaterLnFugacity() const
 {
-  return m_lnFugacity.at( pvt::PHASE_TYPE::LIQUID_WATER_RICH );
+  return m_lnFugacity[getPhaseIndex( pvt::PHASE_TYPE::LIQUID_WATER_RICH )];
 }
 
 }
@@ -28,12 +28,12 @@ NegativeTwoPhaseFlashMultiphaseSystemProperties::NegativeTwoPhaseFlashMultiphase
 
 std::vector< double > const & NegativeTwoPhaseFlashMultiphaseSystemProperties::getOilLnFugacity() const
 {
-  return m_lnFugacity.at( pvt::PHASE_TYPE::OIL );
+  return m_lnFugacity[getPhaseIndex( pvt::PHASE_TYPE::OIL )];
 }
 
 std::vector< double > const & NegativeTwoPhaseFlashMultiphaseSystemProperties::getGasLnFugacity() const
 {
-  return m_lnFugacity.at( pvt::PHASE_TYPE::GAS );
+  return m_lnFugacity[getPhaseIndex( pvt::PHASE_TYPE::GAS )];
 }
 
 }
@@ -30,13 +30,17 @@ std::unique_ptr< NegativeTwoPhaseMultiphaseSystem > NegativeTwoPhaseMultiphaseSy
                                                                                              const std::vector< double > & componentMolarWeights,
                                                                                              const std::vector< double > & componentCriticalTemperatures,
                                                                                              const std::vector< double > & componentCriticalPressures,
-                                                                                             const std::vector< double > & componentOmegas )
+                                                                                             const std::vector< double > & componentOmegas,
+                                                                                             const std::vector< std::vector< double > > & componentBinaryInteractionCoefficients,
+                                                                                             const std::vector< std::vector< double > > & componentVolumeShifts )
 {
   if( not areComponentDataConsistent( componentNames,
                                       componentMolarWeights,
                                       componentCriticalTemperatures,
                                       componentCriticalPressures,
-                                      componentOmegas ) )
+                                      componentOmegas,
+                                      componentBinaryInteractionCoefficients,
+                                      componentVolumeShifts ) )
   {
     return std::unique_ptr< NegativeTwoPhaseMultiphaseSystem >();
   }
@@ -46,7 +50,9 @@ std::unique_ptr< NegativeTwoPhaseMultiphaseSystem > NegativeTwoPhaseMultiphaseSy
                           componentMolarWeights,
                           componentCriticalTemperatures,
                           componentCriticalPressures,
-                          componentOmegas );
+                          componentOmegas,
+                          componentBinaryInteractionCoefficients,
+                          componentVolumeShifts );
 
   // I am not using std::make_unique because I want the constructor to be private.
   auto * ptr = new NegativeTwoPhaseMultiphaseSystem( phases, eosTypes, cp );
@@ -66,14 +72,46 @@ NegativeTwoPhaseMultiphaseSystem::NegativeTwoPhaseMultiphaseSystem( const std::v
 void NegativeTwoPhaseMultiphaseSystem::Update( double pressure,
                                                double temperature,
                                                std::vector< double > feed )
+{
+  m_stateIndicator = solve( pressure, temperature, feed ) ? State::SUCCESS : State::NOT_CONVERGED;
+}
+
+void NegativeTwoPhaseMultiphaseSystem::UpdateCell( std::size_t cellIndex,
+                                                   double pressure,
+                                                   double temperature,
+                                                   std::vector< double > feed )
+{
+  auto solver = [this]( double p, double t, std::vector< double > const & z )
+  {
+    return solve( p, t, z );
+  };
+  const bool success = solveCell( cellIndex, pressure, temperature, feed, m_ntpfmsp, solver );
+  m_stateIndicator = success ? State::SUCCESS : State::NOT_CONVERGED;
+}
+
+bool NegativeTwoPhaseMultiphaseSystem::BatchUpdate( std::size_t nCells,
+                                                    double const * pressures,
+                                                    double const * temperatures,
+                                                    double const * feeds,
+                                                    pvt::MultiphaseSystemBatchProperties const & outputs )
+{
+  auto solver = [this]( double pressure, double temperature, std::vector< double > const & feed )
+  {
+    return solve( pressure, temperature, feed );
+  };
+  return batchUpdate( nCells, pressures, temperatures, feeds, m_ntpfmsp, outputs, solver );
+}
+
+bool NegativeTwoPhaseMultiphaseSystem::solve( double pressure,
+                                              double temperature,
+                                              std::vector< double > const & feed )
 {
   m_ntpfmsp.setTemperature( temperature );
   m_ntpfmsp.setPressure( pressure );
   m_ntpfmsp.setFeed( feed );
+  transferInitialKValues( m_ntpfmsp );
 
-  const bool result = computeEquilibriumAndDerivativesWithTemperature( m_negativeTwoPhaseFlash, m_ntpfmsp );
-
-  m_stateIndicator = result ? State::SUCCESS : State::NOT_CONVERGED;
+  return computeEquilibriumAndDerivatives( m_negativeTwoPhaseFlash, m_ntpfmsp );
 }
 
 const pvt::MultiphaseSystemProperties & NegativeTwoPhaseMultiphaseSystem::getMultiphaseSystemProperties() const
@@ -81,4 +119,34 @@ const pvt::MultiphaseSystemProperties & NegativeTwoPhaseMultiphaseSystem::getMul
   return m_ntpfmsp;
 }
 
+void NegativeTwoPhaseMultiphaseSystem::setPrecisionType( pvt::PRECISION_TYPE const & precisionType )
+{
+  m_negativeTwoPhaseFlash.setPrecisionType( precisionType );
+}
+
+void NegativeTwoPhaseMultiphaseSystem::setSsiAccelerationType( pvt::SSI_ACCELERATION_TYPE const & accelerationType )
+{
+  m_negativeTwoPhaseFlash.setSsiAccelerationType( accelerationType );
+}
+
+void NegativeTwoPhaseMultiphaseSystem::setStabilityTestEnabled( bool enabled )
+{
+  m_negativeTwoPhaseFlash.setStabilityTestEnabled( enabled );
+}
+
+pvt::FlashStatistics const & NegativeTwoPhaseMultiphaseSystem::getFlashStatistics() const
+{
+  return m_negativeTwoPhaseFlash.getStatistics();
+}
+
+void NegativeTwoPhaseMultiphaseSystem::resetFlashStatistics()
+{
+  m_negativeTwoPhaseFlash.resetStatistics();
+}
+
+std::vector< double > const & NegativeTwoPhaseMultiphaseSystem::getKValues() const
+{
+  return m_ntpfmsp.getKValues();
+}
+
 }
@@ -37,6 +37,35 @@ struct BlackOilDeadOilProperties
   {}
 };
 
+/**
+ * @brief The properties and their derivatives, taken from the same table interpolation stencils.
+ */
+struct BlackOilDeadOilPropertiesAndDerivatives
+{
+  BlackOilDeadOilProperties value{ 0., 0., 0. };
+  /// Derivatives w.r.t. pressure (along the saturation curve for the saturated properties).
+  BlackOilDeadOilProperties dP{ 0., 0., 0. };
+  /// Derivatives w.r.t. the dissolved gas ratio Rs, at constant pressure. Only the undersaturated oil depends on it.
+  BlackOilDeadOilProperties dRs{ 0., 0., 0. };
+};
+
+/**
+ * @brief Caller-owned buffers receiving the evaluation of a phase model over many pressures, one entry per pressure.
+ * All the buffers must be set.
+ */
+struct BlackOilDeadOilBatchProperties
+{
+  /// Formation volume factor and its pressure derivative.
+  double * B = nullptr;
+  double * dB_dP = nullptr;
+  double * massDensity = nullptr;
+  double * dMassDensity_dP = nullptr;
+  double * moleDensity = nullptr;
+  double * dMoleDensity_dP = nullptr;
+  double * viscosity = nullptr;
+  double * dViscosity_dP = nullptr;
+};
+
 }
 
 #endif //PVTPACKAGE_BLACKOILDEADOILPROPERTIES_HPP
@@ -51,6 +51,11 @@ BlackOil_GasModel::BlackOil_GasModel( const std::vector< std::vector< double > >
   //Check Consistency
   //checkTableConsistency();
 
+  //Storage used by the evaluations
+  packTable();
+
+  //Interval searches
+  createTableIndices();
 
   ///DEBUG PURPOSE - PLOT table for matlab
 //		std::ofstream outputFile("PVTG.txt");
@@ -255,29 +260,58 @@ void BlackOil_GasModel::refineTable( std::size_t nLevel )
   //}
 }
 
-double BlackOil_GasModel::computePdew( double Rv ) const
+void BlackOil_GasModel::packTable()
+{
+  //The undersaturated branches are ignored (dry gas), the evaluations only read the saturated properties
+  m_PVTG.SaturatedBgViscosity.resize( 2 * m_PVTG.NSaturatedPoints );
+  for( std::size_t i = 0; i < m_PVTG.NSaturatedPoints; ++i )
+  {
+    m_PVTG.SaturatedBgViscosity[2 * i] = m_PVTG.SaturatedBg[i];
+    m_PVTG.SaturatedBgViscosity[2 * i + 1] = m_PVTG.SaturatedViscosity[i];
+  }
+}
+
+void BlackOil_GasModel::createTableIndices()
+{
+  m_RvIndex = math::TableIndex< double >( m_PVTG.Rv );
+  m_dewPressureIndex = math::TableIndex< double >( m_PVTG.DewPressure );
+}
+
+double BlackOil_GasModel::computePdew( double Rv,
+                                       SearchHints * hints ) const
 {
   std::size_t i_lower_branch, i_upper_branch;
-  math::FindSurrondingIndex( m_PVTG.Rv, Rv, i_lower_branch, i_upper_branch );
+  m_RvIndex.find( m_PVTG.Rv, Rv, i_lower_branch, i_upper_branch, hints == nullptr ? nullptr : &hints->Rv );
   return math::LinearInterpolation( m_PVTG.Rv[i_lower_branch], m_PVTG.DewPressure[i_lower_branch], m_PVTG.Rv[i_upper_branch], m_PVTG.DewPressure[i_upper_branch], Rv );
 }
 
-double BlackOil_GasModel::computeRv( double Pdew ) const
+double BlackOil_GasModel::computeRv( double Pdew,
+                                     SearchHints * hints ) const
+{
+  double dRv_dPdew;
+  return computeRv( Pdew, dRv_dPdew, hints );
+}
+
+double BlackOil_GasModel::computeRv( double Pdew,
+                                     double & dRv_dPdew,
+                                     SearchHints * hints ) const
 {
   ASSERT( ( Pdew < m_maxPressure ) & ( Pdew > m_minPressure ), "Pressure out of table range" );
   std::size_t i_lower_branch, i_upper_branch;
-  math::FindSurrondingIndex( m_PVTG.DewPressure, Pdew, i_lower_branch, i_upper_branch );
+  m_dewPressureIndex.find( m_PVTG.DewPressure, Pdew, i_lower_branch, i_upper_branch, hints == nullptr ? nullptr : &hints->dewPressure );
+  dRv_dPdew = ( m_PVTG.Rv[i_upper_branch] - m_PVTG.Rv[i_lower_branch] ) / ( m_PVTG.DewPressure[i_upper_branch] - m_PVTG.DewPressure[i_lower_branch] );
   return math::LinearInterpolation( m_PVTG.DewPressure[i_lower_branch], m_PVTG.Rv[i_lower_branch], m_PVTG.DewPressure[i_upper_branch], m_PVTG.Rv[i_upper_branch], Pdew );
 }
 
 BlackOilDeadOilProperties BlackOil_GasModel::computeSaturatedProperties( double Pdew,
                                                                          double oilMoleSurfaceDensity,
-                                                                         double oilMassSurfaceDensity ) const
+                                                                         double oilMassSurfaceDensity,
+                                                                         SearchHints * hints ) const
 {
   ASSERT( ( Pdew < m_maxPressure ) & ( Pdew > m_minPressure ), "Pressure out of table range" );
-  auto Rv = computeRv( Pdew );
+  auto Rv = computeRv( Pdew, hints );
   double Bg, viscosity;
-  computeBgVisc( Pdew, Bg, viscosity );
+  computeBgVisc( Pdew, Bg, viscosity, hints );
 
   return BlackOilDeadOilProperties(
     computeMassDensity( Rv, Bg, oilMassSurfaceDensity ),
@@ -286,16 +320,43 @@ BlackOilDeadOilProperties BlackOil_GasModel::computeSaturatedProperties( double
   );
 }
 
+BlackOilDeadOilPropertiesAndDerivatives BlackOil_GasModel::computeSaturatedPropertiesAndDerivatives( double Pdew,
+                                                                                                 double oilMoleSurfaceDensity,
+                                                                                                 double oilMassSurfaceDensity,
+                                                                                                 SearchHints * hints ) const
+{
+  ASSERT( ( Pdew < m_maxPressure ) & ( Pdew > m_minPressure ), "Pressure out of table range" );
+  double dRv_dPdew;
+  auto Rv = computeRv( Pdew, dRv_dPdew, hints );
+  double Bg, viscosity;
+  computeBgVisc( Pdew, Bg, viscosity, hints );
+
+  BlackOilDeadOilPropertiesAndDerivatives result;
+  result.value = BlackOilDeadOilProperties(
+    computeMassDensity( Rv, Bg, oilMassSurfaceDensity ),
+    computeMoleDensity( Rv, Bg, oilMoleSurfaceDensity ),
+    viscosity
+  );
+  // The interpolation weights of computeBgVisc do not depend on the pressure inside an interval: Bg and the viscosity are constant there.
+  result.dP = BlackOilDeadOilProperties(
+    1. / Bg * oilMassSurfaceDensity * dRv_dPdew,
+    1. / Bg * oilMoleSurfaceDensity * dRv_dPdew,
+    0.
+  );
+  return result;
+}
+
 void BlackOil_GasModel::computeBgVisc( const double & pres,
                                        double & Bg,
-                                       double & viscosity ) const
+                                       double & viscosity,
+                                       SearchHints * hints ) const
 {
   std::size_t i_lower, i_upper;
-  auto const & Bg_vec = m_PVTG.SaturatedBg;
-  auto const & visc_vec = m_PVTG.SaturatedViscosity;
-  math::FindSurrondingIndex( m_PVTG.DewPressure, pres, i_lower, i_upper );
-  Bg = math::LinearInterpolation( m_PVTG.DewPressure[i_lower], Bg_vec[i_lower], m_PVTG.DewPressure[i_upper], Bg_vec[i_upper] );
-  viscosity = math::LinearInterpolation( m_PVTG.DewPressure[i_lower], visc_vec[i_lower], m_PVTG.DewPressure[i_upper], visc_vec[i_upper] );
+  m_dewPressureIndex.find( m_PVTG.DewPressure, pres, i_lower, i_upper, hints == nullptr ? nullptr : &hints->dewPressure );
+  double const * lower = &m_PVTG.SaturatedBgViscosity[2 * i_lower];
+  double const * upper = &m_PVTG.SaturatedBgViscosity[2 * i_upper];
+  Bg = math::LinearInterpolation( m_PVTG.DewPressure[i_lower], lower[0], m_PVTG.DewPressure[i_upper], upper[0] );
+  viscosity = math::LinearInterpolation( m_PVTG.DewPressure[i_lower], lower[1], m_PVTG.DewPressure[i_upper], upper[1] );
 }
   
 double BlackOil_GasModel::computeMoleDensity( double Rv,
@@ -19,6 +19,7 @@
 #include "PVTGdata.hpp"
 
 #include "Utils/Assert.hpp"
+#include "Utils/TableIndex.hpp"
 
 #include <map>
 #include <vector>
@@ -49,17 +50,45 @@ public:
     return m_surfaceMolecularWeight;
   }
 
-  double computeRv( double Pdew ) const;
+  /**
+   * @brief Intervals of the last lookups on the saturated axes, which nearby successive conditions start from.
+   *
+   * They are kept by the caller (e.g. one per flash), so that the model can be shared.
+   * The evaluations taking them as an optional last argument return the same results without them.
+   */
+  struct SearchHints
+  {
+    std::size_t Rv = 1;
+    std::size_t dewPressure = 1;
+  };
+
+  double computeRv( double Pdew,
+                    SearchHints * hints = nullptr ) const;
+
+  /// Same as above, @p dRv_dPdew receiving the derivative of Rv.
+  double computeRv( double Pdew,
+                    double & dRv_dPdew,
+                    SearchHints * hints = nullptr ) const;
 
   BlackOilDeadOilProperties computeSaturatedProperties( double Pdew,
                                                         double oilMoleSurfaceDensity,
-                                                        double oilMassSurfaceDensity ) const;
+                                                        double oilMassSurfaceDensity,
+                                                        SearchHints * hints = nullptr ) const;
+
+  BlackOilDeadOilPropertiesAndDerivatives computeSaturatedPropertiesAndDerivatives( double Pdew,
+                                                                                    double oilMoleSurfaceDensity,
+                                                                                    double oilMassSurfaceDensity,
+                                                                                    SearchHints * hints = nullptr ) const;
 
 private:
 
   //PVT data
   PVTGdata m_PVTG;
 
+  /// Interval searches of the saturated axes, Rv being possibly not monotonic
+  math::TableIndex< double > m_RvIndex;
+  math::TableIndex< double > m_dewPressureIndex;
+
   double m_minPressure;
   double m_maxPressure;
 
@@ -67,11 +96,13 @@ private:
   double m_surfaceMoleDensity;
   double m_surfaceMolecularWeight;
 
-  double computePdew( double Rv ) const;
+  double computePdew( double Rv,
+                      SearchHints * hints ) const;
 
   void computeBgVisc( const double & pres,
                       double & Bg,
-                      double & viscosity ) const;
+                      double & viscosity,
+                      SearchHints * hints ) const;
   
   double computeMoleDensity( double Rv,
                              double Bg,
@@ -88,6 +119,10 @@ private:
   void checkTableConsistency() const;
 
   static void refineTable( std::size_t nLevel );
+
+  void packTable();
+
+  void createTableIndices();
 };
 
 }
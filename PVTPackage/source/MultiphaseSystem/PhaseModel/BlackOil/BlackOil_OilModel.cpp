@@ -49,6 +49,12 @@ BlackOil_OilModel::BlackOil_OilModel( const std::vector< std::vector< double > >
   //Check Consistency
   checkTableConsistency();
 
+  //Dense storage of the refined branches
+  packTable();
+
+  //Interval searches
+  createTableIndices();
+
   ///DEBUG PURPOSE - PLOT table for matlab
 //		std::ofstream outputFile("PVTO.txt");
 //		for (size_t i =0 ; i<m_PVTO.NSaturatedPoints; ++i )
@@ -332,30 +338,89 @@ void BlackOil_OilModel::refineTable( std::size_t nLevel )
   }
 }
 
-double BlackOil_OilModel::computePb( double Rs ) const
+void BlackOil_OilModel::packTable()
+{
+  m_PVTO.SaturatedBoViscosity.resize( 2 * m_PVTO.NSaturatedPoints );
+  for( std::size_t i = 0; i < m_PVTO.NSaturatedPoints; ++i )
+  {
+    m_PVTO.SaturatedBoViscosity[2 * i] = m_PVTO.SaturatedBo[i];
+    m_PVTO.SaturatedBoViscosity[2 * i + 1] = m_PVTO.SaturatedViscosity[i];
+  }
+
+  //All the branches share the refined pressures
+  m_PVTO.RelativePressure = m_PVTO.UndersaturatedPressure[0];
+  const std::size_t nPressures = m_PVTO.RelativePressure.size();
+
+  m_PVTO.UndersaturatedBoViscosity.resize( 2 * m_PVTO.NSaturatedPoints * nPressures );
+  for( std::size_t i = 0; i < m_PVTO.NSaturatedPoints; ++i )
+  {
+    ASSERT( m_PVTO.UndersaturatedPressure[i] == m_PVTO.RelativePressure, "Undersaturated branches must share their pressures" );
+    double * row = &m_PVTO.UndersaturatedBoViscosity[2 * i * nPressures];
+    for( std::size_t j = 0; j < nPressures; ++j )
+    {
+      row[2 * j] = m_PVTO.UndersaturatedBo[i][j];
+      row[2 * j + 1] = m_PVTO.UndersaturatedViscosity[i][j];
+    }
+  }
+
+  //The branches are not used anymore
+  m_PVTO.UndersaturatedPressure.clear();
+  m_PVTO.UndersaturatedPressure.shrink_to_fit();
+  m_PVTO.UndersaturatedBo.clear();
+  m_PVTO.UndersaturatedBo.shrink_to_fit();
+  m_PVTO.UndersaturatedViscosity.clear();
+  m_PVTO.UndersaturatedViscosity.shrink_to_fit();
+}
+
+void BlackOil_OilModel::createTableIndices()
+{
+  m_RsIndex = math::TableIndex< double >( m_PVTO.Rs );
+  m_bubblePressureIndex = math::TableIndex< double >( m_PVTO.BubblePressure );
+  m_relativePressureIndex = math::TableIndex< double >( m_PVTO.RelativePressure );
+}
+
+BlackOil_OilModel::UndersaturatedBranch BlackOil_OilModel::getUndersaturatedBranch( std::size_t iBranch ) const
+{
+  return { m_PVTO.RelativePressure.data(),
+           &m_PVTO.UndersaturatedBoViscosity[2 * iBranch * m_PVTO.RelativePressure.size()] };
+}
+
+double BlackOil_OilModel::computePb( double Rs,
+                                     SearchHints * hints ) const
 {
   std::size_t i_lower_branch, i_upper_branch;
-  math::FindSurrondingIndex( m_PVTO.Rs, Rs, i_lower_branch, i_upper_branch );
+  m_RsIndex.find( m_PVTO.Rs, Rs, i_lower_branch, i_upper_branch, hints == nullptr ? nullptr : &hints->Rs );
   return math::LinearInterpolation( m_PVTO.Rs[i_lower_branch], m_PVTO.BubblePressure[i_lower_branch], m_PVTO.Rs[i_upper_branch], m_PVTO.BubblePressure[i_upper_branch], Rs );
 }
 
-double BlackOil_OilModel::computeRs( double Pb ) const
+double BlackOil_OilModel::computeRs( double Pb,
+                                     SearchHints * hints ) const
+{
+  double dRs_dPb;
+  return computeRs( Pb, dRs_dPb, hints );
+}
+
+double BlackOil_OilModel::computeRs( double Pb,
+                                     double & dRs_dPb,
+                                     SearchHints * hints ) const
 {
   ASSERT( ( Pb < m_maxPressure ) & ( Pb > m_minPressure ), "Pressure out of table range" );
   std::size_t i_lower_branch, i_upper_branch;
-  math::FindSurrondingIndex( m_PVTO.BubblePressure, Pb, i_lower_branch, i_upper_branch );
+  m_bubblePressureIndex.find( m_PVTO.BubblePressure, Pb, i_lower_branch, i_upper_branch, hints == nullptr ? nullptr : &hints->bubblePressure );
+  dRs_dPb = ( m_PVTO.Rs[i_upper_branch] - m_PVTO.Rs[i_lower_branch] ) / ( m_PVTO.BubblePressure[i_upper_branch] - m_PVTO.BubblePressure[i_lower_branch] );
   return math::LinearInterpolation( m_PVTO.BubblePressure[i_lower_branch], m_PVTO.Rs[i_lower_branch], m_PVTO.BubblePressure[i_upper_branch], m_PVTO.Rs[i_upper_branch], Pb );
 }
 
 
 BlackOilDeadOilProperties BlackOil_OilModel::computeSaturatedProperties( double Pb,
                                                                          double gasMoleSurfaceDensity,
-                                                                         double gasMassSurfaceDensity ) const
+                                                                         double gasMassSurfaceDensity,
+                                                                         SearchHints * hints ) const
 {
   ASSERT( ( Pb < m_maxPressure ) & ( Pb > m_minPressure ), "Pressure out of table range" );
-  auto Rs = computeRs( Pb );
+  auto Rs = computeRs( Pb, hints );
   double Bo, viscosity;
-  computeSaturatedBoVisc( Rs, Bo, viscosity );
+  computeSaturatedBoVisc( Rs, Bo, viscosity, hints );
 
   return BlackOilDeadOilProperties(
     computeMassDensity( Rs, Bo, gasMassSurfaceDensity ),
@@ -364,15 +429,45 @@ BlackOilDeadOilProperties BlackOil_OilModel::computeSaturatedProperties( double
   );
 }
 
+BlackOilDeadOilPropertiesAndDerivatives BlackOil_OilModel::computeSaturatedPropertiesAndDerivatives( double Pb,
+                                                                                                 double gasMoleSurfaceDensity,
+                                                                                                 double gasMassSurfaceDensity,
+                                                                                                 SearchHints * hints ) const
+{
+  ASSERT( ( Pb < m_maxPressure ) & ( Pb > m_minPressure ), "Pressure out of table range" );
+  double dRs_dPb;
+  auto Rs = computeRs( Pb, dRs_dPb, hints );
+  double Bo, viscosity, dBo_dRs, dVisc_dRs;
+  computeSaturatedBoVisc( Rs, Bo, viscosity, dBo_dRs, dVisc_dRs, hints );
+
+  BlackOilDeadOilPropertiesAndDerivatives result;
+  result.value = BlackOilDeadOilProperties(
+    computeMassDensity( Rs, Bo, gasMassSurfaceDensity ),
+    computeMoleDensity( Rs, Bo, gasMoleSurfaceDensity ),
+    viscosity
+  );
+  // On the saturation curve Rs follows the pressure, the Rs derivatives are folded into the pressure ones
+  computeDensityDerivatives( Rs, Bo, 0., dBo_dRs, gasMoleSurfaceDensity, gasMassSurfaceDensity, result );
+  result.dRs.viscosity = dVisc_dRs;
+  result.dP = BlackOilDeadOilProperties(
+    result.dRs.massDensity * dRs_dPb,
+    result.dRs.moleDensity * dRs_dPb,
+    result.dRs.viscosity * dRs_dPb
+  );
+  result.dRs = BlackOilDeadOilProperties( 0., 0., 0. );
+  return result;
+}
+
 BlackOilDeadOilProperties BlackOil_OilModel::computeUnderSaturatedProperties( double P,
-                                                                              std::vector< double > composition,
+                                                                              std::vector< double > const & composition,
                                                                               double gasMoleSurfaceDensity,
-                                                                              double gasMassSurfaceDensity ) const
+                                                                              double gasMassSurfaceDensity,
+                                                                              SearchHints * hints ) const
 {
   ASSERT( ( P < m_maxPressure ) & ( P > m_minPressure ), "Pressure out of table range" );
   auto Rs = ( composition[1] / gasMoleSurfaceDensity ) / ( composition[0] / m_surfaceMoleDensity );
   double Bo, Visc;
-  computeUndersaturatedBoVisc( Rs, P, Bo, Visc );
+  computeUndersaturatedBoVisc( Rs, P, Bo, Visc, hints );
 
   return BlackOilDeadOilProperties(
     computeMassDensity( Rs, Bo, gasMassSurfaceDensity ),
@@ -381,28 +476,82 @@ BlackOilDeadOilProperties BlackOil_OilModel::computeUnderSaturatedProperties( do
   );
 }
 
+BlackOilDeadOilPropertiesAndDerivatives BlackOil_OilModel::computeUnderSaturatedPropertiesAndDerivatives( double P,
+                                                                                                      std::vector< double > const & composition,
+                                                                                                      double gasMoleSurfaceDensity,
+                                                                                                      double gasMassSurfaceDensity,
+                                                                                                      SearchHints * hints ) const
+{
+  ASSERT( ( P < m_maxPressure ) & ( P > m_minPressure ), "Pressure out of table range" );
+  auto Rs = ( composition[1] / gasMoleSurfaceDensity ) / ( composition[0] / m_surfaceMoleDensity );
+  double Bo, Visc, dBo_dP, dVisc_dP, dBo_dRs, dVisc_dRs;
+  computeUndersaturatedBoVisc( Rs, P, Bo, Visc, dBo_dP, dVisc_dP, dBo_dRs, dVisc_dRs, hints );
+
+  BlackOilDeadOilPropertiesAndDerivatives result;
+  result.value = BlackOilDeadOilProperties(
+    computeMassDensity( Rs, Bo, gasMassSurfaceDensity ),
+    computeMoleDensity( Rs, Bo, gasMoleSurfaceDensity ),
+    Visc
+  );
+  computeDensityDerivatives( Rs, Bo, dBo_dP, dBo_dRs, gasMoleSurfaceDensity, gasMassSurfaceDensity, result );
+  result.dP.viscosity = dVisc_dP;
+  result.dRs.viscosity = dVisc_dRs;
+  return result;
+}
+
+void BlackOil_OilModel::computeSaturatedBoVisc( double Rs,
+                                                double & Bo,
+                                                double & visc,
+                                                SearchHints * hints ) const
+{
+  double dBo_dRs, dVisc_dRs;
+  computeSaturatedBoVisc( Rs, Bo, visc, dBo_dRs, dVisc_dRs, hints );
+}
+
 void BlackOil_OilModel::computeSaturatedBoVisc( double Rs,
                                                 double & Bo,
-                                                double & visc ) const
+                                                double & visc,
+                                                double & dBo_dRs,
+                                                double & dVisc_dRs,
+                                                SearchHints * hints ) const
 {
   std::size_t i_lower_branch, i_upper_branch;
   auto const & Rs_vec = m_PVTO.Rs;
-  auto const & Bo_vec = m_PVTO.SaturatedBo;
-  auto const & visc_vec = m_PVTO.SaturatedViscosity;
-  math::FindSurrondingIndex( Rs_vec, Rs, i_lower_branch, i_upper_branch );
-  Bo = math::LinearInterpolation( Rs - Rs_vec[i_lower_branch], Rs_vec[i_upper_branch] - Rs, Bo_vec[i_lower_branch], Bo_vec[i_upper_branch] );
-  visc = math::LinearInterpolation( Rs - Rs_vec[i_lower_branch], Rs_vec[i_upper_branch] - Rs, visc_vec[i_lower_branch], visc_vec[i_upper_branch] );
+  m_RsIndex.find( Rs_vec, Rs, i_lower_branch, i_upper_branch, hints == nullptr ? nullptr : &hints->Rs );
+  double const * lower = &m_PVTO.SaturatedBoViscosity[2 * i_lower_branch];
+  double const * upper = &m_PVTO.SaturatedBoViscosity[2 * i_upper_branch];
+  Bo = math::LinearInterpolation( Rs - Rs_vec[i_lower_branch], Rs_vec[i_upper_branch] - Rs, lower[0], upper[0] );
+  visc = math::LinearInterpolation( Rs - Rs_vec[i_lower_branch], Rs_vec[i_upper_branch] - Rs, lower[1], upper[1] );
+
+  const double dRs = Rs_vec[i_upper_branch] - Rs_vec[i_lower_branch];
+  dBo_dRs = ( upper[0] - lower[0] ) / dRs;
+  dVisc_dRs = ( upper[1] - lower[1] ) / dRs;
 }
 
 void BlackOil_OilModel::computeUndersaturatedBoVisc( double Rs,
                                                      double P,
                                                      double & Bo,
-                                                     double & visc ) const
+                                                     double & visc,
+                                                     SearchHints * hints ) const
+{
+  double dBo_dP, dVisc_dP, dBo_dRs, dVisc_dRs;
+  computeUndersaturatedBoVisc( Rs, P, Bo, visc, dBo_dP, dVisc_dP, dBo_dRs, dVisc_dRs, hints );
+}
+
+void BlackOil_OilModel::computeUndersaturatedBoVisc( double Rs,
+                                                     double P,
+                                                     double & Bo,
+                                                     double & visc,
+                                                     double & dBo_dP,
+                                                     double & dVisc_dP,
+                                                     double & dBo_dRs,
+                                                     double & dVisc_dRs,
+                                                     SearchHints * hints ) const
 {
   ASSERT( ( P < m_maxPressure ) & ( P > m_minPressure ), "Pressure out of table range" );
   std::size_t i_lower_branch, i_upper_branch;
   auto & Rs_vec = m_PVTO.Rs;
-  math::FindSurrondingIndex( Rs_vec, Rs, i_lower_branch, i_upper_branch );
+  m_RsIndex.find( Rs_vec, Rs, i_lower_branch, i_upper_branch, hints == nullptr ? nullptr : &hints->Rs );
 
   auto Pbub = math::LinearInterpolation( m_PVTO.Rs[i_lower_branch], m_PVTO.BubblePressure[i_lower_branch], m_PVTO.Rs[i_upper_branch], m_PVTO.BubblePressure[i_upper_branch], Rs );
 
@@ -413,25 +562,57 @@ void BlackOil_OilModel::computeUndersaturatedBoVisc( double Rs,
   auto dRs_up = std::abs( m_PVTO.Rs[i_upper_branch] - Rs );
   auto dRs_dn = std::abs( Rs - m_PVTO.Rs[i_lower_branch] );
 
-  auto & Pup = m_PVTO.UndersaturatedPressure[i_upper_branch];
-  auto & Pdn = m_PVTO.UndersaturatedPressure[i_lower_branch];
+  // Views of the branches, the lookups do not copy the table
+  UndersaturatedBranch const up = getUndersaturatedBranch( i_upper_branch );
+  UndersaturatedBranch const dn = getUndersaturatedBranch( i_lower_branch );
 
   std::size_t i_lower_P, i_upper_P;
-  math::FindSurrondingIndex( Pup, Prel, i_lower_P, i_upper_P );
+  m_relativePressureIndex.find( m_PVTO.RelativePressure, Prel, i_lower_P, i_upper_P );
+
+  //Bo and viscosity of the stencil are contiguous in each branch
+  double const * lower_dn = &dn.BoViscosity[2 * i_lower_P];
+  double const * upper_dn = &dn.BoViscosity[2 * i_upper_P];
+  double const * lower_up = &up.BoViscosity[2 * i_lower_P];
+  double const * upper_up = &up.BoViscosity[2 * i_upper_P];
 
   //Bo
-  auto Bo_up = m_PVTO.UndersaturatedBo[i_upper_branch];
-  auto Bo_dn = m_PVTO.UndersaturatedBo[i_lower_branch];
-  auto Bo_interp_dn = math::LinearInterpolation( Pdn[i_lower_P], Bo_dn[i_lower_P], Pdn[i_upper_P], Bo_dn[i_upper_P], Prel );
-  auto Bo_interp_up = math::LinearInterpolation( Pup[i_lower_P], Bo_up[i_lower_P], Pup[i_upper_P], Bo_up[i_upper_P], Prel );
+  auto Bo_interp_dn = math::LinearInterpolation( dn.pressure[i_lower_P], lower_dn[0], dn.pressure[i_upper_P], upper_dn[0], Prel );
+  auto Bo_interp_up = math::LinearInterpolation( up.pressure[i_lower_P], lower_up[0], up.pressure[i_upper_P], upper_up[0], Prel );
   Bo = math::LinearInterpolation( dRs_dn, dRs_up, Bo_interp_dn, Bo_interp_up );
 
   //Visc
-  auto Visc_up = m_PVTO.UndersaturatedViscosity[i_upper_branch];
-  auto Visc_dn = m_PVTO.UndersaturatedViscosity[i_lower_branch];
-  auto Visc_interp_dn = math::LinearInterpolation( Pdn[i_lower_P], Visc_dn[i_lower_P], Pdn[i_upper_P], Visc_dn[i_upper_P], Prel );
-  auto Visc_interp_up = math::LinearInterpolation( Pup[i_lower_P], Visc_up[i_lower_P], Pup[i_upper_P], Visc_up[i_upper_P], Prel );
+  auto Visc_interp_dn = math::LinearInterpolation( dn.pressure[i_lower_P], lower_dn[1], dn.pressure[i_upper_P], upper_dn[1], Prel );
+  auto Visc_interp_up = math::LinearInterpolation( up.pressure[i_lower_P], lower_up[1], up.pressure[i_upper_P], upper_up[1], Prel );
   visc = math::LinearInterpolation( dRs_dn, dRs_up, Visc_interp_dn, Visc_interp_up );
+
+  //Derivatives: the weight of the upper branch is f, P moves along both branches and Rs moves the weight and the bubble point
+  const double deltaRs = m_PVTO.Rs[i_upper_branch] - m_PVTO.Rs[i_lower_branch];
+  const double f = dRs_dn / ( dRs_dn + dRs_up );
+  const double dPbub_dRs = ( m_PVTO.BubblePressure[i_upper_branch] - m_PVTO.BubblePressure[i_lower_branch] ) / deltaRs;
+  const double deltaPrel_dn = dn.pressure[i_upper_P] - dn.pressure[i_lower_P];
+  const double deltaPrel_up = up.pressure[i_upper_P] - up.pressure[i_lower_P];
+
+  dBo_dP = f * ( upper_up[0] - lower_up[0] ) / deltaPrel_up + ( 1. - f ) * ( upper_dn[0] - lower_dn[0] ) / deltaPrel_dn;
+  dVisc_dP = f * ( upper_up[1] - lower_up[1] ) / deltaPrel_up + ( 1. - f ) * ( upper_dn[1] - lower_dn[1] ) / deltaPrel_dn;
+  dBo_dRs = ( Bo_interp_up - Bo_interp_dn ) / deltaRs - dBo_dP * dPbub_dRs;
+  dVisc_dRs = ( Visc_interp_up - Visc_interp_dn ) / deltaRs - dVisc_dP * dPbub_dRs;
+}
+
+void BlackOil_OilModel::computeDensityDerivatives( double Rs,
+                                                   double Bo,
+                                                   double dBo_dP,
+                                                   double dBo_dRs,
+                                                   double gasMoleSurfaceDensity,
+                                                   double gasMassSurfaceDensity,
+                                                   BlackOilDeadOilPropertiesAndDerivatives & properties ) const
+{
+  // The densities are ( rho_o + rho_g * Rs ) / Bo
+  const double massDensity = computeMassDensity( Rs, Bo, gasMassSurfaceDensity );
+  const double moleDensity = computeMoleDensity( Rs, Bo, gasMoleSurfaceDensity );
+  properties.dP.massDensity = -massDensity / Bo * dBo_dP;
+  properties.dP.moleDensity = -moleDensity / Bo * dBo_dP;
+  properties.dRs.massDensity = gasMassSurfaceDensity / Bo - massDensity / Bo * dBo_dRs;
+  properties.dRs.moleDensity = gasMoleSurfaceDensity / Bo - moleDensity / Bo * dBo_dRs;
 }
 
 double BlackOil_OilModel::computeMoleDensity( double Rs,
@@ -19,6 +19,7 @@
 #include "PVTOdata.hpp"
 
 #include "Utils/Assert.hpp"
+#include "Utils/TableIndex.hpp"
 
 #include <vector>
 
@@ -48,22 +49,68 @@ public:
     return m_surfaceMolecularWeight;
   }
 
-  double computeRs( double Pb ) const;
+  /**
+   * @brief Intervals of the last lookups on the saturated axes, which nearby successive conditions start from.
+   *
+   * They are kept by the caller (e.g. one per flash), so that the model can be shared.
+   * The evaluations taking them as an optional last argument return the same results without them.
+   */
+  struct SearchHints
+  {
+    std::size_t Rs = 1;
+    std::size_t bubblePressure = 1;
+  };
+
+  double computeRs( double Pb,
+                    SearchHints * hints = nullptr ) const;
+
+  /// Same as above, @p dRs_dPb receiving the derivative of Rs.
+  double computeRs( double Pb,
+                    double & dRs_dPb,
+                    SearchHints * hints = nullptr ) const;
 
   BlackOilDeadOilProperties computeSaturatedProperties( double Pb,
                                                         double gasMoleSurfaceDensity,
-                                                        double gasMassSurfaceDensity ) const;
+                                                        double gasMassSurfaceDensity,
+                                                        SearchHints * hints = nullptr ) const;
+
+  BlackOilDeadOilPropertiesAndDerivatives computeSaturatedPropertiesAndDerivatives( double Pb,
+                                                                                    double gasMoleSurfaceDensity,
+                                                                                    double gasMassSurfaceDensity,
+                                                                                    SearchHints * hints = nullptr ) const;
 
   BlackOilDeadOilProperties computeUnderSaturatedProperties( double P,
-                                                             std::vector< double > composition,
+                                                             std::vector< double > const & composition,
                                                              double gasMoleSurfaceDensity,
-                                                             double gasMassSurfaceDensity ) const;
+                                                             double gasMassSurfaceDensity,
+                                                             SearchHints * hints = nullptr ) const;
+
+  BlackOilDeadOilPropertiesAndDerivatives computeUnderSaturatedPropertiesAndDerivatives( double P,
+                                                                                         std::vector< double > const & composition,
+                                                                                         double gasMoleSurfaceDensity,
+                                                                                         double gasMassSurfaceDensity,
+                                                                                         SearchHints * hints = nullptr ) const;
 
 private:
 
+  /**
+   * @brief View of an undersaturated branch of the table, valid as long as the model is.
+   * @note Bo and viscosity of the j-th relative pressure are BoViscosity[2 * j] and BoViscosity[2 * j + 1].
+   */
+  struct UndersaturatedBranch
+  {
+    double const * pressure;
+    double const * BoViscosity;
+  };
+
   //PVT data
   PVTOdata m_PVTO;
 
+  /// Interval searches of the saturated axes and of the undersaturated relative pressure axis (uniform once refined)
+  math::TableIndex< double > m_RsIndex;
+  math::TableIndex< double > m_bubblePressureIndex;
+  math::TableIndex< double > m_relativePressureIndex;
+
   double m_minPressure;
   double m_maxPressure;
 
@@ -71,16 +118,49 @@ private:
   double m_surfaceMoleDensity;
   double m_surfaceMolecularWeight;
 
-  double computePb( double Rs ) const;
+  double computePb( double Rs,
+                    SearchHints * hints ) const;
+
+  UndersaturatedBranch getUndersaturatedBranch( std::size_t iBranch ) const;
 
   void computeSaturatedBoVisc( double Rs,
                                double & Bo,
-                               double & visc ) const;
+                               double & visc,
+                               SearchHints * hints ) const;
+
+  /// Same as above, with the slopes of the interpolation interval.
+  void computeSaturatedBoVisc( double Rs,
+                               double & Bo,
+                               double & visc,
+                               double & dBo_dRs,
+                               double & dVisc_dRs,
+                               SearchHints * hints ) const;
 
   void computeUndersaturatedBoVisc( double Rs,
                                     double P,
                                     double & Bo,
-                                    double & visc ) const;
+                                    double & visc,
+                                    SearchHints * hints ) const;
+
+  /// Same as above, with the derivatives w.r.t. P (at constant Rs) and w.r.t. Rs (at constant P).
+  void computeUndersaturatedBoVisc( double Rs,
+                                    double P,
+                                    double & Bo,
+                                    double & visc,
+                                    double & dBo_dP,
+                                    double & dVisc_dP,
+                                    double & dBo_dRs,
+                                    double & dVisc_dRs,
+                                    SearchHints * hints ) const;
+
+  /// Derivatives of the densities from the ones of Bo, the viscosity ones being set by the caller.
+  void computeDensityDerivatives( double Rs,
+                                  double Bo,
+                                  double dBo_dP,
+                                  double dBo_dRs,
+                                  double gasMoleSurfaceDensity,
+                                  double gasMassSurfaceDensity,
+                                  BlackOilDeadOilPropertiesAndDerivatives & properties ) const;
 
   double computeMoleDensity( double Rs,
                              double Bo,
@@ -101,6 +181,10 @@ private:
   void checkTableConsistency() const;
 
   void refineTable( std::size_t nLevel );
+
+  void packTable();
+
+  void createTableIndices();
 };
 
 }
@@ -55,4 +55,41 @@ BlackOilDeadOilProperties BlackOil_WaterModel::computeProperties( double pressur
   );
 }
 
+BlackOilDeadOilPropertiesAndDerivatives BlackOil_WaterModel::computePropertiesAndDerivatives( double pressure ) const
+{
+  BlackOilDeadOilPropertiesAndDerivatives result;
+  result.value = computeProperties( pressure );
+
+  // The density grows exponentially with the compressibility, the viscosity is constant.
+  const double dMassDensity_dP = m_PVTW.Compressibility * result.value.massDensity;
+  result.dP = BlackOilDeadOilProperties(
+    dMassDensity_dP,
+    dMassDensity_dP / m_surfaceMolecularWeight,
+    0.
+  );
+  return result;
+}
+
+void BlackOil_WaterModel::computeProperties( std::size_t n,
+                                             double const * pressures,
+                                             BlackOilDeadOilBatchProperties const & properties ) const
+{
+  const double compressibility = m_PVTW.Compressibility;
+  for( std::size_t i = 0; i < n; ++i )
+  {
+    const double B = m_PVTW.Bw * exp( -compressibility * ( pressures[i] - m_PVTW.ReferencePressure ) );
+    const double massDensity = m_surfaceMassDensity / B;
+    const double dMassDensity_dP = compressibility * massDensity;
+
+    properties.B[i] = B;
+    properties.dB_dP[i] = -compressibility * B;
+    properties.massDensity[i] = massDensity;
+    properties.dMassDensity_dP[i] = dMassDensity_dP;
+    properties.moleDensity[i] = massDensity / m_surfaceMolecularWeight;
+    properties.dMoleDensity_dP[i] = dMassDensity_dP / m_surfaceMolecularWeight;
+    properties.viscosity[i] = m_PVTW.Viscosity;
+    properties.dViscosity_dP[i] = 0.;
+  }
+}
+
 }
@@ -38,6 +38,20 @@ public:
 
   BlackOilDeadOilProperties computeProperties( double pressure ) const;
 
+  BlackOilDeadOilPropertiesAndDerivatives computePropertiesAndDerivatives( double pressure ) const;
+
+  /**
+   * @brief Evaluates the properties and their pressure derivatives for @p n pressures at once.
+   * @param n Number of pressures.
+   * @param pressures Contiguous pressures.
+   * @param properties The buffers to fill, of size @p n.
+   *
+   * @note The results are the same as the ones of computePropertiesAndDerivatives.
+   */
+  void computeProperties( std::size_t n,
+                          double const * pressures,
+                          BlackOilDeadOilBatchProperties const & properties ) const;
+
 private:
 
   //PVT data
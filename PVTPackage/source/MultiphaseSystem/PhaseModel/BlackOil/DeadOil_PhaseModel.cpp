@@ -19,6 +19,7 @@
 #include "Utils/math.hpp"
 
 #include <algorithm>
+#include <array>
 
 namespace PVTPackage
 {
@@ -46,7 +47,23 @@ DeadOil_PhaseModel::DeadOil_PhaseModel( pvt::PHASE_TYPE type,
 
   // Check consistency
   checkTableConsistency();
-  
+
+  // Interval search
+  m_pressureIndex = math::TableIndex< double >( m_PVD.Pressure );
+
+  // Slopes of the intervals, shared by all the derivatives computations
+  const std::size_t nIntervals = m_PVD.Pressure.size() - 1;
+  m_BSlopes.resize( nIntervals );
+  m_viscositySlopes.resize( nIntervals );
+  for( std::size_t i = 0; i < nIntervals; ++i )
+  {
+    const double dP = m_PVD.Pressure[i + 1] - m_PVD.Pressure[i];
+    m_BSlopes[i] = ( m_PVD.B[i + 1] - m_PVD.B[i] ) / dP;
+    m_viscositySlopes[i] = ( m_PVD.Viscosity[i + 1] - m_PVD.Viscosity[i] ) / dP;
+  }
+  m_countedBatchSearch = m_PVD.Pressure.size() <= s_batchCountedTableSize and
+                         std::adjacent_find( m_PVD.Pressure.cbegin(), m_PVD.Pressure.cend(), []( double a, double b ){ return not( a < b ); } ) == m_PVD.Pressure.cend();
+
   // Compute density
   m_surfaceMassDensity = oilSurfaceMassDensity;
   m_surfaceMoleDensity = m_surfaceMassDensity / m_surfaceMolecularWeight;
@@ -91,16 +108,31 @@ void DeadOil_PhaseModel::createTable( const std::vector< std::vector< double>> &
 
 void DeadOil_PhaseModel::computeBandVisc( double P,
                                           double & B,
-                                          double & visc ) const
+                                          double & visc,
+                                          SearchHints * hints ) const
+{
+  double dB_dP, dVisc_dP;
+  computeBandVisc( P, B, visc, dB_dP, dVisc_dP, hints );
+}
+
+void DeadOil_PhaseModel::computeBandVisc( double P,
+                                          double & B,
+                                          double & visc,
+                                          double & dB_dP,
+                                          double & dVisc_dP,
+                                          SearchHints * hints ) const
 {
   ASSERT( ( P < m_maxPressure ) & ( P > m_minPressure ), "Pressure out of table range" );
   std::size_t i_lower_branch, i_upper_branch;
   auto const & P_vec = m_PVD.Pressure;
   auto const & B_vec = m_PVD.B;
   auto const & visc_vec = m_PVD.Viscosity;
-  math::FindSurrondingIndex( P_vec, P, i_lower_branch, i_upper_branch );
+  m_pressureIndex.find( P_vec, P, i_lower_branch, i_upper_branch, hints == nullptr ? nullptr : &hints->pressure );
   B = math::LinearInterpolation( P - P_vec[i_lower_branch], P_vec[i_upper_branch] - P, B_vec[i_lower_branch], B_vec[i_upper_branch] );
   visc = math::LinearInterpolation( P - P_vec[i_lower_branch], P_vec[i_upper_branch] - P, visc_vec[i_lower_branch], visc_vec[i_upper_branch] );
+
+  dB_dP = m_BSlopes[i_lower_branch];
+  dVisc_dP = m_viscositySlopes[i_lower_branch];
 }
 
 double DeadOil_PhaseModel::computeMoleDensity( double B ) const
@@ -113,10 +145,11 @@ double DeadOil_PhaseModel::computeMassDensity( double B ) const
   return 1. / B * ( m_surfaceMassDensity );
 }
 
-BlackOilDeadOilProperties DeadOil_PhaseModel::computeProperties( double pressure ) const
+BlackOilDeadOilProperties DeadOil_PhaseModel::computeProperties( double pressure,
+                                                                 SearchHints * hints ) const
 {
   double B, viscosity;
-  computeBandVisc( pressure, B, viscosity );
+  computeBandVisc( pressure, B, viscosity, hints );
 
   return BlackOilDeadOilProperties(
     1. / B * ( m_surfaceMassDensity ),
@@ -125,4 +158,102 @@ BlackOilDeadOilProperties DeadOil_PhaseModel::computeProperties( double pressure
   );
 }
 
+BlackOilDeadOilPropertiesAndDerivatives DeadOil_PhaseModel::computePropertiesAndDerivatives( double pressure,
+                                                                                             SearchHints * hints ) const
+{
+  double B, viscosity, dB_dP, dVisc_dP;
+  computeBandVisc( pressure, B, viscosity, dB_dP, dVisc_dP, hints );
+
+  const double inverseB = 1. / B;
+  const double dInverseB_dP = -inverseB * inverseB * dB_dP;
+
+  BlackOilDeadOilPropertiesAndDerivatives result;
+  result.value = BlackOilDeadOilProperties(
+    inverseB * ( m_surfaceMassDensity ),
+    inverseB * ( m_surfaceMoleDensity ),
+    viscosity
+  );
+  result.dP = BlackOilDeadOilProperties(
+    dInverseB_dP * ( m_surfaceMassDensity ),
+    dInverseB_dP * ( m_surfaceMoleDensity ),
+    dVisc_dP
+  );
+  return result;
+}
+
+void DeadOil_PhaseModel::computeProperties( std::size_t n,
+                                            double const * pressures,
+                                            BlackOilDeadOilBatchProperties const & properties,
+                                            SearchHints * hints ) const
+{
+  double const * const P_vec = m_PVD.Pressure.data();
+  double const * const B_vec = m_PVD.B.data();
+  double const * const visc_vec = m_PVD.Viscosity.data();
+  double const * const BSlopes = m_BSlopes.data();
+  double const * const viscositySlopes = m_viscositySlopes.data();
+  const std::size_t last = m_PVD.Pressure.size() - 1;
+
+  std::array< std::size_t, s_batchChunkSize > lowerIndices;
+  for( std::size_t begin = 0; begin < n; begin += s_batchChunkSize )
+  {
+    const std::size_t chunkSize = n - begin < s_batchChunkSize ? n - begin : s_batchChunkSize;
+    double const * const P = pressures + begin;
+
+    for( std::size_t i = 0; i < chunkSize; ++i )
+    {
+      ASSERT( ( P[i] < m_maxPressure ) & ( P[i] > m_minPressure ), "Pressure out of table range" );
+    }
+
+    // Same intervals as the ones of m_pressureIndex
+    if( m_countedBatchSearch )
+    {
+      // The lower node is the number of inner nodes below the pressure, counted for all the pressures at once without branches
+      std::fill( lowerIndices.begin(), lowerIndices.begin() + chunkSize, 0 );
+      for( std::size_t j = 1; j < last; ++j )
+      {
+        const double node = P_vec[j];
+        for( std::size_t i = 0; i < chunkSize; ++i )
+        {
+          lowerIndices[i] += node < P[i];
+        }
+      }
+    }
+    else
+    {
+      for( std::size_t i = 0; i < chunkSize; ++i )
+      {
+        std::size_t i_lower_branch, i_upper_branch;
+        m_pressureIndex.find( m_PVD.Pressure, P[i], i_lower_branch, i_upper_branch, hints == nullptr ? nullptr : &hints->pressure );
+        lowerIndices[i] = i_lower_branch;
+      }
+    }
+
+    // Same operations as computePropertiesAndDerivatives, the table entries being gathered from the intervals
+    for( std::size_t i = 0; i < chunkSize; ++i )
+    {
+      const std::size_t iLower = lowerIndices[i];
+      const std::size_t iUpper = iLower + 1;
+      const double B = math::LinearInterpolation( P[i] - P_vec[iLower], P_vec[iUpper] - P[i], B_vec[iLower], B_vec[iUpper] );
+      const double dB_dP = BSlopes[iLower];
+      const double inverseB = 1. / B;
+      const double dInverseB_dP = -inverseB * inverseB * dB_dP;
+
+      properties.B[begin + i] = B;
+      properties.dB_dP[begin + i] = dB_dP;
+      properties.massDensity[begin + i] = inverseB * ( m_surfaceMassDensity );
+      properties.dMassDensity_dP[begin + i] = dInverseB_dP * ( m_surfaceMassDensity );
+      properties.moleDensity[begin + i] = inverseB * ( m_surfaceMoleDensity );
+      properties.dMoleDensity_dP[begin + i] = dInverseB_dP * ( m_surfaceMoleDensity );
+    }
+
+    for( std::size_t i = 0; i < chunkSize; ++i )
+    {
+      const std::size_t iLower = lowerIndices[i];
+      const std::size_t iUpper = iLower + 1;
+      properties.viscosity[begin + i] = math::LinearInterpolation( P[i] - P_vec[iLower], P_vec[iUpper] - P[i], visc_vec[iLower], visc_vec[iUpper] );
+      properties.dViscosity_dP[begin + i] = viscositySlopes[iLower];
+    }
+  }
+}
+
 }
@@ -19,6 +19,7 @@
 #include "PVDdata.hpp"
 
 #include "Utils/Assert.hpp"
+#include "Utils/TableIndex.hpp"
 
 #include "pvt/pvt.hpp"
 
@@ -53,16 +54,60 @@ public:
     return m_surfaceMolecularWeight;
   }
 
-  BlackOilDeadOilProperties computeProperties( double pressure ) const;
+  /**
+   * @brief Interval of the last lookup, which nearby successive pressures start from.
+   *
+   * It is kept by the caller (e.g. one per flash), so that the model can be shared.
+   * The evaluations taking it as an optional last argument return the same results without it.
+   */
+  struct SearchHints
+  {
+    std::size_t pressure = 1;
+  };
+
+  BlackOilDeadOilProperties computeProperties( double pressure,
+                                               SearchHints * hints = nullptr ) const;
+
+  BlackOilDeadOilPropertiesAndDerivatives computePropertiesAndDerivatives( double pressure,
+                                                                           SearchHints * hints = nullptr ) const;
+
+  /**
+   * @brief Evaluates the properties and their pressure derivatives for @p n pressures at once.
+   * @param n Number of pressures.
+   * @param pressures Contiguous pressures.
+   * @param properties The buffers to fill, of size @p n.
+   * @param hints Optional search hints.
+   *
+   * @note The results are the same as the ones of computePropertiesAndDerivatives.
+   * The intervals are searched by chunks first, so the interpolation loops only gather table entries and can be vectorized.
+   */
+  void computeProperties( std::size_t n,
+                          double const * pressures,
+                          BlackOilDeadOilBatchProperties const & properties,
+                          SearchHints * hints = nullptr ) const;
 
 private:
 
+  /// Number of pressures which intervals are searched before being interpolated.
+  static constexpr std::size_t s_batchChunkSize = 256;
+  /// Largest table which intervals are found by counting the nodes below each pressure in batch evaluations.
+  static constexpr std::size_t s_batchCountedTableSize = 32;
+
   //Phase type
   const pvt::PHASE_TYPE m_type;
 
   //PVT data
   PVDdata m_PVD;
 
+  /// Interval search of the pressure axis
+  math::TableIndex< double > m_pressureIndex;
+
+  /// Slopes of B and of the viscosity over each interval of the table
+  std::vector< double > m_BSlopes;
+  std::vector< double > m_viscositySlopes;
+  /// Whether the batch evaluations count the nodes below each pressure (small increasing table) instead of searching them
+  bool m_countedBatchSearch = false;
+
   double m_minPressure{};
   double m_maxPressure{};
 
@@ -72,7 +117,16 @@ private:
 
   void computeBandVisc( double P,
                         double & B,
-                        double & visc ) const;
+                        double & visc,
+                        SearchHints * hints ) const;
+
+  /// Same as above, with the slopes of the interpolation interval.
+  void computeBandVisc( double P,
+                        double & B,
+                        double & visc,
+                        double & dB_dP,
+                        double & dVisc_dP,
+                        SearchHints * hints ) const;
 
   double computeMoleDensity( double B ) const;
 
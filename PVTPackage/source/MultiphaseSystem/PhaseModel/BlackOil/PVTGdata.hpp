@@ -30,6 +30,7 @@ struct PVTGdata
   std::size_t NSaturatedPoints;
   std::vector< double > SaturatedBg;
   std::vector< double > SaturatedViscosity;
+  std::vector< double > SaturatedBgViscosity;   // Bg and viscosity interleaved, for the evaluations
   ////Unsaturated
   std::vector< std::vector< double > > UndersaturatedRv;   // always start at 0
   std::vector< std::vector< double > > UndersaturatedBg;
@@ -30,10 +30,14 @@ struct PVTOdata
   std::size_t NSaturatedPoints;
   std::vector< double > SaturatedBo;
   std::vector< double > SaturatedViscosity;
+  std::vector< double > SaturatedBoViscosity;   // Bo and viscosity interleaved, for the evaluations
   // Unsaturated
   std::vector< std::vector< double > > UndersaturatedPressure;   // Pressure - Pbub -> always start at 0
   std::vector< std::vector< double > > UndersaturatedBo;
   std::vector< std::vector< double > > UndersaturatedViscosity;
+  // Unsaturated, once the branches are refined on a common axis (the branches above are then released)
+  std::vector< double > RelativePressure;   // Pressure - Pbub, common to all the branches
+  std::vector< double > UndersaturatedBoViscosity;   // (Rs x RelativePressure) grid, row major, Bo and viscosity interleaved
 
 private:
   //Pressure
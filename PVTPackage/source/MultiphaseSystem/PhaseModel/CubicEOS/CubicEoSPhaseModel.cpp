@@ -15,141 +15,372 @@
 
 #include "CubicEoSPhaseModel.hpp"
 
+#include "Utils/ComponentKernels.hpp"
 #include "Utils/Logger.hpp"
 
 #include <algorithm>
+#include <limits>
 
 namespace PVTPackage
 {
 
-CubicEoSPhaseModel::Properties CubicEoSPhaseModel::computeAllProperties( double pressure,
-                                                                         double temperature,
-                                                                         std::vector< double > const & composition ) const
+CubicEoSPhaseModel::Workspace::Workspace()
+  : mixtureCoefficients( 0 ),
+    temperatureTerms{ nullptr, pvt::PRECISION_TYPE::DOUBLE, std::numeric_limits< double >::quiet_NaN(), {}, {}, {}, {}, {} }
+{ }
+
+void CubicEoSPhaseModel::Workspace::resize( std::size_t nComponents )
+{
+  mixtureCoefficients.APure.resize( nComponents );
+  mixtureCoefficients.BPure.resize( nComponents );
+  mixtureCoefficients.AInteraction.resize( nComponents * nComponents );
+  mixtureCoefficients.ki.resize( nComponents );
+  temperatureTerms.alpha.resize( nComponents );
+  temperatureTerms.APureDenominators.resize( nComponents );
+  temperatureTerms.BPureDenominators.resize( nComponents );
+  temperatureTerms.dLnAPure_dT.resize( nComponents );
+  dki.resize( nComponents );
+  dBPure.resize( nComponents );
+  dLnFugacityCoefficients.resize( nComponents );
+}
+
+void CubicEoSPhaseModel::computeAllProperties( double pressure,
+                                               double temperature,
+                                               std::vector< double > const & composition,
+                                               Workspace & workspace,
+                                               Properties & properties ) const
 {
-  const CubicEosMixtureCoefficients mixtureCoeffs = computeMixtureCoefficients( pressure, temperature, composition );
-  const double compressibilityFactor = computeCompressibilityFactor( pressure, temperature, composition, mixtureCoeffs );
-  const std::vector< double > lnFugacitiesCoeffs = computeLnFugacitiesCoefficients( composition, compressibilityFactor, mixtureCoeffs );
-  const double moleDensity = computeMoleDensity( m_componentProperties, pressure, temperature, composition, compressibilityFactor );
+  workspace.resize( m_componentProperties.NComponents );
+  properties.lnFugacityCoefficients.resize( m_componentProperties.NComponents );
+
+  CubicEosMixtureCoefficients & mixtureCoeffs = workspace.mixtureCoefficients;
+  computeMixtureCoefficients( pressure, temperature, composition, workspace );
+  const double compressibilityFactor = computeCompressibilityFactor( mixtureCoeffs );
+  computeLnFugacitiesCoefficients( compressibilityFactor, mixtureCoeffs, properties.lnFugacityCoefficients );
+  const double moleDensity = computeMoleDensity( pressure, temperature, composition, compressibilityFactor );
   const double molecularWeight = computeMolecularWeight( m_componentProperties, composition );
-  const double massDensity = computeMassDensity( moleDensity, molecularWeight );
-  const double viscosity = computeViscosity();
-  
-  return Properties{
-    compressibilityFactor, massDensity, moleDensity, viscosity, molecularWeight, lnFugacitiesCoeffs
-  };
+
+  properties.compressibilityFactor = compressibilityFactor;
+  properties.massDensity = computeMassDensity( moleDensity, molecularWeight );
+  properties.moleDensity = moleDensity;
+  properties.viscosity = computeViscosity();
+  properties.molecularWeight = molecularWeight;
 }
 
-CubicEoSPhaseModel::CubicEosMixtureCoefficients CubicEoSPhaseModel::computeMixtureCoefficients( double pressure,
-                                                                                                double temperature,
-                                                                                                std::vector< double > const & composition ) const
+bool CubicEoSPhaseModel::isLiquidLike( Properties const & properties,
+                                       Workspace const & workspace ) const
+{
+  return properties.compressibilityFactor * m_omegaB < m_criticalCompressibilityFactor * workspace.mixtureCoefficients.BMixture;
+}
+
+void CubicEoSPhaseModel::computeAllPropertiesAndDerivatives( double pressure,
+                                                             double temperature,
+                                                             std::vector< double > const & composition,
+                                                             Workspace & workspace,
+                                                             PropertiesAndDerivatives & result ) const
 {
   auto const & nComponents = m_componentProperties.NComponents;
-  std::vector< double > const & Tc = m_componentProperties.Tc;
-  std::vector< double > const & Pc = m_componentProperties.Pc;
+  std::vector< double > const & Mw = m_componentProperties.Mw;
 
-  CubicEosMixtureCoefficients mixCoeffs( nComponents );
+  ASSERT( result.lnFugacityCoefficients.value.size() == nComponents, "Properties and derivatives not sized for the components" );
 
-  //Mixture coefficients
-  for( std::size_t i = 0; i < nComponents; ++i )
+  workspace.resize( nComponents );
+  CubicEosMixtureCoefficients & mixtureCoeffs = workspace.mixtureCoefficients;
+  computeMixtureCoefficients( pressure, temperature, composition, workspace );
+  const double Z = computeCompressibilityFactor( mixtureCoeffs );
+  const double A = mixtureCoeffs.AMixture;
+  const double B = mixtureCoeffs.BMixture;
+
+  result.compressibilityFactor.value = Z;
+  computeLnFugacitiesCoefficients( Z, mixtureCoeffs, result.lnFugacityCoefficients.value );
+
+  // Interaction terms aij = (1 - kij) sqrt(ai aj) and their sums ki = sum_j xj aij are part of the mixture coefficients
+  std::vector< double > const & aij = mixtureCoeffs.AInteraction;
+  std::vector< double > const & ki = mixtureCoeffs.ki;
+
+  std::vector< double > & dki = workspace.dki;
+  std::vector< double > & dBPure = workspace.dBPure;
+  std::vector< double > & dZdx = result.compressibilityFactor.dz;
+
+  // Pressure: A, B, ki and BPure are all proportional to the pressure
   {
-    mixCoeffs.APure[i] = m_omegaA * Tc[i] * Tc[i] * pressure / ( Pc[i] * temperature * temperature ) * pow( 1.0 + m_m[i] * ( 1.0 - sqrt( temperature / Tc[i] ) ), 2.0 );
-    mixCoeffs.BPure[i] = m_omegaB * Tc[i] * pressure / ( Pc[i] * temperature );
+    const double dA = A / pressure;
+    const double dB = B / pressure;
+    for( std::size_t i = 0; i < nComponents; ++i )
+    {
+      dki[i] = ki[i] / pressure;
+      dBPure[i] = mixtureCoeffs.BPure[i] / pressure;
+    }
+    result.compressibilityFactor.dP = computeCompressibilityFactorVariation( Z, mixtureCoeffs, dA, dB );
+    computeLnFugacitiesCoefficientsVariation( Z, mixtureCoeffs, result.compressibilityFactor.dP, dA, dB, dki, dBPure,
+                                              result.lnFugacityCoefficients.dP );
   }
 
-  mixCoeffs.AMixture = 0;
-  mixCoeffs.BMixture = 0;
-  for( std::size_t i = 0; i < nComponents; ++i )
+  // Temperature: APure_i is proportional to alpha_i / T^2, with alpha_i = ( 1 + m_i ( 1 - sqrt( T / Tc_i ) ) )^2
   {
-    for( std::size_t j = 0; j < nComponents; ++j )
+    std::vector< double > const & dLnAPure = getTemperatureTerms( temperature, workspace.temperatureTerms ).dLnAPure_dT;
+
+    double dA = 0.;
+    for( std::size_t i = 0; i < nComponents; ++i )
+    {
+      dki[i] = 0.;
+      for( std::size_t j = 0; j < nComponents; ++j )
+      {
+        dki[i] += 0.5 * composition[j] * aij[i * nComponents + j] * ( dLnAPure[i] + dLnAPure[j] );
+      }
+      dA += composition[i] * ki[i] * dLnAPure[i];
+      dBPure[i] = -mixtureCoeffs.BPure[i] / temperature;
+    }
+    const double dB = -B / temperature;
+    result.compressibilityFactor.dT = computeCompressibilityFactorVariation( Z, mixtureCoeffs, dA, dB );
+    computeLnFugacitiesCoefficientsVariation( Z, mixtureCoeffs, result.compressibilityFactor.dT, dA, dB, dki, dBPure,
+                                              result.lnFugacityCoefficients.dT );
+  }
+
+  // Composition
+  {
+    std::vector< double > & dLnFugacityCoeffs = workspace.dLnFugacityCoefficients;
+    std::fill( dBPure.begin(), dBPure.end(), 0. );
+    for( std::size_t k = 0; k < nComponents; ++k )
     {
-      mixCoeffs.AMixture = mixCoeffs.AMixture + ( composition[i] * composition[j] * ( 1.0 - m_BICs ) * sqrt( mixCoeffs.APure[i] * mixCoeffs.APure[j] ) );
+      const double dA = 2.0 * ki[k];
+      const double dB = mixtureCoeffs.BPure[k];
+      for( std::size_t i = 0; i < nComponents; ++i )
+      {
+        dki[i] = aij[i * nComponents + k];
+      }
+      dZdx[k] = computeCompressibilityFactorVariation( Z, mixtureCoeffs, dA, dB );
+      computeLnFugacitiesCoefficientsVariation( Z, mixtureCoeffs, dZdx[k], dA, dB, dki, dBPure, dLnFugacityCoeffs );
+      for( std::size_t i = 0; i < nComponents; ++i )
+      {
+        result.lnFugacityCoefficients.dz[i][k] = dLnFugacityCoeffs[i];
+      }
     }
-    mixCoeffs.BMixture = mixCoeffs.BMixture + composition[i] * mixCoeffs.BPure[i];
   }
 
-  return mixCoeffs;
+  // Densities and molecular weight. The mole density is 1 / v, with v = R T Z / P + sum_i x_i c_i(T).
+  const double moleDensity = computeMoleDensity( pressure, temperature, composition, Z );
+  const double molecularWeight = computeMolecularWeight( m_componentProperties, composition );
+  const double squaredMoleDensity = moleDensity * moleDensity;
+
+  double dVolumeShift_dT = 0.;
+  if( m_hasVolumeShift )
+  {
+    for( std::size_t i = 0; i < nComponents; ++i )
+    {
+      dVolumeShift_dT += composition[i] * m_volumeShiftTemperatureCoefficients[i];
+    }
+  }
+
+  result.moleDensity.value = moleDensity;
+  result.moleDensity.dP = -squaredMoleDensity * R * temperature * ( result.compressibilityFactor.dP - Z / pressure ) / pressure;
+  result.moleDensity.dT = -squaredMoleDensity * ( R * ( Z + temperature * result.compressibilityFactor.dT ) / pressure + dVolumeShift_dT );
+
+  result.molecularWeight.value = molecularWeight;
+
+  result.massDensity.value = computeMassDensity( moleDensity, molecularWeight );
+  result.massDensity.dP = result.moleDensity.dP * molecularWeight;
+  result.massDensity.dT = result.moleDensity.dT * molecularWeight;
+
+  for( std::size_t k = 0; k < nComponents; ++k )
+  {
+    const double volumeShift = m_volumeShiftConstants[k] + m_volumeShiftTemperatureCoefficients[k] * temperature;
+    result.moleDensity.dz[k] = -squaredMoleDensity * ( R * temperature * dZdx[k] / pressure + volumeShift );
+    result.molecularWeight.dz[k] = Mw[k];
+    result.massDensity.dz[k] = result.moleDensity.dz[k] * molecularWeight + moleDensity * Mw[k];
+  }
+
+  // The viscosity is constant for the moment, its derivatives are left to zero.
+  result.viscosity.value = computeViscosity();
 }
 
-double CubicEoSPhaseModel::computeCompressibilityFactor( double pressure,
-                                                         double temperature,
-                                                         std::vector< double > const & composition,
-                                                         CubicEosMixtureCoefficients const & mixCoeffs ) const
+void CubicEoSPhaseModel::computeMixtureCoefficients( double pressure,
+                                                     double temperature,
+                                                     std::vector< double > const & composition,
+                                                     Workspace & workspace ) const
 {
-  (void) pressure, (void) temperature;
-  //ASSERT(m_MixtureCoefficientsUpToDate, "Z factor requires mixture properties up-to-date.");
-  std::vector< double > coeff( 3 );
-  //aZ3+bZ2+cZ+d=0
-  double a = 1.0;
-  double b = ( m_delta1 + m_delta2 - 1.0 ) * mixCoeffs.BMixture - 1.0;
-  double c = mixCoeffs.AMixture + m_delta1 * m_delta2 * mixCoeffs.BMixture * mixCoeffs.BMixture - ( m_delta1 + m_delta2 ) * mixCoeffs.BMixture * ( mixCoeffs.BMixture + 1.0 );
-  double d = -( mixCoeffs.AMixture * mixCoeffs.BMixture + m_delta1 * m_delta2 * mixCoeffs.BMixture * mixCoeffs.BMixture * ( mixCoeffs.BMixture + 1.0 ) );
+  auto const & nComponents = m_componentProperties.NComponents;
+  TemperatureTerms const & temperatureTerms = getTemperatureTerms( temperature, workspace.temperatureTerms );
+  CubicEosMixtureCoefficients & mixCoeffs = workspace.mixtureCoefficients;
 
-  auto sols = solveCubicPolynomial( a, b, c, d );
-  double compressibility;
-
-
-//		if ((m_PhaseType == pvt::PHASE_TYPE::LIQUID_WATER_RICH) || (m_PhaseType == pvt::PHASE_TYPE::OIL))
-//		{
-//			compressibility = *(std::min_element(sols.begin(), sols.end()));
-//		}
-//		else if (m_PhaseType == pvt::PHASE_TYPE::GAS)
-//		{
-//			compressibility = *(std::max_element(sols.begin(), sols.end()));
-//		}
-//		else
-//		{
-//			LOGERROR("Undetermined phase type for compressibility calculation");
-//			compressibility = -1;
-//		}
-
-  if( sols.size() == 1 )
+  //Mixture coefficients
+  for( std::size_t i = 0; i < nComponents; ++i )
   {
-    compressibility = sols[0];
+    mixCoeffs.APure[i] = m_APureNumerators[i] * pressure / temperatureTerms.APureDenominators[i] * temperatureTerms.alpha[i];
+    mixCoeffs.BPure[i] = m_BPureNumerators[i] * pressure / temperatureTerms.BPureDenominators[i];
   }
-  else
-  {
 
-    // Check for unphysical roots and remove them 
-    auto const unphysical = [&]( double v ) { return v <= mixCoeffs.BMixture; };
-    sols.erase( std::remove_if( sols.begin(), sols.end(), unphysical ), sols.end() );
+  m_mixingKernel( nComponents, m_oneMinusBIC.data(), temperatureTerms.interactionsSingle.data(), pressure, composition.data(), mixCoeffs );
+}
 
-    // Choose the root according to Gibbs' free energy minimization
-    const double Zmin = *std::min_element( sols.begin(), sols.end() );
-    const double Zmax = *std::max_element( sols.begin(), sols.end() );
+CubicEoSPhaseModel::TemperatureTerms const & CubicEoSPhaseModel::getTemperatureTerms( double temperature,
+                                                                                     TemperatureTerms & terms ) const
+{
+  if( terms.model == this and terms.precisionType == m_precisionType and temperature == terms.temperature )
+  {
+    return terms;
+  }
 
-    auto ln_fug_min = computeLnFugacitiesCoefficients( composition, Zmin, mixCoeffs );
-    auto ln_fug_max = computeLnFugacitiesCoefficients( composition, Zmax, mixCoeffs );
+  auto const & nComponents = m_componentProperties.NComponents;
+  std::vector< double > const & Tc = m_componentProperties.Tc;
+  std::vector< double > const & Pc = m_componentProperties.Pc;
+  for( std::size_t i = 0; i < nComponents; ++i )
+  {
+    const double sqrtTr = sqrt( temperature / Tc[i] );
+    const double sqrtAlpha = 1.0 + m_m[i] * ( 1.0 - sqrtTr );
+    terms.alpha[i] = sqrtAlpha * sqrtAlpha;
+    terms.APureDenominators[i] = Pc[i] * temperature * temperature;
+    terms.BPureDenominators[i] = Pc[i] * temperature;
+    terms.dLnAPure_dT[i] = -2.0 / temperature - m_m[i] * sqrtTr / ( temperature * sqrtAlpha );
+  }
 
-    double dG = 0.0;
-    for( std::size_t ic = 0; ic < m_componentProperties.NComponents; ++ic )
+  if( m_precisionType == pvt::PRECISION_TYPE::MIXED )
+  {
+    terms.interactionsSingle.resize( nComponents * nComponents );
+    for( std::size_t i = 0; i < nComponents; ++i )
     {
-      dG += composition[ic] * ( ln_fug_min[ic] - ln_fug_max[ic] );
+      const double ai = m_APureNumerators[i] / terms.APureDenominators[i] * terms.alpha[i];
+      for( std::size_t j = 0; j < nComponents; ++j )
+      {
+        const double aj = m_APureNumerators[j] / terms.APureDenominators[j] * terms.alpha[j];
+        terms.interactionsSingle[i * nComponents + j] = static_cast< float >( m_oneMinusBIC[i * nComponents + j] * sqrt( ai * aj ) );
+      }
     }
-
-    compressibility = ( dG < 0 ) ? Zmin : Zmax;
   }
+  terms.model = this;
+  terms.precisionType = m_precisionType;
+  terms.temperature = temperature;
 
-  return compressibility;
+  return terms;
 }
 
-std::vector< double > CubicEoSPhaseModel::computeLnFugacitiesCoefficients( std::vector< double > const & composition,
-                                                                           double Z,
-                                                                           CubicEosMixtureCoefficients const & mixtureCoefficients ) const
+template< std::size_t NC >
+void CubicEoSPhaseModel::MixingKernel< NC >::run( std::size_t nComponents,
+                                                   double const * oneMinusBIC,
+                                                   float const *,
+                                                   double,
+                                                   double const * composition,
+                                                   CubicEosMixtureCoefficients & mixCoeffs )
 {
-  auto const nComponents = m_componentProperties.NComponents;
+  const std::size_t n = nComponentsOf< NC >( nComponents );
+  double const * APure = mixCoeffs.APure.data();
+  double * aij = mixCoeffs.AInteraction.data();
 
-  auto ki = std::vector< double >( nComponents, 0 );
+  // Interaction terms, sqrt(ai aj) being symmetric
+  for( std::size_t i = 0; i < n; ++i )
+  {
+    for( std::size_t j = i; j < n; ++j )
+    {
+      const double sqrtAiAj = sqrt( APure[i] * APure[j] );
+      aij[i * n + j] = oneMinusBIC[i * n + j] * sqrtAiAj;
+      aij[j * n + i] = oneMinusBIC[j * n + i] * sqrtAiAj;
+    }
+  }
 
-  std::vector< double > lnFugacityCoeffs( nComponents );
+  accumulate( n, composition, mixCoeffs );
+}
 
-  //Ki
-  for( std::size_t i = 0; i < nComponents; ++i )
+template< std::size_t NC >
+void CubicEoSPhaseModel::MixingKernel< NC >::accumulate( std::size_t nComponents,
+                                                          double const * composition,
+                                                          CubicEosMixtureCoefficients & mixCoeffs )
+{
+  const std::size_t n = nComponentsOf< NC >( nComponents );
+  double const * BPure = mixCoeffs.BPure.data();
+  double const * aij = mixCoeffs.AInteraction.data();
+  double * ki = mixCoeffs.ki.data();
+
+  // AMixture = sum_i x_i sum_j x_j aij and ki = sum_j x_j aij share the same pass
+  double AMixture = 0;
+  double BMixture = 0;
+  for( std::size_t i = 0; i < n; ++i )
   {
-    for( std::size_t j = 0; j < nComponents; ++j )
+    double const * aiRow = &aij[i * n];
+    double kiSum = 0;
+    for( std::size_t j = 0; j < n; ++j )
     {
-      ki[i] = ki[i] + composition[j] * ( 1.0 - m_BICs ) * sqrt( mixtureCoefficients.APure[i] * mixtureCoefficients.APure[j] );
+      AMixture = AMixture + ( composition[i] * composition[j] * aiRow[j] );
+      kiSum = kiSum + composition[j] * aiRow[j];
     }
+    ki[i] = kiSum;
+    BMixture = BMixture + composition[i] * BPure[i];
   }
+  mixCoeffs.AMixture = AMixture;
+  mixCoeffs.BMixture = BMixture;
+}
+
+template< std::size_t NC >
+void CubicEoSPhaseModel::MixedPrecisionMixingKernel< NC >::run( std::size_t nComponents,
+                                                                 double const *,
+                                                                 float const * interactions,
+                                                                 double pressure,
+                                                                 double const * composition,
+                                                                 CubicEosMixtureCoefficients & mixCoeffs )
+{
+  const std::size_t n = nComponentsOf< NC >( nComponents );
+  double * aij = mixCoeffs.AInteraction.data();
+
+  // The interaction terms are proportional to the pressure, their single precision values being cached with the temperature
+  for( std::size_t ij = 0; ij < n * n; ++ij )
+  {
+    aij[ij] = pressure * interactions[ij];
+  }
+
+  MixingKernel< NC >::accumulate( n, composition, mixCoeffs );
+}
+
+double CubicEoSPhaseModel::computeCompressibilityFactor( CubicEosMixtureCoefficients const & mixCoeffs ) const
+{
+  //ASSERT(m_MixtureCoefficientsUpToDate, "Z factor requires mixture properties up-to-date.");
+  //aZ3+bZ2+cZ+d=0
+  double a = 1.0;
+  double b = ( m_delta1 + m_delta2 - 1.0 ) * mixCoeffs.BMixture - 1.0;
+  double c = mixCoeffs.AMixture + m_delta1 * m_delta2 * mixCoeffs.BMixture * mixCoeffs.BMixture - ( m_delta1 + m_delta2 ) * mixCoeffs.BMixture * ( mixCoeffs.BMixture + 1.0 );
+  double d = -( mixCoeffs.AMixture * mixCoeffs.BMixture + m_delta1 * m_delta2 * mixCoeffs.BMixture * mixCoeffs.BMixture * ( mixCoeffs.BMixture + 1.0 ) );
+
+  std::array< double, 3 > sols;
+  std::size_t nSols = solveCubicPolynomial( a, b, c, d, sols );
+
+  if( nSols == 1 )
+  {
+    return sols[0];
+  }
+
+  // Smallest and largest physical roots (Z > B), selected without branching.
+  double Zmin = std::numeric_limits< double >::max();
+  double Zmax = std::numeric_limits< double >::lowest();
+  for( double const & Z: sols )
+  {
+    const bool physical = Z > mixCoeffs.BMixture;
+    Zmin = physical ? std::min( Zmin, Z ) : Zmin;
+    Zmax = physical ? std::max( Zmax, Z ) : Zmax;
+  }
+
+  // Choose the root according to Gibbs' free energy minimization
+  const double dG = computeReducedGibbsEnergy( Zmin, mixCoeffs ) - computeReducedGibbsEnergy( Zmax, mixCoeffs );
+
+  return ( dG < 0 ) ? Zmin : Zmax;
+}
+
+double CubicEoSPhaseModel::computeReducedGibbsEnergy( double Z,
+                                                      CubicEosMixtureCoefficients const & mixtureCoefficients ) const
+{
+  // sum_i x_i ln phi_i, with the E, F, G terms of computeLnFugacitiesCoefficients.
+  // Since sum_i x_i BPure_i = B and sum_i x_i ki = A, the sum does not depend on the components.
+  const double E = log( ( Z + m_delta1 * mixtureCoefficients.BMixture ) / ( Z + m_delta2 * mixtureCoefficients.BMixture ) );
+  const double F = log( Z - mixtureCoefficients.BMixture );
+  const double G = 1.0 / ( ( m_delta1 - m_delta2 ) * mixtureCoefficients.BMixture );
+  const double A = mixtureCoefficients.AMixture;
+
+  return ( Z - 1 ) - F - G * A * E;
+}
+
+void CubicEoSPhaseModel::computeLnFugacitiesCoefficients( double Z,
+                                                          CubicEosMixtureCoefficients const & mixtureCoefficients,
+                                                          std::vector< double > & lnFugacityCoeffs ) const
+{
+  auto const nComponents = m_componentProperties.NComponents;
+  std::vector< double > const & ki = mixtureCoefficients.ki;
 
   //E
   const double E = log( ( Z + m_delta1 * mixtureCoefficients.BMixture ) / ( Z + m_delta2 * mixtureCoefficients.BMixture ) );
@@ -163,26 +394,76 @@ std::vector< double > CubicEoSPhaseModel::computeLnFugacitiesCoefficients( std::
     const double B = mixtureCoefficients.BPure[i] / mixtureCoefficients.BMixture;
     lnFugacityCoeffs[i] = ( Z - 1 ) * B - F - G * ( 2 * ki[i] - A * B ) * E;
   }
+}
 
-  return lnFugacityCoeffs;
+double CubicEoSPhaseModel::computeCompressibilityFactorVariation( double Z,
+                                                                  CubicEosMixtureCoefficients const & mixtureCoefficients,
+                                                                  double dA,
+                                                                  double dB ) const
+{
+  const double A = mixtureCoefficients.AMixture;
+  const double B = mixtureCoefficients.BMixture;
+
+  // Implicit differentiation of f(Z, A, B) = Z^3 + b Z^2 + c Z + d = 0 (see computeCompressibilityFactor)
+  const double b = ( m_delta1 + m_delta2 - 1.0 ) * B - 1.0;
+  const double c = A + m_delta1 * m_delta2 * B * B - ( m_delta1 + m_delta2 ) * B * ( B + 1.0 );
+
+  const double df_dZ = 3.0 * Z * Z + 2.0 * b * Z + c;
+  const double df_dA = Z - B;
+  const double df_dB = ( m_delta1 + m_delta2 - 1.0 ) * Z * Z
+                       + ( 2.0 * m_delta1 * m_delta2 * B - ( m_delta1 + m_delta2 ) * ( 2.0 * B + 1.0 ) ) * Z
+                       - ( A + m_delta1 * m_delta2 * B * ( 3.0 * B + 2.0 ) );
+
+  return -( df_dA * dA + df_dB * dB ) / df_dZ;
 }
 
-double CubicEoSPhaseModel::computeMoleDensity( const ComponentProperties & componentProperties,
-                                               double pressure,
+void CubicEoSPhaseModel::computeLnFugacitiesCoefficientsVariation( double Z,
+                                                                   CubicEosMixtureCoefficients const & mixtureCoefficients,
+                                                                   double dZ,
+                                                                   double dA,
+                                                                   double dB,
+                                                                   std::vector< double > const & dki,
+                                                                   std::vector< double > const & dBPure,
+                                                                   std::vector< double > & dLnFugacityCoeffs ) const
+{
+  const double A = mixtureCoefficients.AMixture;
+  const double B = mixtureCoefficients.BMixture;
+  std::vector< double > const & ki = mixtureCoefficients.ki;
+
+  // Same E, F, G as computeLnFugacitiesCoefficients, and their variations
+  const double E = log( ( Z + m_delta1 * B ) / ( Z + m_delta2 * B ) );
+  const double G = 1.0 / ( ( m_delta1 - m_delta2 ) * B );
+  const double dE = ( dZ + m_delta1 * dB ) / ( Z + m_delta1 * B ) - ( dZ + m_delta2 * dB ) / ( Z + m_delta2 * B );
+  const double dF = ( dZ - dB ) / ( Z - B );
+  const double dG = -G * dB / B;
+
+  for( std::size_t i = 0; i < m_componentProperties.NComponents; ++i )
+  {
+    const double b = mixtureCoefficients.BPure[i] / B;
+    const double db = ( dBPure[i] - b * dB ) / B;
+    const double H = 2 * ki[i] - A * b;
+    const double dH = 2 * dki[i] - dA * b - A * db;
+    dLnFugacityCoeffs[i] = dZ * b + ( Z - 1 ) * db - dF - ( dG * H + G * dH ) * E - G * H * dE;
+  }
+}
+
+double CubicEoSPhaseModel::computeMoleDensity( double pressure,
                                                double temperature,
                                                std::vector< double > const & composition,
-                                               double Z )
+                                               double Z ) const
 {
-  auto const & nComponents = componentProperties.NComponents;
-  auto const & Vs = componentProperties.VolumeShift;
+  auto const & nComponents = m_componentProperties.NComponents;
   double vEos = R * temperature * Z / pressure;
   double vCorrected = vEos;
 
   double moleDensity;
 
-  for( std::size_t i = 0; i < nComponents; i++ )
+  if( m_hasVolumeShift )
   {
-    vCorrected = vCorrected + composition[i] * ( ( Vs[i][1] ) * temperature + Vs[i][1] );
+    for( std::size_t i = 0; i < nComponents; i++ )
+    {
+      vCorrected = vCorrected + composition[i] * ( m_volumeShiftConstants[i] + m_volumeShiftTemperatureCoefficients[i] * temperature );
+    }
   }
 
   if( std::fabs( vCorrected ) > 0.0 )
@@ -222,6 +503,25 @@ double CubicEoSPhaseModel::computeViscosity()
   return 0.001; 
 }
 
+void CubicEoSPhaseModel::setPrecisionType( pvt::PRECISION_TYPE const & precisionType )
+{
+  auto const & nComponents = m_componentProperties.NComponents;
+  // The workspaces recompute their cached temperature dependent terms when the precision type changes
+  m_precisionType = precisionType;
+  switch( precisionType )
+  {
+    case pvt::PRECISION_TYPE::DOUBLE:
+      m_mixingKernel = selectKernel< MixingKernel >( nComponents );
+      break;
+    case pvt::PRECISION_TYPE::MIXED:
+      m_mixingKernel = selectKernel< MixedPrecisionMixingKernel >( nComponents );
+      break;
+    default:
+      LOGERROR( "non supported precision type" );
+      break;
+  }
+}
+
 void CubicEoSPhaseModel::init()
 {
   auto const & nComponents = m_componentProperties.NComponents;
@@ -235,6 +535,7 @@ void CubicEoSPhaseModel::init()
       m_omegaB = 0.077796074;
       m_delta1 = 1 + sqrt( 2 );
       m_delta2 = 1 - sqrt( 2 );
+      m_criticalCompressibilityFactor = 0.307401308;
       EOS_m_function = &CubicEoSPhaseModel::m_function_PR;
       break;
     case pvt::EOS_TYPE::REDLICH_KWONG_SOAVE:
@@ -242,6 +543,7 @@ void CubicEoSPhaseModel::init()
       m_omegaB = 0.08664;
       m_delta1 = 0.0;
       m_delta2 = 1;
+      m_criticalCompressibilityFactor = 1. / 3.;
       EOS_m_function = &CubicEoSPhaseModel::m_function_SRK;
       break;
     default:
@@ -249,6 +551,8 @@ void CubicEoSPhaseModel::init()
       break;
   }
 
+  setPrecisionType( pvt::PRECISION_TYPE::DOUBLE );
+
   //Set Constant properties
   m_m.resize( nComponents, 0 );
 
@@ -256,16 +560,85 @@ void CubicEoSPhaseModel::init()
   {
     m_m[i] = ( this->*EOS_m_function )( omega[i] );
   }
+
+  // Constant factors of the pure components coefficients, the temperature dependent terms being computed on first use
+  std::vector< double > const & Tc = m_componentProperties.Tc;
+  m_APureNumerators.resize( nComponents );
+  m_BPureNumerators.resize( nComponents );
+  for( std::size_t i = 0; i < nComponents; i++ )
+  {
+    m_APureNumerators[i] = m_omegaA * Tc[i] * Tc[i];
+    m_BPureNumerators[i] = m_omegaB * Tc[i];
+  }
+
+  // Binary interaction coefficients, flattened once for the mixing rule
+  std::vector< std::vector< double > > const & BIC = m_componentProperties.BIC;
+  m_oneMinusBIC.resize( nComponents * nComponents );
+  for( std::size_t i = 0; i < nComponents; i++ )
+  {
+    for( std::size_t j = 0; j < nComponents; j++ )
+    {
+      m_oneMinusBIC[i * nComponents + j] = 1.0 - BIC[i][j];
+    }
+  }
+
+  // Volume shifts c_i(T) = c0_i + c1_i T, packed per coefficient. Zero shifts are skipped altogether.
+  std::vector< std::vector< double > > const & volumeShift = m_componentProperties.VolumeShift;
+  m_volumeShiftConstants.resize( nComponents );
+  m_volumeShiftTemperatureCoefficients.resize( nComponents );
+  m_hasVolumeShift = false;
+  for( std::size_t i = 0; i < nComponents; i++ )
+  {
+    m_volumeShiftConstants[i] = volumeShift[i][0];
+    m_volumeShiftTemperatureCoefficients[i] = volumeShift[i][1];
+    m_hasVolumeShift = m_hasVolumeShift || volumeShift[i][0] != 0.0 || volumeShift[i][1] != 0.0;
+  }
 }
 
-std::vector< double > CubicEoSPhaseModel::solveCubicPolynomial( double m3,
-                                                                double m2,
-                                                                double m1,
-                                                                double m0 )
+namespace
 {
-  ////CUBIC EQUATION :  m3 * x^3 +  m3 * x^2 + m1 *x + m0  = 0
-  double x1, x2, x3;
 
+/**
+ * @brief Computes the three real roots of the monic cubic x^3 + a1 x^2 + a2 x + a3, using the trigonometric formula.
+ * @return The roots, the first and second ones being the smallest and the largest.
+ * @note Only meaningful when Q^3 - r^2 >= 0.
+ */
+inline std::array< double, 3 > trigonometricCubicRoots( double a1,
+                                                        double Q,
+                                                        double r,
+                                                        double Qcubed,
+                                                        double pi )
+{
+  double theta = acos( r / sqrt( Qcubed ) );
+  double sqrtQ = sqrt( Q );
+  return { -2 * sqrtQ * cos( theta / 3 ) - a1 / 3,
+           -2 * sqrtQ * cos( ( theta + 2 * pi ) / 3 ) - a1 / 3,
+           -2 * sqrtQ * cos( ( theta + 4 * pi ) / 3 ) - a1 / 3 };
+}
+
+/**
+ * @brief Computes the only real root of the monic cubic x^3 + a1 x^2 + a2 x + a3, using Cardano's formula.
+ * @note Only meaningful when Q^3 - r^2 < 0.
+ */
+inline double cardanoCubicRoot( double a1,
+                                double Q,
+                                double r,
+                                double d )
+{
+  double e = pow( sqrt( -d ) + fabs( r ), 1. / 3. );
+  e = r > 0 ? -e : e;
+  return ( e + Q / e ) - a1 / 3.;
+}
+
+}
+
+std::size_t CubicEoSPhaseModel::solveCubicPolynomial( double m3,
+                                                      double m2,
+                                                      double m1,
+                                                      double m0,
+                                                      std::array< double, 3 > & roots )
+{
+  ////CUBIC EQUATION :  m3 * x^3 +  m3 * x^2 + m1 *x + m0  = 0
   double a1 = m2 / m3;
   double a2 = m1 / m3;
   double a3 = m0 / m3;
@@ -278,23 +651,14 @@ std::vector< double > CubicEoSPhaseModel::solveCubicPolynomial( double m3,
   /* Three real roots */
   if( d >= 0 )
   {
-    double theta = acos( r / sqrt( Qcubed ) );
-    double sqrtQ = sqrt( Q );
-    x1 = -2 * sqrtQ * cos( theta / 3 ) - a1 / 3;
-    x2 = -2 * sqrtQ * cos( ( theta + 2 * PI ) / 3 ) - a1 / 3;
-    x3 = -2 * sqrtQ * cos( ( theta + 4 * PI ) / 3 ) - a1 / 3;
-    return { x1, x2, x3 };
+    roots = trigonometricCubicRoots( a1, Q, r, Qcubed, PI );
+    return 3;
   }
     /* One real root */
   else
   {
-    double e = pow( sqrt( -d ) + fabs( r ), 1. / 3. );
-    if( r > 0 )
-    {
-      e = -e;
-    }
-    x1 = ( e + Q / e ) - a1 / 3.;
-    return { x1 };
+    roots[0] = cardanoCubicRoot( a1, Q, r, d );
+    return 1;
   }
 }
 
@@ -21,6 +21,7 @@
 
 #include "pvt/pvt.hpp"
 
+#include <array>
 #include <vector>
 #include <cmath>
 
@@ -41,8 +42,11 @@ public:
       m_omegaB( 0 ),
       m_delta1( 0 ),
       m_delta2( 0 ),
+      m_criticalCompressibilityFactor( 0 ),
       EOS_m_function( nullptr ),
-      m_BICs( 0 )
+      m_hasVolumeShift( false ),
+      m_precisionType( pvt::PRECISION_TYPE::DOUBLE ),
+      m_mixingKernel( nullptr )
   {
     init();
   }
@@ -52,6 +56,16 @@ public:
     return m_componentProperties;
   }
 
+  /**
+   * @brief Selects the precision of the mixing rule. Double precision is used by default.
+   * @param precisionType The precision type.
+   *
+   * In mixed precision, the interaction terms ( 1 - k_ij ) sqrt(APure_i APure_j) / P, which only depend on the temperature,
+   * are stored in single precision with the temperature dependent terms. Each evaluation then scales them by the pressure,
+   * without any square root. Their sums, the cubic equation and its root selection remain in double precision.
+   */
+  void setPrecisionType( pvt::PRECISION_TYPE const & precisionType );
+
   /**
    * @brief Small utility class for better output.
    *
@@ -67,9 +81,147 @@ public:
     std::vector< double > lnFugacityCoefficients;
   };
 
-  Properties computeAllProperties( double pressure,
-                                   double temperature,
-                                   std::vector< double > const & composition ) const;
+private:
+
+  // Used to shorten input
+  struct CubicEosMixtureCoefficients
+  {
+    std::vector< double > APure, BPure;
+    /// Interaction terms ( 1 - k_ij ) sqrt(APure_i APure_j), stored row-major.
+    std::vector< double > AInteraction;
+    /// ki[i] = sum_j x_j (1 - k_ij) sqrt(APure_i APure_j), such that AMixture = sum_i x_i ki[i].
+    std::vector< double > ki;
+    double AMixture, BMixture;
+
+    CubicEosMixtureCoefficients( std::size_t nComponents )
+      : APure( nComponents ),
+        BPure( nComponents ),
+        AInteraction( nComponents * nComponents ),
+        ki( nComponents ),
+        AMixture( 0. ),
+        BMixture( 0. )
+    { }
+  };
+
+  /**
+   * @brief Temperature dependent terms of the pure components coefficients and of their derivatives.
+   *
+   * APure_i = omegaA Tc_i^2 P / ( Pc_i T^2 ) alpha_i and BPure_i = omegaB Tc_i P / ( Pc_i T ),
+   * so that only the pressure scaling remains once these terms are known.
+   */
+  struct TemperatureTerms
+  {
+    /// The model the terms were computed for, nullptr until they are first computed.
+    CubicEoSPhaseModel const * model;
+    /// The precision type of the model when the terms were computed.
+    pvt::PRECISION_TYPE precisionType;
+    /// The temperature of the terms.
+    double temperature;
+    /// alpha_i = ( 1 + m_i ( 1 - sqrt( T / Tc_i ) ) )^2.
+    std::vector< double > alpha;
+    /// Pc_i T^2.
+    std::vector< double > APureDenominators;
+    /// Pc_i T.
+    std::vector< double > BPureDenominators;
+    /// d ln( APure_i ) / dT.
+    std::vector< double > dLnAPure_dT;
+    /// ( 1 - k_ij ) sqrt(APure_i APure_j) / P in single precision, row-major. Only computed in mixed precision.
+    std::vector< float > interactionsSingle;
+  };
+
+public:
+
+  /**
+   * @brief Scratch buffers used by the properties computations.
+   *
+   * The buffers are sized on first use, so that subsequent computations with the same number of components
+   * do not allocate. A workspace can be reused from one cell to another, but must not be shared between threads.
+   * It also caches the temperature dependent terms of the last model it was used with, which are only recomputed
+   * when the model or the temperature changes (e.g. never in isothermal runs with one workspace per phase model).
+   */
+  class Workspace
+  {
+  public:
+    Workspace();
+
+  private:
+    friend class CubicEoSPhaseModel;
+
+    void resize( std::size_t nComponents );
+
+    CubicEosMixtureCoefficients mixtureCoefficients;
+    TemperatureTerms temperatureTerms;
+    /// Variations of the ki sums, of the pure components B coefficients and of the ln fugacity coefficients, for the derivatives.
+    std::vector< double > dki;
+    std::vector< double > dBPure;
+    std::vector< double > dLnFugacityCoefficients;
+  };
+
+  /**
+   * @brief Computes the properties without any heap allocation once @p workspace and @p properties are sized.
+   * @param pressure The pressure.
+   * @param temperature The temperature.
+   * @param composition The phase mole composition.
+   * @param workspace The scratch buffers.
+   * @param properties The output properties. Its ln fugacity coefficients are resized if needed.
+   */
+  void computeAllProperties( double pressure,
+                             double temperature,
+                             std::vector< double > const & composition,
+                             Workspace & workspace,
+                             Properties & properties ) const;
+
+  /**
+   * @brief Tells whether a phase is liquid-like, from its molar volume compared to the critical one of the equation of state.
+   * @param properties The properties of the phase, computed by this model.
+   * @param workspace The workspace @p properties were computed with, holding the mixture coefficients of the phase.
+   * @return True if V / b = Z / B is below Zc / omegaB, its value for a pure component at its critical point.
+   */
+  bool isLiquidLike( Properties const & properties,
+                     Workspace const & workspace ) const;
+
+  /**
+   * @brief Same data as Properties, with their analytical derivatives.
+   *
+   * @note The @p dz members hold the derivatives w.r.t. the phase mole composition,
+   * each mole fraction being considered as an independent variable.
+   */
+  struct PropertiesAndDerivatives
+  {
+    explicit PropertiesAndDerivatives( std::size_t nComponents )
+      : compressibilityFactor( nComponents ),
+        massDensity( nComponents ),
+        moleDensity( nComponents ),
+        viscosity( nComponents ),
+        molecularWeight( nComponents ),
+        lnFugacityCoefficients( nComponents, nComponents )
+    { }
+
+    pvt::ScalarPropertyAndDerivatives< double > compressibilityFactor;
+    pvt::ScalarPropertyAndDerivatives< double > massDensity;
+    pvt::ScalarPropertyAndDerivatives< double > moleDensity;
+    pvt::ScalarPropertyAndDerivatives< double > viscosity;
+    pvt::ScalarPropertyAndDerivatives< double > molecularWeight;
+    pvt::VectorPropertyAndDerivatives< double > lnFugacityCoefficients;
+  };
+
+  /**
+   * @brief Computes the properties and their derivatives w.r.t. pressure, temperature and @p composition,
+   * without any heap allocation once @p workspace is sized.
+   * @param pressure The pressure.
+   * @param temperature The temperature.
+   * @param composition The phase mole composition.
+   * @param workspace The scratch buffers, whose cached temperature terms are reused.
+   * @param result The output properties and derivatives, constructed for the number of components of the model.
+   *
+   * The derivatives of the compressibility factor are obtained by differentiating the cubic equation (dZ/dA, dZ/dB),
+   * and are then chained into the ln fugacity coefficients and the densities.
+   */
+  void computeAllPropertiesAndDerivatives( double pressure,
+                                           double temperature,
+                                           std::vector< double > const & composition,
+                                           Workspace & workspace,
+                                           PropertiesAndDerivatives & result ) const;
 
 private:
 
@@ -87,44 +239,123 @@ private:
   double m_omegaA;
   double m_omegaB;
   double m_delta1, m_delta2;
+  /// The compressibility factor of a pure component at its critical point.
+  double m_criticalCompressibilityFactor;
 
   double (CubicEoSPhaseModel::*EOS_m_function)( double );
 
   // Constant Properties
   std::vector< double > m_m;
-  const double m_BICs;
+  /// The ( 1 - k_ij ) matrix built from the binary interaction coefficients, stored row-major.
+  std::vector< double > m_oneMinusBIC;
+  /// The volume shifts c_i(T) = c0_i + c1_i T, added to the EOS molar volume.
+  std::vector< double > m_volumeShiftConstants;
+  std::vector< double > m_volumeShiftTemperatureCoefficients;
+  bool m_hasVolumeShift;
 
-  // Init function at instantiation
-  void init();
+  /// omegaA Tc_i^2 and omegaB Tc_i, the constant factors of the pure components coefficients.
+  std::vector< double > m_APureNumerators;
+  std::vector< double > m_BPureNumerators;
 
-  // Used to shorten input
-  struct CubicEosMixtureCoefficients
+  /// The precision of the mixing rule.
+  pvt::PRECISION_TYPE m_precisionType;
+
+  /**
+   * @brief Kernel of the mixing rule: interaction terms, ki sums and mixture A and B coefficients.
+   * @tparam NC The number of components, see nComponentsOf.
+   */
+  template< std::size_t NC >
+  struct MixingKernel
   {
-    std::vector< double > APure, BPure;
-    double AMixture, BMixture;
+    /**
+     * @param nComponents The number of components.
+     * @param oneMinusBIC The ( 1 - k_ij ) matrix, row-major.
+     * @param interactionsSingle The single precision interaction terms of TemperatureTerms, only used in mixed precision.
+     * @param pressure The pressure.
+     * @param composition The phase mole composition.
+     * @param mixCoeffs The coefficients, which pure components coefficients are input.
+     */
+    static void run( std::size_t nComponents,
+                     double const * oneMinusBIC,
+                     float const * interactionsSingle,
+                     double pressure,
+                     double const * composition,
+                     CubicEosMixtureCoefficients & mixCoeffs );
+
+    /**
+     * @brief Computes the ki sums and the mixture A and B coefficients from the interaction terms.
+     * @param nComponents The number of components.
+     * @param composition The phase mole composition.
+     * @param mixCoeffs The coefficients, which pure components coefficients and interaction terms are input.
+     */
+    static void accumulate( std::size_t nComponents,
+                            double const * composition,
+                            CubicEosMixtureCoefficients & mixCoeffs );
+  };
 
-    CubicEosMixtureCoefficients( std::size_t nComponents )
-      : APure( nComponents ),
-        BPure( nComponents ),
-        AMixture( 0. ),
-        BMixture( 0. )
-    { }
+  /**
+   * @brief Mixed precision version of MixingKernel, the interaction terms being scaled from their single precision values.
+   * @tparam NC The number of components, see nComponentsOf.
+   */
+  template< std::size_t NC >
+  struct MixedPrecisionMixingKernel
+  {
+    /// Same arguments as MixingKernel::run.
+    static void run( std::size_t nComponents,
+                     double const * oneMinusBIC,
+                     float const * interactionsSingle,
+                     double pressure,
+                     double const * composition,
+                     CubicEosMixtureCoefficients & mixCoeffs );
   };
 
-  CubicEosMixtureCoefficients computeMixtureCoefficients( double pressure,
-                                                          double temperature,
-                                                          std::vector< double > const & composition ) const;
+  /// The mixing rule kernel specialized for the number of components and the precision type.
+  void (* m_mixingKernel)( std::size_t, double const *, float const *, double, double const *, CubicEosMixtureCoefficients & );
 
-  double computeCompressibilityFactor( double pressure,
-                                       double temperature,
-                                       std::vector< double > const & composition,
-                                       CubicEosMixtureCoefficients const & mixCoeffs ) const;
+  // Init function at instantiation
+  void init();
+
+  /**
+   * @brief Gets the temperature dependent terms, which are recomputed unless @p terms hold the ones of this model at @p temperature.
+   * @param temperature The temperature.
+   * @param terms The cached terms, updated if needed.
+   * @return The terms at @p temperature.
+   */
+  TemperatureTerms const & getTemperatureTerms( double temperature,
+                                                TemperatureTerms & terms ) const;
+
+  /**
+   * @brief Computes the pure and mixture coefficients, as well as the interaction terms and the ki sums, for given conditions.
+   * @param pressure The pressure.
+   * @param temperature The temperature.
+   * @param composition The phase mole composition.
+   * @param workspace The workspace holding the cached temperature dependent terms and the output coefficients.
+   *
+   * The interaction terms are evaluated once (n (n + 1) / 2 square roots) and then shared
+   * by the mixing rule, the ln fugacity coefficients and their derivatives.
+   */
+  void computeMixtureCoefficients( double pressure,
+                                   double temperature,
+                                   std::vector< double > const & composition,
+                                   Workspace & workspace ) const;
+
+  double computeCompressibilityFactor( CubicEosMixtureCoefficients const & mixCoeffs ) const;
+
+  /**
+   * @brief Computes sum_i x_i ln phi_i, i.e. the Gibbs energy of the phase up to terms independent of @p Z.
+   * @param Z The compressibility factor.
+   * @param mixtureCoefficients The mixture coefficients.
+   * @return The reduced Gibbs energy.
+   *
+   * It is used to select the root of the cubic in O(1), without computing the ln fugacity coefficients of each root.
+   */
+  double computeReducedGibbsEnergy( double Z,
+                                    CubicEosMixtureCoefficients const & mixtureCoefficients ) const;
 
-  static double computeMoleDensity( const ComponentProperties & componentProperties,
-                                    double pressure,
-                                    double temperature,
-                                    std::vector< double > const & composition,
-                                    double Z );
+  double computeMoleDensity( double pressure,
+                             double temperature,
+                             std::vector< double > const & composition,
+                             double Z ) const;
 
   static double computeMolecularWeight( const ComponentProperties & componentProperties,
                                         std::vector< double > const & composition );
@@ -134,14 +365,53 @@ private:
 
   static double computeViscosity(); 
   
-  std::vector< double > computeLnFugacitiesCoefficients( std::vector< double > const & composition,
-                                                         double Z,
-                                                         CubicEosMixtureCoefficients const & mixtureCoefficients ) const;
-
-  static std::vector< double > solveCubicPolynomial( double m3,
-                                                     double m2,
-                                                     double m1,
-                                                     double m0 );
+  void computeLnFugacitiesCoefficients( double Z,
+                                        CubicEosMixtureCoefficients const & mixtureCoefficients,
+                                        std::vector< double > & lnFugacityCoeffs ) const;
+
+  /**
+   * @brief Computes the variation of Z from the variations of the mixture coefficients.
+   * @param Z The compressibility factor.
+   * @param mixtureCoefficients The mixture coefficients.
+   * @param dA Variation of the mixture A coefficient.
+   * @param dB Variation of the mixture B coefficient.
+   * @return The variation of Z.
+   */
+  double computeCompressibilityFactorVariation( double Z,
+                                                CubicEosMixtureCoefficients const & mixtureCoefficients,
+                                                double dA,
+                                                double dB ) const;
+
+  /**
+   * @brief Computes the variations of the ln fugacity coefficients.
+   * @param Z The compressibility factor.
+   * @param mixtureCoefficients The mixture coefficients.
+   * @param dZ Variation of Z.
+   * @param dA Variation of the mixture A coefficient.
+   * @param dB Variation of the mixture B coefficient.
+   * @param dki Variations of the ki sums of @p mixtureCoefficients.
+   * @param dBPure Variations of the pure components B coefficients.
+   * @param dLnFugacityCoeffs The output variations.
+   */
+  void computeLnFugacitiesCoefficientsVariation( double Z,
+                                                 CubicEosMixtureCoefficients const & mixtureCoefficients,
+                                                 double dZ,
+                                                 double dA,
+                                                 double dB,
+                                                 std::vector< double > const & dki,
+                                                 std::vector< double > const & dBPure,
+                                                 std::vector< double > & dLnFugacityCoeffs ) const;
+
+  /**
+   * @brief Solves m3 x^3 + m2 x^2 + m1 x + m0 = 0.
+   * @param roots The real roots, only the first returned ones being defined.
+   * @return The number of real roots (1 or 3).
+   */
+  static std::size_t solveCubicPolynomial( double m3,
+                                           double m2,
+                                           double m1,
+                                           double m0,
+                                           std::array< double, 3 > & roots );
 
   // m functions
   double m_function_PR( double omega );
@@ -36,12 +36,41 @@ BlackOilFlash::BlackOilFlash( const std::vector< std::vector< double > > & PVTO,
 }
 
 bool BlackOilFlash::computeEquilibrium( BlackOilFlashMultiphaseSystemProperties & sysProps ) const
+{
+  return computeEquilibrium( sysProps, false );
+}
+
+bool BlackOilFlash::computeEquilibriumAndDerivatives( BlackOilFlashMultiphaseSystemProperties & sysProps,
+                                                      bool & derivativesComputed ) const
+{
+  derivativesComputed = true;
+  return computeEquilibrium( sysProps, true );
+}
+
+bool BlackOilFlash::computeEquilibrium( BlackOilFlashMultiphaseSystemProperties & sysProps,
+                                        bool withDerivatives ) const
 {
   // FIXME hard coded indices everywhere.
   const auto & pressure = sysProps.getPressure();
 
   const std::vector< double > & feed = sysProps.getFeed();
   const double zo = feed[0], zg = feed[1], zw = feed[2];
+  const std::size_t nComponents = feed.size();
+
+  // Derivative of the feed of component i w.r.t. component j, the perturbed feed being normalized.
+  auto const dFeed = [&]( std::size_t i, std::size_t j )
+  {
+    return ( i == j ? 1. : 0. ) - feed[i];
+  };
+
+  if( withDerivatives )
+  {
+    sysProps.resetDerivatives();
+    for( std::size_t j = 0; j < nComponents; ++j )
+    {
+      sysProps.setPhaseMoleFractionDZ( pvt::PHASE_TYPE::LIQUID_WATER_RICH, j, dFeed( 2, j ) );
+    }
+  }
 
   // check feed first, and if only water is present (e.g., pure water injection), do nothing
   if( zw >= 1.0 )
@@ -52,7 +81,8 @@ bool BlackOilFlash::computeEquilibrium( BlackOilFlashMultiphaseSystemProperties
     sysProps.setWaterFraction( zw );
 
     // compositions
-    const std::vector< double > zeroMoleComposition{ 0.0, 0.0, 0.0 };
+    std::vector< double > & zeroMoleComposition = m_oilMoleComposition;
+    zeroMoleComposition.assign( { 0.0, 0.0, 0.0 } );
     sysProps.setOilMoleComposition( zeroMoleComposition );
     sysProps.setGasMoleComposition( zeroMoleComposition );
     
@@ -60,24 +90,20 @@ bool BlackOilFlash::computeEquilibrium( BlackOilFlashMultiphaseSystemProperties
     BlackOilDeadOilProperties tmp( 0.0, 0.0, 0.0 );
     sysProps.setOilModelProperties( tmp );
     sysProps.setGasModelProperties( tmp );
-
-    // water
-    auto const waterProperties = m_waterPhaseModel.computeProperties( pressure );
-    sysProps.setWaterModelProperties( waterProperties );
-    
-    return true;
   }
   else
   {    
     // OIL
     const double & oilSurfaceMoleDensity = m_oilPhaseModel.getSurfaceMoleDensity();
     const double & oilSurfaceMassDensity = m_oilPhaseModel.getSurfaceMassDensity();
-    const double rsSat = m_oilPhaseModel.computeRs( pressure );
+    double drsSat_dP;
+    const double rsSat = m_oilPhaseModel.computeRs( pressure, drsSat_dP, &m_oilSearchHints );
     
     // GAS
     const double & gasSurfaceMoleDensity = m_gasPhaseModel.getSurfaceMoleDensity();
     const double & gasSurfaceMassDensity = m_gasPhaseModel.getSurfaceMassDensity();
-    const double rvSat = m_gasPhaseModel.computeRv( pressure );
+    double drvSat_dP;
+    const double rvSat = m_gasPhaseModel.computeRv( pressure, drvSat_dP, &m_gasSearchHints );
 
     // Phase State - Negative flash type
     double const Ko = rvSat * ( oilSurfaceMoleDensity + gasSurfaceMoleDensity * rsSat ) / ( gasSurfaceMoleDensity + oilSurfaceMoleDensity * rvSat );
@@ -92,20 +118,55 @@ bool BlackOilFlash::computeEquilibrium( BlackOilFlashMultiphaseSystemProperties
       sysProps.setWaterFraction( zw );
       // OIL
       const double tmpOil = oilSurfaceMoleDensity / ( oilSurfaceMoleDensity + gasSurfaceMoleDensity * rsSat );
-      const std::vector< double > oilMoleComposition{ tmpOil, 1. - tmpOil, 0. }; // FIXME always 0.
+      std::vector< double > & oilMoleComposition = m_oilMoleComposition;
+      oilMoleComposition.assign( { tmpOil, 1. - tmpOil, 0. } ); // FIXME always 0.
       sysProps.setOilMoleComposition( oilMoleComposition );
 
-      auto const oilSaturatedProperties = m_oilPhaseModel.computeSaturatedProperties( pressure, gasSurfaceMoleDensity, gasSurfaceMassDensity );
-      sysProps.setOilModelProperties( oilSaturatedProperties );
-    
       // GAS
       const double tmpGas = gasSurfaceMoleDensity / ( gasSurfaceMoleDensity + oilSurfaceMoleDensity * rvSat );
-      const std::vector< double > gasMoleComposition{ 1. - tmpGas, tmpGas, 0. }; // FIXME always 0.
+      std::vector< double > & gasMoleComposition = m_gasMoleComposition;
+      gasMoleComposition.assign( { 1. - tmpGas, tmpGas, 0. } ); // FIXME always 0.
       sysProps.setGasMoleComposition( gasMoleComposition );
-      
-      auto const gasSaturatedProperties = m_gasPhaseModel.computeSaturatedProperties( pressure, oilSurfaceMoleDensity, oilSurfaceMassDensity );
-      sysProps.setGasModelProperties( gasSaturatedProperties );
 
+      if( withDerivatives )
+      {
+        sysProps.setOilModelProperties( m_oilPhaseModel.computeSaturatedPropertiesAndDerivatives( pressure, gasSurfaceMoleDensity, gasSurfaceMassDensity, &m_oilSearchHints ) );
+        sysProps.setGasModelProperties( m_gasPhaseModel.computeSaturatedPropertiesAndDerivatives( pressure, oilSurfaceMoleDensity, oilSurfaceMassDensity, &m_gasSearchHints ) );
+
+        // K-values are ratios of A = rho_o + rho_g * Rs and B = rho_g + rho_o * Rv, which only depend on the pressure
+        const double A = oilSurfaceMoleDensity + gasSurfaceMoleDensity * rsSat;
+        const double B = gasSurfaceMoleDensity + oilSurfaceMoleDensity * rvSat;
+        const double dA = gasSurfaceMoleDensity * drsSat_dP;
+        const double dB = oilSurfaceMoleDensity * drvSat_dP;
+        const double dKo = ( drvSat_dP * A + rvSat * dA ) / B - Ko * dB / B;
+        const double dKg = dA / ( rsSat * B ) - Kg * ( drsSat_dP / rsSat + dB / B );
+
+        const double dV_dP = zo * dKg / ( ( 1. - Kg ) * ( 1. - Kg ) ) + zg * dKo / ( ( 1. - Ko ) * ( 1. - Ko ) );
+        sysProps.setPhaseMoleFractionDP( pvt::PHASE_TYPE::GAS, dV_dP );
+        sysProps.setPhaseMoleFractionDP( pvt::PHASE_TYPE::OIL, -dV_dP );
+        for( std::size_t j = 0; j < nComponents; ++j )
+        {
+          const double dV_dz = dFeed( 0, j ) / ( 1. - Kg ) + dFeed( 1, j ) / ( 1. - Ko );
+          sysProps.setPhaseMoleFractionDZ( pvt::PHASE_TYPE::GAS, j, dV_dz );
+          sysProps.setPhaseMoleFractionDZ( pvt::PHASE_TYPE::OIL, j, -dV_dz - dFeed( 2, j ) );
+        }
+
+        const double dTmpOil = -tmpOil * dA / A;
+        const double dTmpGas = -tmpGas * dB / B;
+        std::vector< double > & dMoleComposition = m_moleCompositionDerivatives;
+        dMoleComposition.assign( { dTmpOil, -dTmpOil, 0. } );
+        sysProps.setMoleCompositionDP( pvt::PHASE_TYPE::OIL, dMoleComposition );
+        dMoleComposition.assign( { -dTmpGas, dTmpGas, 0. } );
+        sysProps.setMoleCompositionDP( pvt::PHASE_TYPE::GAS, dMoleComposition );
+      }
+      else
+      {
+        auto const oilSaturatedProperties = m_oilPhaseModel.computeSaturatedProperties( pressure, gasSurfaceMoleDensity, gasSurfaceMassDensity, &m_oilSearchHints );
+        sysProps.setOilModelProperties( oilSaturatedProperties );
+
+        auto const gasSaturatedProperties = m_gasPhaseModel.computeSaturatedProperties( pressure, oilSurfaceMoleDensity, oilSurfaceMassDensity, &m_gasSearchHints );
+        sysProps.setGasModelProperties( gasSaturatedProperties );
+      }
     }
     else if( V > 1 ) //Only gas or undersaturated gas
     {
@@ -119,19 +180,48 @@ bool BlackOilFlash::computeEquilibrium( BlackOilFlashMultiphaseSystemProperties
       sysProps.setWaterFraction( zw );
 
       // OIL
-      std::vector< double > const oilMoleComposition{ zo, zg, 0. }; // FIXME always 0.
+      std::vector< double > & oilMoleComposition = m_oilMoleComposition;
+      oilMoleComposition.assign( { zo, zg, 0. } ); // FIXME always 0.
       sysProps.setOilMoleComposition( oilMoleComposition );
-      auto const oilUnderSaturatedProperties = m_oilPhaseModel.computeUnderSaturatedProperties( pressure, oilMoleComposition, gasSurfaceMoleDensity, gasSurfaceMassDensity );
-      sysProps.setOilModelProperties( oilUnderSaturatedProperties );
+
+      if( withDerivatives )
+      {
+        // Rs = ( zg / rho_g ) / ( zo / rho_o ) is given by the feed
+        const double rs = ( zg / gasSurfaceMoleDensity ) / ( zo / oilSurfaceMoleDensity );
+        std::vector< double > & dRs_dz = m_dRs_dz;
+        std::vector< double > & dMoleComposition = m_moleCompositionDerivatives;
+        dRs_dz.resize( nComponents );
+        for( std::size_t j = 0; j < nComponents; ++j )
+        {
+          dRs_dz[j] = dFeed( 1, j ) * oilSurfaceMoleDensity / ( gasSurfaceMoleDensity * zo ) - dFeed( 0, j ) * rs / zo;
+          sysProps.setPhaseMoleFractionDZ( pvt::PHASE_TYPE::OIL, j, -dFeed( 2, j ) );
+          dMoleComposition.assign( { dFeed( 0, j ), dFeed( 1, j ), 0. } );
+          sysProps.setMoleCompositionDZ( pvt::PHASE_TYPE::OIL, j, dMoleComposition );
+        }
+        auto const oilUnderSaturatedProperties = m_oilPhaseModel.computeUnderSaturatedPropertiesAndDerivatives( pressure, oilMoleComposition, gasSurfaceMoleDensity, gasSurfaceMassDensity, &m_oilSearchHints );
+        sysProps.setOilModelProperties( oilUnderSaturatedProperties, dRs_dz );
+      }
+      else
+      {
+        auto const oilUnderSaturatedProperties = m_oilPhaseModel.computeUnderSaturatedProperties( pressure, oilMoleComposition, gasSurfaceMoleDensity, gasSurfaceMassDensity, &m_oilSearchHints );
+        sysProps.setOilModelProperties( oilUnderSaturatedProperties );
+      }
     }
+  }
 
-    // Water
+  // Water
+  if( withDerivatives )
+  {
+    sysProps.setWaterModelProperties( m_waterPhaseModel.computePropertiesAndDerivatives( pressure ) );
+  }
+  else
+  {
     auto const waterProperties = m_waterPhaseModel.computeProperties( pressure );
     sysProps.setWaterModelProperties( waterProperties );
-    // FIXME be sure that waterComp = {0, 0, 1} is done...
-
-    return true;
   }
+  // FIXME be sure that waterComp = {0, 0, 1} is done...
+
+  return true;
 }
 
 }
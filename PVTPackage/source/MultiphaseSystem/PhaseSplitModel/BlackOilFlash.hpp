@@ -41,12 +41,41 @@ public:
 
   bool computeEquilibrium( BlackOilFlashMultiphaseSystemProperties & sysProperties ) const;
 
+  /**
+   * @brief Computes the equilibrium and its analytical derivatives w.r.t. pressure and feed.
+   * @param sysProps The data the flash algorithm will be using.
+   * @param derivativesComputed Set to false if the analytical derivatives could not be computed.
+   * @return True if the equilibrium computation succeeded.
+   *
+   * @note The feed derivatives follow the finite differences convention: the perturbed feed is normalized.
+   */
+  bool computeEquilibriumAndDerivatives( BlackOilFlashMultiphaseSystemProperties & sysProps,
+                                         bool & derivativesComputed ) const;
+
 private:
 
+  /**
+   * @brief Computes the equilibrium.
+   * @param sysProps The data the flash algorithm will be using.
+   * @param withDerivatives Whether the pressure and feed derivatives are computed as well.
+   * @return True if the equilibrium computation succeeded.
+   */
+  bool computeEquilibrium( BlackOilFlashMultiphaseSystemProperties & sysProps,
+                           bool withDerivatives ) const;
+
   BlackOil_OilModel m_oilPhaseModel;
   BlackOil_GasModel m_gasPhaseModel;
   BlackOil_WaterModel m_waterPhaseModel;
 
+  /// Search hints of the oil and gas models, which the successive flashes start from.
+  mutable BlackOil_OilModel::SearchHints m_oilSearchHints;
+  mutable BlackOil_GasModel::SearchHints m_gasSearchHints;
+
+  /// Buffers of the phase compositions and of their derivatives, which are reused from one call to the other.
+  mutable std::vector< double > m_oilMoleComposition, m_gasMoleComposition, m_moleCompositionDerivatives;
+  /// Buffer of the feed derivatives of the oil Rs.
+  mutable std::vector< double > m_dRs_dz;
+
 };
 
 }
@@ -18,6 +18,10 @@
 #include "Utils/math.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
 
 namespace PVTPackage
 {
@@ -25,216 +29,633 @@ namespace PVTPackage
 CompositionalFlash::CompositionalFlash( const std::vector< pvt::PHASE_TYPE > & phases,
                                         const std::vector< pvt::EOS_TYPE > & eosTypes,
                                         ComponentProperties const & componentProperties )
-  : m_componentProperties( componentProperties ) // FIXME still usefull?
+  : m_componentProperties( componentProperties ), // FIXME still usefull?
+    m_eosWorkspaces( phases.size() ),
+    m_eosProperties(),
+    m_eosPropertiesAndDerivatives( phases.size(), CubicEoSPhaseModel::PropertiesAndDerivatives( componentProperties.NComponents ) ),
+    m_ssiAccelerationType( pvt::SSI_ACCELERATION_TYPE::NONE ),
+    m_stabilityTestEnabled( false ),
+    m_stabilityTestWorkspace()
 {
+  m_phaseModelIndices.fill( phases.size() );
   for( std::size_t i = 0; i != phases.size(); ++i )
   {
-    m_phaseModels.insert(
-      { phases[i], CubicEoSPhaseModel( m_componentProperties, eosTypes[i], phases[i] ) }
-    );
+    m_phaseModels.push_back( CubicEoSPhaseModel( m_componentProperties, eosTypes[i], phases[i] ) );
+    const int phaseValue = static_cast< int >( phases[i] );
+    if( phaseValue >= 0 and phaseValue < static_cast< int >( m_phaseModelIndices.size() ) )
+    {
+      m_phaseModelIndices[phaseValue] = i;
+    }
   }
 }
 
 double CompositionalFlash::solveRachfordRiceEquation( const std::vector< double > & kValues,
                                                       const std::vector< double > & feed,
-                                                      const std::list< std::size_t > & nonZeroIndex )
+                                                      const std::vector< std::size_t > & nonZeroIndex ) const
 {
-  double gas_phase_mole_fraction = 0;
+  return m_rachfordRice.solve( kValues, feed, nonZeroIndex );
+}
 
-  //Numerical Parameters //TODO: move them outside the function
-  double SSI_tolerance = 1e-3;
-  int max_SSI_iterations = 200;
-  double Newton_tolerance = 1e-12;
-  int max_Newton_iterations = 30;
-  double epsilon = std::numeric_limits< double >::epsilon();
+void CompositionalFlash::computeWilsonGasLiquidKvalue( double pressure,
+                                                       double temperature,
+                                                       std::vector< double > & Kval ) const
+{
+  const auto nbc = m_componentProperties.NComponents;
+  const auto & Tc = m_componentProperties.Tc;
+  const auto & Pc = m_componentProperties.Pc;
+  const auto & Omega = m_componentProperties.Omega;
+
+  Kval.resize( nbc );
 
-  //Min and Max Kvalues for non-zero composition
-  double max_K = 0, min_K = 1 / epsilon;
-  for( auto it = nonZeroIndex.begin(); it != nonZeroIndex.end(); ++it )
+  //Gas-Oil
+  for( std::size_t i = 0; i != nbc; i++ )
   {
-    if( kValues[*it] > max_K )
-    {
-      max_K = kValues[*it];
-    }
-    if( kValues[*it] < min_K )
+    Kval[i] = Pc[i] / pressure * exp( 5.37 * ( 1 + Omega[i] ) * ( 1 - Tc[i] / temperature ) );
+  }
+}
+
+void CompositionalFlash::computeInitialGasLiquidKvalue( CompositionalMultiphaseSystemProperties const & sysProps,
+                                                        std::vector< double > & kValues ) const
+{
+  std::vector< double > const & initialKValues = sysProps.getInitialKValues();
+  if( initialKValues.empty() )
+  {
+    computeWilsonGasLiquidKvalue( sysProps.getPressure(), sysProps.getTemperature(), kValues );
+    return;
+  }
+
+  ASSERT( initialKValues.size() == m_componentProperties.NComponents, "Initial K-values must be defined for all the components" );
+  kValues = initialKValues;
+}
+
+double CompositionalFlash::computeFugacityTolerance( CompositionalMultiphaseSystemProperties const & sysProps )
+{
+  return sysProps.getInitialKValues().empty() ? 1e-8 : 1e-12;
+}
+
+double CompositionalFlash::computeWaterVaporKvalue( double pressure,
+                                                    double temperature ) const
+{
+  return exp( -4844.168051 / temperature + 12.93022442 ) * 1e5 / pressure;
+}
+
+void CompositionalFlash::computeWaterGasKvalue( double pressure,
+                                                double temperature,
+                                                std::vector< double > & Kval ) const
+{
+  const auto nbc = m_componentProperties.NComponents;
+  const auto water_index = m_componentProperties.WaterIndex;
+  Kval.assign( nbc, 0 );
+  Kval[water_index] = computeWaterVaporKvalue( pressure, temperature );
+}
+
+void CompositionalFlash::computeWaterOilKvalue( double pressure,
+                                                double temperature,
+                                                std::vector< double > & Kval ) const
+{
+  (void) pressure, (void) temperature;
+  const auto nbc = m_componentProperties.NComponents;
+  Kval.assign( nbc, 0 );
+}
+
+std::size_t CompositionalFlash::getPhaseModelIndex( pvt::PHASE_TYPE const & phase ) const
+{
+  const int phaseValue = static_cast< int >( phase );
+  if( phaseValue < 0 or phaseValue >= static_cast< int >( m_phaseModelIndices.size() ) or m_phaseModelIndices[phaseValue] == m_phaseModels.size() )
+  {
+    throw std::out_of_range( "Phase " + std::to_string( phaseValue ) + " is not defined" );
+  }
+  return m_phaseModelIndices[phaseValue];
+}
+
+const CubicEoSPhaseModel & CompositionalFlash::getCubicEoSPhaseModel( pvt::PHASE_TYPE const & phase ) const
+{
+  return m_phaseModels[getPhaseModelIndex( phase )];
+}
+
+CubicEoSPhaseModel::Workspace & CompositionalFlash::getCubicEoSWorkspace( pvt::PHASE_TYPE const & phase ) const
+{
+  return m_eosWorkspaces[getPhaseModelIndex( phase )];
+}
+
+void CompositionalFlash::computePhaseProperties( pvt::PHASE_TYPE const & phase,
+                                                 double pressure,
+                                                 double temperature,
+                                                 std::vector< double > const & composition,
+                                                 CompositionalMultiphaseSystemProperties & sysProps ) const
+{
+  getCubicEoSPhaseModel( phase ).computeAllProperties( pressure, temperature, composition, getCubicEoSWorkspace( phase ), m_eosProperties );
+  sysProps.setModelProperties( phase, m_eosProperties );
+}
+
+void CompositionalFlash::setSsiAccelerationType( pvt::SSI_ACCELERATION_TYPE const & accelerationType )
+{
+  m_ssiAccelerationType = accelerationType;
+}
+
+void CompositionalFlash::setStabilityTestEnabled( bool enabled )
+{
+  m_stabilityTestEnabled = enabled;
+}
+
+void CompositionalFlash::setPrecisionType( pvt::PRECISION_TYPE const & precisionType )
+{
+  for( CubicEoSPhaseModel & phaseModel: m_phaseModels )
+  {
+    phaseModel.setPrecisionType( precisionType );
+  }
+}
+
+pvt::FlashStatistics const & CompositionalFlash::getStatistics() const
+{
+  return m_statistics;
+}
+
+void CompositionalFlash::resetStatistics()
+{
+  m_statistics = pvt::FlashStatistics();
+}
+
+void CompositionalFlash::recordIterations( CompositionalMultiphaseSystemProperties const & sysProps,
+                                           std::size_t nIterations,
+                                           bool converged ) const
+{
+  if( sysProps.isFiniteDifferencesPerturbation() )
+  {
+    return;
+  }
+  ++m_statistics.nFlashes;
+  m_statistics.nIterations += nIterations;
+  m_statistics.maxIterations = std::max( m_statistics.maxIterations, nIterations );
+  if( not converged )
+  {
+    ++m_statistics.nNotConverged;
+  }
+}
+
+void CompositionalFlash::recordFlashTime( CompositionalMultiphaseSystemProperties const & sysProps,
+                                          std::chrono::steady_clock::time_point const & start ) const
+{
+  if( sysProps.isFiniteDifferencesPerturbation() )
+  {
+    return;
+  }
+  m_statistics.flashTime += std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+}
+
+CompositionalFlash::Stability CompositionalFlash::computeFeedStability( CompositionalMultiphaseSystemProperties & sysProps,
+                                                                       std::vector< std::size_t > const & components,
+                                                                       std::vector< double > const & kValues ) const
+{
+  const Stability hint = sysProps.getStabilityHint();
+  if( hint != Stability::UNKNOWN )
+  {
+    // The hints of the finite differences flashes come from their base flash, not from the shadow region cache
+    if( not sysProps.isFiniteDifferencesPerturbation() )
     {
-      min_K = kValues[*it];
+      ++m_statistics.nShadowRegionHits;
+      if( hint != Stability::UNSTABLE )
+      {
+        ++m_statistics.nSkippedFlashes;
+      }
     }
+    sysProps.setStabilityTestResult( Stability::UNKNOWN, 0. );
+    return hint;
   }
 
-  //Check for trivial solutions. This corresponds to bad Kvalues //TODO:to be fixed
-  if( max_K < 1.0 )
+  if( not m_stabilityTestEnabled )
   {
-    return gas_phase_mole_fraction = 0.0;
+    sysProps.setStabilityTestResult( Stability::UNKNOWN, 0. );
+    return Stability::UNKNOWN;
   }
-  if( min_K > 1.0 )
+
+  const auto start = std::chrono::steady_clock::now();
+  const StabilityTest::Result result = StabilityTest::run( sysProps.getPressure(),
+                                                           sysProps.getTemperature(),
+                                                           sysProps.getFeed(),
+                                                           components,
+                                                           kValues,
+                                                           getCubicEoSPhaseModel( pvt::PHASE_TYPE::OIL ),
+                                                           getCubicEoSWorkspace( pvt::PHASE_TYPE::OIL ),
+                                                           getCubicEoSPhaseModel( pvt::PHASE_TYPE::GAS ),
+                                                           getCubicEoSWorkspace( pvt::PHASE_TYPE::GAS ),
+                                                           m_eosProperties,
+                                                           m_stabilityTestWorkspace );
+  m_statistics.stabilityTestTime += std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+
+  ++m_statistics.nStabilityTests;
+  m_statistics.nStabilityIterations += result.nIterations;
+
+  Stability stability = Stability::UNSTABLE;
+  if( result.stable )
   {
-    return gas_phase_mole_fraction = 1.0;
+    ++m_statistics.nSkippedFlashes;
+    stability = result.liquidLike ? Stability::STABLE_OIL : Stability::STABLE_GAS;
   }
 
-  //Solver
-  //Find solution window
-  double x_min = 1.0 / ( 1 - max_K );
-  double x_max = 1.0 / ( 1 - min_K );
-  double sqrt_epsilon = sqrt( epsilon );
-  x_min = x_min + sqrt_epsilon * ( std::fabs( x_min ) + sqrt_epsilon );
-  x_max = x_max - sqrt_epsilon * ( std::fabs( x_max ) + sqrt_epsilon );
+  sysProps.setStabilityTestResult( stability, result.tangentPlaneDistance );
+  return stability;
+}
 
-  double current_error = 1 / epsilon;
+void CompositionalFlash::updateKValues( std::vector< double > const & fugacityRatios,
+                                        std::vector< std::size_t > const & components,
+                                        SuccessiveSubstitutionSteps & steps,
+                                        std::vector< double > & kValues ) const
+{
+  if( m_ssiAccelerationType == pvt::SSI_ACCELERATION_TYPE::NONE )
+  {
+    for( auto ic : components )
+    {
+      kValues[ic] *= fugacityRatios[ic];
+    }
+    return;
+  }
 
-  //SSI loop
-  double func_x_min = 0, func_x_mid = 0, func_x_max = 0;
-  bool recompute_min = true, recompute_max = true;
-  int SSI_iteration = 0;
-  while( ( current_error > SSI_tolerance ) && ( SSI_iteration < max_SSI_iterations ) )
+  // GDEM parameters: number of plain iterations between two extrapolations, and bound of the extrapolation factor
+  const std::size_t gdemPeriod = 3;
+  const double maxExtrapolation = 20.;
+
+  for( auto ic : components )
   {
-    double x_mid = 0.5 * ( x_min + x_max );
-    if( recompute_min )
-    { func_x_min = RachfordRiceFunction( kValues, feed, nonZeroIndex, x_min ); }
-    if( recompute_max )
-    { func_x_max = RachfordRiceFunction( kValues, feed, nonZeroIndex, x_max ); }
-    func_x_mid = RachfordRiceFunction( kValues, feed, nonZeroIndex, x_mid );
+    steps.current[ic] = std::log( fugacityRatios[ic] );
+  }
 
-    if( ( func_x_min < 0 ) && ( func_x_max < 0 ) )
+  double extrapolation = 1.;
+  if( steps.nPlainIterations >= gdemPeriod )
+  {
+    double b01 = 0., b11 = 0.;
+    for( auto ic : components )
     {
-      return gas_phase_mole_fraction = 0.0;
+      b01 += steps.current[ic] * steps.previous[ic];
+      b11 += steps.previous[ic] * steps.previous[ic];
     }
-    else if( ( func_x_min > 1 ) && ( func_x_max > 1 ) )
+    const double lambda = b11 > 0. ? b01 / b11 : 0.;
+    if( lambda > 0. and lambda < 1. )
     {
-      return gas_phase_mole_fraction = 1.0;
+      extrapolation = std::min( 1. / ( 1. - lambda ), maxExtrapolation );
     }
-    else if( func_x_min * func_x_mid < 0.0 )
+  }
+
+  if( extrapolation > 1. )
+  {
+    for( auto ic : components )
     {
-      x_max = x_mid;
-      recompute_max = true;
-      recompute_min = false;
+      kValues[ic] *= std::exp( extrapolation * steps.current[ic] );
     }
-    else if( func_x_max * func_x_mid < 0.0 )
+    steps.nPlainIterations = 0;
+  }
+  else
+  {
+    for( auto ic : components )
     {
-      x_min = x_mid;
-      recompute_max = false;
-      recompute_min = true;
+      kValues[ic] *= fugacityRatios[ic];
     }
+    ++steps.nPlainIterations;
+  }
 
-    current_error = std::min( std::fabs( func_x_max - func_x_min ), std::fabs( x_max - x_min ) );
-    SSI_iteration++;
+  std::swap( steps.current, steps.previous );
+}
 
-    if( SSI_iteration == max_SSI_iterations )
-      LOGWARNING( "Rachford-Rice SSI reached max number of iterations" );
+bool CompositionalFlash::updateKValuesNewton( double pressure,
+                                              double temperature,
+                                              std::vector< double > const & feed,
+                                              std::vector< std::size_t > const & components,
+                                              std::vector< double > const & oilMoleComposition,
+                                              std::vector< double > const & gasMoleComposition,
+                                              double vaporFraction,
+                                              std::vector< double > const & fugacityRatios,
+                                              bool isWarmStart,
+                                              std::vector< double > & kValues ) const
+{
+  if( m_ssiAccelerationType != pvt::SSI_ACCELERATION_TYPE::NEWTON and not isWarmStart )
+  {
+    return false;
   }
 
-  gas_phase_mole_fraction = 0.5 * ( x_max + x_min );
+  // Newton parameters: largest ln fugacity ratio to switch from successive substitution, and largest Newton step on ln K
+  const double newtonSwitchThreshold = 1.e-2;
+  const double maxNewtonStep = 1.;
 
-  //Newton loop
-  int Newton_iteration = 0;
-  double Newton_value = gas_phase_mole_fraction;
-  while( ( current_error > Newton_tolerance ) && ( Newton_iteration < max_Newton_iterations ) )
-  {
-    double delta_Newton = -RachfordRiceFunction( kValues, feed, nonZeroIndex, Newton_value ) / dRachfordRiceFunction_dx( kValues, feed, nonZeroIndex, Newton_value );
-    current_error = std::fabs( delta_Newton ) / std::fabs( Newton_value );
+  std::vector< std::size_t > const & active = components;
+  const std::size_t n = active.size();
 
-    // Test if we are stepping out of the [x_min;x_max] interval
-    if( Newton_value + delta_Newton < x_min )
+  NewtonWorkspace & workspace = m_newtonWorkspace;
+  std::vector< double > & rhs = workspace.rhs;
+  rhs.resize( n );
+  for( std::size_t i = 0; i != n; ++i )
+  {
+    rhs[i] = std::log( fugacityRatios[active[i]] );
+    if( std::fabs( rhs[i] ) > newtonSwitchThreshold )
     {
-      Newton_value = .5 * ( Newton_value + x_min );
+      return false;
     }
-    else if( Newton_value + delta_Newton > x_max )
+  }
+
+  CubicEoSPhaseModel::PropertiesAndDerivatives & oil = m_eosPropertiesAndDerivatives[getPhaseModelIndex( pvt::PHASE_TYPE::OIL )];
+  CubicEoSPhaseModel::PropertiesAndDerivatives & gas = m_eosPropertiesAndDerivatives[getPhaseModelIndex( pvt::PHASE_TYPE::GAS )];
+  getCubicEoSPhaseModel( pvt::PHASE_TYPE::OIL ).computeAllPropertiesAndDerivatives( pressure, temperature, oilMoleComposition,
+                                                                                     getCubicEoSWorkspace( pvt::PHASE_TYPE::OIL ), oil );
+  getCubicEoSPhaseModel( pvt::PHASE_TYPE::GAS ).computeAllPropertiesAndDerivatives( pressure, temperature, gasMoleComposition,
+                                                                                     getCubicEoSWorkspace( pvt::PHASE_TYPE::GAS ), gas );
+
+  // Derivatives of the Rachford-Rice solution: with t_i = 1 + V ( K_i - 1 ), dV/dlnK_j = ( z_j K_j / t_j^2 ) / sum_i z_i ( K_i - 1 )^2 / t_i^2
+  const double & V = vaporFraction;
+  std::vector< double > & t = workspace.t;
+  std::vector< double > & dV = workspace.dV;
+  t.resize( n );
+  dV.resize( n );
+  double dRachfordRice_dV = 0.;
+  for( std::size_t i = 0; i != n; ++i )
+  {
+    const std::size_t ic = active[i];
+    t[i] = 1. + V * ( kValues[ic] - 1. );
+    dRachfordRice_dV += feed[ic] * ( kValues[ic] - 1. ) * ( kValues[ic] - 1. ) / ( t[i] * t[i] );
+  }
+  for( std::size_t j = 0; j != n; ++j )
+  {
+    const std::size_t jc = active[j];
+    dV[j] = feed[jc] * kValues[jc] / ( t[j] * t[j] ) / dRachfordRice_dV;
+  }
+
+  // Jacobian of ln K_i + ln phi^V_i - ln phi^L_i w.r.t. ln K_j, using
+  // dx_k/dlnK_j = -x_k / t_k ( V K_k delta_kj + ( K_k - 1 ) dV_j ) and dy_k/dlnK_j = y_k delta_kj + K_k dx_k/dlnK_j
+  std::vector< double > & jacobian = workspace.jacobian;
+  std::vector< double > & dx = workspace.dx;
+  std::vector< double > & dy = workspace.dy;
+  jacobian.resize( n * n );
+  dx.resize( n );
+  dy.resize( n );
+  for( std::size_t j = 0; j != n; ++j )
+  {
+    for( std::size_t k = 0; k != n; ++k )
     {
-      Newton_value = .5 * ( Newton_value + x_max );
+      const std::size_t kc = active[k];
+      dx[k] = -oilMoleComposition[kc] / t[k] * ( ( k == j ? V * kValues[kc] : 0. ) + ( kValues[kc] - 1. ) * dV[j] );
+      dy[k] = ( k == j ? gasMoleComposition[kc] : 0. ) + kValues[kc] * dx[k];
     }
-    else
+    for( std::size_t i = 0; i != n; ++i )
     {
-      Newton_value = Newton_value + delta_Newton;
+      const std::size_t ic = active[i];
+      double value = i == j ? 1. : 0.;
+      for( std::size_t k = 0; k != n; ++k )
+      {
+        const std::size_t kc = active[k];
+        value += gas.lnFugacityCoefficients.dz[ic][kc] * dy[k] - oil.lnFugacityCoefficients.dz[ic][kc] * dx[k];
+      }
+      jacobian[i * n + j] = value;
     }
+  }
 
-    Newton_iteration++;
+  // The residual is -ln( fugacity ratio ), hence the right hand side
+  if( not math::SolveLinearSystem( jacobian, rhs, n, 1 ) )
+  {
+    return false;
+  }
+  for( double const & step: rhs )
+  {
+    if( not ( std::fabs( step ) <= maxNewtonStep ) )
+    {
+      return false;
+    }
+  }
 
-    if( Newton_iteration == max_Newton_iterations )
-      LOGWARNING( "Rachford-Rice Newton reached max number of iterations" );
+  for( std::size_t i = 0; i != n; ++i )
+  {
+    kValues[active[i]] *= std::exp( rhs[i] );
   }
 
-  return gas_phase_mole_fraction = Newton_value;
+  return true;
 }
 
-double CompositionalFlash::RachfordRiceFunction( const std::vector< double > & kValues,
-                                                 const std::vector< double > & feed,
-                                                 const std::list< std::size_t > & nonZeroIndex,
-                                                 double x )
+std::size_t CompositionalFlash::getNComponents() const
 {
-  double val = 0;
-  for( auto ic : nonZeroIndex )
-  {
-    const double K = ( kValues[ic] - 1.0 );
-    val = val + feed[ic] * K / ( 1.0 + x * K );
-  }
-  return val;
+  return m_componentProperties.NComponents;
 }
 
-double CompositionalFlash::dRachfordRiceFunction_dx( const std::vector< double > & kValues,
-                                                     const std::vector< double > & feed,
-                                                     const std::list< std::size_t > & nonZeroIndex,
-                                                     double x )
+std::size_t CompositionalFlash::getWaterIndex() const
 {
-  double val = 0;
-  for( auto ic : nonZeroIndex )
-  {
-    const double K = ( kValues[ic] - 1.0 );
-    const double R = K / ( 1.0 + x * K );
-    val = val - feed[ic] * R * R;
-  }
-  return val;
+  return m_componentProperties.WaterIndex;
 }
 
-std::vector< double > CompositionalFlash::computeWilsonGasLiquidKvalue( double pressure,
-                                                                        double temperature ) const
+namespace
 {
-  const auto nbc = m_componentProperties.NComponents;
-  const auto & Tc = m_componentProperties.Tc;
-  const auto & Pc = m_componentProperties.Pc;
-  const auto & Omega = m_componentProperties.Omega;
 
-  std::vector< double > Kval( nbc );
+/**
+ * @brief Chains the EOS derivatives of a phase with the derivatives of its composition, and stores them into @p sysProps.
+ * @param phase The phase.
+ * @param eos The phase properties and their derivatives w.r.t. pressure, temperature and phase composition.
+ * @param moleCompositionDerivatives The derivatives of the phase composition, for pressure, temperature, then each feed component.
+ * @param phaseMoleFractionDerivatives The derivatives of the phase mole fraction, same ordering.
+ * @param sysProps The destination.
+ */
+void setPhaseDerivatives( pvt::PHASE_TYPE const & phase,
+                          CubicEoSPhaseModel::PropertiesAndDerivatives const & eos,
+                          std::vector< std::vector< double > > const & moleCompositionDerivatives,
+                          std::vector< double > const & phaseMoleFractionDerivatives,
+                          CompositionalMultiphaseSystemProperties & sysProps )
+{
+  const std::size_t nComponents = eos.lnFugacityCoefficients.value.size();
 
-  //Gas-Oil
-  for( std::size_t i = 0; i != nbc; i++ )
+  for( std::size_t column = 0; column != moleCompositionDerivatives.size(); ++column )
   {
-    Kval[i] = Pc[i] / pressure * exp( 5.37 * ( 1 + Omega[i] ) * ( 1 - Tc[i] / temperature ) );
-  }
+    const std::vector< double > & dx = moleCompositionDerivatives[column];
 
-  return Kval;
+    auto chain = [&]( pvt::ScalarPropertyAndDerivatives< double > const & property ) -> double
+    {
+      double result = column == 0 ? property.dP : column == 1 ? property.dT : 0.;
+      for( std::size_t k = 0; k != nComponents; ++k )
+      {
+        result += property.dz[k] * dx[k];
+      }
+      return result;
+    };
+
+    const double dMassDensity = chain( eos.massDensity );
+    const double dMoleDensity = chain( eos.moleDensity );
+    const double dViscosity = chain( eos.viscosity );
+    const double dMolecularWeight = chain( eos.molecularWeight );
+    const double & dPhaseMoleFraction = phaseMoleFractionDerivatives[column];
+
+    if( column == 0 )
+    {
+      sysProps.setMassDensityDP( phase, dMassDensity );
+      sysProps.setMoleDensityDP( phase, dMoleDensity );
+      sysProps.setViscosityDP( phase, dViscosity );
+      sysProps.setMolecularWeightDP( phase, dMolecularWeight );
+      sysProps.setPhaseMoleFractionDP( phase, dPhaseMoleFraction );
+      sysProps.setMoleCompositionDP( phase, dx );
+    }
+    else if( column == 1 )
+    {
+      sysProps.setMassDensityDT( phase, dMassDensity );
+      sysProps.setMoleDensityDT( phase, dMoleDensity );
+      sysProps.setViscosityDT( phase, dViscosity );
+      sysProps.setMolecularWeightDT( phase, dMolecularWeight );
+      sysProps.setPhaseMoleFractionDT( phase, dPhaseMoleFraction );
+      sysProps.setMoleCompositionDT( phase, dx );
+    }
+    else
+    {
+      const std::size_t ic = column - 2;
+      sysProps.setMassDensityDZ( phase, ic, dMassDensity );
+      sysProps.setMoleDensityDZ( phase, ic, dMoleDensity );
+      sysProps.setViscosityDZ( phase, ic, dViscosity );
+      sysProps.setMolecularWeightDZ( phase, ic, dMolecularWeight );
+      sysProps.setPhaseMoleFractionDZ( phase, ic, dPhaseMoleFraction );
+      sysProps.setMoleCompositionDZ( phase, ic, dx );
+    }
+  }
 }
 
-std::vector< double > CompositionalFlash::computeWaterGasKvalue( double pressure,
-                                                                 double temperature ) const
-{
-  const auto nbc = m_componentProperties.NComponents;
-  const auto water_index = m_componentProperties.WaterIndex;
-  std::vector< double > Kval( nbc, 0 );
-  Kval[water_index] = exp( -4844.168051 / temperature + 12.93022442 ) * 1e5 / pressure;
-  return Kval;
 }
 
-std::vector< double > CompositionalFlash::computeWaterOilKvalue( double pressure,
-                                                                 double temperature ) const
+bool CompositionalFlash::computeTwoPhaseEquilibriumDerivatives( TwoPhaseEquilibrium const & equilibrium,
+                                                                std::size_t gasOnlyComponent,
+                                                                CompositionalMultiphaseSystemProperties & sysProps ) const
 {
-  (void) pressure, (void) temperature;
-  const auto nbc = m_componentProperties.NComponents;
-  return std::vector< double >( nbc, 0 );
-}
+  const double & pressure = sysProps.getPressure();
+  const double & temperature = sysProps.getTemperature();
+  const std::vector< double > & feed = sysProps.getFeed();
+
+  const std::size_t nComponents = getNComponents();
+  const std::vector< double > & x = equilibrium.oilMoleComposition;
+  const std::vector< double > & y = equilibrium.gasMoleComposition;
+  const double & V = equilibrium.gasPhaseMoleFraction;
+
+  const CubicEoSPhaseModel & oilModel = getCubicEoSPhaseModel( pvt::PHASE_TYPE::OIL );
+  const CubicEoSPhaseModel & gasModel = getCubicEoSPhaseModel( pvt::PHASE_TYPE::GAS );
+  CubicEoSPhaseModel::PropertiesAndDerivatives & oil = m_eosPropertiesAndDerivatives[getPhaseModelIndex( pvt::PHASE_TYPE::OIL )];
+  CubicEoSPhaseModel::PropertiesAndDerivatives & gas = m_eosPropertiesAndDerivatives[getPhaseModelIndex( pvt::PHASE_TYPE::GAS )];
+  oilModel.computeAllPropertiesAndDerivatives( pressure, temperature, x, getCubicEoSWorkspace( pvt::PHASE_TYPE::OIL ), oil );
+  gasModel.computeAllPropertiesAndDerivatives( pressure, temperature, y, getCubicEoSWorkspace( pvt::PHASE_TYPE::GAS ), gas );
+
+  // Unknowns are ordered as (x, y, V), and right hand sides as (P, T, z_0, ..., z_nc-1).
+  const std::size_t n = 2 * nComponents + 1;
+  const std::size_t nColumns = 2 + nComponents;
+  DerivativesWorkspace & workspace = m_derivativesWorkspace;
+  std::vector< double > & jacobian = workspace.jacobian;
+  std::vector< double > & rhs = workspace.rhs;
+  jacobian.assign( n * n, 0. );
+  rhs.assign( n * nColumns, 0. );
+
+  const double epsilon = std::numeric_limits< double >::epsilon();
+  for( std::size_t ic = 0; ic != nComponents; ++ic )
+  {
+    // Mass balance: ( 1 - V ) x_i + V y_i = z_i
+    double * row = &jacobian[ic * n];
+    row[ic] = 1. - V;
+    row[nComponents + ic] = V;
+    row[2 * nComponents] = y[ic] - x[ic];
+    for( std::size_t jc = 0; jc != nComponents; ++jc )
+    {
+      rhs[ic * nColumns + 2 + jc] = ( ic == jc ? 1. : 0. ) - feed[ic];
+    }
 
-const CubicEoSPhaseModel & CompositionalFlash::getCubicEoSPhaseModel( pvt::PHASE_TYPE const & phase ) const
-{
-  return m_phaseModels.at( phase );
-}
+    const std::size_t ie = nComponents + ic;
+    row = &jacobian[ie * n];
+    if( ic == gasOnlyComponent )
+    {
+      // x_i = 0
+      row[ic] = 1.;
+    }
+    else if( feed[ic] > epsilon )
+    {
+      // Equality of fugacities: ln x_i + ln phi^L_i - ln y_i - ln phi^V_i = 0
+      for( std::size_t kc = 0; kc != nComponents; ++kc )
+      {
+        row[kc] = oil.lnFugacityCoefficients.dz[ic][kc];
+        row[nComponents + kc] = -gas.lnFugacityCoefficients.dz[ic][kc];
+      }
+      row[ic] += 1. / x[ic];
+      row[nComponents + ic] -= 1. / y[ic];
+      rhs[ie * nColumns] = gas.lnFugacityCoefficients.dP[ic] - oil.lnFugacityCoefficients.dP[ic];
+      rhs[ie * nColumns + 1] = gas.lnFugacityCoefficients.dT[ic] - oil.lnFugacityCoefficients.dT[ic];
+    }
+    else
+    {
+      // Absent component, the equality of fugacities is written x_i phi^L_i = y_i phi^V_i
+      row[ic] = std::exp( oil.lnFugacityCoefficients.value[ic] );
+      row[nComponents + ic] = -std::exp( gas.lnFugacityCoefficients.value[ic] );
+    }
+  }
 
-std::size_t CompositionalFlash::getNComponents() const
-{
-  return m_componentProperties.NComponents;
-}
+  // Closure: sum_i ( y_i - x_i ) = 0
+  for( std::size_t ic = 0; ic != nComponents; ++ic )
+  {
+    jacobian[2 * nComponents * n + ic] = -1.;
+    jacobian[2 * nComponents * n + nComponents + ic] = 1.;
+  }
 
-std::size_t CompositionalFlash::getWaterIndex() const
-{
-  return m_componentProperties.WaterIndex;
+  if( not math::SolveLinearSystem( jacobian, rhs, n, nColumns ) )
+  {
+    return false;
+  }
+
+  std::vector< std::vector< double > > & dx = workspace.dx;
+  std::vector< std::vector< double > > & dy = workspace.dy;
+  std::vector< double > & dV = workspace.dV;
+  std::vector< double > & dL = workspace.dL;
+  dx.resize( nColumns );
+  dy.resize( nColumns );
+  dV.resize( nColumns );
+  dL.resize( nColumns );
+  for( std::size_t column = 0; column != nColumns; ++column )
+  {
+    dx[column].resize( nComponents );
+    dy[column].resize( nComponents );
+    for( std::size_t ic = 0; ic != nComponents; ++ic )
+    {
+      dx[column][ic] = rhs[ic * nColumns + column];
+      dy[column][ic] = rhs[( nComponents + ic ) * nColumns + column];
+    }
+    dV[column] = rhs[2 * nComponents * nColumns + column];
+  }
+
+  // Single phase after clamping: the phase gets the feed composition and the phase fractions are constant.
+  if( V <= 0. or V >= 1. )
+  {
+    const bool isGas = V >= 1.;
+    std::vector< std::vector< double > > & dFeed = isGas ? dy : dx;
+    for( std::size_t column = 0; column != nColumns; ++column )
+    {
+      for( std::size_t ic = 0; ic != nComponents; ++ic )
+      {
+        dFeed[column][ic] = column < 2 ? 0. : ( ic == column - 2 ? 1. : 0. ) - feed[ic];
+      }
+      dV[column] = 0.;
+    }
+    const pvt::PHASE_TYPE phase = isGas ? pvt::PHASE_TYPE::GAS : pvt::PHASE_TYPE::OIL;
+    ( isGas ? gasModel : oilModel ).computeAllPropertiesAndDerivatives( pressure, temperature, feed, getCubicEoSWorkspace( phase ), isGas ? gas : oil );
+  }
+
+  std::transform( dV.cbegin(), dV.cend(), dL.begin(), []( double d ) { return -d; } );
+
+  setPhaseDerivatives( pvt::PHASE_TYPE::OIL, oil, dx, dL, sysProps );
+  setPhaseDerivatives( pvt::PHASE_TYPE::GAS, gas, dy, dV, sysProps );
+
+  // Other phases (e.g. free water) have a constant composition and phase fraction.
+  std::vector< std::vector< double > > & noCompositionDerivatives = workspace.noCompositionDerivatives;
+  std::vector< double > & noPhaseMoleFractionDerivatives = workspace.noPhaseMoleFractionDerivatives;
+  noCompositionDerivatives.resize( nColumns );
+  for( std::vector< double > & d: noCompositionDerivatives )
+  {
+    d.assign( nComponents, 0. );
+  }
+  noPhaseMoleFractionDerivatives.assign( nColumns, 0. );
+  for( const pvt::PHASE_TYPE & phase: sysProps.getPhases() )
+  {
+    if( phase != pvt::PHASE_TYPE::OIL and phase != pvt::PHASE_TYPE::GAS )
+    {
+      const pvt::ArrayView< double > view = sysProps.getMoleComposition( phase ).value;
+      std::vector< double > & composition = workspace.composition;
+      composition.assign( view.begin(), view.end() );
+      CubicEoSPhaseModel::PropertiesAndDerivatives & eos = m_eosPropertiesAndDerivatives[getPhaseModelIndex( phase )];
+      getCubicEoSPhaseModel( phase ).computeAllPropertiesAndDerivatives( pressure, temperature, composition, getCubicEoSWorkspace( phase ), eos );
+      setPhaseDerivatives( phase, eos, noCompositionDerivatives, noPhaseMoleFractionDerivatives, sysProps );
+    }
+  }
+
+  return true;
 }
 
 }
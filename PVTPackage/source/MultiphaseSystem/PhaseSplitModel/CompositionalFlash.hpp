@@ -18,10 +18,14 @@
 #include "MultiphaseSystem/ComponentProperties.hpp"
 #include "MultiphaseSystem/MultiphaseSystemProperties/CompositionalMultiphaseSystemProperties.hpp"
 #include "MultiphaseSystem/PhaseModel/CubicEOS/CubicEoSPhaseModel.hpp"
+#include "MultiphaseSystem/PhaseSplitModel/RachfordRice.hpp"
+#include "MultiphaseSystem/PhaseSplitModel/StabilityTest.hpp"
 
 #include "pvt/pvt.hpp"
 
-#include <list>
+#include <array>
+#include <chrono>
+#include <vector>
 
 namespace PVTPackage
 {
@@ -34,43 +38,336 @@ public:
                       const std::vector< pvt::EOS_TYPE > & eosTypes,
                       ComponentProperties const & componentProperties );
 
+  /**
+   * @brief Selects the acceleration of the successive substitution iterations on the K-values.
+   * @param accelerationType The acceleration type.
+   */
+  void setSsiAccelerationType( pvt::SSI_ACCELERATION_TYPE const & accelerationType );
+
+  /**
+   * @brief Enables the stability test of the feed before the flash iterations.
+   * @param enabled True to enable the test.
+   */
+  void setStabilityTestEnabled( bool enabled );
+
+  /**
+   * @brief Selects the precision of the equation of state evaluations of all the phases.
+   * @param precisionType The precision type.
+   */
+  void setPrecisionType( pvt::PRECISION_TYPE const & precisionType );
+
+  /**
+   * @brief Access the iteration counters accumulated by the flash computations.
+   * @return Reference to const counters.
+   */
+  pvt::FlashStatistics const & getStatistics() const;
+
+  /**
+   * @brief Sets the iteration counters back to zero.
+   */
+  void resetStatistics();
+
 protected:
 
-  static double solveRachfordRiceEquation( const std::vector< double > & kValues,
-                                           const std::vector< double > & feed,
-                                           const std::list< std::size_t > & nonZeroIndex );
+  /**
+   * @brief Records one flash computation into the statistics, unless it is a finite differences flash.
+   * @param sysProps The properties of the flash.
+   * @param nIterations The number of successive substitution iterations.
+   * @param converged False if the maximum number of iterations was reached.
+   */
+  void recordIterations( CompositionalMultiphaseSystemProperties const & sysProps,
+                         std::size_t nIterations,
+                         bool converged ) const;
+
+  /**
+   * @brief Records the time spent in one flash computation into the statistics, unless it is a finite differences flash.
+   * @param sysProps The properties of the flash.
+   * @param start The time the flash computation started.
+   */
+  void recordFlashTime( CompositionalMultiphaseSystemProperties const & sysProps,
+                        std::chrono::steady_clock::time_point const & start ) const;
+
+  using Stability = CompositionalMultiphaseSystemProperties::Stability;
+
+  /**
+   * @brief Determines the stability of the feed before the flash iterations, and records it into the statistics
+   * unless it is a finite differences flash.
+   * @param sysProps The properties holding the pressure, temperature, feed and stability hint.
+   * The outcome of the stability test, if run, is stored into them.
+   * @param components The components present in the feed.
+   * @param kValues The K-values the trial phases are initialized from.
+   * @return The stability hint of @p sysProps if known. Otherwise, the outcome of the stability test if enabled, UNKNOWN if not.
+   *
+   * The phase of a stable feed is chosen from its molar volume, see StabilityTest::Result::liquidLike.
+   */
+  Stability computeFeedStability( CompositionalMultiphaseSystemProperties & sysProps,
+                                  std::vector< std::size_t > const & components,
+                                  std::vector< double > const & kValues ) const;
+
+  /**
+   * @brief The last two successive substitution steps, used to accelerate the iterations.
+   *
+   * One instance lives for one flash computation, or is reset between two of them.
+   */
+  struct SuccessiveSubstitutionSteps
+  {
+    explicit SuccessiveSubstitutionSteps( std::size_t nComponents )
+      : current( nComponents, 0. ),
+        previous( nComponents, 0. ),
+        nPlainIterations( 0 )
+    { }
+
+    /**
+     * @brief Starts a new flash computation, keeping the storage.
+     * @param nComponents The number of components.
+     */
+    void reset( std::size_t nComponents )
+    {
+      current.assign( nComponents, 0. );
+      previous.assign( nComponents, 0. );
+      nPlainIterations = 0;
+    }
+
+    /// The ln fugacity ratios of the current and previous iterations.
+    std::vector< double > current, previous;
+    /// The number of plain iterations since the last extrapolation.
+    std::size_t nPlainIterations;
+  };
+
+  /**
+   * @brief Updates the K-values from the fugacity ratios, possibly accelerating the iterations.
+   * @param fugacityRatios The fugacity ratios of the current iteration.
+   * @param components The components to update.
+   * @param steps The successive substitution steps.
+   * @param kValues The K-values to update.
+   *
+   * Plain successive substitution multiplies the K-values by the fugacity ratios.
+   * With GDEM, every few iterations the dominant eigenvalue lambda of the iterations is estimated from the last two steps,
+   * and the current step on ln K is extrapolated by 1 / (1 - lambda).
+   */
+  void updateKValues( std::vector< double > const & fugacityRatios,
+                      std::vector< std::size_t > const & components,
+                      SuccessiveSubstitutionSteps & steps,
+                      std::vector< double > & kValues ) const;
+
+  /**
+   * @brief Updates the oil/gas K-values with a Newton step on ln K, when close enough to convergence.
+   * @param pressure The pressure.
+   * @param temperature The temperature.
+   * @param feed The feed.
+   * @param components The components present in the feed.
+   * @param oilMoleComposition The oil composition of the current iterate.
+   * @param gasMoleComposition The gas composition of the current iterate.
+   * @param vaporFraction The Rachford-Rice solution of the current iterate.
+   * @param fugacityRatios The fugacity ratios of the current iterate.
+   * @param isWarmStart True if the flash started from initial K-values, which selects the Newton steps
+   * whatever the acceleration type, see computeFugacityTolerance.
+   * @param kValues The K-values to update.
+   * @return False if no Newton step was taken (not selected, residual too large or singular Jacobian),
+   * @p kValues being left unchanged.
+   *
+   * The residual ln K_i + ln phi^V_i(y) - ln phi^L_i(x) is differentiated through the Rachford-Rice solution
+   * and the analytical derivatives of the ln fugacity coefficients w.r.t. composition.
+   */
+  bool updateKValuesNewton( double pressure,
+                            double temperature,
+                            std::vector< double > const & feed,
+                            std::vector< std::size_t > const & components,
+                            std::vector< double > const & oilMoleComposition,
+                            std::vector< double > const & gasMoleComposition,
+                            double vaporFraction,
+                            std::vector< double > const & fugacityRatios,
+                            bool isWarmStart,
+                            std::vector< double > & kValues ) const;
+
+  /**
+   * @brief Solves the Rachford-Rice equation.
+   * @param kValues The K-values.
+   * @param feed The feed.
+   * @param nonZeroIndex The components present in the feed.
+   * @return The vapor fraction, possibly out of [0, 1].
+   */
+  double solveRachfordRiceEquation( const std::vector< double > & kValues,
+                                    const std::vector< double > & feed,
+                                    const std::vector< std::size_t > & nonZeroIndex ) const;
 
   // It may be possible to redefine these static functions as members in order to hide componentsProperties arg.
-  std::vector< double > computeWilsonGasLiquidKvalue( double pressure,
-                                                      double temperature ) const;
+  void computeWilsonGasLiquidKvalue( double pressure,
+                                     double temperature,
+                                     std::vector< double > & kValues ) const;
+
+  /**
+   * @brief Computes the K-values the flash starts from.
+   * @param sysProps The properties, holding the possible initial K-values.
+   * @param kValues The initial K-values of @p sysProps if any, the Wilson correlation otherwise.
+   */
+  void computeInitialGasLiquidKvalue( CompositionalMultiphaseSystemProperties const & sysProps,
+                                      std::vector< double > & kValues ) const;
 
-  std::vector< double > computeWaterGasKvalue( double pressure,
-                                               double temperature ) const;
+  /**
+   * @brief Computes the tolerance on the fugacity ratios below which the flash has converged.
+   * @param sysProps The properties, holding the possible initial K-values.
+   * @return 1e-8 for a flash started from the Wilson correlation, 1e-12 for a warm-started one.
+   *
+   * The finite differences flashes of a warm-started flash start from its solution.
+   * Both converge well below the perturbation (about 1e-8), so that these flashes follow the variations of the K-values
+   * instead of stopping at once, and so that the convergence error does not pollute the differences.
+   * Starting close to the solution, the negative flash takes Newton steps to reach the tighter tolerance in a few iterations.
+   */
+  static double computeFugacityTolerance( CompositionalMultiphaseSystemProperties const & sysProps );
 
-  std::vector< double > computeWaterOilKvalue( double pressure,
-                                               double temperature ) const;
+  /**
+   * @brief Computes the gas/water K-value of water, from its vapor pressure.
+   * @param pressure The pressure.
+   * @param temperature The temperature.
+   * @return The K-value.
+   */
+  double computeWaterVaporKvalue( double pressure,
+                                  double temperature ) const;
+
+  void computeWaterGasKvalue( double pressure,
+                              double temperature,
+                              std::vector< double > & kValues ) const;
+
+  void computeWaterOilKvalue( double pressure,
+                              double temperature,
+                              std::vector< double > & kValues ) const;
 
   const CubicEoSPhaseModel & getCubicEoSPhaseModel( const pvt::PHASE_TYPE & phase ) const;
 
+  /**
+   * @brief Access the scratch buffers of the equation of state of @p phase.
+   * @param phase The phase.
+   * @return The workspace, caching the temperature dependent terms of the phase model.
+   */
+  CubicEoSPhaseModel::Workspace & getCubicEoSWorkspace( const pvt::PHASE_TYPE & phase ) const;
+
+  /**
+   * @brief Computes the properties of @p phase for given @p composition and stores them into @p sysProps.
+   * @param phase The phase.
+   * @param pressure The pressure.
+   * @param temperature The temperature.
+   * @param composition The phase mole composition.
+   * @param sysProps The flash results.
+   *
+   * @note The scratch buffers of the equation of state are owned by the flash and reused from one call to the other,
+   * so a flash instance must not be used concurrently.
+   */
+  void computePhaseProperties( const pvt::PHASE_TYPE & phase,
+                               double pressure,
+                               double temperature,
+                               const std::vector< double > & composition,
+                               CompositionalMultiphaseSystemProperties & sysProps ) const;
+
   std::size_t getNComponents() const;
 
   std::size_t getWaterIndex() const;
 
+  /**
+   * @brief The converged two-phase (possibly negative) flash, before it gets clamped to a single phase.
+   */
+  struct TwoPhaseEquilibrium
+  {
+    std::vector< double > oilMoleComposition;
+    std::vector< double > gasMoleComposition;
+    double gasPhaseMoleFraction;
+  };
+
+  /**
+   * @brief Computes the analytical derivatives of a converged two-phase flash and stores them into @p sysProps.
+   * @param equilibrium The converged flash, before clamping.
+   * @param gasOnlyComponent Index of a component that never enters the oil phase, getNComponents() if none.
+   * @param sysProps The flash results, which derivatives are updated.
+   * @return False if the derivatives could not be computed.
+   *
+   * The implicit function theorem is applied to the mass balance, the equality of fugacities and the phase compositions closure.
+   * Feed derivatives follow the convention of the finite difference process (perturbation of z_j then normalization),
+   * i.e. they are taken along the direction e_j - z.
+   * Phases other than oil and gas keep a constant composition and phase fraction,
+   * only the pressure and temperature derivatives of their properties are computed.
+   */
+  bool computeTwoPhaseEquilibriumDerivatives( TwoPhaseEquilibrium const & equilibrium,
+                                              std::size_t gasOnlyComponent,
+                                              CompositionalMultiphaseSystemProperties & sysProps ) const;
+
 private:
 
-  std::map< pvt::PHASE_TYPE, CubicEoSPhaseModel > m_phaseModels;
+  /// The model of each phase.
+  std::vector< CubicEoSPhaseModel > m_phaseModels;
+  /// Index in m_phaseModels of each pvt::PHASE_TYPE (by value), or m_phaseModels.size() if the phase is not defined.
+  std::array< std::size_t, 3 > m_phaseModelIndices;
+
+  /**
+   * @brief Gets the index of the model of @p phase in m_phaseModels.
+   * @param phase The phase.
+   * @return The index.
+   * @throw std::out_of_range if @p phase is not defined.
+   */
+  std::size_t getPhaseModelIndex( const pvt::PHASE_TYPE & phase ) const;
 
   const ComponentProperties m_componentProperties;
 
-  static double RachfordRiceFunction( const std::vector< double > & kValues,
-                                      const std::vector< double > & feed,
-                                      const std::list< std::size_t > & nonZeroIndex,
-                                      double x );
+  /// Scratch buffers of the equation of state computations, one per phase model.
+  mutable std::vector< CubicEoSPhaseModel::Workspace > m_eosWorkspaces;
+  /// Reused output of the equation of state computations.
+  mutable CubicEoSPhaseModel::Properties m_eosProperties;
+  /// Reused output of the equation of state computations with derivatives, one per phase model.
+  mutable std::vector< CubicEoSPhaseModel::PropertiesAndDerivatives > m_eosPropertiesAndDerivatives;
+
+  /**
+   * @brief Scratch buffers of the Newton steps on the K-values, see updateKValuesNewton.
+   */
+  struct NewtonWorkspace
+  {
+    /// The right hand side, then the Newton step.
+    std::vector< double > rhs;
+    /// t_i = 1 + V ( K_i - 1 ) and dV/dlnK_j.
+    std::vector< double > t, dV;
+    /// dx_k/dlnK_j and dy_k/dlnK_j for one j.
+    std::vector< double > dx, dy;
+    /// The jacobian, row-major.
+    std::vector< double > jacobian;
+  };
+
+  /// Reused scratch buffers of the Newton steps.
+  mutable NewtonWorkspace m_newtonWorkspace;
+
+  /**
+   * @brief Scratch buffers of the analytical derivatives, see computeTwoPhaseEquilibriumDerivatives.
+   */
+  struct DerivativesWorkspace
+  {
+    /// The jacobian, row-major.
+    std::vector< double > jacobian;
+    /// The right hand sides, then the derivatives of the unknowns.
+    std::vector< double > rhs;
+    /// The derivatives of the oil and gas compositions, for pressure, temperature, then each feed component.
+    std::vector< std::vector< double > > dx, dy;
+    /// The derivatives of the gas and oil phase mole fractions, same ordering.
+    std::vector< double > dV, dL;
+    /// The zero derivatives of the phases of constant composition and phase mole fraction.
+    std::vector< std::vector< double > > noCompositionDerivatives;
+    std::vector< double > noPhaseMoleFractionDerivatives;
+    /// The composition of such a phase.
+    std::vector< double > composition;
+  };
+
+  /// Reused scratch buffers of the analytical derivatives.
+  mutable DerivativesWorkspace m_derivativesWorkspace;
+
+  /// The acceleration of the successive substitution iterations.
+  pvt::SSI_ACCELERATION_TYPE m_ssiAccelerationType;
+
+  /// True if the stability test runs before the flash iterations.
+  bool m_stabilityTestEnabled;
+  /// Reused scratch buffers of the stability test.
+  mutable StabilityTest::Workspace m_stabilityTestWorkspace;
+
+  /// Reused Rachford-Rice solver.
+  mutable RachfordRice m_rachfordRice;
 
-  static double dRachfordRiceFunction_dx( const std::vector< double > & kValues,
-                                          const std::vector< double > & feed,
-                                          const std::list< std::size_t > & nonZeroIndex,
-                                          double x );
+  /// Iteration counters.
+  mutable pvt::FlashStatistics m_statistics;
 };
 
 }
@@ -19,6 +19,8 @@
 #include "MultiphaseSystem/PhaseModel/BlackOil/DeadOil_PhaseModel.hpp"
 
 #include <algorithm>
+#include <stdexcept>
+#include <string>
 
 namespace PVTPackage
 {
@@ -80,6 +82,19 @@ BlackOil_WaterModel const & DeadOilFlash::getWaterPhaseModel() const
 }
 
 bool DeadOilFlash::computeEquilibrium( DeadOilFlashMultiphaseSystemProperties & sysProps ) const
+{
+  return computeEquilibrium( sysProps, false );
+}
+
+bool DeadOilFlash::computeEquilibriumAndDerivatives( DeadOilFlashMultiphaseSystemProperties & sysProps,
+                                                     bool & derivativesComputed ) const
+{
+  derivativesComputed = true;
+  return computeEquilibrium( sysProps, true );
+}
+
+bool DeadOilFlash::computeEquilibrium( DeadOilFlashMultiphaseSystemProperties & sysProps,
+                                       bool withDerivatives ) const
 {
   const auto & pressure = sysProps.getPressure();
 
@@ -90,30 +105,217 @@ bool DeadOilFlash::computeEquilibrium( DeadOilFlashMultiphaseSystemProperties &
                                         sysProps.getPhases().cend(),
                                         pvt::PHASE_TYPE::LIQUID_WATER_RICH ) != sysProps.getPhases().cend();
 
+  if( withDerivatives )
+  {
+    sysProps.resetDerivatives();
+
+    // The phase fractions are the feed (oil first, water last), the perturbed feed being normalized
+    std::vector< double > const & feed = sysProps.getFeed();
+    std::size_t const nComponents = feed.size();
+    auto const setPhaseMoleFractionDZ = [&]( pvt::PHASE_TYPE const & phase, std::size_t k )
+    {
+      for( std::size_t j = 0; j < nComponents; ++j )
+      {
+        sysProps.setPhaseMoleFractionDZ( phase, j, ( j == k ? 1. : 0. ) - feed[k] );
+      }
+    };
+    setPhaseMoleFractionDZ( pvt::PHASE_TYPE::OIL, 0 );
+    if( containsGas )
+    {
+      setPhaseMoleFractionDZ( pvt::PHASE_TYPE::GAS, 1 );
+    }
+    if( containsWater )
+    {
+      setPhaseMoleFractionDZ( pvt::PHASE_TYPE::LIQUID_WATER_RICH, nComponents - 1 );
+    }
+  }
+
   // OIL
   const DeadOil_PhaseModel & oilPhaseModel = getOilPhaseModel();  
-  auto const oilProps = oilPhaseModel.computeProperties( pressure );
-  sysProps.setOilModelProperties( oilProps );
+  if( withDerivatives )
+  {
+    sysProps.setOilModelProperties( oilPhaseModel.computePropertiesAndDerivatives( pressure, &m_oilSearchHints ) );
+  }
+  else
+  {
+    auto const oilProps = oilPhaseModel.computeProperties( pressure, &m_oilSearchHints );
+    sysProps.setOilModelProperties( oilProps );
+  }
 
   // GAS
   if( containsGas )
   {
     const DeadOil_PhaseModel & gasPhaseModel = getGasPhaseModel();
-    auto const gasProps = gasPhaseModel.computeProperties( pressure );
-    sysProps.setGasModelProperties( gasProps );
+    if( withDerivatives )
+    {
+      sysProps.setGasModelProperties( gasPhaseModel.computePropertiesAndDerivatives( pressure, &m_gasSearchHints ) );
+    }
+    else
+    {
+      auto const gasProps = gasPhaseModel.computeProperties( pressure, &m_gasSearchHints );
+      sysProps.setGasModelProperties( gasProps );
+    }
   }
 
   // WATER
   if( containsWater )
   {
     const BlackOil_WaterModel & waterPhaseModel = getWaterPhaseModel();
-    auto const waterProps = waterPhaseModel.computeProperties( pressure );
-    sysProps.setWaterModelProperties( waterProps );
+    if( withDerivatives )
+    {
+      sysProps.setWaterModelProperties( waterPhaseModel.computePropertiesAndDerivatives( pressure ) );
+    }
+    else
+    {
+      auto const waterProps = waterPhaseModel.computeProperties( pressure );
+      sysProps.setWaterModelProperties( waterProps );
+    }
   }
 
   return true;
 }
 
+bool DeadOilFlash::computeEquilibriaAndDerivatives( std::size_t nCells,
+                                                    double const * pressures,
+                                                    double const * feeds,
+                                                    pvt::MultiphaseSystemBatchProperties const & outputs ) const
+{
+  std::size_t const nComponents = 1 + ( m_gasPhaseModel != nullptr ? 1 : 0 ) + ( m_waterPhaseModel != nullptr ? 1 : 0 );
+  std::size_t const nPhases = outputs.phases.size();
+  std::size_t const recordSize = pvt::MultiphaseSystemBatchProperties::recordSize( nComponents );
+
+  std::vector< std::size_t > feedIndices;
+  feedIndices.reserve( nPhases );
+  for( pvt::PHASE_TYPE const & phase: outputs.phases )
+  {
+    feedIndices.push_back( getFeedIndex( phase ) );
+  }
+
+  m_batchScratch.resize( 8 * s_batchChunkSize );
+  double * const scratch = m_batchScratch.data();
+  BlackOilDeadOilBatchProperties properties;
+  properties.B = scratch;
+  properties.dB_dP = scratch + s_batchChunkSize;
+  properties.massDensity = scratch + 2 * s_batchChunkSize;
+  properties.dMassDensity_dP = scratch + 3 * s_batchChunkSize;
+  properties.moleDensity = scratch + 4 * s_batchChunkSize;
+  properties.dMoleDensity_dP = scratch + 5 * s_batchChunkSize;
+  properties.viscosity = scratch + 6 * s_batchChunkSize;
+  properties.dViscosity_dP = scratch + 7 * s_batchChunkSize;
+
+  // Records only hold a value and a pressure derivative, except the phase mole fractions (the feed)
+  auto writeRecord = [recordSize]( double * record, double value, double dP )
+  {
+    std::fill( record, record + recordSize, 0. );
+    record[0] = value;
+    record[1] = dP;
+  };
+
+  // As the single cell flash, the batched one extrapolates the tables and always succeeds
+  if( outputs.succeeded != nullptr )
+  {
+    std::fill( outputs.succeeded, outputs.succeeded + nCells, true );
+  }
+
+  for( std::size_t begin = 0; begin < nCells; begin += s_batchChunkSize )
+  {
+    std::size_t const chunkSize = nCells - begin < s_batchChunkSize ? nCells - begin : s_batchChunkSize;
+    for( std::size_t iPhase = 0; iPhase < nPhases; ++iPhase )
+    {
+      std::size_t const k = feedIndices[iPhase];
+      computePhaseProperties( outputs.phases[iPhase], chunkSize, pressures + begin, properties );
+
+      for( std::size_t i = 0; i < chunkSize; ++i )
+      {
+        std::size_t const iCell = begin + i;
+        std::size_t const offset = ( iCell * nPhases + iPhase ) * recordSize;
+        double const massDensity = properties.massDensity[i];
+        double const moleDensity = properties.moleDensity[i];
+
+        if( outputs.massDensity != nullptr )
+        {
+          writeRecord( outputs.massDensity + offset, massDensity, properties.dMassDensity_dP[i] );
+        }
+        if( outputs.moleDensity != nullptr )
+        {
+          writeRecord( outputs.moleDensity + offset, moleDensity, properties.dMoleDensity_dP[i] );
+        }
+        if( outputs.viscosity != nullptr )
+        {
+          writeRecord( outputs.viscosity + offset, properties.viscosity[i], properties.dViscosity_dP[i] );
+        }
+        if( outputs.molecularWeight != nullptr )
+        {
+          double const molecularWeight = moleDensity > 0 ? massDensity / moleDensity : 0.0;
+          double const dMolecularWeight_dP = moleDensity > 0 ? ( properties.dMassDensity_dP[i] - molecularWeight * properties.dMoleDensity_dP[i] ) / moleDensity : 0.0;
+          writeRecord( outputs.molecularWeight + offset, molecularWeight, dMolecularWeight_dP );
+        }
+        // Each phase holds a single component, its phase fraction being the feed one (see computeEquilibrium)
+        if( outputs.phaseMoleFraction != nullptr )
+        {
+          double const * const feed = feeds + iCell * nComponents;
+          double * const record = outputs.phaseMoleFraction + offset;
+          writeRecord( record, feed[k], 0. );
+          for( std::size_t j = 0; j < nComponents; ++j )
+          {
+            record[FactorMultiphaseSystemProperties::DZ + j] = ( j == k ? 1. : 0. ) - feed[k];
+          }
+        }
+        if( outputs.moleComposition != nullptr )
+        {
+          for( std::size_t ic = 0; ic < nComponents; ++ic )
+          {
+            writeRecord( outputs.moleComposition + offset * nComponents + ic * recordSize, ic == k ? 1. : 0., 0. );
+          }
+        }
+      }
+    }
+  }
+
+  return true;
 }
 
+std::size_t DeadOilFlash::getFeedIndex( pvt::PHASE_TYPE const & phase ) const
+{
+  switch( phase )
+  {
+    case pvt::PHASE_TYPE::OIL:
+      return 0;
+    case pvt::PHASE_TYPE::GAS:
+      if( m_gasPhaseModel != nullptr )
+      {
+        return 1;
+      }
+      break;
+    case pvt::PHASE_TYPE::LIQUID_WATER_RICH:
+      if( m_waterPhaseModel != nullptr )
+      {
+        return m_gasPhaseModel != nullptr ? 2 : 1;
+      }
+      break;
+    default:
+      break;
+  }
+  throw std::out_of_range( "Phase " + std::to_string( static_cast< int >( phase ) ) + " is not defined" );
+}
+
+void DeadOilFlash::computePhaseProperties( pvt::PHASE_TYPE const & phase,
+                                           std::size_t n,
+                                           double const * pressures,
+                                           BlackOilDeadOilBatchProperties const & properties ) const
+{
+  switch( phase )
+  {
+    case pvt::PHASE_TYPE::OIL:
+      m_oilPhaseModel.computeProperties( n, pressures, properties, &m_oilSearchHints );
+      break;
+    case pvt::PHASE_TYPE::GAS:
+      m_gasPhaseModel->computeProperties( n, pressures, properties, &m_gasSearchHints );
+      break;
+    default:
+      m_waterPhaseModel->computeProperties( n, pressures, properties );
+      break;
+  }
+}
 
+}
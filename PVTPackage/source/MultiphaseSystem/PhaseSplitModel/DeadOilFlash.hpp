@@ -19,6 +19,10 @@
 #include "MultiphaseSystem/PhaseModel/BlackOil/BlackOil_WaterModel.hpp"
 #include "MultiphaseSystem/PhaseModel/BlackOil/DeadOil_PhaseModel.hpp"
 
+#include "pvt/pvt.hpp"
+
+#include <vector>
+
 namespace PVTPackage
 {
 
@@ -75,11 +79,71 @@ public:
 
   bool computeEquilibrium( DeadOilFlashMultiphaseSystemProperties & sysProps ) const;
 
+  /**
+   * @brief Computes the equilibrium and its analytical derivatives w.r.t. pressure and feed.
+   * @param sysProps The data the flash algorithm will be using.
+   * @param derivativesComputed Set to false if the analytical derivatives could not be computed.
+   * @return True if the equilibrium computation succeeded.
+   *
+   * @note The feed derivatives follow the finite differences convention: the perturbed feed is normalized.
+   */
+  bool computeEquilibriumAndDerivatives( DeadOilFlashMultiphaseSystemProperties & sysProps,
+                                         bool & derivativesComputed ) const;
+
+  /**
+   * @brief Computes the equilibria of @p nCells cells and their analytical derivatives w.r.t. pressure and feed.
+   * @param nCells Number of cells.
+   * @param pressures Contiguous pressures.
+   * @param feeds Contiguous feeds, laid out as [cell][component].
+   * @param outputs The caller-owned buffers.
+   * @return True if the computation succeeded for all the cells.
+   * @throw std::out_of_range if one of the phases of @p outputs is not defined.
+   *
+   * @note The results and the per cell success indicators are the same as the ones of computeEquilibriumAndDerivatives.
+   * The phase models are evaluated over chunks of cells at once.
+   */
+  bool computeEquilibriaAndDerivatives( std::size_t nCells,
+                                        double const * pressures,
+                                        double const * feeds,
+                                        pvt::MultiphaseSystemBatchProperties const & outputs ) const;
+
 private:
 
+  /**
+   * @brief Position of @p phase in the feed: oil first, water last.
+   * @throw std::out_of_range if @p phase is not defined.
+   */
+  std::size_t getFeedIndex( pvt::PHASE_TYPE const & phase ) const;
+
+  /**
+   * @brief Evaluates the model of @p phase and its pressure derivatives for @p n pressures at once.
+   */
+  void computePhaseProperties( pvt::PHASE_TYPE const & phase,
+                               std::size_t n,
+                               double const * pressures,
+                               BlackOilDeadOilBatchProperties const & properties ) const;
+
+  /**
+   * @brief Computes the equilibrium.
+   * @param sysProps The data the flash algorithm will be using.
+   * @param withDerivatives Whether the pressure and feed derivatives are computed as well.
+   * @return True if the equilibrium computation succeeded.
+   */
+  bool computeEquilibrium( DeadOilFlashMultiphaseSystemProperties & sysProps,
+                           bool withDerivatives ) const;
+
   DeadOil_PhaseModel m_oilPhaseModel;
   std::unique_ptr< DeadOil_PhaseModel > m_gasPhaseModel;
   std::unique_ptr< BlackOil_WaterModel > m_waterPhaseModel;
+
+  /// Search hints of the oil and gas models, which the successive flashes start from.
+  mutable DeadOil_PhaseModel::SearchHints m_oilSearchHints;
+  mutable DeadOil_PhaseModel::SearchHints m_gasSearchHints;
+
+  /// Number of cells which phase properties are evaluated at once by computeEquilibriaAndDerivatives.
+  static constexpr std::size_t s_batchChunkSize = 512;
+  /// Phase properties of a chunk of cells, reused from batch to batch.
+  mutable std::vector< double > m_batchScratch;
 };
 
 }
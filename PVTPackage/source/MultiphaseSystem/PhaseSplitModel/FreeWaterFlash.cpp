@@ -18,8 +18,10 @@
 
 #include "Utils/math.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <limits>
-#include <map>
 
 namespace PVTPackage
 {
@@ -34,7 +36,7 @@ FreeWaterFlash::FreeWaterFlash( const std::vector< pvt::PHASE_TYPE > & phases,
 
 bool FreeWaterFlash::isThreePhase( const std::vector< double > & kValues,
                                    const std::vector< double > & feed,
-                                   const std::list< std::size_t > & nonZeroIndex,
+                                   const std::vector< std::size_t > & nonZeroIndex,
                                    double KWater_GasWater,
                                    double KWater_OilWater,
                                    double waterFeed,
@@ -44,18 +46,12 @@ bool FreeWaterFlash::isThreePhase( const std::vector< double > & kValues,
 
   //Min and Max Kvalues for non-zero composition
   double max_K = 0, min_K = 1 / epsilon;
-  for( auto it = nonZeroIndex.begin(); it != nonZeroIndex.end(); ++it )
+  for( auto ic : nonZeroIndex )
   {
-    if( static_cast< std::size_t >(std::distance( nonZeroIndex.begin(), it )) != waterIndex )
+    if( ic != waterIndex )
     {
-      if( kValues[*it] > max_K )
-      {
-        max_K = kValues[*it];
-      }
-      if( kValues[*it] < min_K )
-      {
-        min_K = kValues[*it];
-      }
+      max_K = std::max( max_K, kValues[ic] );
+      min_K = std::min( min_K, kValues[ic] );
     }
   }
 
@@ -91,7 +87,7 @@ bool FreeWaterFlash::isThreePhase( const std::vector< double > & kValues,
 
 double FreeWaterFlash::modifiedRachfordRiceFunction( const std::vector< double > & kValues,
                                                      const std::vector< double > & feed,
-                                                     const std::list< std::size_t > & nonZeroIndex,
+                                                     const std::vector< std::size_t > & nonZeroIndex,
                                                      double kWater_GasWater,
                                                      double kWater_OilWater,
                                                      double waterFeed,
@@ -114,164 +110,85 @@ double FreeWaterFlash::modifiedRachfordRiceFunction( const std::vector< double >
   return val;
 }
 
-double FreeWaterFlash::dModifiedRachfordRiceFunction_dx( const std::vector< double > & kValues,
-                                                         const std::vector< double > & feed,
-                                                         const std::list< std::size_t > & nonZeroIndex,
-                                                         const double kWater_GasWater,
-                                                         const double kWater_OilWater,
-                                                         double waterFeed,
-                                                         std::size_t waterIndex,
-                                                         double x )
-{
-  double val = 0;
-  double kStarW = ( 1.0 - kWater_GasWater ) / ( 1.0 - kWater_OilWater );
-  double K_z_w = ( 1.0 - waterFeed ) / ( 1.0 - kWater_OilWater );
-  for( auto ic : nonZeroIndex )
-  {
-    if( ic != waterIndex )
-    {
-      const double K = ( kValues[ic] - kStarW );
-      const double R = K / ( K_z_w + x * K );
-      val = val - feed[ic] * R * R;
-    }
-  }
-  return val;
-}
-
 double FreeWaterFlash::solveModifiedRachfordRiceEquation( const std::vector< double > & kValues,
                                                           const std::vector< double > & feed,
-                                                          const std::list< std::size_t > & nonZeroIndex,
+                                                          const std::vector< std::size_t > & nonZeroIndex,
                                                           double kWater_gasWater,
                                                           double kWater_oilWater,
                                                           double waterFeed,
-                                                          std::size_t waterIndex )
+                                                          std::size_t waterIndex ) const
 {
-  double gas_phase_mole_fraction = 0;
+  //Numerical Parameters
+  const double bisectionTolerance = 1e-8;
+  const double epsilon = std::numeric_limits< double >::epsilon();
 
-  //Numerical Parameters //TODO: move them outside the function
-  double SSI_tolerance = 1e-8;
-  int max_SSI_iterations = 200;
-  double Newton_tolerance = 1e-12;
-  int max_Newton_iterations = 30;
-  double epsilon = std::numeric_limits< double >::epsilon();
+  const double kStarW = ( 1.0 - kWater_gasWater ) / ( 1.0 - kWater_oilWater );
+  const double K_z_w = ( 1.0 - waterFeed ) / ( 1.0 - kWater_oilWater );
 
-  //Min and Max Kvalues for non-zero composition
+  //Compact the non water components, with their coefficients K - kStarW, and find their min and max Kvalues
+  m_rachfordRiceFeed.clear();
+  m_rachfordRiceCoefficients.clear();
   double max_K = 0, min_K = 1 / epsilon;
-  for( auto it = nonZeroIndex.begin(); it != nonZeroIndex.end(); ++it )
+  for( auto ic : nonZeroIndex )
   {
-    if( static_cast< std::size_t >(std::distance( nonZeroIndex.begin(), it )) != waterIndex )
+    if( ic != waterIndex )
     {
-      if( kValues[*it] > max_K )
-      {
-        max_K = kValues[*it];
-      }
-      if( kValues[*it] < min_K )
-      {
-        min_K = kValues[*it];
-      }
+      m_rachfordRiceFeed.push_back( feed[ic] );
+      m_rachfordRiceCoefficients.push_back( kValues[ic] - kStarW );
+      max_K = std::max( max_K, kValues[ic] );
+      min_K = std::min( min_K, kValues[ic] );
     }
   }
 
   //Check for trivial solutions. This corresponds to bad Kvalues //TODO:to be fixed
   if( max_K < ( 1.0 - ( kWater_gasWater - kWater_oilWater ) / ( 1.0 - kWater_oilWater ) ) )
   {
-    return gas_phase_mole_fraction = 0.0;
+    return 0.0;
   }
   if( min_K > ( 1.0 - ( kWater_gasWater - kWater_oilWater ) / ( 1.0 - kWater_oilWater ) ) )
   {
-    return gas_phase_mole_fraction = 1.0;
+    return 1.0;
   }
 
-  //Solver
   //Find solution window
   double x_min = ( -1.0 - ( kWater_oilWater - waterFeed ) / ( 1.0 - kWater_oilWater ) )
                  / ( -1.0 + max_K + ( kWater_gasWater - kWater_oilWater ) / ( 1.0 - kWater_oilWater ) );
   double x_max = ( -1.0 - ( kWater_oilWater - waterFeed ) / ( 1.0 - kWater_oilWater ) )
                  / ( -1.0 + min_K + ( kWater_gasWater - kWater_oilWater ) / ( 1.0 - kWater_oilWater ) );
-  double sqrt_epsilon = sqrt( epsilon );
+  const double sqrt_epsilon = std::sqrt( epsilon );
   x_min = x_min + sqrt_epsilon * ( std::fabs( x_min ) + sqrt_epsilon );
   x_max = x_max - sqrt_epsilon * ( std::fabs( x_max ) + sqrt_epsilon );
 
-  double current_error = 1 / epsilon;
-
-  //SSI loop
-  double func_x_min = 0, func_x_mid = 0, func_x_max = 0;
-  int SSI_iteration = 0;
-  while( ( current_error > SSI_tolerance ) && ( SSI_iteration < max_SSI_iterations ) )
-  {
-    double x_mid = 0.5 * ( x_min + x_max );
-    func_x_min = 0;
-    func_x_mid = 0;
-    func_x_max = 0;
-
-    for( auto it = nonZeroIndex.begin(); it != nonZeroIndex.end(); ++it )
-    {
-      func_x_min = modifiedRachfordRiceFunction( kValues, feed, nonZeroIndex, kWater_gasWater, kWater_oilWater, waterFeed, waterIndex, x_min );
-      func_x_mid = modifiedRachfordRiceFunction( kValues, feed, nonZeroIndex, kWater_gasWater, kWater_oilWater, waterFeed, waterIndex, x_mid );
-      func_x_max = modifiedRachfordRiceFunction( kValues, feed, nonZeroIndex, kWater_gasWater, kWater_oilWater, waterFeed, waterIndex, x_max );
-    }
-
-    ASSERT( !std::isnan( func_x_min ), "Modified Rachford-Rice solver returns NaN" );
-    ASSERT( !std::isnan( func_x_mid ), "Modified Rachford-Rice solver returns NaN" );
-    ASSERT( !std::isnan( func_x_max ), "Modified Rachford-Rice solver returns NaN" );
-
-    if( ( func_x_min < 0 ) && ( func_x_max < 0 ) )
-    {
-      return gas_phase_mole_fraction = 0.0;
-    }
-
-    if( ( func_x_min > 1 ) && ( func_x_max > 1 ) )
-    {
-      return gas_phase_mole_fraction = 1.0;
-    }
-
-    if( func_x_min * func_x_mid < 0.0 )
-    {
-      x_max = x_mid;
-    }
-
-    if( func_x_max * func_x_mid < 0.0 )
-    {
-      x_min = x_mid;
-    }
-
-    current_error = std::min( std::fabs( func_x_max - func_x_min ), std::fabs( x_max - x_min ) );
-
-    SSI_iteration++;
-
-    if( SSI_iteration == max_SSI_iterations )
-    {
-      LOGWARNING( "Rachford-Rice SSI reached max number of iterations" );
-    }
-  }
-  gas_phase_mole_fraction = 0.5 * ( x_max + x_min );
-
-  //Newton loop
-  int Newton_iteration = 0;
-  double Newton_value = gas_phase_mole_fraction;
-  while( ( current_error > Newton_tolerance ) && ( Newton_iteration < max_Newton_iterations ) )
-  {
-    double delta_Newton =
-      -modifiedRachfordRiceFunction( kValues, feed, nonZeroIndex, kWater_gasWater, kWater_oilWater, waterFeed, waterIndex, Newton_value )
-      / dModifiedRachfordRiceFunction_dx( kValues, feed, nonZeroIndex, kWater_gasWater, kWater_oilWater, waterFeed, waterIndex, Newton_value );
+  //The modified function sum_i z_i ( K_i - kStarW ) / ( K_z_w + x ( K_i - kStarW ) ) has the form of the two phase one
+  return RachfordRice::solve( m_rachfordRiceFeed.size(), m_rachfordRiceFeed.data(), m_rachfordRiceCoefficients.data(),
+                              K_z_w, x_min, x_max, bisectionTolerance );
+}
 
-    current_error = std::fabs( delta_Newton ) / std::fabs( Newton_value );
-    Newton_value = Newton_value + delta_Newton;
-    Newton_iteration++;
+bool FreeWaterFlash::computeEquilibrium( FreeWaterFlashMultiphaseSystemProperties & sysProps ) const
+{
+  bool threePhase = false;
+  return computeEquilibrium( sysProps, nullptr, threePhase );
+}
 
-    if( Newton_iteration == max_Newton_iterations )
-    {
-      LOGWARNING( "Rachford-Rice Newton reached max number of iterations" );
-    }
-  }
-  return gas_phase_mole_fraction = Newton_value;
+bool FreeWaterFlash::computeEquilibriumAndDerivatives( FreeWaterFlashMultiphaseSystemProperties & sysProps,
+                                                       bool & derivativesComputed ) const
+{
+  TwoPhaseEquilibrium & equilibrium = m_equilibrium;
+  bool threePhase = false;
+  const bool success = computeEquilibrium( sysProps, &equilibrium, threePhase );
+  derivativesComputed = not threePhase and computeTwoPhaseEquilibriumDerivatives( equilibrium, getWaterIndex(), sysProps );
+  return success;
 }
 
-bool FreeWaterFlash::computeEquilibrium( FreeWaterFlashMultiphaseSystemProperties & sysProps ) const
+bool FreeWaterFlash::computeEquilibrium( FreeWaterFlashMultiphaseSystemProperties & sysProps,
+                                         TwoPhaseEquilibrium * equilibrium,
+                                         bool & threePhase ) const
 {
+  const auto start = std::chrono::steady_clock::now();
+
   // Equilibrium convergence parameters
   const int max_SSI_iterations = 100;
-  const double fugacityEpsilon = 1e-8;
+  const double fugacityEpsilon = computeFugacityTolerance( sysProps );
 
   const auto & pressure = sysProps.getPressure();
   const auto & temperature = sysProps.getTemperature();
@@ -289,17 +206,23 @@ bool FreeWaterFlash::computeEquilibrium( FreeWaterFlashMultiphaseSystemPropertie
   const std::vector< double > & gasLnFugacity = sysProps.getGasLnFugacity();
   const std::vector< double > & waterLnFugacity = sysProps.getWaterLnFugacity();
 
-  std::vector< double > fugacityRatios( nComponents ), fugacityRatiosW( nComponents );
+  std::vector< double > & fugacityRatios = m_fugacityRatios;
+  std::vector< double > & fugacityRatiosW = m_waterFugacityRatios;
+  fugacityRatios.resize( nComponents );
+  fugacityRatiosW.resize( nComponents );
 
   // Compute Equilibrium ratios
-  std::vector< double > kGasLiquid = computeWilsonGasLiquidKvalue( pressure, temperature );
+  // The water entry of the initial K-values, if any, is the gas/water K-value of water.
+  std::vector< double > & kGasLiquid = m_kValues;
+  computeInitialGasLiquidKvalue( sysProps, kGasLiquid );
+  double kWater_GasWater = sysProps.getInitialKValues().empty() ? computeWaterVaporKvalue( pressure, temperature ) : kGasLiquid[waterIndex];
   kGasLiquid[waterIndex] = std::numeric_limits< double >::max(); //std::numeric_limits<double>::infinity(); //No water in oil
-  double kWater_GasWater = computeWaterGasKvalue( pressure, temperature )[waterIndex];
   const double kWater_OilWater = 0.0;
 
   // Check for machine-zero feed values
   const double epsilon = std::numeric_limits< double >::epsilon();
-  std::list< std::size_t > positiveComponents;
+  std::vector< std::size_t > & positiveComponents = m_positiveComponents;
+  positiveComponents.clear();
   for( std::size_t i = 0; i != nComponents; ++i )
   {
     if( feed[i] > epsilon )
@@ -308,23 +231,21 @@ bool FreeWaterFlash::computeEquilibrium( FreeWaterFlashMultiphaseSystemPropertie
     }
   }
 
-  std::vector< double > oilMoleComposition( nComponents, 0. );
-  std::vector< double > gasMoleComposition( nComponents, 0. );
-  std::vector< double > waterMoleComposition( nComponents, 0. );
-  // This map holds references to the data so we can use them in loops
-  std::map< pvt::PHASE_TYPE, const std::vector< double > & > moleComposition{
-    { pvt::PHASE_TYPE::OIL,               oilMoleComposition },
-    { pvt::PHASE_TYPE::GAS,               gasMoleComposition },
-    { pvt::PHASE_TYPE::LIQUID_WATER_RICH, waterMoleComposition }
-  };
+  std::vector< double > & oilMoleComposition = m_oilMoleComposition;
+  std::vector< double > & gasMoleComposition = m_gasMoleComposition;
+  std::vector< double > & waterMoleComposition = m_waterMoleComposition;
+  // Phase slots indexed by pvt::PHASE_TYPE (GAS, OIL, LIQUID_WATER_RICH), so that the loops over the phases find the compositions without map lookup.
+  // The accesses are bounds checked, other phases throwing std::out_of_range.
+  std::array< std::vector< double > const *, 3 > const moleComposition{ { &gasMoleComposition, &oilMoleComposition, &waterMoleComposition } };
   double oilPhaseMoleFraction, gasPhaseMoleFraction, waterPhaseMoleFraction;
 
   gasMoleComposition.assign( nComponents, 0.0 );
   oilMoleComposition.assign( nComponents, 0.0 );
   waterMoleComposition.assign( nComponents, 0.0 );
 
-  bool threePhase = false;
-  int totalNbIter = 0;
+  threePhase = false;
+  bool converged = false;
+  std::size_t nIterations = max_SSI_iterations;
   for( int iter = 0; iter < max_SSI_iterations; ++iter )
   {
 
@@ -372,20 +293,18 @@ bool FreeWaterFlash::computeEquilibrium( FreeWaterFlashMultiphaseSystemPropertie
       //auto KWater_GasWater_max = water_feed / (gas_fraction*(1.0 - KWater_OilWater) + KWater_OilWater);
     }
 
-    oilMoleComposition = math::Normalize( oilMoleComposition );
-    gasMoleComposition = math::Normalize( gasMoleComposition );
+    math::NormalizeInPlace( oilMoleComposition );
+    math::NormalizeInPlace( gasMoleComposition );
     waterMoleComposition[waterIndex] = 1.0;
 
     // Compute phase fugacity
     for( const pvt::PHASE_TYPE phase: sysProps.getPhases() )
     {
-      const CubicEoSPhaseModel & model = getCubicEoSPhaseModel( phase );
-      const auto props = model.computeAllProperties( pressure, temperature, moleComposition.at( phase ) );
-      sysProps.setModelProperties( phase, props );
+      computePhaseProperties( phase, pressure, temperature, *moleComposition.at( static_cast< std::size_t >( phase ) ), sysProps );
     }
 
     // Compute fugacity ratio and check convergence
-    bool converged = true;
+    converged = true;
 
     for( auto ic : positiveComponents )
     {
@@ -405,6 +324,7 @@ bool FreeWaterFlash::computeEquilibrium( FreeWaterFlashMultiphaseSystemPropertie
 
     if( converged )
     {
+      nIterations = iter + 1;
       break;
     }
 
@@ -420,8 +340,18 @@ bool FreeWaterFlash::computeEquilibrium( FreeWaterFlashMultiphaseSystemPropertie
         kWater_GasWater *= fugacityRatiosW[ic];   //HACK: Only this water k-value is updated
       }
     }
+  }
+
+  recordIterations( sysProps, nIterations, converged );
+  m_outputKValues = kGasLiquid;
+  m_outputKValues[waterIndex] = kWater_GasWater;
+  sysProps.setKValues( m_outputKValues );
 
-    totalNbIter = iter;
+  if( equilibrium != nullptr and not threePhase )
+  {
+    equilibrium->oilMoleComposition = oilMoleComposition;
+    equilibrium->gasMoleComposition = gasMoleComposition;
+    equilibrium->gasPhaseMoleFraction = gasPhaseMoleFraction;
   }
 
   // Retrieve physical bounds from negative flash values
@@ -452,9 +382,7 @@ bool FreeWaterFlash::computeEquilibrium( FreeWaterFlashMultiphaseSystemPropertie
       }
 
       // Update phase properties since adjusting composition
-      const CubicEoSPhaseModel & model = getCubicEoSPhaseModel( phase );
-      const auto props = model.computeAllProperties( pressure, temperature, moleComposition.at( phase ) );
-      sysProps.setModelProperties( phase, props );
+      computePhaseProperties( phase, pressure, temperature, *moleComposition.at( static_cast< std::size_t >( phase ) ), sysProps );
     }
 
     waterPhaseMoleFraction = ( waterFeed + gasPhaseMoleFraction + ( kWater_OilWater - kWater_GasWater ) - kWater_OilWater )
@@ -479,9 +407,7 @@ bool FreeWaterFlash::computeEquilibrium( FreeWaterFlashMultiphaseSystemPropertie
       }
 
       // Update phase properties since adjusting composition
-      const CubicEoSPhaseModel & model = getCubicEoSPhaseModel( phase );
-      const auto props = model.computeAllProperties( pressure, temperature, moleComposition.at( phase ) );
-      sysProps.setModelProperties( phase, props );
+      computePhaseProperties( phase, pressure, temperature, *moleComposition.at( static_cast< std::size_t >( phase ) ), sysProps );
     }
 
     waterPhaseMoleFraction = 0.0;
@@ -508,7 +434,9 @@ bool FreeWaterFlash::computeEquilibrium( FreeWaterFlashMultiphaseSystemPropertie
   sysProps.setGasFraction( gasPhaseMoleFraction );
   sysProps.setWaterFraction( waterPhaseMoleFraction );
 
-  return totalNbIter != max_SSI_iterations;
+  recordFlashTime( sysProps, start );
+
+  return converged;
 }
 
 }
@@ -33,17 +33,46 @@ public:
                   const std::vector< pvt::EOS_TYPE > & eosTypes,
                   ComponentProperties const & componentProperties );
 
+  using CompositionalFlash::setPrecisionType;
+  using CompositionalFlash::setSsiAccelerationType;
+  using CompositionalFlash::getStatistics;
+  using CompositionalFlash::resetStatistics;
+
   bool computeEquilibrium( FreeWaterFlashMultiphaseSystemProperties & outVariables ) const;
 
+  /**
+   * @brief Computes the equilibrium and its analytical derivatives.
+   * @param sysProps The data the flash algorithm will be using.
+   * @param derivativesComputed Set to false if the analytical derivatives could not be computed.
+   * @return True if the equilibrium computation converged.
+   *
+   * @note In the three phase case, the water K-value is not part of the convergence criterion,
+   * the converged state does not satisfy the equality of fugacities that the derivatives rely on.
+   * No derivative is computed in that case.
+   */
+  bool computeEquilibriumAndDerivatives( FreeWaterFlashMultiphaseSystemProperties & sysProps,
+                                         bool & derivativesComputed ) const;
+
 protected:
 
   std::size_t m_WaterIndex;
 
 private:
 
+  /**
+   * @brief Computes the equilibrium.
+   * @param sysProps The data the flash algorithm will be using.
+   * @param equilibrium If not nullptr, receives the converged two phase flash before clamping.
+   * @param threePhase Set to true if the water phase is present.
+   * @return True if the equilibrium computation converged.
+   */
+  bool computeEquilibrium( FreeWaterFlashMultiphaseSystemProperties & sysProps,
+                           TwoPhaseEquilibrium * equilibrium,
+                           bool & threePhase ) const;
+
   static bool isThreePhase( const std::vector< double > & kValues,
                             const std::vector< double > & feed,
-                            const std::list< std::size_t > & nonZeroIndex,
+                            const std::vector< std::size_t > & nonZeroIndex,
                             double KWater_GasWater,
                             double KWater_OilWater,
                             double waterFeed,
@@ -51,29 +80,37 @@ private:
 
   static double modifiedRachfordRiceFunction( const std::vector< double > & kValues,
                                               const std::vector< double > & feed,
-                                              const std::list< std::size_t > & nonZeroIndex,
+                                              const std::vector< std::size_t > & nonZeroIndex,
                                               double kWater_GasWater,
                                               double kWater_OilWater,
                                               double waterFeed,
                                               std::size_t waterIndex,
                                               double x );
 
-  static double dModifiedRachfordRiceFunction_dx( const std::vector< double > & kValues,
-                                                  const std::vector< double > & feed,
-                                                  const std::list< std::size_t > & nonZeroIndex,
-                                                  double kWater_GasWater,
-                                                  double kWater_OilWater,
-                                                  double waterFeed,
-                                                  std::size_t waterIndex,
-                                                  double x );
-
-  static double solveModifiedRachfordRiceEquation( const std::vector< double > & kValues,
-                                                   const std::vector< double > & feed,
-                                                   const std::list< std::size_t > & nonZeroIndex,
-                                                   double kWater_gasWater,
-                                                   double kWater_oilWater,
-                                                   double waterFeed,
-                                                   std::size_t waterIndex );
+  /**
+   * @brief Solves the modified Rachford-Rice equation of the three phase case with the two phase engine.
+   * @return The gas phase mole fraction, 0 or 1 for trivial K-values.
+   */
+  double solveModifiedRachfordRiceEquation( const std::vector< double > & kValues,
+                                            const std::vector< double > & feed,
+                                            const std::vector< std::size_t > & nonZeroIndex,
+                                            double kWater_gasWater,
+                                            double kWater_oilWater,
+                                            double waterFeed,
+                                            std::size_t waterIndex ) const;
+
+  /// Reused compacted feed of the modified Rachford-Rice equation.
+  mutable std::vector< double > m_rachfordRiceFeed;
+  /// Reused coefficients of the modified Rachford-Rice equation.
+  mutable std::vector< double > m_rachfordRiceCoefficients;
+
+  /// Buffers of the flash computations, which are reused from one call to the other.
+  mutable std::vector< double > m_kValues, m_outputKValues, m_fugacityRatios, m_waterFugacityRatios;
+  mutable std::vector< double > m_oilMoleComposition, m_gasMoleComposition, m_waterMoleComposition;
+  /// The components present in the feed.
+  mutable std::vector< std::size_t > m_positiveComponents;
+  /// The converged two-phase flash handed over to the analytical derivatives.
+  mutable TwoPhaseEquilibrium m_equilibrium;
 };
 
 }
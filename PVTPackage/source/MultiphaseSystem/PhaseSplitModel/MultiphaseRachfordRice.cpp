@@ -0,0 +1,244 @@
+/*
+ * ------------------------------------------------------------------------------------------------------------
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (c) 2016-2024 Lawrence Livermore National Security LLC
+ * Copyright (c) 2018-2024 TotalEnergies
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University
+ * Copyright (c) 2018-2024 Chevron 
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors
+ * All rights reserved
+ *
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.
+ * ------------------------------------------------------------------------------------------------------------
+ */
+
+#include "MultiphaseSystem/PhaseSplitModel/MultiphaseRachfordRice.hpp"
+
+#include "Utils/Assert.hpp"
+#include "Utils/math.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace PVTPackage
+{
+
+MultiphaseRachfordRice::Result MultiphaseRachfordRice::solve( std::vector< std::vector< double > > const & kValues,
+                                                              std::vector< double > const & feed,
+                                                              std::vector< std::size_t > const & components,
+                                                              std::vector< double > & phaseFractions )
+{
+  // Numerical parameters
+  const std::size_t maxIterations = 50;
+  const double stepTolerance = 1.e-12;
+  const double gradientTolerance = 1.e-12;
+  const double armijo = 1.e-4;
+  const double minStep = 1.e-10;
+
+  const std::size_t nPhases = kValues.size() + 1;
+  const std::size_t nActive = components.size();
+
+  // The K-values and feed of the components present in the feed are compacted into contiguous arrays, as [component][phase].
+  std::vector< double > & k = m_kValues;
+  std::vector< double > & z = m_feed;
+  k.resize( nActive * nPhases );
+  z.resize( nActive );
+  {
+    std::size_t i = 0;
+    for( auto ic : components )
+    {
+      z[i] = feed[ic];
+      k[i * nPhases] = 1.;
+      for( std::size_t p = 1; p < nPhases; ++p )
+      {
+        ASSERT( kValues[p - 1][ic] > 0., "K-values must be positive" );
+        k[i * nPhases + p] = kValues[p - 1][ic];
+      }
+      ++i;
+    }
+  }
+
+  // Starting point, projected onto the simplex.
+  std::vector< double > & beta = phaseFractions;
+  if( beta.size() != nPhases )
+  {
+    beta.assign( nPhases, 1. / nPhases );
+  }
+  std::transform( beta.cbegin(), beta.cend(), beta.begin(), []( double b ) { return std::max( b, 0. ); } );
+  double sumBeta = 0.;
+  for( double b : beta )
+  {
+    sumBeta += b;
+  }
+  if( sumBeta > 0. )
+  {
+    std::transform( beta.cbegin(), beta.cend(), beta.begin(), [sumBeta]( double b ) { return b / sumBeta; } );
+  }
+  else
+  {
+    beta.assign( nPhases, 1. / nPhases );
+  }
+
+  std::vector< bool > & free = m_free;
+  free.resize( nPhases );
+  std::transform( beta.cbegin(), beta.cend(), free.begin(), []( double b ) { return b > 0.; } );
+
+  // Objective function, gradient and hessian, evaluated in one pass over the components.
+  std::vector< double > & t = m_t;
+  std::vector< double > & gradient = m_gradient;
+  std::vector< double > & hessian = m_hessian;
+  t.resize( nActive );
+  gradient.resize( nPhases );
+  hessian.resize( nPhases * nPhases );
+  auto objective = [&]( std::vector< double > const & b )
+  {
+    double f = 0.;
+    for( std::size_t i = 0; i < nActive; ++i )
+    {
+      double ti = 0.;
+      for( std::size_t p = 0; p < nPhases; ++p )
+      {
+        ti += b[p] * k[i * nPhases + p];
+      }
+      f -= z[i] * std::log( ti );
+    }
+    return f;
+  };
+
+  std::vector< double > & trial = m_trial;
+  std::vector< double > & step = m_step;
+  std::vector< double > & a = m_newtonMatrix;
+  std::vector< double > & rhs = m_newtonRhs;
+  std::vector< std::size_t > & freePhases = m_freePhases;
+  trial.resize( nPhases );
+  step.resize( nPhases );
+  for( std::size_t iteration = 0; iteration < maxIterations; ++iteration )
+  {
+    std::fill( gradient.begin(), gradient.end(), 0. );
+    std::fill( hessian.begin(), hessian.end(), 0. );
+    double f = 0.;
+    for( std::size_t i = 0; i < nActive; ++i )
+    {
+      double const * ki = &k[i * nPhases];
+      double ti = 0.;
+      for( std::size_t p = 0; p < nPhases; ++p )
+      {
+        ti += beta[p] * ki[p];
+      }
+      t[i] = ti;
+      f -= z[i] * std::log( ti );
+      const double w = z[i] / ti;
+      for( std::size_t p = 0; p < nPhases; ++p )
+      {
+        gradient[p] -= w * ki[p];
+        for( std::size_t q = 0; q <= p; ++q )
+        {
+          hessian[p * nPhases + q] += w * ki[p] * ki[q] / ti;
+        }
+      }
+    }
+
+    // Newton step on the free phases, keeping the sum of the fractions: [ H 1 ; 1^T 0 ] [ d ; lambda ] = [ -g ; 0 ].
+    freePhases.clear();
+    for( std::size_t p = 0; p < nPhases; ++p )
+    {
+      if( free[p] )
+      {
+        freePhases.push_back( p );
+      }
+    }
+    const std::size_t n = freePhases.size() + 1;
+    a.assign( n * n, 0. );
+    rhs.assign( n, 0. );
+    for( std::size_t r = 0; r + 1 < n; ++r )
+    {
+      const std::size_t p = freePhases[r];
+      for( std::size_t c = 0; c + 1 < n; ++c )
+      {
+        const std::size_t q = freePhases[c];
+        a[r * n + c] = p >= q ? hessian[p * nPhases + q] : hessian[q * nPhases + p];
+      }
+      a[r * n + n - 1] = 1.;
+      a[( n - 1 ) * n + r] = 1.;
+      rhs[r] = -gradient[p];
+    }
+    if( not math::SolveLinearSystem( a, rhs, n, 1 ) )
+    {
+      return Result{ false, iteration };
+    }
+
+    std::fill( step.begin(), step.end(), 0. );
+    double stepNorm = 0.;
+    for( std::size_t r = 0; r + 1 < n; ++r )
+    {
+      step[freePhases[r]] = rhs[r];
+      stepNorm = std::max( stepNorm, std::fabs( rhs[r] ) );
+    }
+
+    if( stepNorm < stepTolerance )
+    {
+      // The free phases are at equilibrium, and the sum of beta_p g_p is -1.
+      // A bounded phase with g_p < -1, i.e. sum_i K_ip x_i > 1, lowers F when released.
+      std::size_t released = nPhases;
+      double minGradient = -1. - gradientTolerance;
+      for( std::size_t p = 0; p < nPhases; ++p )
+      {
+        if( not free[p] and gradient[p] < minGradient )
+        {
+          minGradient = gradient[p];
+          released = p;
+        }
+      }
+      if( released == nPhases )
+      {
+        return Result{ true, iteration + 1 };
+      }
+      free[released] = true;
+      continue;
+    }
+
+    // Largest step keeping the fractions non negative.
+    double maxStep = 1.;
+    std::size_t blocking = nPhases;
+    for( std::size_t p = 0; p < nPhases; ++p )
+    {
+      if( step[p] < 0. and -beta[p] / step[p] < maxStep )
+      {
+        maxStep = -beta[p] / step[p];
+        blocking = p;
+      }
+    }
+
+    // Backtracking line search on F.
+    double slope = 0.;
+    for( std::size_t p = 0; p < nPhases; ++p )
+    {
+      slope += gradient[p] * step[p];
+    }
+    double alpha = maxStep;
+    for( std::size_t p = 0; p < nPhases; ++p )
+    {
+      trial[p] = beta[p] + alpha * step[p];
+    }
+    while( alpha > minStep and objective( trial ) > f + armijo * alpha * slope )
+    {
+      alpha *= 0.5;
+      for( std::size_t p = 0; p < nPhases; ++p )
+      {
+        trial[p] = beta[p] + alpha * step[p];
+      }
+    }
+
+    beta = trial;
+    if( blocking != nPhases and alpha == maxStep )
+    {
+      beta[blocking] = 0.;
+      free[blocking] = false;
+    }
+  }
+
+  return Result{ false, maxIterations };
+}
+
+}
@@ -0,0 +1,84 @@
+/*
+ * ------------------------------------------------------------------------------------------------------------
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (c) 2016-2024 Lawrence Livermore National Security LLC
+ * Copyright (c) 2018-2024 TotalEnergies
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University
+ * Copyright (c) 2018-2024 Chevron 
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors
+ * All rights reserved
+ *
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.
+ * ------------------------------------------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <vector>
+
+namespace PVTPackage
+{
+
+/**
+ * @brief Multiphase Rachford-Rice solver, written as a convex minimization.
+ *
+ * With the first phase as reference and K_ip the K-value of component i in phase p w.r.t. the reference,
+ * the phase mole fractions beta minimize F(beta) = -sum_i z_i ln t_i(beta), where t_i(beta) = sum_p beta_p K_ip,
+ * over the simplex beta_p >= 0, sum_p beta_p = 1. The minimizer solves the Rachford-Rice equations of the phases it keeps,
+ * the other phases get a zero fraction. F is convex, and t_i remains positive over the simplex,
+ * so that a Newton method with an active set on the bounds and a backtracking line search always converges.
+ */
+class MultiphaseRachfordRice
+{
+public:
+
+  /**
+   * @brief Outcome of one solve.
+   */
+  struct Result
+  {
+    /// False if the maximum number of iterations was reached or the Newton system was singular.
+    bool converged;
+    /// The number of Newton iterations.
+    std::size_t nIterations;
+  };
+
+  /**
+   * @brief Solves the multiphase Rachford-Rice equations.
+   * @param kValues The K-values of the phases other than the reference, w.r.t. the reference, as [phase - 1][component].
+   * @param feed The feed.
+   * @param components The components present in the feed.
+   * @param phaseFractions The initial guess of the phase mole fractions on input, the solution on output.
+   * The reference phase comes first. An empty vector starts from equal fractions.
+   * @return The outcome of the solve.
+   *
+   * The present components and the Newton system are stored into buffers owned by the instance,
+   * which are reused from one call to the other.
+   */
+  Result solve( std::vector< std::vector< double > > const & kValues,
+                std::vector< double > const & feed,
+                std::vector< std::size_t > const & components,
+                std::vector< double > & phaseFractions );
+
+private:
+
+  /// The K-values of the present components, as [component][phase], the reference phase having K = 1.
+  std::vector< double > m_kValues;
+  /// The feed of the present components.
+  std::vector< double > m_feed;
+  /// The t_i( beta ) of the present components.
+  std::vector< double > m_t;
+  /// The gradient and the lower triangle of the hessian of F, the latter being row-major.
+  std::vector< double > m_gradient, m_hessian;
+  /// The Newton step and the line search trial point.
+  std::vector< double > m_step, m_trial;
+  /// The matrix and right hand side of the Newton system of the free phases.
+  std::vector< double > m_newtonMatrix, m_newtonRhs;
+  /// True for the phases not held on their bound.
+  std::vector< bool > m_free;
+  /// The indices of the free phases.
+  std::vector< std::size_t > m_freePhases;
+};
+
+}
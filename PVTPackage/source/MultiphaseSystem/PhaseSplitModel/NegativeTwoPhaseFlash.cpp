@@ -19,8 +19,8 @@
 
 #include "Utils/math.hpp"
 
+#include <array>
 #include <limits>
-#include <map>
 #include <vector>
 
 namespace PVTPackage
@@ -29,14 +29,35 @@ namespace PVTPackage
 NegativeTwoPhaseFlash::NegativeTwoPhaseFlash( const std::vector< pvt::PHASE_TYPE > & phases,
                                               const std::vector< pvt::EOS_TYPE > & eosTypes,
                                               ComponentProperties const & componentProperties )
-  : CompositionalFlash( phases, eosTypes, componentProperties )
+  : CompositionalFlash( phases, eosTypes, componentProperties ),
+    m_ssiSteps( 0 )
 { }
 
 bool NegativeTwoPhaseFlash::computeEquilibrium( NegativeTwoPhaseFlashMultiphaseSystemProperties & sysProps ) const
 {
+  return computeEquilibrium( sysProps, nullptr );
+}
+
+bool NegativeTwoPhaseFlash::computeEquilibriumAndDerivatives( NegativeTwoPhaseFlashMultiphaseSystemProperties & sysProps,
+                                                              bool & derivativesComputed ) const
+{
+  TwoPhaseEquilibrium & equilibrium = m_equilibrium;
+  equilibrium.oilMoleComposition.clear();
+  const bool success = computeEquilibrium( sysProps, &equilibrium );
+  // The equilibrium is left empty when the stability test skipped the flash, finite differences are then used.
+  derivativesComputed = not equilibrium.oilMoleComposition.empty() and
+                        computeTwoPhaseEquilibriumDerivatives( equilibrium, getNComponents(), sysProps );
+  return success;
+}
+
+bool NegativeTwoPhaseFlash::computeEquilibrium( NegativeTwoPhaseFlashMultiphaseSystemProperties & sysProps,
+                                                TwoPhaseEquilibrium * equilibrium ) const
+{
+  const auto start = std::chrono::steady_clock::now();
+
   // Equilibrium convergence parameters
   const int max_SSI_iterations = 100;
-  const double fugacityEpsilon = 1e-8;
+  const double fugacityEpsilon = computeFugacityTolerance( sysProps );
 
   const double & pressure = sysProps.getPressure();
   const double & temperature = sysProps.getTemperature();
@@ -46,12 +67,15 @@ bool NegativeTwoPhaseFlash::computeEquilibrium( NegativeTwoPhaseFlashMultiphaseS
 
   const std::size_t nComponents = getNComponents();
 
-  std::vector< double > fugacityRatios( nComponents );
-  std::vector< double > kGasOil = computeWilsonGasLiquidKvalue( pressure, temperature );
+  std::vector< double > & fugacityRatios = m_fugacityRatios;
+  fugacityRatios.resize( nComponents );
+  std::vector< double > & kGasOil = m_kValues;
+  computeInitialGasLiquidKvalue( sysProps, kGasOil );
 
   //Check for machine-zero feed values
   const double epsilon = std::numeric_limits< double >::epsilon();
-  std::list< std::size_t > positiveComponents;
+  std::vector< std::size_t > & positiveComponents = m_positiveComponents;
+  positiveComponents.clear();
   for( std::size_t i = 0; i < nComponents; ++i )
   {
     if( feed[i] > epsilon )
@@ -60,15 +84,46 @@ bool NegativeTwoPhaseFlash::computeEquilibrium( NegativeTwoPhaseFlashMultiphaseS
     }
   }
 
-  std::vector< double > oilMoleComposition( nComponents, 0. ), gasMoleComposition( nComponents, 0. );
-  // This map holds references to the data so we can use them in loops
-  std::map< pvt::PHASE_TYPE, const std::vector< double > & > moleComposition{
-    { pvt::PHASE_TYPE::OIL, oilMoleComposition },
-    { pvt::PHASE_TYPE::GAS, gasMoleComposition }
-  };
+  std::vector< double > & oilMoleComposition = m_oilMoleComposition;
+  std::vector< double > & gasMoleComposition = m_gasMoleComposition;
+  oilMoleComposition.assign( nComponents, 0. );
+  gasMoleComposition.assign( nComponents, 0. );
+  // Phase slots indexed by pvt::PHASE_TYPE (GAS, OIL), so that the loops over the phases find the compositions without map lookup.
+  // The accesses are bounds checked, other phases throwing std::out_of_range.
+  std::array< std::vector< double > const *, 2 > const moleComposition{ { &gasMoleComposition, &oilMoleComposition } };
   double oilPhaseMoleFraction, gasPhaseMoleFraction;
 
-  int totalNbIter = 0;
+  // Stable feeds skip the iterations. Both phases get the feed composition so that their properties are defined.
+  const Stability stability = computeFeedStability( sysProps, positiveComponents, kGasOil );
+  if( stability == Stability::STABLE_OIL or stability == Stability::STABLE_GAS )
+  {
+    gasPhaseMoleFraction = stability == Stability::STABLE_GAS ? 1. : 0.;
+    oilPhaseMoleFraction = 1. - gasPhaseMoleFraction;
+    oilMoleComposition = feed;
+    gasMoleComposition = feed;
+    for( const pvt::PHASE_TYPE & phase: sysProps.getPhases() )
+    {
+      computePhaseProperties( phase, pressure, temperature, *moleComposition.at( static_cast< std::size_t >( phase ) ), sysProps );
+    }
+
+    sysProps.setOilMoleComposition( oilMoleComposition );
+    sysProps.setGasMoleComposition( gasMoleComposition );
+    sysProps.setOilFraction( oilPhaseMoleFraction );
+    sysProps.setGasFraction( gasPhaseMoleFraction );
+    sysProps.setKValues( kGasOil );
+
+    recordIterations( sysProps, 0, true );
+    recordFlashTime( sysProps, start );
+    return true;
+  }
+
+  const std::vector< double > & oilLnFugacity = sysProps.getOilLnFugacity();
+  const std::vector< double > & gasLnFugacity = sysProps.getGasLnFugacity();
+
+  SuccessiveSubstitutionSteps & ssiSteps = m_ssiSteps;
+  ssiSteps.reset( nComponents );
+  bool converged = false;
+  std::size_t nIterations = max_SSI_iterations;
   for( int iter = 0; iter < max_SSI_iterations; ++iter )
   {
     // Solve Rachford-Rice Equation
@@ -83,22 +138,17 @@ bool NegativeTwoPhaseFlash::computeEquilibrium( NegativeTwoPhaseFlashMultiphaseS
       gasMoleComposition[ic] = kGasOil[ic] * oilMoleComposition[ic];
     }
 
-    oilMoleComposition = math::Normalize( oilMoleComposition );
-    gasMoleComposition = math::Normalize( gasMoleComposition );
+    math::NormalizeInPlace( oilMoleComposition );
+    math::NormalizeInPlace( gasMoleComposition );
 
     // Compute phase fugacity
     for( const pvt::PHASE_TYPE & phase: sysProps.getPhases() )
     {
-      const CubicEoSPhaseModel & model = getCubicEoSPhaseModel( phase );
-      const auto props = model.computeAllProperties( pressure, temperature, moleComposition.at( phase ) );
-      sysProps.setModelProperties( phase, props );
+      computePhaseProperties( phase, pressure, temperature, *moleComposition.at( static_cast< std::size_t >( phase ) ), sysProps );
     }
 
     // Compute fugacity ratio and check convergence
-    bool converged = true;
-
-    const std::vector< double > & oilLnFugacity = sysProps.getOilLnFugacity();
-    const std::vector< double > & gasLnFugacity = sysProps.getGasLnFugacity();
+    converged = true;
     for( auto ic : positiveComponents )
     {
       fugacityRatios[ic] = std::exp( oilLnFugacity[ic] - gasLnFugacity[ic] ) * oilMoleComposition[ic] / gasMoleComposition[ic];
@@ -110,16 +160,26 @@ bool NegativeTwoPhaseFlash::computeEquilibrium( NegativeTwoPhaseFlashMultiphaseS
 
     if( converged )
     {
+      nIterations = iter + 1;
       break;
     }
 
     // Update K-values
-    for( auto ic : positiveComponents )
+    if( not updateKValuesNewton( pressure, temperature, feed, positiveComponents, oilMoleComposition, gasMoleComposition,
+                                 vaporFraction, fugacityRatios, not sysProps.getInitialKValues().empty(), kGasOil ) )
     {
-      kGasOil[ic] *= fugacityRatios[ic];
+      updateKValues( fugacityRatios, positiveComponents, ssiSteps, kGasOil );
     }
+  }
+
+  recordIterations( sysProps, nIterations, converged );
+  sysProps.setKValues( kGasOil );
 
-    totalNbIter = iter;
+  if( equilibrium != nullptr )
+  {
+    equilibrium->oilMoleComposition = oilMoleComposition;
+    equilibrium->gasMoleComposition = gasMoleComposition;
+    equilibrium->gasPhaseMoleFraction = gasPhaseMoleFraction;
   }
 
   // Retrieve physical bounds from negative flash values
@@ -142,9 +202,7 @@ bool NegativeTwoPhaseFlash::computeEquilibrium( NegativeTwoPhaseFlashMultiphaseS
     }
 
     // Update phase properties since adjusting composition
-    const CubicEoSPhaseModel & model = getCubicEoSPhaseModel( phase );
-    const auto props = model.computeAllProperties( pressure, temperature, moleComposition.at( phase ) );
-    sysProps.setModelProperties( phase, props );
+    computePhaseProperties( phase, pressure, temperature, *moleComposition.at( static_cast< std::size_t >( phase ) ), sysProps );
   }
 
   // TODO reassign the final values
@@ -156,7 +214,9 @@ bool NegativeTwoPhaseFlash::computeEquilibrium( NegativeTwoPhaseFlashMultiphaseS
   // Compute final phase state
 //  setPhaseState( sysProps );
 
-  return totalNbIter < max_SSI_iterations;
+  recordFlashTime( sysProps, start );
+
+  return converged;
 }
 
 }
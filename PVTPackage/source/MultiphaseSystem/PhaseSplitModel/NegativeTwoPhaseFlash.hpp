@@ -32,7 +32,42 @@ public:
                          const std::vector< pvt::EOS_TYPE > & eosTypes,
                          ComponentProperties const & componentProperties );
 
+  using CompositionalFlash::setSsiAccelerationType;
+  using CompositionalFlash::setStabilityTestEnabled;
+  using CompositionalFlash::getStatistics;
+  using CompositionalFlash::resetStatistics;
+  using CompositionalFlash::setPrecisionType;
+
   bool computeEquilibrium( NegativeTwoPhaseFlashMultiphaseSystemProperties & sysProps ) const;
+
+  /**
+   * @brief Computes the equilibrium and its analytical derivatives.
+   * @param sysProps The data the flash algorithm will be using.
+   * @param derivativesComputed Set to false if the analytical derivatives could not be computed.
+   * @return True if the equilibrium computation converged.
+   */
+  bool computeEquilibriumAndDerivatives( NegativeTwoPhaseFlashMultiphaseSystemProperties & sysProps,
+                                         bool & derivativesComputed ) const;
+
+private:
+
+  /**
+   * @brief Computes the equilibrium.
+   * @param sysProps The data the flash algorithm will be using.
+   * @param equilibrium If not nullptr, receives the converged flash before clamping.
+   * @return True if the equilibrium computation converged.
+   */
+  bool computeEquilibrium( NegativeTwoPhaseFlashMultiphaseSystemProperties & sysProps,
+                           TwoPhaseEquilibrium * equilibrium ) const;
+
+  /// Buffers of the flash computations, which are reused from one call to the other.
+  mutable std::vector< double > m_kValues, m_fugacityRatios, m_oilMoleComposition, m_gasMoleComposition;
+  /// The components present in the feed.
+  mutable std::vector< std::size_t > m_positiveComponents;
+  /// The successive substitution steps of the K-values.
+  mutable SuccessiveSubstitutionSteps m_ssiSteps;
+  /// The converged two-phase flash handed over to the analytical derivatives.
+  mutable TwoPhaseEquilibrium m_equilibrium;
 };
 
 }
@@ -0,0 +1,188 @@
+/*
+ * ------------------------------------------------------------------------------------------------------------
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (c) 2016-2024 Lawrence Livermore National Security LLC
+ * Copyright (c) 2018-2024 TotalEnergies
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University
+ * Copyright (c) 2018-2024 Chevron 
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors
+ * All rights reserved
+ *
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.
+ * ------------------------------------------------------------------------------------------------------------
+ */
+
+#include "MultiphaseSystem/PhaseSplitModel/RachfordRice.hpp"
+
+#include "Utils/ComponentKernels.hpp"
+#include "Utils/Logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace PVTPackage
+{
+
+double RachfordRice::solve( std::vector< double > const & kValues,
+                            std::vector< double > const & feed,
+                            std::vector< std::size_t > const & components )
+{
+  m_feed.clear();
+  m_shiftedKValues.clear();
+  for( auto ic : components )
+  {
+    m_feed.push_back( feed[ic] );
+    m_shiftedKValues.push_back( kValues[ic] - 1.0 );
+  }
+  return solve( m_feed.size(), m_feed.data(), m_shiftedKValues.data() );
+}
+
+double RachfordRice::solve( std::size_t nComponents,
+                            double const * feed,
+                            double const * shiftedKValues )
+{
+  const double bisectionTolerance = 1e-3;
+  const double epsilon = std::numeric_limits< double >::epsilon();
+
+  //Min and Max shifted Kvalues
+  double maxA = -1., minA = 1. / epsilon;
+  for( std::size_t i = 0; i < nComponents; ++i )
+  {
+    maxA = std::max( maxA, shiftedKValues[i] );
+    minA = std::min( minA, shiftedKValues[i] );
+  }
+
+  //Check for trivial solutions. This corresponds to bad Kvalues //TODO:to be fixed
+  if( maxA < 0. )
+  {
+    return 0.;
+  }
+  if( minA > 0. )
+  {
+    return 1.;
+  }
+
+  //Find solution window
+  const double sqrtEpsilon = std::sqrt( epsilon );
+  const double lower = 1.0 / -maxA;
+  const double upper = 1.0 / -minA;
+  return solve( nComponents, feed, shiftedKValues, 1.0,
+                lower + sqrtEpsilon * ( std::fabs( lower ) + sqrtEpsilon ),
+                upper - sqrtEpsilon * ( std::fabs( upper ) + sqrtEpsilon ),
+                bisectionTolerance );
+}
+
+template< std::size_t NC >
+double RachfordRice::WindowKernel< NC >::run( std::size_t nComponents,
+                                              double const * feed,
+                                              double const * coefficients,
+                                              double offset,
+                                              double lower,
+                                              double upper,
+                                              double bisectionTolerance )
+{
+  const std::size_t n = nComponentsOf< NC >( nComponents );
+
+  //Numerical Parameters
+  const int maxBisectionIterations = 200;
+  const double newtonTolerance = 1e-12;
+  const int maxNewtonIterations = 30;
+  const double epsilon = std::numeric_limits< double >::epsilon();
+
+  // The function is decreasing between its poles, where the root lies.
+  auto evaluate = [n, feed, coefficients, offset]( double x )
+  {
+    double f = 0.;
+    for( std::size_t i = 0; i < n; ++i )
+    {
+      const double a = coefficients[i];
+      f = f + feed[i] * a / ( offset + x * a );
+    }
+    return f;
+  };
+
+  //Bisection down to a coarse bracket.
+  //The stopping criterion uses the function values at the bounds of the previous bracket.
+  double fLower = evaluate( lower ), fUpper = evaluate( upper );
+  double error = 1. / epsilon;
+  for( int iteration = 0; error > bisectionTolerance and iteration < maxBisectionIterations; ++iteration )
+  {
+    const double middle = 0.5 * ( lower + upper );
+    const double fMiddle = evaluate( middle );
+    const double fDifference = std::fabs( fUpper - fLower );
+    if( fLower * fMiddle < 0.0 )
+    {
+      upper = middle;
+      fUpper = fMiddle;
+    }
+    else if( fUpper * fMiddle < 0.0 )
+    {
+      lower = middle;
+      fLower = fMiddle;
+    }
+    error = std::min( fDifference, std::fabs( upper - lower ) );
+  }
+
+  //Newton iterations, the function and its derivative being evaluated in the same pass.
+  //Steps leaving the bracket are replaced by half steps towards its bound, and the bracket shrinks at each iteration.
+  double x = 0.5 * ( upper + lower );
+  for( int iteration = 0; error > newtonTolerance and iteration < maxNewtonIterations; ++iteration )
+  {
+    double f = 0., df = 0.;
+    for( std::size_t i = 0; i < n; ++i )
+    {
+      const double a = coefficients[i];
+      const double denominator = offset + x * a;
+      const double r = a / denominator;
+      f = f + feed[i] * a / denominator;
+      df = df - feed[i] * r * r;
+    }
+
+    if( f > 0. )
+    {
+      lower = x;
+    }
+    else if( f < 0. )
+    {
+      upper = x;
+    }
+
+    const double delta = -f / df;
+    error = std::fabs( delta ) / std::fabs( x );
+
+    if( x + delta < lower )
+    {
+      x = .5 * ( x + lower );
+    }
+    else if( x + delta > upper )
+    {
+      x = .5 * ( x + upper );
+    }
+    else
+    {
+      x = x + delta;
+    }
+  }
+
+  if( error > newtonTolerance )
+  {
+    LOGWARNING( "Rachford-Rice Newton reached max number of iterations" );
+  }
+
+  return x;
+}
+
+double RachfordRice::solve( std::size_t nComponents,
+                            double const * feed,
+                            double const * coefficients,
+                            double offset,
+                            double lower,
+                            double upper,
+                            double bisectionTolerance )
+{
+  return selectKernel< WindowKernel >( nComponents )( nComponents, feed, coefficients, offset, lower, upper, bisectionTolerance );
+}
+
+}
@@ -0,0 +1,110 @@
+/*
+ * ------------------------------------------------------------------------------------------------------------
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (c) 2016-2024 Lawrence Livermore National Security LLC
+ * Copyright (c) 2018-2024 TotalEnergies
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University
+ * Copyright (c) 2018-2024 Chevron 
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors
+ * All rights reserved
+ *
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.
+ * ------------------------------------------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace PVTPackage
+{
+
+/**
+ * @brief Two-phase Rachford-Rice solver.
+ *
+ * Solves f(V) = sum_i z_i a_i / (1 + V a_i) = 0 for V, where a_i is the shifted K-value K_i - 1
+ * (or any other coefficient leading to the same form, e.g. for the free water flash).
+ * The components are stored in contiguous arrays. A few bisection steps between the poles of f give a coarse bracket of the root,
+ * then Newton iterations, which evaluate f and its derivative in one pass, converge within the bracket.
+ * The bracket is tightened at each iteration, so that steps leaving it fall back to bisection and the convergence is guaranteed.
+ */
+class RachfordRice
+{
+public:
+
+  /**
+   * @brief Solves the Rachford-Rice equation of the components present in the feed.
+   * @param kValues The K-values.
+   * @param feed The feed.
+   * @param components The components present in the feed.
+   * @return The vapor fraction, possibly out of [0, 1] (negative flash).
+   * It is 0 if all the K-values are below 1, and 1 if all are above 1.
+   *
+   * The present components are compacted into buffers owned by the instance, which are reused from one call to the other.
+   */
+  double solve( std::vector< double > const & kValues,
+                std::vector< double > const & feed,
+                std::vector< std::size_t > const & components );
+
+  /**
+   * @brief Solves one Rachford-Rice equation.
+   * @param nComponents The number of components.
+   * @param feed The feed of the components, which must be positive.
+   * @param shiftedKValues The coefficients a_i.
+   * @return The root, 0 if all the coefficients are negative and 1 if all are positive.
+   */
+  static double solve( std::size_t nComponents,
+                       double const * feed,
+                       double const * shiftedKValues );
+
+  /**
+   * @brief Solves sum_i z_i a_i / (offset + x a_i) = 0 for x within a given window.
+   * @param nComponents The number of components.
+   * @param feed The feed of the components, which must be positive.
+   * @param coefficients The coefficients a_i.
+   * @param offset The constant term of the denominators.
+   * @param lower The lower bound of the window, right above the pole -offset / max(a_i).
+   * @param upper The upper bound of the window, right below the pole -offset / min(a_i).
+   * @param bisectionTolerance The width of the bracket (or of the function values at its bounds) below which Newton iterations start.
+   * @return The root.
+   *
+   * This is the core of the other overloads. It also serves modified forms of the equation (e.g. the free water flash),
+   * which compute their own trivial solutions and window.
+   * The iterations are specialized for the number of components up to MAX_SPECIALIZED_N_COMPONENTS.
+   */
+  static double solve( std::size_t nComponents,
+                       double const * feed,
+                       double const * coefficients,
+                       double offset,
+                       double lower,
+                       double upper,
+                       double bisectionTolerance );
+
+private:
+
+  /**
+   * @brief Bisection and Newton iterations of the windowed solve.
+   * @tparam NC The number of components, see nComponentsOf.
+   */
+  template< std::size_t NC >
+  struct WindowKernel
+  {
+    /// Same arguments as the windowed solve.
+    static double run( std::size_t nComponents,
+                       double const * feed,
+                       double const * coefficients,
+                       double offset,
+                       double lower,
+                       double upper,
+                       double bisectionTolerance );
+  };
+
+  /// The compacted feed.
+  std::vector< double > m_feed;
+  /// The compacted shifted K-values.
+  std::vector< double > m_shiftedKValues;
+};
+
+}
@@ -0,0 +1,133 @@
+/*
+ * ------------------------------------------------------------------------------------------------------------
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (c) 2016-2024 Lawrence Livermore National Security LLC
+ * Copyright (c) 2018-2024 TotalEnergies
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University
+ * Copyright (c) 2018-2024 Chevron 
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors
+ * All rights reserved
+ *
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.
+ * ------------------------------------------------------------------------------------------------------------
+ */
+
+#include "MultiphaseSystem/PhaseSplitModel/StabilityTest.hpp"
+
+#include <cmath>
+
+namespace PVTPackage
+{
+
+StabilityTest::Result StabilityTest::run( double pressure,
+                                          double temperature,
+                                          std::vector< double > const & feed,
+                                          std::vector< std::size_t > const & components,
+                                          std::vector< double > const & kValues,
+                                          CubicEoSPhaseModel const & liquidModel,
+                                          CubicEoSPhaseModel::Workspace & liquidWorkspace,
+                                          CubicEoSPhaseModel const & vaporModel,
+                                          CubicEoSPhaseModel::Workspace & vaporWorkspace,
+                                          CubicEoSPhaseModel::Properties & properties,
+                                          Workspace & workspace )
+{
+  Result result{ false, 0, 1., false };
+  result.stable = isTrialPhaseStable( true, pressure, temperature, feed, components, kValues, vaporModel, vaporWorkspace, properties,
+                                      workspace, result ) and
+                  isTrialPhaseStable( false, pressure, temperature, feed, components, kValues, liquidModel, liquidWorkspace, properties,
+                                      workspace, result );
+  return result;
+}
+
+bool StabilityTest::isTrialPhaseStable( bool isVapor,
+                                        double pressure,
+                                        double temperature,
+                                        std::vector< double > const & feed,
+                                        std::vector< std::size_t > const & components,
+                                        std::vector< double > const & kValues,
+                                        CubicEoSPhaseModel const & model,
+                                        CubicEoSPhaseModel::Workspace & modelWorkspace,
+                                        CubicEoSPhaseModel::Properties & properties,
+                                        Workspace & workspace,
+                                        Result & result )
+{
+  // Convergence parameters
+  const int maxIterations = 50;
+  const double lnWEpsilon = 1e-8;
+  // Trial phases closer than this to the feed, in sum_i ( ln W_i - ln z_i )^2, are considered as the trivial solution.
+  const double trivialEpsilon = 1e-4;
+  const double sumEpsilon = 1e-8;
+
+  const std::size_t nComponents = feed.size();
+
+  // Tangent plane of the feed: d_i = ln z_i + ln phi_i( z )
+  model.computeAllProperties( pressure, temperature, feed, modelWorkspace, properties );
+  if( not isVapor )
+  {
+    result.liquidLike = model.isLiquidLike( properties, modelWorkspace );
+  }
+
+  std::vector< double > & d = workspace.d;
+  std::vector< double > & lnW = workspace.lnW;
+  std::vector< double > & w = workspace.w;
+  d.assign( nComponents, 0. );
+  lnW.assign( nComponents, 0. );
+  w.assign( nComponents, 0. );
+  for( auto ic : components )
+  {
+    d[ic] = std::log( feed[ic] ) + properties.lnFugacityCoefficients[ic];
+    lnW[ic] = std::log( feed[ic] ) + ( isVapor ? 1. : -1. ) * std::log( kValues[ic] );
+  }
+
+  for( int iter = 0; iter < maxIterations; ++iter )
+  {
+    double sumW = 0.;
+    for( auto ic : components )
+    {
+      w[ic] = std::exp( lnW[ic] );
+      sumW += w[ic];
+    }
+    for( auto ic : components )
+    {
+      w[ic] /= sumW;
+    }
+
+    model.computeAllProperties( pressure, temperature, w, modelWorkspace, properties );
+    ++result.nIterations;
+
+    double maxVariation = 0., distanceToFeed = 0.;
+    sumW = 0.;
+    for( auto ic : components )
+    {
+      const double newLnW = d[ic] - properties.lnFugacityCoefficients[ic];
+      maxVariation = std::fmax( maxVariation, std::fabs( newLnW - lnW[ic] ) );
+      distanceToFeed += ( newLnW - std::log( feed[ic] ) ) * ( newLnW - std::log( feed[ic] ) );
+      lnW[ic] = newLnW;
+      sumW += std::exp( newLnW );
+    }
+
+    // A negative tangent plane distance 1 - sum_i W_i proves (for successive substitutions) the feed unstable.
+    if( sumW > 1. + sumEpsilon )
+    {
+      result.tangentPlaneDistance = std::fmin( result.tangentPlaneDistance, 1. - sumW );
+      return false;
+    }
+    // The trivial solution (reached by all trial phases near a critical point) says nothing about the neighbourhood of the feed.
+    if( distanceToFeed < trivialEpsilon )
+    {
+      result.tangentPlaneDistance = std::fmin( result.tangentPlaneDistance, 0. );
+      return true;
+    }
+    if( maxVariation < lnWEpsilon )
+    {
+      result.tangentPlaneDistance = std::fmin( result.tangentPlaneDistance, 1. - sumW );
+      return true;
+    }
+  }
+
+  // No conclusion
+  return false;
+}
+
+}
@@ -0,0 +1,118 @@
+/*
+ * ------------------------------------------------------------------------------------------------------------
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (c) 2016-2024 Lawrence Livermore National Security LLC
+ * Copyright (c) 2018-2024 TotalEnergies
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University
+ * Copyright (c) 2018-2024 Chevron 
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors
+ * All rights reserved
+ *
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.
+ * ------------------------------------------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include "MultiphaseSystem/PhaseModel/CubicEOS/CubicEoSPhaseModel.hpp"
+
+#include <vector>
+
+namespace PVTPackage
+{
+
+/**
+ * @brief Michelsen tangent plane distance stability test of a feed.
+ *
+ * The feed is tested against a vapor-like and a liquid-like trial phase, initialized from K-values
+ * (W_i = z_i K_i and W_i = z_i / K_i), and driven to a stationary point of the tangent plane distance
+ * by successive substitutions on ln W. The feed is stable if no trial phase ends with a sum of W greater than one.
+ */
+class StabilityTest
+{
+public:
+
+  struct Result
+  {
+    /// True if the feed was proven stable. A test that did not conclude reports an unstable feed.
+    bool stable;
+    /// Number of successive substitution iterations of both trial phases.
+    std::size_t nIterations;
+    /// The smallest tangent plane distance 1 - sum_i W_i of the trial phases, taken as 0 for a trial phase that collapsed
+    /// onto the feed. Negative when the feed was found unstable.
+    double tangentPlaneDistance;
+    /// True if the feed, evaluated with the equation of state of the liquid-like trial phase, is liquid-like
+    /// (see CubicEoSPhaseModel::isLiquidLike). Only meaningful for a stable feed.
+    bool liquidLike;
+  };
+
+  /**
+   * @brief Scratch buffers of the trial phases.
+   *
+   * They are sized on first use, so that subsequent tests with the same number of components do not allocate.
+   */
+  struct Workspace
+  {
+    /// The tangent plane of the feed d_i = ln z_i + ln phi_i( z ).
+    std::vector< double > d;
+    /// The ln W_i of the trial phase and its normalized composition.
+    std::vector< double > lnW, w;
+  };
+
+  /**
+   * @brief Runs the test.
+   * @param pressure The pressure.
+   * @param temperature The temperature.
+   * @param feed The feed.
+   * @param components The components present in the feed.
+   * @param kValues The K-values the trial phases are initialized from.
+   * @param liquidModel The equation of state of the liquid-like trial phase.
+   * @param liquidWorkspace The scratch buffers of @p liquidModel.
+   * @param vaporModel The equation of state of the vapor-like trial phase.
+   * @param vaporWorkspace The scratch buffers of @p vaporModel.
+   * @param properties Reused output of the equation of state.
+   * @param workspace The scratch buffers of the trial phases.
+   * @return The result of the test.
+   *
+   * Each trial phase is compared with the feed evaluated with the same equation of state.
+   */
+  static Result run( double pressure,
+                     double temperature,
+                     std::vector< double > const & feed,
+                     std::vector< std::size_t > const & components,
+                     std::vector< double > const & kValues,
+                     CubicEoSPhaseModel const & liquidModel,
+                     CubicEoSPhaseModel::Workspace & liquidWorkspace,
+                     CubicEoSPhaseModel const & vaporModel,
+                     CubicEoSPhaseModel::Workspace & vaporWorkspace,
+                     CubicEoSPhaseModel::Properties & properties,
+                     Workspace & workspace );
+
+private:
+
+  /**
+   * @brief Drives one trial phase to a stationary point of the tangent plane distance.
+   * @param isVapor True for the vapor-like trial phase.
+   * @param model The equation of state of the trial phase.
+   * @param modelWorkspace The scratch buffers of @p model.
+   * @param result The iterations are added to its number of iterations. Its tangent plane distance is lowered
+   * to the one of the trial phase, or to 0 if it collapsed onto the feed. The liquid-like trial phase also sets its liquidLike flag.
+   * @return True if the trial phase converged to the feed (trivial solution) or to a non-negative tangent plane distance.
+   *
+   * Other parameters are described in #run.
+   */
+  static bool isTrialPhaseStable( bool isVapor,
+                                  double pressure,
+                                  double temperature,
+                                  std::vector< double > const & feed,
+                                  std::vector< std::size_t > const & components,
+                                  std::vector< double > const & kValues,
+                                  CubicEoSPhaseModel const & model,
+                                  CubicEoSPhaseModel::Workspace & modelWorkspace,
+                                  CubicEoSPhaseModel::Properties & properties,
+                                  Workspace & workspace,
+                                  Result & result );
+};
+
+}
@@ -0,0 +1,200 @@
+/*
+ * ------------------------------------------------------------------------------------------------------------
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (c) 2016-2024 Lawrence Livermore National Security LLC
+ * Copyright (c) 2018-2024 TotalEnergies
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University
+ * Copyright (c) 2018-2024 Chevron 
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors
+ * All rights reserved
+ *
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.
+ * ------------------------------------------------------------------------------------------------------------
+ */
+
+#include "MultiphaseSystem/PhaseSplitModel/TabulatedKValuesFlash.hpp"
+
+#include "Utils/math.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace PVTPackage
+{
+
+namespace
+{
+
+/**
+ * @brief Locates @p x on a uniform axis.
+ * @param x The value.
+ * @param min The first value of the axis.
+ * @param inverseStep The inverse of the spacing of the axis.
+ * @param n The number of values of the axis.
+ * @param index The index of the lower node, such that index + 1 < n when n > 1.
+ * @param weight The weight of the upper node, in [0, 1].
+ */
+void locate( double x,
+             double min,
+             double inverseStep,
+             std::size_t n,
+             std::size_t & index,
+             double & weight )
+{
+  if( n == 1 )
+  {
+    index = 0;
+    weight = 0.;
+    return;
+  }
+
+  const double u = std::min( std::max( ( x - min ) * inverseStep, 0. ), static_cast< double >( n - 1 ) );
+  index = std::min( static_cast< std::size_t >( u ), n - 2 );
+  weight = u - static_cast< double >( index );
+}
+
+}
+
+TabulatedKValuesFlash::TabulatedKValuesFlash( const std::vector< pvt::PHASE_TYPE > & phases,
+                                              const std::vector< pvt::EOS_TYPE > & eosTypes,
+                                              ComponentProperties const & componentProperties,
+                                              pvt::KValueTable const & kValueTable )
+  : CompositionalFlash( phases, eosTypes, componentProperties ),
+    m_minPressure( kValueTable.minPressure ),
+    m_inversePressureStep( kValueTable.nPressures > 1 ? 1. / kValueTable.pressureStep : 0. ),
+    m_nPressures( kValueTable.nPressures ),
+    m_minTemperature( kValueTable.minTemperature ),
+    m_inverseTemperatureStep( kValueTable.nTemperatures > 1 ? 1. / kValueTable.temperatureStep : 0. ),
+    m_nTemperatures( kValueTable.nTemperatures ),
+    m_lnKValues( kValueTable.kValues.size() )
+{
+  ASSERT( isTableConsistent( kValueTable, componentProperties.NComponents ), "Inconsistent K-value table" );
+  std::transform( kValueTable.kValues.cbegin(), kValueTable.kValues.cend(), m_lnKValues.begin(), []( double k ) { return std::log( k ); } );
+}
+
+bool TabulatedKValuesFlash::isTableConsistent( pvt::KValueTable const & kValueTable,
+                                               std::size_t nComponents )
+{
+  auto isAxisConsistent = []( double step, std::size_t n )
+  {
+    return n == 1 or ( n > 1 and step > 0. );
+  };
+
+  return isAxisConsistent( kValueTable.pressureStep, kValueTable.nPressures ) &&
+         isAxisConsistent( kValueTable.temperatureStep, kValueTable.nTemperatures ) &&
+         kValueTable.kValues.size() == kValueTable.nPressures * kValueTable.nTemperatures * nComponents &&
+         std::all_of( kValueTable.kValues.cbegin(), kValueTable.kValues.cend(), []( double k ) { return k > 0.; } );
+}
+
+void TabulatedKValuesFlash::interpolateKValues( double pressure,
+                                                double temperature,
+                                                std::vector< double > & kValues ) const
+{
+  const std::size_t nComponents = getNComponents();
+
+  std::size_t iPressure, iTemperature;
+  double wPressure, wTemperature;
+  locate( pressure, m_minPressure, m_inversePressureStep, m_nPressures, iPressure, wPressure );
+  locate( temperature, m_minTemperature, m_inverseTemperatureStep, m_nTemperatures, iTemperature, wTemperature );
+
+  // Strides to the upper nodes, which are the lower ones on single node axes.
+  const std::size_t temperatureStride = m_nTemperatures > 1 ? nComponents : 0;
+  const std::size_t pressureStride = m_nPressures > 1 ? m_nTemperatures * nComponents : 0;
+
+  double const * lnK00 = &m_lnKValues[( iPressure * m_nTemperatures + iTemperature ) * nComponents];
+  double const * lnK01 = lnK00 + temperatureStride;
+  double const * lnK10 = lnK00 + pressureStride;
+  double const * lnK11 = lnK10 + temperatureStride;
+
+  const double w00 = ( 1. - wPressure ) * ( 1. - wTemperature );
+  const double w01 = ( 1. - wPressure ) * wTemperature;
+  const double w10 = wPressure * ( 1. - wTemperature );
+  const double w11 = wPressure * wTemperature;
+
+  kValues.resize( nComponents );
+  for( std::size_t ic = 0; ic < nComponents; ++ic )
+  {
+    kValues[ic] = std::exp( w00 * lnK00[ic] + w01 * lnK01[ic] + w10 * lnK10[ic] + w11 * lnK11[ic] );
+  }
+}
+
+bool TabulatedKValuesFlash::computeEquilibrium( NegativeTwoPhaseFlashMultiphaseSystemProperties & sysProps ) const
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  const double & pressure = sysProps.getPressure();
+  const double & temperature = sysProps.getTemperature();
+  const std::vector< double > & feed = sysProps.getFeed();
+
+  ASSERT( std::fabs( math::sum_array( feed ) - 1.0 ) < 1e-12, "Feed sum must be 1" );
+
+  const std::size_t nComponents = getNComponents();
+
+  std::vector< double > & kGasOil = m_kValues;
+  interpolateKValues( pressure, temperature, kGasOil );
+
+  //Check for machine-zero feed values
+  const double epsilon = std::numeric_limits< double >::epsilon();
+  std::vector< std::size_t > & positiveComponents = m_positiveComponents;
+  positiveComponents.clear();
+  for( std::size_t i = 0; i < nComponents; ++i )
+  {
+    if( feed[i] > epsilon )
+    {
+      positiveComponents.push_back( i );
+    }
+  }
+
+  // Solve Rachford-Rice Equation
+  double gasPhaseMoleFraction = solveRachfordRiceEquation( kGasOil, feed, positiveComponents );
+
+  // Assign phase compositions
+  std::vector< double > & oilMoleComposition = m_oilMoleComposition;
+  std::vector< double > & gasMoleComposition = m_gasMoleComposition;
+  oilMoleComposition.assign( nComponents, 0. );
+  gasMoleComposition.assign( nComponents, 0. );
+  for( auto ic : positiveComponents )
+  {
+    oilMoleComposition[ic] = feed[ic] / ( 1.0 + gasPhaseMoleFraction * ( kGasOil[ic] - 1.0 ) );
+    gasMoleComposition[ic] = kGasOil[ic] * oilMoleComposition[ic];
+  }
+
+  math::NormalizeInPlace( oilMoleComposition );
+  math::NormalizeInPlace( gasMoleComposition );
+
+  // Retrieve physical bounds from negative flash values
+  if( gasPhaseMoleFraction >= 1. )
+  {
+    gasPhaseMoleFraction = 1.;
+    gasMoleComposition = feed;
+  }
+  else if( gasPhaseMoleFraction <= 0. )
+  {
+    gasPhaseMoleFraction = 0.;
+    oilMoleComposition = feed;
+  }
+
+  sysProps.setOilMoleComposition( oilMoleComposition );
+  sysProps.setGasMoleComposition( gasMoleComposition );
+  sysProps.setOilFraction( 1. - gasPhaseMoleFraction );
+  sysProps.setGasFraction( gasPhaseMoleFraction );
+  sysProps.setKValues( kGasOil );
+
+  // One equation of state evaluation per phase
+  // Phase slots indexed by pvt::PHASE_TYPE (GAS, OIL), other phases throwing std::out_of_range.
+  std::array< std::vector< double > const *, 2 > const moleComposition{ { &gasMoleComposition, &oilMoleComposition } };
+  for( const pvt::PHASE_TYPE & phase: sysProps.getPhases() )
+  {
+    computePhaseProperties( phase, pressure, temperature, *moleComposition.at( static_cast< std::size_t >( phase ) ), sysProps );
+  }
+
+  recordIterations( sysProps, 0, true );
+  recordFlashTime( sysProps, start );
+
+  return true;
+}
+
+}
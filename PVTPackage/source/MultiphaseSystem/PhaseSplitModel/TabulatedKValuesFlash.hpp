@@ -0,0 +1,89 @@
+/*
+ * ------------------------------------------------------------------------------------------------------------
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (c) 2016-2024 Lawrence Livermore National Security LLC
+ * Copyright (c) 2018-2024 TotalEnergies
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University
+ * Copyright (c) 2018-2024 Chevron 
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors
+ * All rights reserved
+ *
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.
+ * ------------------------------------------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include "MultiphaseSystem/ComponentProperties.hpp"
+#include "MultiphaseSystem/MultiphaseSystemProperties/NegativeTwoPhaseFlashMultiphaseSystemProperties.hpp"
+#include "MultiphaseSystem/PhaseSplitModel/CompositionalFlash.hpp"
+
+#include "pvt/pvt.hpp"
+
+#include <vector>
+
+namespace PVTPackage
+{
+
+/**
+ * @brief Oil/gas flash with K-values interpolated from a table, without any fugacity iteration.
+ *
+ * The phase split is given by one Rachford-Rice solve, and the phase properties by one equation of state evaluation per phase.
+ */
+class TabulatedKValuesFlash final : private CompositionalFlash
+{
+public:
+
+  TabulatedKValuesFlash( const std::vector< pvt::PHASE_TYPE > & phases,
+                         const std::vector< pvt::EOS_TYPE > & eosTypes,
+                         ComponentProperties const & componentProperties,
+                         pvt::KValueTable const & kValueTable );
+
+  using CompositionalFlash::setPrecisionType;
+  using CompositionalFlash::getStatistics;
+  using CompositionalFlash::resetStatistics;
+
+  /**
+   * @brief Checks the dimensions, the steps and the values of @p kValueTable.
+   * @param kValueTable The table.
+   * @param nComponents The number of components.
+   * @return True if the table can be used.
+   */
+  static bool isTableConsistent( pvt::KValueTable const & kValueTable,
+                                 std::size_t nComponents );
+
+  bool computeEquilibrium( NegativeTwoPhaseFlashMultiphaseSystemProperties & sysProps ) const;
+
+private:
+
+  /**
+   * @brief Interpolates the K-values bilinearly in ln K.
+   * @param pressure The pressure.
+   * @param temperature The temperature.
+   * @param kValues The output K-values, sized to the number of components.
+   *
+   * The four surrounding grid nodes are found in O(1) since the grid is uniform,
+   * and the K-values of each node are contiguous. Conditions outside of the grid use the closest edge.
+   */
+  void interpolateKValues( double pressure,
+                           double temperature,
+                           std::vector< double > & kValues ) const;
+
+  double m_minPressure;
+  double m_inversePressureStep;
+  std::size_t m_nPressures;
+  double m_minTemperature;
+  double m_inverseTemperatureStep;
+  std::size_t m_nTemperatures;
+
+  /// The ln K-values, laid out as [pressure][temperature][component].
+  std::vector< double > m_lnKValues;
+
+  /// Buffers of the flash computations, which are reused from one call to the other.
+  mutable std::vector< double > m_kValues, m_oilMoleComposition, m_gasMoleComposition;
+  /// The components present in the feed.
+  mutable std::vector< std::size_t > m_positiveComponents;
+};
+
+}
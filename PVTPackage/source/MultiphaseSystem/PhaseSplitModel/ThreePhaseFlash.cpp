@@ -0,0 +1,183 @@
+/*
+ * ------------------------------------------------------------------------------------------------------------
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (c) 2016-2024 Lawrence Livermore National Security LLC
+ * Copyright (c) 2018-2024 TotalEnergies
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University
+ * Copyright (c) 2018-2024 Chevron 
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors
+ * All rights reserved
+ *
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.
+ * ------------------------------------------------------------------------------------------------------------
+ */
+
+#include "MultiphaseSystem/PhaseSplitModel/ThreePhaseFlash.hpp"
+
+#include "Utils/math.hpp"
+
+#include <array>
+#include <limits>
+
+namespace PVTPackage
+{
+
+ThreePhaseFlash::ThreePhaseFlash( const std::vector< pvt::PHASE_TYPE > & phases,
+                                  const std::vector< pvt::EOS_TYPE > & eosTypes,
+                                  ComponentProperties const & componentProperties )
+  : CompositionalFlash( phases, eosTypes, componentProperties )
+{ }
+
+void ThreePhaseFlash::computeInitialKValues( double pressure,
+                                             double temperature,
+                                             std::vector< std::vector< double > > & kValues ) const
+{
+  // Solubility of the hydrocarbons in the aqueous phase, and of water in the oil phase.
+  const double hydrocarbonSolubility = 1.e-5;
+  const double waterSolubility = 1.e-3;
+
+  const std::size_t waterIndex = getWaterIndex();
+
+  kValues.resize( 2 );
+  std::vector< double > & kGasOil = kValues[0];
+  std::vector< double > & kWaterOil = kValues[1];
+  computeWilsonGasLiquidKvalue( pressure, temperature, kGasOil );
+  kWaterOil.assign( getNComponents(), hydrocarbonSolubility );
+  kWaterOil[waterIndex] = 1. / waterSolubility;
+  kGasOil[waterIndex] = kWaterOil[waterIndex] * computeWaterVaporKvalue( pressure, temperature );
+}
+
+bool ThreePhaseFlash::computeEquilibrium( FreeWaterFlashMultiphaseSystemProperties & sysProps ) const
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  // Equilibrium convergence parameters
+  const int max_SSI_iterations = 100;
+  const double fugacityEpsilon = 1e-8;
+
+  const double & pressure = sysProps.getPressure();
+  const double & temperature = sysProps.getTemperature();
+  const std::vector< double > & feed = sysProps.getFeed();
+
+  ASSERT( std::fabs( math::sum_array( feed ) - 1.0 ) < 1e-12, "Feed sum must be 1" );
+
+  const std::size_t nComponents = getNComponents();
+
+  // The oil phase is the reference of the K-values.
+  const std::array< pvt::PHASE_TYPE, 3 > phases{ { pvt::PHASE_TYPE::OIL, pvt::PHASE_TYPE::GAS, pvt::PHASE_TYPE::LIQUID_WATER_RICH } };
+  std::vector< double > const * lnFugacities[] = {
+    &sysProps.getOilLnFugacity(), &sysProps.getGasLnFugacity(), &sysProps.getWaterLnFugacity()
+  };
+  std::vector< std::vector< double > > & kValues = m_kValues;
+  computeInitialKValues( pressure, temperature, kValues );
+
+  //Check for machine-zero feed values
+  const double epsilon = std::numeric_limits< double >::epsilon();
+  std::vector< std::size_t > & positiveComponents = m_positiveComponents;
+  positiveComponents.clear();
+  for( std::size_t i = 0; i < nComponents; ++i )
+  {
+    if( feed[i] > epsilon )
+    {
+      positiveComponents.push_back( i );
+    }
+  }
+
+  std::vector< std::vector< double > > & moleCompositions = m_moleCompositions;
+  std::vector< std::vector< double > > & fugacityRatios = m_fugacityRatios;
+  std::vector< SuccessiveSubstitutionSteps > & ssiSteps = m_ssiSteps;
+  moleCompositions.resize( phases.size() );
+  fugacityRatios.resize( phases.size() - 1 );
+  ssiSteps.resize( phases.size() - 1, SuccessiveSubstitutionSteps( 0 ) );
+  for( std::size_t p = 0; p < phases.size(); ++p )
+  {
+    moleCompositions[p].assign( nComponents, 0. );
+  }
+  for( std::size_t p = 0; p + 1 < phases.size(); ++p )
+  {
+    fugacityRatios[p].assign( nComponents, 0. );
+    ssiSteps[p].reset( nComponents );
+  }
+  // Empty fractions make the Rachford-Rice solver start from equal fractions.
+  std::vector< double > & phaseFractions = m_phaseFractions;
+  phaseFractions.clear();
+
+  std::size_t nIterations = max_SSI_iterations;
+  bool rachfordRiceConverged = true;
+  bool fugacitiesConverged = false;
+  for( int iter = 0; iter < max_SSI_iterations; ++iter )
+  {
+    // Solve the multiphase Rachford-Rice equations, starting from the previous fractions
+    rachfordRiceConverged = m_multiphaseRachfordRice.solve( kValues, feed, positiveComponents, phaseFractions ).converged;
+
+    // Assign phase compositions
+    for( auto ic : positiveComponents )
+    {
+      double t = phaseFractions[0];
+      for( std::size_t p = 1; p < phases.size(); ++p )
+      {
+        t += phaseFractions[p] * kValues[p - 1][ic];
+      }
+      moleCompositions[0][ic] = feed[ic] / t;
+      for( std::size_t p = 1; p < phases.size(); ++p )
+      {
+        moleCompositions[p][ic] = kValues[p - 1][ic] * moleCompositions[0][ic];
+      }
+    }
+
+    for( std::size_t p = 0; p < phases.size(); ++p )
+    {
+      math::NormalizeInPlace( moleCompositions[p] );
+      computePhaseProperties( phases[p], pressure, temperature, moleCompositions[p], sysProps );
+    }
+
+    // Compute fugacity ratios w.r.t. the oil phase and check convergence.
+    // The fugacity coefficients are those of the normalized compositions, but the ratios phi^oil_i / ( K_ip phi^p_i )
+    // relate the compositions through y_ip = K_ip x_i, whether phase p is present or not, so that the K-values
+    // of a vanished phase converge to the stationary point of its tangent plane distance.
+    bool converged = true;
+    std::vector< double > const & oilLnFugacity = *lnFugacities[0];
+    for( std::size_t p = 1; p < phases.size(); ++p )
+    {
+      std::vector< double > const & lnFugacity = *lnFugacities[p];
+      for( auto ic : positiveComponents )
+      {
+        fugacityRatios[p - 1][ic] = std::exp( oilLnFugacity[ic] - lnFugacity[ic] ) / kValues[p - 1][ic];
+        if( std::fabs( fugacityRatios[p - 1][ic] - 1.0 ) > fugacityEpsilon )
+        {
+          converged = false;
+        }
+      }
+    }
+
+    if( converged )
+    {
+      nIterations = iter + 1;
+      fugacitiesConverged = true;
+      break;
+    }
+
+    // Update K-values
+    for( std::size_t p = 1; p < phases.size(); ++p )
+    {
+      updateKValues( fugacityRatios[p - 1], positiveComponents, ssiSteps[p - 1], kValues[p - 1] );
+    }
+  }
+
+  const bool success = rachfordRiceConverged and fugacitiesConverged;
+  recordIterations( sysProps, nIterations, success );
+
+  sysProps.setOilMoleComposition( moleCompositions[0] );
+  sysProps.setGasMoleComposition( moleCompositions[1] );
+  sysProps.setWaterMoleComposition( moleCompositions[2] );
+  sysProps.setOilFraction( phaseFractions[0] );
+  sysProps.setGasFraction( phaseFractions[1] );
+  sysProps.setWaterFraction( phaseFractions[2] );
+
+  recordFlashTime( sysProps, start );
+
+  return success;
+}
+
+}
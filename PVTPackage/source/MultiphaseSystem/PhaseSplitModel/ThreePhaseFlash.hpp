@@ -0,0 +1,80 @@
+/*
+ * ------------------------------------------------------------------------------------------------------------
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (c) 2016-2024 Lawrence Livermore National Security LLC
+ * Copyright (c) 2018-2024 TotalEnergies
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University
+ * Copyright (c) 2018-2024 Chevron 
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors
+ * All rights reserved
+ *
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.
+ * ------------------------------------------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include "MultiphaseSystem/ComponentProperties.hpp"
+#include "MultiphaseSystem/MultiphaseSystemProperties/FreeWaterFlashMultiphaseSystemProperties.hpp"
+#include "MultiphaseSystem/PhaseSplitModel/CompositionalFlash.hpp"
+#include "MultiphaseSystem/PhaseSplitModel/MultiphaseRachfordRice.hpp"
+
+#include "pvt/pvt.hpp"
+
+namespace PVTPackage
+{
+
+/**
+ * @brief Oil/gas/aqueous flash where all the components may enter all the phases.
+ *
+ * The K-values of the gas and aqueous phases w.r.t. the oil phase are updated by successive substitution,
+ * each iteration solving the multiphase Rachford-Rice equations with MultiphaseRachfordRice.
+ * Phases which vanish get a zero fraction and keep the composition of their K-values,
+ * so that they can reappear in the next iterations.
+ */
+class ThreePhaseFlash final : private CompositionalFlash
+{
+public:
+
+  ThreePhaseFlash( const std::vector< pvt::PHASE_TYPE > & phases,
+                   const std::vector< pvt::EOS_TYPE > & eosTypes,
+                   ComponentProperties const & componentProperties );
+
+  using CompositionalFlash::setPrecisionType;
+  using CompositionalFlash::setSsiAccelerationType;
+  using CompositionalFlash::getStatistics;
+  using CompositionalFlash::resetStatistics;
+
+  bool computeEquilibrium( FreeWaterFlashMultiphaseSystemProperties & sysProps ) const;
+
+private:
+
+  /**
+   * @brief Computes the initial K-values of the gas and aqueous phases w.r.t. the oil phase.
+   * @param pressure The pressure.
+   * @param temperature The temperature.
+   * @param kValues The K-values, as [phase][component], gas first.
+   *
+   * Gas K-values come from the Wilson correlation. Water is assumed to be nearly immiscible with the hydrocarbons,
+   * its gas/aqueous K-value coming from its vapor pressure.
+   */
+  void computeInitialKValues( double pressure,
+                              double temperature,
+                              std::vector< std::vector< double > > & kValues ) const;
+
+  /// Reused multiphase Rachford-Rice solver.
+  mutable MultiphaseRachfordRice m_multiphaseRachfordRice;
+
+  /// Buffers of the flash computations, as [phase][component], which are reused from one call to the other.
+  /// The K-values and fugacity ratios are w.r.t. the oil phase and do not include it.
+  mutable std::vector< std::vector< double > > m_kValues, m_moleCompositions, m_fugacityRatios;
+  /// The phase mole fractions, oil first.
+  mutable std::vector< double > m_phaseFractions;
+  /// The components present in the feed.
+  mutable std::vector< std::size_t > m_positiveComponents;
+  /// The successive substitution steps of the gas and aqueous K-values.
+  mutable std::vector< SuccessiveSubstitutionSteps > m_ssiSteps;
+};
+
+}
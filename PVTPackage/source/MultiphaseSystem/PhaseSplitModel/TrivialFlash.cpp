@@ -17,6 +17,7 @@
 #include "MultiphaseSystem/PhaseModel/CubicEOS/CubicEoSPhaseModel.hpp"
 #include "Utils/math.hpp"
 
+#include <array>
 #include <vector>
 
 namespace PVTPackage
@@ -41,13 +42,17 @@ bool TrivialFlash::computeEquilibrium( TrivialFlashMultiphaseSystemProperties &
   // FIXME These componentsProperties seem the same as EOSPhaseModels'. They should no go to the data part.
   const std::size_t nComponents = getNComponents();
 
-  std::vector< double > gasMoleComposition = std::vector< double >( nComponents, 0. );
-  std::vector< double > oilMoleComposition = std::vector< double >( nComponents, 0. );
-  std::vector< double > waterMoleComposition = std::vector< double >( nComponents, 0. );
+  std::vector< double > & gasMoleComposition = m_gasMoleComposition;
+  std::vector< double > & oilMoleComposition = m_oilMoleComposition;
+  std::vector< double > & waterMoleComposition = m_waterMoleComposition;
+  gasMoleComposition.assign( nComponents, 0. );
+  oilMoleComposition.assign( nComponents, 0. );
+  waterMoleComposition.assign( nComponents, 0. );
 
-  std::vector< double > kGasOil = computeWilsonGasLiquidKvalue( pressure, temperature );
-  std::vector< double > kWaterGas = computeWaterGasKvalue( pressure, temperature );
-  std::vector< double > kWaterOil = computeWaterOilKvalue( pressure, temperature );
+  std::vector< double > & kGasOil = m_kGasOil;
+  computeWilsonGasLiquidKvalue( pressure, temperature, kGasOil );
+  std::vector< double > & kWaterGas = m_kWaterGas;
+  computeWaterGasKvalue( pressure, temperature, kWaterGas );
 
   //Trivial split
   double vOil = 0.;
@@ -103,13 +108,11 @@ bool TrivialFlash::computeEquilibrium( TrivialFlashMultiphaseSystemProperties &
   sysProps.setOilMoleComposition( oilMoleComposition );
   sysProps.setWaterMoleComposition( waterMoleComposition );
 
+  // Phase slots indexed by pvt::PHASE_TYPE (GAS, OIL, LIQUID_WATER_RICH), other phases throwing std::out_of_range.
+  std::array< std::vector< double > const *, 3 > const moleComposition{ { &gasMoleComposition, &oilMoleComposition, &waterMoleComposition } };
   for( const pvt::PHASE_TYPE & phase: sysProps.getPhases() )
   {
-    const CubicEoSPhaseModel & model = getCubicEoSPhaseModel( phase );
-    const std::vector< double > & moleComposition = sysProps.getMoleComposition( phase ).value;
-    const auto props = model.computeAllProperties( pressure, temperature, moleComposition );
-
-    sysProps.setModelProperties( phase, props );
+    computePhaseProperties( phase, pressure, temperature, *moleComposition.at( static_cast< std::size_t >( phase ) ), sysProps );
   }
 
   return true;
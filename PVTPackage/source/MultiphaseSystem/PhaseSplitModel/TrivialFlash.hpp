@@ -32,7 +32,15 @@ public:
                 const std::vector< pvt::EOS_TYPE > & eosTypes,
                 ComponentProperties const & componentProperties );
 
+  using CompositionalFlash::setPrecisionType;
+
   bool computeEquilibrium( TrivialFlashMultiphaseSystemProperties & sysProps ) const;
+
+private:
+
+  /// Buffers of the flash computations, which are reused from one call to the other.
+  mutable std::vector< double > m_kGasOil, m_kWaterGas;
+  mutable std::vector< double > m_gasMoleComposition, m_oilMoleComposition, m_waterMoleComposition;
 };
 
 }
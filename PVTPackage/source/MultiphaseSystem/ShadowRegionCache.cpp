@@ -0,0 +1,93 @@
+/*
+ * ------------------------------------------------------------------------------------------------------------
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (c) 2016-2024 Lawrence Livermore National Security LLC
+ * Copyright (c) 2018-2024 TotalEnergies
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University
+ * Copyright (c) 2018-2024 Chevron 
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors
+ * All rights reserved
+ *
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.
+ * ------------------------------------------------------------------------------------------------------------
+ */
+
+#include "MultiphaseSystem/ShadowRegionCache.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace PVTPackage
+{
+
+ShadowRegionCache::ShadowRegionCache( std::size_t nCells,
+                                      std::size_t nComponents )
+  : m_nComponents( nComponents ),
+    m_pressures( nCells, 0. ),
+    m_temperatures( nCells, 0. ),
+    m_feeds( nCells * nComponents, 0. ),
+    m_trustRadii( nCells, 0. ),
+    m_stabilities( nCells, Stability::UNKNOWN )
+{ }
+
+std::size_t ShadowRegionCache::size() const
+{
+  return m_stabilities.size();
+}
+
+void ShadowRegionCache::clear()
+{
+  std::fill( m_stabilities.begin(), m_stabilities.end(), Stability::UNKNOWN );
+}
+
+std::size_t ShadowRegionCache::getNComponents() const
+{
+  return m_nComponents;
+}
+
+ShadowRegionCache::Stability ShadowRegionCache::getStability( std::size_t cellIndex,
+                                                              double pressure,
+                                                              double temperature,
+                                                              std::vector< double > const & feed ) const
+{
+  const Stability stability = m_stabilities[cellIndex];
+  if( stability == Stability::UNKNOWN )
+  {
+    return Stability::UNKNOWN;
+  }
+
+  const double radius = m_trustRadii[cellIndex];
+  if( std::fabs( pressure - m_pressures[cellIndex] ) > radius * std::fabs( m_pressures[cellIndex] ) or
+      std::fabs( temperature - m_temperatures[cellIndex] ) > radius * std::fabs( m_temperatures[cellIndex] ) )
+  {
+    return Stability::UNKNOWN;
+  }
+
+  double const * cellFeed = &m_feeds[cellIndex * m_nComponents];
+  for( std::size_t ic = 0; ic < m_nComponents; ++ic )
+  {
+    if( std::fabs( feed[ic] - cellFeed[ic] ) > radius )
+    {
+      return Stability::UNKNOWN;
+    }
+  }
+
+  return stability;
+}
+
+void ShadowRegionCache::setStability( std::size_t cellIndex,
+                                      double pressure,
+                                      double temperature,
+                                      std::vector< double > const & feed,
+                                      Stability stability,
+                                      double distance )
+{
+  m_pressures[cellIndex] = pressure;
+  m_temperatures[cellIndex] = temperature;
+  std::copy( feed.cbegin(), feed.cend(), m_feeds.begin() + cellIndex * m_nComponents );
+  m_trustRadii[cellIndex] = trustRegionFactor * std::fmax( distance, 0. );
+  m_stabilities[cellIndex] = stability;
+}
+
+}
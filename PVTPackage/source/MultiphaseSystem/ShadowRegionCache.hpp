@@ -0,0 +1,95 @@
+/*
+ * ------------------------------------------------------------------------------------------------------------
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (c) 2016-2024 Lawrence Livermore National Security LLC
+ * Copyright (c) 2018-2024 TotalEnergies
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University
+ * Copyright (c) 2018-2024 Chevron 
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors
+ * All rights reserved
+ *
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.
+ * ------------------------------------------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include "MultiphaseSystem/MultiphaseSystemProperties/CompositionalMultiphaseSystemProperties.hpp"
+
+#include "pvt/pvt.hpp"
+
+#include <vector>
+
+namespace PVTPackage
+{
+
+/**
+ * @brief Per cell conditions and outcome of the last stability test.
+ *
+ * All the data is allocated at construction, so that distinct cells can be read and written concurrently.
+ */
+class ShadowRegionCache final : public pvt::ShadowRegionCache
+{
+public:
+
+  using Stability = CompositionalMultiphaseSystemProperties::Stability;
+
+  ShadowRegionCache( std::size_t nCells,
+                     std::size_t nComponents );
+
+  std::size_t size() const override;
+
+  void clear() override;
+
+  std::size_t getNComponents() const;
+
+  /**
+   * @brief Computes the known stability of a cell for given conditions.
+   * @param cellIndex The cell.
+   * @param pressure The pressure.
+   * @param temperature The temperature.
+   * @param feed The feed.
+   * @return The outcome of the last stability test of the cell if the conditions are inside its trust region, UNKNOWN otherwise.
+   */
+  Stability getStability( std::size_t cellIndex,
+                          double pressure,
+                          double temperature,
+                          std::vector< double > const & feed ) const;
+
+  /**
+   * @brief Stores the conditions and outcome of a stability test of a cell.
+   * @param cellIndex The cell.
+   * @param pressure The pressure.
+   * @param temperature The temperature.
+   * @param feed The feed.
+   * @param stability The outcome of the test.
+   * @param distance The distance to the phase boundary: the tangent plane distance for a stable feed,
+   * the smallest phase mole fraction of the flash for an unstable one.
+   *
+   * The trust region spans relative variations of pressure and temperature, and variations of the mole fractions,
+   * up to #trustRegionFactor times @p distance.
+   */
+  void setStability( std::size_t cellIndex,
+                     double pressure,
+                     double temperature,
+                     std::vector< double > const & feed,
+                     Stability stability,
+                     double distance );
+
+private:
+
+  /// Size of the trust region per unit of distance to the phase boundary.
+  static constexpr double trustRegionFactor = 0.1;
+
+  const std::size_t m_nComponents;
+
+  std::vector< double > m_pressures;
+  std::vector< double > m_temperatures;
+  /// Feeds of the cells, laid out as [cell][component].
+  std::vector< double > m_feeds;
+  std::vector< double > m_trustRadii;
+  std::vector< Stability > m_stabilities;
+};
+
+}
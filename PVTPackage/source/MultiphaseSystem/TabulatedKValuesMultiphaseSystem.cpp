@@ -0,0 +1,135 @@
+/*
+ * ------------------------------------------------------------------------------------------------------------
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (c) 2016-2024 Lawrence Livermore National Security LLC
+ * Copyright (c) 2018-2024 TotalEnergies
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University
+ * Copyright (c) 2018-2024 Chevron 
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors
+ * All rights reserved
+ *
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.
+ * ------------------------------------------------------------------------------------------------------------
+ */
+
+#include "TabulatedKValuesMultiphaseSystem.hpp"
+
+#include "MultiphaseSystem/ComponentProperties.hpp"
+
+#include "pvt/pvt.hpp"
+
+#include <memory>
+
+namespace PVTPackage
+{
+
+std::unique_ptr< TabulatedKValuesMultiphaseSystem > TabulatedKValuesMultiphaseSystem::build( const std::vector< pvt::PHASE_TYPE > & phases,
+                                                                                             const std::vector< pvt::EOS_TYPE > & eosTypes,
+                                                                                             const std::vector< std::string > & componentNames,
+                                                                                             const std::vector< double > & componentMolarWeights,
+                                                                                             const std::vector< double > & componentCriticalTemperatures,
+                                                                                             const std::vector< double > & componentCriticalPressures,
+                                                                                             const std::vector< double > & componentOmegas,
+                                                                                             const std::vector< std::vector< double > > & componentBinaryInteractionCoefficients,
+                                                                                             const std::vector< std::vector< double > > & componentVolumeShifts,
+                                                                                             const pvt::KValueTable & kValueTable )
+{
+  if( not areComponentDataConsistent( componentNames,
+                                      componentMolarWeights,
+                                      componentCriticalTemperatures,
+                                      componentCriticalPressures,
+                                      componentOmegas,
+                                      componentBinaryInteractionCoefficients,
+                                      componentVolumeShifts ) )
+  {
+    return std::unique_ptr< TabulatedKValuesMultiphaseSystem >();
+  }
+
+  if( not TabulatedKValuesFlash::isTableConsistent( kValueTable, componentNames.size() ) )
+  {
+    return std::unique_ptr< TabulatedKValuesMultiphaseSystem >();
+  }
+
+  ComponentProperties cp( componentNames.size(),
+                          componentNames,
+                          componentMolarWeights,
+                          componentCriticalTemperatures,
+                          componentCriticalPressures,
+                          componentOmegas,
+                          componentBinaryInteractionCoefficients,
+                          componentVolumeShifts );
+
+  // I am not using std::make_unique because I want the constructor to be private.
+  auto * ptr = new TabulatedKValuesMultiphaseSystem( phases, eosTypes, cp, kValueTable );
+  return std::unique_ptr< TabulatedKValuesMultiphaseSystem >( ptr );
+}
+
+TabulatedKValuesMultiphaseSystem::TabulatedKValuesMultiphaseSystem( const std::vector< pvt::PHASE_TYPE > & phases,
+                                                                    const std::vector< pvt::EOS_TYPE > & eosTypes,
+                                                                    const ComponentProperties & componentProperties,
+                                                                    const pvt::KValueTable & kValueTable )
+  :
+  m_tabulatedKValuesFlash( phases, eosTypes, componentProperties, kValueTable ),
+  m_ntpfmsp( phases, componentProperties.NComponents )
+{
+
+}
+
+void TabulatedKValuesMultiphaseSystem::Update( double pressure,
+                                               double temperature,
+                                               std::vector< double > feed )
+{
+  m_stateIndicator = solve( pressure, temperature, feed ) ? State::SUCCESS : State::NOT_CONVERGED;
+}
+
+bool TabulatedKValuesMultiphaseSystem::BatchUpdate( std::size_t nCells,
+                                                    double const * pressures,
+                                                    double const * temperatures,
+                                                    double const * feeds,
+                                                    pvt::MultiphaseSystemBatchProperties const & outputs )
+{
+  auto solver = [this]( double pressure, double temperature, std::vector< double > const & feed )
+  {
+    return solve( pressure, temperature, feed );
+  };
+  return batchUpdate( nCells, pressures, temperatures, feeds, m_ntpfmsp, outputs, solver );
+}
+
+bool TabulatedKValuesMultiphaseSystem::solve( double pressure,
+                                              double temperature,
+                                              std::vector< double > const & feed )
+{
+  m_ntpfmsp.setTemperature( temperature );
+  m_ntpfmsp.setPressure( pressure );
+  m_ntpfmsp.setFeed( feed );
+
+  return computeEquilibriumAndDerivativesWithTemperature( m_tabulatedKValuesFlash, m_ntpfmsp );
+}
+
+const pvt::MultiphaseSystemProperties & TabulatedKValuesMultiphaseSystem::getMultiphaseSystemProperties() const
+{
+  return m_ntpfmsp;
+}
+
+void TabulatedKValuesMultiphaseSystem::setPrecisionType( pvt::PRECISION_TYPE const & precisionType )
+{
+  m_tabulatedKValuesFlash.setPrecisionType( precisionType );
+}
+
+pvt::FlashStatistics const & TabulatedKValuesMultiphaseSystem::getFlashStatistics() const
+{
+  return m_tabulatedKValuesFlash.getStatistics();
+}
+
+void TabulatedKValuesMultiphaseSystem::resetFlashStatistics()
+{
+  m_tabulatedKValuesFlash.resetStatistics();
+}
+
+std::vector< double > const & TabulatedKValuesMultiphaseSystem::getKValues() const
+{
+  return m_ntpfmsp.getKValues();
+}
+
+}
@@ -0,0 +1,90 @@
+/*
+ * ------------------------------------------------------------------------------------------------------------
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (c) 2016-2024 Lawrence Livermore National Security LLC
+ * Copyright (c) 2018-2024 TotalEnergies
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University
+ * Copyright (c) 2018-2024 Chevron 
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors
+ * All rights reserved
+ *
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.
+ * ------------------------------------------------------------------------------------------------------------
+ */
+
+#ifndef PVTPACKAGE_TABULATEDKVALUESMULTIPHASESYSTEM_HPP
+#define PVTPACKAGE_TABULATEDKVALUESMULTIPHASESYSTEM_HPP
+
+#include "MultiphaseSystem/ComponentProperties.hpp"
+#include "MultiphaseSystem/MultiphaseSystemProperties/NegativeTwoPhaseFlashMultiphaseSystemProperties.hpp"
+#include "MultiphaseSystem/PhaseSplitModel/TabulatedKValuesFlash.hpp"
+#include "MultiphaseSystem/MultiphaseSystem.hpp"
+
+#include "pvt/pvt.hpp"
+
+#include <memory>
+
+namespace PVTPackage
+{
+
+class TabulatedKValuesMultiphaseSystem : public CompositionalMultiphaseSystem
+{
+public:
+
+  static std::unique_ptr< TabulatedKValuesMultiphaseSystem > build( const std::vector< pvt::PHASE_TYPE > & phases,
+                                                                    const std::vector< pvt::EOS_TYPE > & eosTypes,
+                                                                    const std::vector< std::string > & componentNames,
+                                                                    const std::vector< double > & componentMolarWeights,
+                                                                    const std::vector< double > & componentCriticalTemperatures,
+                                                                    const std::vector< double > & componentCriticalPressures,
+                                                                    const std::vector< double > & componentOmegas,
+                                                                    const std::vector< std::vector< double > > & componentBinaryInteractionCoefficients,
+                                                                    const std::vector< std::vector< double > > & componentVolumeShifts,
+                                                                    const pvt::KValueTable & kValueTable );
+
+  void Update( double pressure,
+               double temperature,
+               std::vector< double > feed ) override;
+
+  bool BatchUpdate( std::size_t nCells,
+                    double const * pressures,
+                    double const * temperatures,
+                    double const * feeds,
+                    pvt::MultiphaseSystemBatchProperties const & outputs ) override;
+
+  const pvt::MultiphaseSystemProperties & getMultiphaseSystemProperties() const override;
+
+  void setPrecisionType( pvt::PRECISION_TYPE const & precisionType ) override;
+
+  pvt::FlashStatistics const & getFlashStatistics() const override;
+
+  void resetFlashStatistics() override;
+
+  std::vector< double > const & getKValues() const override;
+
+private:
+
+  /**
+   * @brief Solves the system for given @p pressure, @p temperature and @p feed.
+   * @return True in case of success.
+   *
+   * The derivatives are always computed by finite differences.
+   */
+  bool solve( double pressure,
+              double temperature,
+              std::vector< double > const & feed );
+
+  TabulatedKValuesMultiphaseSystem( const std::vector< pvt::PHASE_TYPE > & phases,
+                                    const std::vector< pvt::EOS_TYPE > & eosTypes,
+                                    const ComponentProperties & componentProperties,
+                                    const pvt::KValueTable & kValueTable );
+
+  TabulatedKValuesFlash m_tabulatedKValuesFlash;
+
+  NegativeTwoPhaseFlashMultiphaseSystemProperties m_ntpfmsp;
+};
+
+}
+
+#endif //PVTPACKAGE_TABULATEDKVALUESMULTIPHASESYSTEM_HPP
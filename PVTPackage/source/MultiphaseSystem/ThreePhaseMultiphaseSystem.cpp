@@ -0,0 +1,142 @@
+/*
+ * ------------------------------------------------------------------------------------------------------------
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (c) 2016-2024 Lawrence Livermore National Security LLC
+ * Copyright (c) 2018-2024 TotalEnergies
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University
+ * Copyright (c) 2018-2024 Chevron 
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors
+ * All rights reserved
+ *
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.
+ * ------------------------------------------------------------------------------------------------------------
+ */
+
+#include "ThreePhaseMultiphaseSystem.hpp"
+
+#include "MultiphaseSystem/ComponentProperties.hpp"
+
+#include "pvt/pvt.hpp"
+
+#include <algorithm>
+#include <memory>
+
+namespace PVTPackage
+{
+
+std::unique_ptr< ThreePhaseMultiphaseSystem > ThreePhaseMultiphaseSystem::build( const std::vector< pvt::PHASE_TYPE > & phases,
+                                                                                 const std::vector< pvt::EOS_TYPE > & eosTypes,
+                                                                                 const std::vector< std::string > & componentNames,
+                                                                                 const std::vector< double > & componentMolarWeights,
+                                                                                 const std::vector< double > & componentCriticalTemperatures,
+                                                                                 const std::vector< double > & componentCriticalPressures,
+                                                                                 const std::vector< double > & componentOmegas,
+                                                                                 const std::vector< std::vector< double > > & componentBinaryInteractionCoefficients,
+                                                                                 const std::vector< std::vector< double > > & componentVolumeShifts )
+{
+  if( not areComponentDataConsistent( componentNames,
+                                      componentMolarWeights,
+                                      componentCriticalTemperatures,
+                                      componentCriticalPressures,
+                                      componentOmegas,
+                                      componentBinaryInteractionCoefficients,
+                                      componentVolumeShifts ) )
+  {
+    return std::unique_ptr< ThreePhaseMultiphaseSystem >();
+  }
+
+  for( const pvt::PHASE_TYPE phase: { pvt::PHASE_TYPE::OIL, pvt::PHASE_TYPE::GAS, pvt::PHASE_TYPE::LIQUID_WATER_RICH } )
+  {
+    if( std::find( phases.cbegin(), phases.cend(), phase ) == phases.cend() )
+    {
+      return std::unique_ptr< ThreePhaseMultiphaseSystem >();
+    }
+  }
+
+  ComponentProperties cp( componentNames.size(),
+                          componentNames,
+                          componentMolarWeights,
+                          componentCriticalTemperatures,
+                          componentCriticalPressures,
+                          componentOmegas,
+                          componentBinaryInteractionCoefficients,
+                          componentVolumeShifts );
+
+  if( cp.WaterIndex >= cp.NComponents )
+  {
+    return std::unique_ptr< ThreePhaseMultiphaseSystem >();
+  }
+
+  // I am not using std::make_unique because I want the constructor to be private.
+  auto * ptr = new ThreePhaseMultiphaseSystem( phases, eosTypes, cp );
+  return std::unique_ptr< ThreePhaseMultiphaseSystem >( ptr );
+}
+
+ThreePhaseMultiphaseSystem::ThreePhaseMultiphaseSystem( const std::vector< pvt::PHASE_TYPE > & phases,
+                                                        const std::vector< pvt::EOS_TYPE > & eosTypes,
+                                                        const ComponentProperties & componentProperties )
+  :
+  m_threePhaseFlash( phases, eosTypes, componentProperties ),
+  m_tpfmsp( phases, componentProperties.NComponents )
+{
+
+}
+
+void ThreePhaseMultiphaseSystem::Update( double pressure,
+                                         double temperature,
+                                         std::vector< double > feed )
+{
+  m_stateIndicator = solve( pressure, temperature, feed ) ? State::SUCCESS : State::NOT_CONVERGED;
+}
+
+bool ThreePhaseMultiphaseSystem::BatchUpdate( std::size_t nCells,
+                                              double const * pressures,
+                                              double const * temperatures,
+                                              double const * feeds,
+                                              pvt::MultiphaseSystemBatchProperties const & outputs )
+{
+  auto solver = [this]( double pressure, double temperature, std::vector< double > const & feed )
+  {
+    return solve( pressure, temperature, feed );
+  };
+  return batchUpdate( nCells, pressures, temperatures, feeds, m_tpfmsp, outputs, solver );
+}
+
+bool ThreePhaseMultiphaseSystem::solve( double pressure,
+                                        double temperature,
+                                        std::vector< double > const & feed )
+{
+  m_tpfmsp.setTemperature( temperature );
+  m_tpfmsp.setPressure( pressure );
+  m_tpfmsp.setFeed( feed );
+
+  return computeEquilibriumAndDerivativesWithTemperature( m_threePhaseFlash, m_tpfmsp );
+}
+
+const pvt::MultiphaseSystemProperties & ThreePhaseMultiphaseSystem::getMultiphaseSystemProperties() const
+{
+  return m_tpfmsp;
+}
+
+void ThreePhaseMultiphaseSystem::setPrecisionType( pvt::PRECISION_TYPE const & precisionType )
+{
+  m_threePhaseFlash.setPrecisionType( precisionType );
+}
+
+void ThreePhaseMultiphaseSystem::setSsiAccelerationType( pvt::SSI_ACCELERATION_TYPE const & accelerationType )
+{
+  m_threePhaseFlash.setSsiAccelerationType( accelerationType );
+}
+
+pvt::FlashStatistics const & ThreePhaseMultiphaseSystem::getFlashStatistics() const
+{
+  return m_threePhaseFlash.getStatistics();
+}
+
+void ThreePhaseMultiphaseSystem::resetFlashStatistics()
+{
+  m_threePhaseFlash.resetStatistics();
+}
+
+}
@@ -24,13 +24,17 @@ std::unique_ptr< TrivialMultiphaseSystem > TrivialMultiphaseSystem::build( std::
                                                                            std::vector< double > const & componentMolarWeights,
                                                                            std::vector< double > const & componentCriticalTemperatures,
                                                                            std::vector< double > const & componentCriticalPressures,
-                                                                           std::vector< double > const & componentOmegas )
+                                                                           std::vector< double > const & componentOmegas,
+                                                                           std::vector< std::vector< double > > const & componentBinaryInteractionCoefficients,
+                                                                           std::vector< std::vector< double > > const & componentVolumeShifts )
 {
   if( not areComponentDataConsistent( componentNames,
                                       componentMolarWeights,
                                       componentCriticalTemperatures,
                                       componentCriticalPressures,
-                                      componentOmegas ) )
+                                      componentOmegas,
+                                      componentBinaryInteractionCoefficients,
+                                      componentVolumeShifts ) )
   {
     return std::unique_ptr< TrivialMultiphaseSystem >();
   }
@@ -40,7 +44,9 @@ std::unique_ptr< TrivialMultiphaseSystem > TrivialMultiphaseSystem::build( std::
                           componentMolarWeights,
                           componentCriticalTemperatures,
                           componentCriticalPressures,
-                          componentOmegas );
+                          componentOmegas,
+                          componentBinaryInteractionCoefficients,
+                          componentVolumeShifts );
 
   // I am not using std::make_unique because I want the constructor to be private.
   auto * ptr = new TrivialMultiphaseSystem( phases, eosTypes, cp );
@@ -60,14 +66,32 @@ TrivialMultiphaseSystem::TrivialMultiphaseSystem( const std::vector< pvt::PHASE_
 void TrivialMultiphaseSystem::Update( double pressure,
                                       double temperature,
                                       std::vector< double > feed )
+{
+  m_stateIndicator = solve( pressure, temperature, feed ) ? State::SUCCESS : State::NOT_CONVERGED;
+}
+
+bool TrivialMultiphaseSystem::BatchUpdate( std::size_t nCells,
+                                           double const * pressures,
+                                           double const * temperatures,
+                                           double const * feeds,
+                                           pvt::MultiphaseSystemBatchProperties const & outputs )
+{
+  auto solver = [this]( double pressure, double temperature, std::vector< double > const & feed )
+  {
+    return solve( pressure, temperature, feed );
+  };
+  return batchUpdate( nCells, pressures, temperatures, feeds, m_tfmsp, outputs, solver );
+}
+
+bool TrivialMultiphaseSystem::solve( double pressure,
+                                     double temperature,
+                                     std::vector< double > const & feed )
 {
   m_tfmsp.setPressure( pressure );
   m_tfmsp.setTemperature( temperature );
   m_tfmsp.setFeed( feed );
 
-  const bool result = computeEquilibriumAndDerivativesWithTemperature( m_trivialFlash, m_tfmsp );
-
-  m_stateIndicator = result ? State::SUCCESS : State::NOT_CONVERGED;
+  return computeEquilibriumAndDerivativesWithTemperature( m_trivialFlash, m_tfmsp );
 }
 
 const pvt::MultiphaseSystemProperties & TrivialMultiphaseSystem::getMultiphaseSystemProperties() const
@@ -75,4 +99,9 @@ const pvt::MultiphaseSystemProperties & TrivialMultiphaseSystem::getMultiphaseSy
   return m_tfmsp;
 }
 
+void TrivialMultiphaseSystem::setPrecisionType( pvt::PRECISION_TYPE const & precisionType )
+{
+  m_trivialFlash.setPrecisionType( precisionType );
+}
+
 }
\ No newline at end of file
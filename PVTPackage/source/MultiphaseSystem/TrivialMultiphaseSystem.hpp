@@ -39,14 +39,32 @@ public:
                                                            std::vector< double > const & componentMolarWeights,
                                                            std::vector< double > const & componentCriticalTemperatures,
                                                            std::vector< double > const & componentCriticalPressures,
-                                                           std::vector< double > const & componentOmegas );
+                                                           std::vector< double > const & componentOmegas,
+                                                           std::vector< std::vector< double > > const & componentBinaryInteractionCoefficients,
+                                                           std::vector< std::vector< double > > const & componentVolumeShifts );
 
   virtual void Update( double pressure, double temperature, std::vector< double > feed ) override;
 
+  bool BatchUpdate( std::size_t nCells,
+                    double const * pressures,
+                    double const * temperatures,
+                    double const * feeds,
+                    pvt::MultiphaseSystemBatchProperties const & outputs ) override;
+
   const pvt::MultiphaseSystemProperties & getMultiphaseSystemProperties() const override;
 
+  void setPrecisionType( pvt::PRECISION_TYPE const & precisionType ) override;
+
 private:
 
+  /**
+   * @brief Solves the system for given @p pressure, @p temperature and @p feed.
+   * @return True in case of success.
+   */
+  bool solve( double pressure,
+              double temperature,
+              std::vector< double > const & feed );
+
   TrivialMultiphaseSystem( const std::vector< pvt::PHASE_TYPE > & phases,
                            const std::vector< pvt::EOS_TYPE > & eosTypes,
                            const ComponentProperties & componentProperties );
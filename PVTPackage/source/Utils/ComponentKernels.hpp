@@ -0,0 +1,67 @@
+/*
+ * ------------------------------------------------------------------------------------------------------------
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (c) 2016-2024 Lawrence Livermore National Security LLC
+ * Copyright (c) 2018-2024 TotalEnergies
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University
+ * Copyright (c) 2018-2024 Chevron 
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors
+ * All rights reserved
+ *
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.
+ * ------------------------------------------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace PVTPackage
+{
+
+/// Largest number of components for which the kernels are specialized at compile time.
+constexpr std::size_t MAX_SPECIALIZED_N_COMPONENTS = 16;
+
+/**
+ * @brief Number of components of a kernel.
+ * @tparam NC The number of components the kernel is specialized for, 0 for the runtime fallback.
+ * @param nComponents The runtime number of components.
+ * @return @p NC as a compile-time constant for specialized kernels, @p nComponents otherwise.
+ */
+template< std::size_t NC >
+constexpr std::size_t nComponentsOf( std::size_t nComponents )
+{
+  return NC == 0 ? nComponents : NC;
+}
+
+namespace details
+{
+
+template< template< std::size_t > class Kernel, std::size_t... NC >
+std::array< decltype( &Kernel< 0 >::run ), sizeof...( NC ) > makeKernelTable( std::index_sequence< NC... > )
+{
+  return { { &Kernel< NC >::run... } };
+}
+
+}
+
+/**
+ * @brief Selects the specialization of a kernel for a number of components.
+ * @tparam Kernel Class template on the number of components (see nComponentsOf), exposing the kernel as a static function run.
+ * @param nComponents The number of components.
+ * @return The kernel specialized for @p nComponents, or the runtime fallback above MAX_SPECIALIZED_N_COMPONENTS.
+ *
+ * The loops of specialized kernels have compile-time bounds, so that the compiler can unroll and vectorize them.
+ * Since the operations are the same, all the specializations give the same results.
+ */
+template< template< std::size_t > class Kernel >
+decltype( &Kernel< 0 >::run ) selectKernel( std::size_t nComponents )
+{
+  static const auto kernels = details::makeKernelTable< Kernel >( std::make_index_sequence< MAX_SPECIALIZED_N_COMPONENTS + 1 >() );
+  return nComponents < kernels.size() ? kernels[nComponents] : kernels[0];
+}
+
+}
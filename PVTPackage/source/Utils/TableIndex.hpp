@@ -0,0 +1,159 @@
+/*
+ * ------------------------------------------------------------------------------------------------------------
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (c) 2016-2024 Lawrence Livermore National Security LLC
+ * Copyright (c) 2018-2024 TotalEnergies
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University
+ * Copyright (c) 2018-2024 Chevron 
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors
+ * All rights reserved
+ *
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.
+ * ------------------------------------------------------------------------------------------------------------
+ */
+
+
+#pragma once
+
+#include "Assert.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace math
+{
+
+/**
+ * @brief Interval search of an interpolation table axis, which strategy is chosen once from the axis values.
+ * @tparam T The type of the axis values.
+ *
+ * The intervals are the same as the ones of FindSurrondingIndex, whatever the strategy:
+ * - uniform axes (e.g. built by linspace) get their interval in O(1), then checked against the actual values;
+ * - other increasing axes use a binary search, which can start from the interval of a previous lookup (hint);
+ * - axes which are not increasing keep the linear scan.
+ */
+template< typename T >
+class TableIndex
+{
+public:
+
+  /**
+   * @brief Builds a linear scan index, until it is built from the axis values.
+   */
+  TableIndex() = default;
+
+  /**
+   * @brief Builds the index of an axis.
+   * @param x The axis values. The index does not keep any reference to them.
+   */
+  explicit TableIndex( std::vector< T > const & x )
+  {
+    ASSERT( !x.empty(), "Interpolation table is empty" );
+    const std::size_t last = x.size() - 1;
+    const bool increasing = std::adjacent_find( x.cbegin(), x.cend(), []( T const & a, T const & b ){ return not( a < b ); } ) == x.cend();
+    if( last < 1 or not increasing )
+    {
+      return;
+    }
+
+    // Uniform axes are detected up to the rounding of their construction, since the O(1) guess gets corrected anyway
+    const T spacing = ( x[last] - x[0] ) / last;
+    bool uniform = true;
+    for( std::size_t i = 1; i < last and uniform; ++i )
+    {
+      uniform = std::fabs( x[i] - ( x[0] + i * spacing ) ) <= 1.e-8 * spacing;
+    }
+
+    m_search = uniform ? Search::UNIFORM : Search::BINARY;
+    m_origin = x[0];
+    m_inverseSpacing = 1. / spacing;
+  }
+
+  /**
+   * @brief Finds the interval of @p xval, see FindSurrondingIndex.
+   * @param x The axis values the index was built from.
+   * @param xval The value to locate.
+   * @param iminus The lower bound of the interval.
+   * @param iplus The upper bound of the interval.
+   * @param hint Optional interval of a previous lookup (e.g. of the same cell), checked first and updated.
+   * Only used by the binary search.
+   */
+  void find( std::vector< T > const & x,
+             T xval,
+             std::size_t & iminus,
+             std::size_t & iplus,
+             std::size_t * hint = nullptr ) const
+  {
+    ASSERT( !x.empty(), "Interpolation table is empty" );
+    ASSERT( x[0] <= xval, "Input x value iut of range, extrapolation not allowed" );
+    const std::size_t last = x.size() - 1;
+    switch( m_search )
+    {
+      case Search::UNIFORM:
+      {
+        const T position = ( xval - m_origin ) * m_inverseSpacing;
+        iplus = position >= last ? last : position > 1 ? static_cast< std::size_t >( std::ceil( position ) ) : 1;
+        while( iplus > 1 and not( x[iplus - 1] < xval ) )
+        {
+          --iplus;
+        }
+        while( iplus < last and x[iplus] < xval )
+        {
+          ++iplus;
+        }
+        break;
+      }
+      case Search::BINARY:
+      {
+        if( hint != nullptr and *hint >= 1 and *hint <= last and isInterval( x, xval, *hint ) )
+        {
+          iplus = *hint;
+        }
+        else
+        {
+          iplus = std::lower_bound( x.cbegin() + 1, x.cbegin() + last, xval ) - x.cbegin();
+        }
+        if( hint != nullptr )
+        {
+          *hint = iplus;
+        }
+        break;
+      }
+      default:
+      {
+        for( iplus = 1; iplus < last && x[iplus] < xval; ++iplus )
+        { }
+        break;
+      }
+    }
+    iminus = iplus - 1;
+  }
+
+private:
+
+  enum class Search
+  {
+    SCAN, BINARY, UNIFORM
+  };
+
+  /**
+   * @brief Checks that @p iplus is the upper bound of the interval of @p xval on an increasing axis.
+   */
+  static bool isInterval( std::vector< T > const & x,
+                          T xval,
+                          std::size_t iplus )
+  {
+    return ( iplus == 1 or x[iplus - 1] < xval ) and ( iplus == x.size() - 1 or not( x[iplus] < xval ) );
+  }
+
+  /// The search strategy.
+  Search m_search = Search::SCAN;
+  /// First value of a uniform axis.
+  T m_origin = 0;
+  /// Inverse of the spacing of a uniform axis.
+  T m_inverseSpacing = 0;
+};
+
+}
@@ -17,7 +17,9 @@
 
 #include "Assert.hpp"
 
+#include <algorithm>
 #include <array>
+#include <limits>
 #include <vector>
 #include <type_traits>
 #include <numeric>
@@ -196,6 +198,16 @@ std::vector< T > Normalize( const std::vector< T > & xin )
   return xout;
 }
 
+template< typename T >
+void NormalizeInPlace( std::vector< T > & x )
+{
+  auto sum = sum_array( x );
+  for( std::size_t n = 0; n != x.size(); ++n )
+  {
+    x[n] = x[n] / sum;
+  }
+}
+
 
 template< typename T >
 std::vector< T > Interpolation1( std::vector< T > & xin,
@@ -321,4 +333,81 @@ std::vector< T > linspace( T a,
   return v;
 }
 
+/**
+ * @brief Solves the dense linear system A X = B by Gaussian elimination with partial pivoting.
+ * @param A The n x n matrix (row major). Overwritten by the elimination.
+ * @param B The n x m right hand sides (row major). Overwritten by the solution X.
+ * @param n The size of the system.
+ * @param m The number of right hand sides.
+ * @return False if the matrix is (numerically) singular.
+ */
+template< typename T >
+bool SolveLinearSystem( std::vector< T > & A,
+                        std::vector< T > & B,
+                        std::size_t n,
+                        std::size_t m )
+{
+  ASSERT( A.size() == n * n and B.size() == n * m, "Inconsistent linear system sizes" );
+
+  for( std::size_t k = 0; k != n; ++k )
+  {
+    // Partial pivoting
+    std::size_t pivot = k;
+    for( std::size_t i = k + 1; i != n; ++i )
+    {
+      if( std::fabs( A[i * n + k] ) > std::fabs( A[pivot * n + k] ) )
+      {
+        pivot = i;
+      }
+    }
+    if( not( std::fabs( A[pivot * n + k] ) > 0 ) )
+    {
+      return false;
+    }
+    if( pivot != k )
+    {
+      std::swap_ranges( A.begin() + k * n, A.begin() + ( k + 1 ) * n, A.begin() + pivot * n );
+      std::swap_ranges( B.begin() + k * m, B.begin() + ( k + 1 ) * m, B.begin() + pivot * m );
+    }
+
+    // Elimination
+    for( std::size_t i = k + 1; i != n; ++i )
+    {
+      const T factor = A[i * n + k] / A[k * n + k];
+      if( factor == 0 )
+      {
+        continue;
+      }
+      for( std::size_t j = k; j != n; ++j )
+      {
+        A[i * n + j] -= factor * A[k * n + j];
+      }
+      for( std::size_t j = 0; j != m; ++j )
+      {
+        B[i * m + j] -= factor * B[k * m + j];
+      }
+    }
+  }
+
+  // Back substitution
+  for( std::size_t k = n; k-- != 0; )
+  {
+    for( std::size_t j = 0; j != m; ++j )
+    {
+      T value = B[k * m + j];
+      for( std::size_t i = k + 1; i != n; ++i )
+      {
+        value -= A[k * n + i] * B[i * m + j];
+      }
+      B[k * m + j] = value / A[k * n + k];
+      if( not std::isfinite( B[k * m + j] ) )
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
 }
@@ -19,8 +19,11 @@
 #include "MultiphaseSystem/TrivialMultiphaseSystem.hpp"
 #include "MultiphaseSystem/NegativeTwoPhaseMultiphaseSystem.hpp"
 #include "MultiphaseSystem/FreeWaterMultiphaseSystem.hpp"
+#include "MultiphaseSystem/TabulatedKValuesMultiphaseSystem.hpp"
+#include "MultiphaseSystem/ThreePhaseMultiphaseSystem.hpp"
 #include "MultiphaseSystem/BlackOilMultiphaseSystem.hpp"
 #include "MultiphaseSystem/DeadOilMultiphaseSystem.hpp"
+#include "MultiphaseSystem/ShadowRegionCache.hpp"
 
 #include <functional>
 #include <map>
@@ -28,6 +31,15 @@
 namespace pvt
 {
 
+void MultiphaseSystem::setSsiAccelerationType( SSI_ACCELERATION_TYPE const & )
+{ }
+
+void MultiphaseSystem::setStabilityTestEnabled( bool )
+{ }
+
+void MultiphaseSystem::setPrecisionType( PRECISION_TYPE const & )
+{ }
+
 std::unique_ptr< MultiphaseSystem > MultiphaseSystemBuilder::buildCompositional( COMPOSITIONAL_FLASH_TYPE const & flashType,
                                                                                  std::vector< PHASE_TYPE > const & phases,
                                                                                  std::vector< EOS_TYPE > const & eosTypes,
@@ -36,6 +48,29 @@ std::unique_ptr< MultiphaseSystem > MultiphaseSystemBuilder::buildCompositional(
                                                                                  std::vector< double > const & componentCriticalTemperatures,
                                                                                  std::vector< double > const & componentCriticalPressures,
                                                                                  std::vector< double > const & componentOmegas )
+{
+  return buildCompositional( flashType,
+                             phases,
+                             eosTypes,
+                             componentNames,
+                             componentMolarWeights,
+                             componentCriticalTemperatures,
+                             componentCriticalPressures,
+                             componentOmegas,
+                             {},
+                             {} );
+}
+
+std::unique_ptr< MultiphaseSystem > MultiphaseSystemBuilder::buildCompositional( COMPOSITIONAL_FLASH_TYPE const & flashType,
+                                                                                 std::vector< PHASE_TYPE > const & phases,
+                                                                                 std::vector< EOS_TYPE > const & eosTypes,
+                                                                                 std::vector< std::string > const & componentNames,
+                                                                                 std::vector< double > const & componentMolarWeights,
+                                                                                 std::vector< double > const & componentCriticalTemperatures,
+                                                                                 std::vector< double > const & componentCriticalPressures,
+                                                                                 std::vector< double > const & componentOmegas,
+                                                                                 std::vector< std::vector< double > > const & componentBinaryInteractionCoefficients,
+                                                                                 std::vector< std::vector< double > > const & componentVolumeShifts )
 {
   typedef std::function< std::unique_ptr< MultiphaseSystem >(
     const std::vector< pvt::PHASE_TYPE > &,
@@ -44,16 +79,25 @@ std::unique_ptr< MultiphaseSystem > MultiphaseSystemBuilder::buildCompositional(
     const std::vector< double > &,
     const std::vector< double > &,
     const std::vector< double > &,
-    const std::vector< double > &
+    const std::vector< double > &,
+    const std::vector< std::vector< double > > &,
+    const std::vector< std::vector< double > > &
   ) > builderType;
 
   // FIXME The registration is wrong so we have to depend on implementations
   const std::map< pvt::COMPOSITIONAL_FLASH_TYPE, builderType > m{
     { pvt::COMPOSITIONAL_FLASH_TYPE::TRIVIAL,          PVTPackage::TrivialMultiphaseSystem::build },
     { pvt::COMPOSITIONAL_FLASH_TYPE::NEGATIVE_OIL_GAS, PVTPackage::NegativeTwoPhaseMultiphaseSystem::build },
-    { pvt::COMPOSITIONAL_FLASH_TYPE::FREE_WATER,       PVTPackage::FreeWaterMultiphaseSystem::build }
+    { pvt::COMPOSITIONAL_FLASH_TYPE::FREE_WATER,       PVTPackage::FreeWaterMultiphaseSystem::build },
+    { pvt::COMPOSITIONAL_FLASH_TYPE::THREE_PHASE,      PVTPackage::ThreePhaseMultiphaseSystem::build }
   };
 
+  if( flashType == pvt::COMPOSITIONAL_FLASH_TYPE::TABULATED_KVALUES )
+  {
+    LOGERROR( "TABULATED_KVALUES systems require a K-value table and must be built by buildTabulatedKValues" );
+    return std::unique_ptr< MultiphaseSystem >();
+  }
+
   try
   {
     builderType const & builder = m.at( flashType );
@@ -63,7 +107,9 @@ std::unique_ptr< MultiphaseSystem > MultiphaseSystemBuilder::buildCompositional(
                     componentMolarWeights,
                     componentCriticalTemperatures,
                     componentCriticalPressures,
-                    componentOmegas );
+                    componentOmegas,
+                    componentBinaryInteractionCoefficients,
+                    componentVolumeShifts );
   }
   catch( const std::out_of_range & e )
   {
@@ -73,6 +119,29 @@ std::unique_ptr< MultiphaseSystem > MultiphaseSystemBuilder::buildCompositional(
   }
 }
 
+std::unique_ptr< MultiphaseSystem > MultiphaseSystemBuilder::buildTabulatedKValues( std::vector< PHASE_TYPE > const & phases,
+                                                                                    std::vector< EOS_TYPE > const & eosTypes,
+                                                                                    std::vector< std::string > const & componentNames,
+                                                                                    std::vector< double > const & componentMolarWeights,
+                                                                                    std::vector< double > const & componentCriticalTemperatures,
+                                                                                    std::vector< double > const & componentCriticalPressures,
+                                                                                    std::vector< double > const & componentOmegas,
+                                                                                    std::vector< std::vector< double > > const & componentBinaryInteractionCoefficients,
+                                                                                    std::vector< std::vector< double > > const & componentVolumeShifts,
+                                                                                    KValueTable const & kValueTable )
+{
+  return PVTPackage::TabulatedKValuesMultiphaseSystem::build( phases,
+                                                              eosTypes,
+                                                              componentNames,
+                                                              componentMolarWeights,
+                                                              componentCriticalTemperatures,
+                                                              componentCriticalPressures,
+                                                              componentOmegas,
+                                                              componentBinaryInteractionCoefficients,
+                                                              componentVolumeShifts,
+                                                              kValueTable );
+}
+
 std::unique_ptr< MultiphaseSystem > MultiphaseSystemBuilder::buildLiveOil( const std::vector< pvt::PHASE_TYPE > & phases,
                                                                            const std::vector< std::string > & tableFileNames,
                                                                            const std::vector< double > & surfaceMassDensities,
@@ -89,4 +158,10 @@ std::unique_ptr< MultiphaseSystem > MultiphaseSystemBuilder::buildDeadOil( const
   return PVTPackage::DeadOilMultiphaseSystem::build( phases, tableFileNames, surfaceMassDensities, molarWeights );
 }
 
+std::unique_ptr< ShadowRegionCache > MultiphaseSystemBuilder::buildShadowRegionCache( std::size_t nCells,
+                                                                                      std::size_t nComponents )
+{
+  return std::unique_ptr< ShadowRegionCache >( new PVTPackage::ShadowRegionCache( nCells, nComponents ) );
+}
+
 }
\ No newline at end of file
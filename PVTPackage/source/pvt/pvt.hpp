@@ -16,6 +16,8 @@
 #ifndef PVTPACKAGE_PVT_HPP
 #define PVTPACKAGE_PVT_HPP
 
+#include <cstddef>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <vector>
@@ -84,6 +86,180 @@ struct VectorPropertyAndDerivatives
   std::vector< std::vector< T > > dz;
 };
 
+/**
+ * @brief Read-only view of @p size values, laid out every @p stride entries of a buffer it does not own.
+ * @tparam T Scalar type (double, float)
+ */
+template< typename T >
+class ArrayView
+{
+public:
+
+  /**
+   * @brief Random access iterator over the values of the view.
+   */
+  class const_iterator
+  {
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T const *;
+    using reference = T const &;
+
+    const_iterator( T const * data,
+                    std::size_t stride )
+      : m_data( data ),
+        m_stride( stride )
+    { }
+
+    reference operator*() const { return *m_data; }
+    reference operator[]( difference_type n ) const { return m_data[n * static_cast< difference_type >( m_stride )]; }
+    const_iterator & operator++() { m_data += m_stride; return *this; }
+    const_iterator operator++( int ) { const_iterator result( *this ); ++*this; return result; }
+    const_iterator & operator--() { m_data -= m_stride; return *this; }
+    const_iterator operator--( int ) { const_iterator result( *this ); --*this; return result; }
+    const_iterator & operator+=( difference_type n ) { m_data += n * static_cast< difference_type >( m_stride ); return *this; }
+    const_iterator & operator-=( difference_type n ) { return *this += -n; }
+    const_iterator operator+( difference_type n ) const { const_iterator result( *this ); return result += n; }
+    const_iterator operator-( difference_type n ) const { const_iterator result( *this ); return result -= n; }
+    difference_type operator-( const_iterator const & other ) const { return ( m_data - other.m_data ) / static_cast< difference_type >( m_stride ); }
+    bool operator==( const_iterator const & other ) const { return m_data == other.m_data; }
+    bool operator!=( const_iterator const & other ) const { return m_data != other.m_data; }
+    bool operator<( const_iterator const & other ) const { return m_data < other.m_data; }
+    bool operator>( const_iterator const & other ) const { return m_data > other.m_data; }
+    bool operator<=( const_iterator const & other ) const { return m_data <= other.m_data; }
+    bool operator>=( const_iterator const & other ) const { return m_data >= other.m_data; }
+
+private:
+    T const * m_data;
+    std::size_t m_stride;
+  };
+
+  /**
+   * @brief Builds the view.
+   * @param data The first value.
+   * @param size Number of values.
+   * @param stride Distance between two consecutive values in the buffer.
+   */
+  ArrayView( T const * data,
+             std::size_t size,
+             std::size_t stride = 1 )
+    : m_data( data ),
+      m_size( size ),
+      m_stride( stride )
+  { }
+
+  T const & operator[]( std::size_t i ) const { return m_data[i * m_stride]; }
+
+  std::size_t size() const { return m_size; }
+
+  const_iterator begin() const { return const_iterator( m_data, m_stride ); }
+
+  const_iterator end() const { return const_iterator( m_data + m_size * m_stride, m_stride ); }
+
+  const_iterator cbegin() const { return begin(); }
+
+  const_iterator cend() const { return end(); }
+
+private:
+  T const * m_data;
+  std::size_t m_size;
+  std::size_t m_stride;
+};
+
+/**
+ * @brief Read-only view of a scalar data and its derivatives w.r.t pressure, temperature and feed.
+ * @tparam T Scalar type (double, float)
+ *
+ * The view refers to a record of 3 + nComponents values: the value, its pressure and temperature derivatives,
+ * then its derivatives w.r.t. feed. It does not own the record, and reflects its changes.
+ */
+template< typename T >
+struct ScalarPropertyAndDerivativesView
+{
+  /**
+   * @brief Builds the view of a record.
+   * @param record The first entry of the record.
+   * @param nComponents Number of fluid components.
+   */
+  ScalarPropertyAndDerivativesView( T const * record,
+                                    std::size_t nComponents )
+    : value( record[0] ),
+      dP( record[1] ),
+      dT( record[2] ),
+      dz( record + 3, nComponents )
+  { }
+
+  /// The value of the data itself.
+  T const & value;
+  /// The derivatives w.r.t pressure.
+  T const & dP;
+  /// The derivatives w.r.t temperature.
+  T const & dT;
+  /// The derivatives w.r.t feed.
+  ArrayView< T > dz;
+};
+
+/**
+ * @brief Read-only view of a vector data and its derivatives w.r.t pressure, temperature and feed.
+ * @tparam T Scalar type (double, float)
+ *
+ * The view refers to @p dim consecutive records, one per dimension of the data, laid out as the record of a scalar data
+ * (see ScalarPropertyAndDerivativesView). It does not own the records, and reflects their changes.
+ */
+template< typename T >
+struct VectorPropertyAndDerivativesView
+{
+  /**
+   * @brief Read-only view of the derivatives w.r.t. feed, indexed as [dimension][component].
+   */
+  class FeedDerivatives
+  {
+public:
+    FeedDerivatives( T const * records,
+                     std::size_t dim,
+                     std::size_t nComponents )
+      : m_records( records ),
+        m_dim( dim ),
+        m_nComponents( nComponents )
+    { }
+
+    ArrayView< T > operator[]( std::size_t i ) const { return ArrayView< T >( m_records + i * ( 3 + m_nComponents ) + 3, m_nComponents ); }
+
+    std::size_t size() const { return m_dim; }
+
+private:
+    T const * m_records;
+    std::size_t m_dim;
+    std::size_t m_nComponents;
+  };
+
+  /**
+   * @brief Builds the view of consecutive records.
+   * @param records The first entry of the first record.
+   * @param dim Number of dimensions of the vector data.
+   * @param nComponents Number of fluid components.
+   */
+  VectorPropertyAndDerivativesView( T const * records,
+                                    std::size_t dim,
+                                    std::size_t nComponents )
+    : value( records, dim, 3 + nComponents ),
+      dP( records + 1, dim, 3 + nComponents ),
+      dT( records + 2, dim, 3 + nComponents ),
+      dz( records, dim, nComponents )
+  { }
+
+  /// The value of the data itself.
+  ArrayView< T > value;
+  /// The derivatives w.r.t pressure.
+  ArrayView< T > dP;
+  /// The derivatives w.r.t temperature.
+  ArrayView< T > dT;
+  /// The derivatives w.r.t feed.
+  FeedDerivatives dz;
+};
+
 enum class PHASE_TYPE : int
 {
   LIQUID_WATER_RICH = 2, OIL = 1, GAS = 0, UNKNOWN = -1
@@ -99,6 +275,50 @@ enum class COMPOSITIONAL_FLASH_TYPE : int
   TRIVIAL = 0, NEGATIVE_OIL_GAS = 1, TABULATED_KVALUES = 2, FREE_WATER = 3, THREE_PHASE = 4, UNKNOWN = -1
 };
 
+enum class DERIVATIVES_TYPE : int
+{
+  FINITE_DIFFERENCES = 0, ANALYTICAL = 1
+};
+
+enum class SSI_ACCELERATION_TYPE : int
+{
+  NONE = 0, GDEM = 1, NEWTON = 2
+};
+
+enum class PRECISION_TYPE : int
+{
+  DOUBLE = 0, MIXED = 1
+};
+
+/**
+ * @brief Iteration counters and timings of the compositional flashes.
+ *
+ * Only the flash computations of the updates are counted, not the ones performed to compute finite differences derivatives.
+ */
+struct FlashStatistics
+{
+  /// Number of flash computations.
+  std::size_t nFlashes = 0;
+  /// Total number of successive substitution iterations (one iteration being one equation of state evaluation per phase).
+  std::size_t nIterations = 0;
+  /// Largest number of iterations of a single flash computation.
+  std::size_t maxIterations = 0;
+  /// Number of flash computations which reached the maximum number of iterations.
+  std::size_t nNotConverged = 0;
+  /// Number of stability tests run before the flash computations.
+  std::size_t nStabilityTests = 0;
+  /// Number of flash computations skipped because the feed is stable, as proven by the stability test or the shadow region cache.
+  std::size_t nSkippedFlashes = 0;
+  /// Number of flash computations which skipped the stability test because the feed was in its shadow region (see ShadowRegionCache).
+  std::size_t nShadowRegionHits = 0;
+  /// Total number of successive substitution iterations of the stability tests.
+  std::size_t nStabilityIterations = 0;
+  /// Wall clock time spent in the stability tests, in seconds.
+  double stabilityTestTime = 0.;
+  /// Wall clock time spent in the flash computations, stability tests included, in seconds.
+  double flashTime = 0.;
+};
+
 /**
  * @brief Data combination for any PVT system solved.
  */
@@ -110,50 +330,146 @@ public:
   /**
    * @brief Mass density data (and derivatives) for given @p phase.
    * @param phase The required phase (oil, gas, water).
-   * @return The data as a ref to const.
+   * @return A view of the data, valid as long as these properties.
    * @throw std::out_of_range if @p phase does not exist.
    */
-  virtual const ScalarPropertyAndDerivatives< double > & getMassDensity( PHASE_TYPE const & phase ) const = 0;
+  virtual ScalarPropertyAndDerivativesView< double > getMassDensity( PHASE_TYPE const & phase ) const = 0;
 
   /**
    * @brief Mole composition data (and derivatives) for given @p phase.
    * @param phase The required phase (oil, gas, water).
-   * @return The data as a ref to const.
+   * @return A view of the data, valid as long as these properties.
    * @throw std::out_of_range if @p phase does not exist.
    */
-  virtual const VectorPropertyAndDerivatives< double > & getMoleComposition( PHASE_TYPE const & phase ) const = 0;
+  virtual VectorPropertyAndDerivativesView< double > getMoleComposition( PHASE_TYPE const & phase ) const = 0;
 
   /**
    * @brief Mole density data (and derivatives) for given @p phase.
    * @param phase The required phase (oil, gas, water).
-   * @return The data as a ref to const.
+   * @return A view of the data, valid as long as these properties.
    * @throw std::out_of_range if @p phase does not exist.
    */
-  virtual const ScalarPropertyAndDerivatives< double > & getMoleDensity( PHASE_TYPE const & phase ) const = 0;
+  virtual ScalarPropertyAndDerivativesView< double > getMoleDensity( PHASE_TYPE const & phase ) const = 0;
 
   /**
    * @brief Viscosity data (and derivatives) for given @p phase.
    * @param phase The required phase (oil, gas, water).
-   * @return The data as a ref to const.
+   * @return A view of the data, valid as long as these properties.
    * @throw std::out_of_range if @p phase does not exist.
    */
-  virtual const ScalarPropertyAndDerivatives< double > & getViscosity( PHASE_TYPE const & phase ) const = 0;
+  virtual ScalarPropertyAndDerivativesView< double > getViscosity( PHASE_TYPE const & phase ) const = 0;
 
   /**
    * @brief Molecular weight data (and derivatives) for given @p phase.
    * @param phase The required phase (oil, gas, water).
-   * @return The data as a ref to const.
+   * @return A view of the data, valid as long as these properties.
    * @throw std::out_of_range if @p phase does not exist.
    */
-  virtual const ScalarPropertyAndDerivatives< double > & getMolecularWeight( PHASE_TYPE const & phase ) const = 0;
+  virtual ScalarPropertyAndDerivativesView< double > getMolecularWeight( PHASE_TYPE const & phase ) const = 0;
 
   /**
    * @brief Phase mole fraction data (and derivatives) for given @p phase.
    * @param phase The required phase (oil, gas, water).
-   * @return The data as a ref to const.
+   * @return A view of the data, valid as long as these properties.
    * @throw std::out_of_range if @p phase does not exist.
    */
-  virtual const ScalarPropertyAndDerivatives< double > & getPhaseMoleFraction( PHASE_TYPE const & phase ) const = 0;
+  virtual ScalarPropertyAndDerivativesView< double > getPhaseMoleFraction( PHASE_TYPE const & phase ) const = 0;
+};
+
+/**
+ * @brief Caller-owned buffers receiving the results of MultiphaseSystem::BatchUpdate.
+ *
+ * Each scalar property of one phase in one cell is stored as a record of @p 3 + nComponents doubles:
+ * the value, its pressure and temperature derivatives, then its derivatives w.r.t. feed.
+ * Scalar buffers are laid out as [cell][phase][record], mole composition buffers as [cell][phase][component][record].
+ * Phases are stored in the order of #phases. Buffers left to @p nullptr are not filled.
+ */
+struct MultiphaseSystemBatchProperties
+{
+  /**
+   * @brief Size of one record (value and derivatives) for a system of @p nComponents components.
+   * @param nComponents Number of fluid components.
+   * @return The number of doubles per record.
+   */
+  static std::size_t recordSize( std::size_t nComponents )
+  {
+    return 3 + nComponents;
+  }
+
+  /// The phases to extract, in the order they are stored in the buffers.
+  std::vector< PHASE_TYPE > phases;
+  /// Mass density buffer, size nCells * phases.size() * recordSize.
+  double * massDensity = nullptr;
+  /// Mole composition buffer, size nCells * phases.size() * nComponents * recordSize.
+  double * moleComposition = nullptr;
+  /// Mole density buffer, size nCells * phases.size() * recordSize.
+  double * moleDensity = nullptr;
+  /// Viscosity buffer, size nCells * phases.size() * recordSize.
+  double * viscosity = nullptr;
+  /// Molecular weight buffer, size nCells * phases.size() * recordSize.
+  double * molecularWeight = nullptr;
+  /// Phase mole fraction buffer, size nCells * phases.size() * recordSize.
+  double * phaseMoleFraction = nullptr;
+  /// Per cell success indicator, size nCells.
+  bool * succeeded = nullptr;
+  /**
+   * Per cell K-values, laid out as [cell][component], size nCells * nComponents.
+   * On input, the K-values each cell starts from (e.g. the ones of the previous time step), a first entry
+   * not strictly positive meaning the default initialization. On output, the K-values of each cell.
+   * Systems without K-values leave the buffer untouched.
+   */
+  double * kValues = nullptr;
+};
+
+/**
+ * @brief Gas/oil K-values of all the components, tabulated on a uniform pressure x temperature grid.
+ *
+ * K-values are laid out as [pressure][temperature][component], the K-values of one grid node being contiguous.
+ * They are interpolated bilinearly in ln K; outside of the grid, the closest edge is used.
+ * An axis with a single value makes the K-values independent of that variable.
+ */
+struct KValueTable
+{
+  /// First pressure of the grid.
+  double minPressure = 0.;
+  /// Spacing of the pressures, must be positive if there are several pressures.
+  double pressureStep = 0.;
+  /// Number of pressures.
+  std::size_t nPressures = 0;
+  /// First temperature of the grid.
+  double minTemperature = 0.;
+  /// Spacing of the temperatures, must be positive if there are several temperatures.
+  double temperatureStep = 0.;
+  /// Number of temperatures.
+  std::size_t nTemperatures = 0;
+  /// The nPressures x nTemperatures x nComponents positive K-values.
+  std::vector< double > kValues;
+};
+
+/**
+ * @brief Per cell memory of the last stability test of the cells of a domain, known as shadow region cache.
+ *
+ * For each cell, the cache keeps the conditions and the outcome of the last stability test, with its distance to the phase boundary.
+ * As long as the pressure, temperature and feed of the cell remain in a trust region around these conditions,
+ * which size is proportional to this distance, the stability test is skipped: stable cells get their single phase
+ * without any flash iteration, unstable cells go straight to the flash.
+ *
+ * The cache is allocated once for all the cells and can be shared by systems owned by different threads:
+ * distinct cells may be updated concurrently, but a given cell must not be updated by two threads at once.
+ */
+class ShadowRegionCache
+{
+public:
+  virtual ~ShadowRegionCache() = default;
+  /**
+   * @brief Number of cells of the cache.
+   * @return The number of cells.
+   */
+  virtual std::size_t size() const = 0;
+  /**
+   * @brief Forgets the state of all the cells.
+   */
+  virtual void clear() = 0;
 };
 
 class MultiphaseSystem
@@ -169,6 +485,34 @@ public:
    * @param feed
    */
   virtual void Update( double pressure, double temperature, std::vector< double > feed ) = 0;
+  /**
+   * @brief Same as #Update for the cell @p cellIndex of a domain, using and updating its state in the shadow region cache.
+   * @param cellIndex The index of the cell in the cache.
+   * @param pressure
+   * @param temperature
+   * @param feed
+   *
+   * Without cache (see #setShadowRegionCache), this is #Update.
+   */
+  virtual void UpdateCell( std::size_t cellIndex, double pressure, double temperature, std::vector< double > feed ) = 0;
+  /**
+   * @brief Solves the system for @p nCells cells at once and writes the results in @p outputs.
+   * @param nCells Number of cells.
+   * @param pressures Contiguous pressures, size @p nCells.
+   * @param temperatures Contiguous temperatures, size @p nCells.
+   * @param feeds Contiguous feeds laid out as [cell][component], size @p nCells * nComponents.
+   * @param outputs The caller-owned buffers to fill.
+   * @return True if the computation went OK for all the cells.
+   * @throw std::out_of_range if one of the requested phases does not exist.
+   *
+   * After the call, #getMultiphaseSystemProperties holds the data of the last cell
+   * and #hasSucceeded tells if all the cells succeeded.
+   */
+  virtual bool BatchUpdate( std::size_t nCells,
+                            double const * pressures,
+                            double const * temperatures,
+                            double const * feeds,
+                            MultiphaseSystemBatchProperties const & outputs ) = 0;
   /**
    * @brief Access the data of the system.
    * @return Reference to const datw.
@@ -179,6 +523,76 @@ public:
    * @return A boolean.
    */
   virtual bool hasSucceeded() const = 0 ;
+  /**
+   * @brief Selects how the derivatives are computed. Finite differences are used by default.
+   * @param derivativesType The derivatives computation type.
+   *
+   * Systems that do not provide analytical derivatives, or cases they do not cover, fall back to finite differences.
+   */
+  virtual void setDerivativesType( DERIVATIVES_TYPE const & derivativesType ) = 0;
+  /**
+   * @brief Selects the acceleration of the successive substitution iterations on the K-values. No acceleration by default.
+   * @param accelerationType The acceleration type.
+   *
+   * GDEM (General Dominant Eigenvalue Method) extrapolates the ln K-values along the dominant eigenvector of the iterations
+   * every few iterations. NEWTON switches to Newton iterations on ln K once the fugacity residual is small enough.
+   * The negative two-phase flashes started from #setInitialKValues switch to them whatever the selection.
+   * The default implementation, kept by the systems without successive substitution iterations, does nothing.
+   */
+  virtual void setSsiAccelerationType( SSI_ACCELERATION_TYPE const & accelerationType );
+  /**
+   * @brief Enables a stability test of the feed before each flash. Disabled by default.
+   * @param enabled True to enable the test.
+   *
+   * Feeds proven stable by the Michelsen tangent plane distance test skip the flash iterations
+   * and get a single phase with the feed composition. See FlashStatistics for the share of skipped flashes.
+   * Only the negative two-phase flash runs the test, the default implementation does nothing.
+   */
+  virtual void setStabilityTestEnabled( bool enabled );
+  /**
+   * @brief Selects the floating point precision of the equation of state evaluations. Double precision is used by default.
+   * @param precisionType The precision type.
+   *
+   * MIXED computes the n x n interaction terms of the mixing rule in single precision, which doubles their SIMD width.
+   * Their sums, the cubic equation and its root selection, as well as the flash iterations, remain in double precision.
+   * The properties then deviate from the double precision ones by about the single precision round-off.
+   * All the compositional systems use it. The black-oil and dead-oil systems, which have no equation of state,
+   * ignore it (the default implementation does nothing).
+   */
+  virtual void setPrecisionType( PRECISION_TYPE const & precisionType );
+  /**
+   * @brief Attaches the shadow region cache used by #UpdateCell.
+   * @param cache A cache built by MultiphaseSystemBuilder::buildShadowRegionCache for the components of this system.
+   * It is not owned by the system, and nullptr detaches it.
+   *
+   * The cache is only filled by the stability tests, which must be enabled (see #setStabilityTestEnabled).
+   * Systems without stability test ignore it.
+   */
+  virtual void setShadowRegionCache( ShadowRegionCache * cache ) = 0;
+  /**
+   * @brief Access the iteration counters accumulated since the creation of the system or the last #resetFlashStatistics.
+   * @return Reference to const counters. Systems without iterative flash keep them to zero.
+   */
+  virtual FlashStatistics const & getFlashStatistics() const = 0;
+  /**
+   * @brief Sets the iteration counters back to zero.
+   */
+  virtual void resetFlashStatistics() = 0;
+  /**
+   * @brief Sets the K-values (y_i / x_i) the next flash starts from, instead of the Wilson correlation.
+   * @param kValues One K-value per component, typically the ones of the same cell at the previous time step
+   * (see #getKValues). An empty vector keeps the default initialization.
+   *
+   * The setting only applies to the next #Update. A warm-started flash converges more tightly than a cold-started one,
+   * and its finite differences flashes start from its solution, so that the derivatives remain accurate
+   * even when the K-values were already converged at the same conditions. Systems without K-values ignore it.
+   */
+  virtual void setInitialKValues( std::vector< double > const & kValues ) = 0;
+  /**
+   * @brief Access the K-values computed by the last flash, before the phases get clamped to their physical bounds.
+   * @return One K-value per component, empty for systems without K-values.
+   */
+  virtual std::vector< double > const & getKValues() const = 0;
 };
 
 class MultiphaseSystemBuilder
@@ -187,7 +601,8 @@ public:
 
   /**
    * @brief Builds a compositional instance of a multiphase system.
-   * @param flashType The type of compositional system we want (for the moment, trivial, negative two phase and free water).
+   * @param flashType The type of compositional system we want (for the moment, trivial, negative two phase, free water and three phase).
+   * TABULATED_KVALUES systems are built by #buildTabulatedKValues.
    * @param phases The considered phases in the system.
    * @param eosTypes The considered equations states.
    * @param componentNames The component names
@@ -209,6 +624,47 @@ public:
                                                                  std::vector< double > const & componentCriticalPressures,
                                                                  std::vector< double > const & componentOmegas );
 
+  /**
+   * @brief Builds a compositional instance of a multiphase system, with binary interaction coefficients and volume shifts.
+   * @param componentBinaryInteractionCoefficients The nComponents x nComponents binary interaction coefficients k_ij.
+   * The matrix must be symmetric: asymmetric coefficients are rejected.
+   * @param componentVolumeShifts The nComponents x 2 volume shifts (m3/mol), added to the equation of state molar volume.
+   * The shift of component i at temperature T is componentVolumeShifts[i][0] + componentVolumeShifts[i][1] * T.
+   * @return A std::unique_ptr holding the system. The smart ptr may hold nullptr if something went wrong.
+   *
+   * Other parameters are the same as above. An empty matrix is equivalent to a matrix of zeros.
+   */
+  static std::unique_ptr< MultiphaseSystem > buildCompositional( COMPOSITIONAL_FLASH_TYPE const & flashType,
+                                                                 std::vector< PHASE_TYPE > const & phases,
+                                                                 std::vector< EOS_TYPE > const & eosTypes,
+                                                                 std::vector< std::string > const & componentNames,
+                                                                 std::vector< double > const & componentMolarWeights,
+                                                                 std::vector< double > const & componentCriticalTemperatures,
+                                                                 std::vector< double > const & componentCriticalPressures,
+                                                                 std::vector< double > const & componentOmegas,
+                                                                 std::vector< std::vector< double > > const & componentBinaryInteractionCoefficients,
+                                                                 std::vector< std::vector< double > > const & componentVolumeShifts );
+
+  /**
+   * @brief Builds a TABULATED_KVALUES compositional instance of a multiphase system.
+   * @param kValueTable The gas/oil K-values of the components.
+   * @return A std::unique_ptr holding the system. The smart ptr may hold nullptr if something went wrong.
+   *
+   * The flash interpolates the K-values instead of iterating on the equality of fugacities:
+   * it solves the Rachford-Rice equation once, then evaluates the equation of state once per phase.
+   * Other parameters are the same as above.
+   */
+  static std::unique_ptr< MultiphaseSystem > buildTabulatedKValues( std::vector< PHASE_TYPE > const & phases,
+                                                                    std::vector< EOS_TYPE > const & eosTypes,
+                                                                    std::vector< std::string > const & componentNames,
+                                                                    std::vector< double > const & componentMolarWeights,
+                                                                    std::vector< double > const & componentCriticalTemperatures,
+                                                                    std::vector< double > const & componentCriticalPressures,
+                                                                    std::vector< double > const & componentOmegas,
+                                                                    std::vector< std::vector< double > > const & componentBinaryInteractionCoefficients,
+                                                                    std::vector< std::vector< double > > const & componentVolumeShifts,
+                                                                    KValueTable const & kValueTable );
+
   /**
    * @brief Builds a live oil instance of a multiphase system.
    * @param phases The considered phases in the system.
@@ -234,6 +690,15 @@ public:
                                                            const std::vector< std::string > & tableFileNames,
                                                            const std::vector< double > & surfaceMassDensities,
                                                            const std::vector< double > & molarWeights );
+
+  /**
+   * @brief Builds a shadow region cache for a domain.
+   * @param nCells The number of cells of the domain.
+   * @param nComponents The number of components of the systems using the cache.
+   * @return A std::unique_ptr holding the cache, all the cells being in an unknown state.
+   */
+  static std::unique_ptr< ShadowRegionCache > buildShadowRegionCache( std::size_t nCells,
+                                                                      std::size_t nComponents );
 };
 
 }
@@ -0,0 +1,112 @@
+/*	
+ * ------------------------------------------------------------------------------------------------------------	
+ * SPDX-License-Identifier: LGPL-2.1-only	
+ *	
+ * Copyright (c) 2018-2024 Lawrence Livermore National Security LLC	
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University	
+ * Copyright (c) 2018-2024 TotalEnergies	
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors	
+ * All right reserved	
+ *	
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.	
+ * ------------------------------------------------------------------------------------------------------------	
+ */
+
+#include "./AllocationCounter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+std::size_t allocationCount = 0;
+
+void * countedAllocation( std::size_t size ) noexcept
+{
+  ++allocationCount;
+  return std::malloc( size == 0 ? 1 : size );
+}
+
+}
+
+namespace PVTPackage
+{
+namespace tests
+{
+
+std::size_t getAllocationCount()
+{
+  return allocationCount;
+}
+
+}
+}
+
+// The whole set of the global allocation and deallocation functions is replaced, so that every new has its matching delete.
+// The over-aligned variants are left to the standard library, nothing in PVTPackage being over-aligned.
+void * operator new( std::size_t size )
+{
+  if( void * p = countedAllocation( size ) )
+  {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void * operator new[]( std::size_t size )
+{
+  if( void * p = countedAllocation( size ) )
+  {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void * operator new( std::size_t size,
+                     std::nothrow_t const & ) noexcept
+{
+  return countedAllocation( size );
+}
+
+void * operator new[]( std::size_t size,
+                       std::nothrow_t const & ) noexcept
+{
+  return countedAllocation( size );
+}
+
+void operator delete( void * p ) noexcept
+{
+  std::free( p );
+}
+
+void operator delete[]( void * p ) noexcept
+{
+  std::free( p );
+}
+
+void operator delete( void * p,
+                      std::nothrow_t const & ) noexcept
+{
+  std::free( p );
+}
+
+void operator delete[]( void * p,
+                        std::nothrow_t const & ) noexcept
+{
+  std::free( p );
+}
+
+#if defined( __cpp_sized_deallocation )
+void operator delete( void * p,
+                      std::size_t ) noexcept
+{
+  std::free( p );
+}
+
+void operator delete[]( void * p,
+                        std::size_t ) noexcept
+{
+  std::free( p );
+}
+#endif
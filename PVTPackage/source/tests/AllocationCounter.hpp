@@ -0,0 +1,38 @@
+/*	
+ * ------------------------------------------------------------------------------------------------------------	
+ * SPDX-License-Identifier: LGPL-2.1-only	
+ *	
+ * Copyright (c) 2018-2024 Lawrence Livermore National Security LLC	
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University	
+ * Copyright (c) 2018-2024 TotalEnergies	
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors	
+ * All right reserved	
+ *	
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.	
+ * ------------------------------------------------------------------------------------------------------------	
+ */
+
+#ifndef PVTPACKAGE_ALLOCATIONCOUNTER_HPP
+#define PVTPACKAGE_ALLOCATIONCOUNTER_HPP
+
+#include <cstddef>
+
+namespace PVTPackage
+{
+namespace tests
+{
+
+/**
+ * @brief Counts the allocations of the program.
+ * @return The number of calls to the global allocation functions since the start of the program.
+ *
+ * @note AllocationCounter.cpp replaces the global allocation functions of the program it is linked into.
+ * It is kept in a translation unit of its own, so that the compiler does not inline the replacement functions
+ * and mistake their malloc and free for mismatched allocation functions.
+ */
+std::size_t getAllocationCount();
+
+}
+}
+
+#endif //PVTPACKAGE_ALLOCATIONCOUNTER_HPP
@@ -44,7 +44,7 @@ std::vector< pvt::PHASE_TYPE > convert( const std::vector< pds::PHASE_TYPE > & i
 std::vector< pvt::EOS_TYPE > convert( const std::vector< pds::EOS_TYPE > & input );
 
 template< typename T >
-void compare( const pvt::ScalarPropertyAndDerivatives< T > & actual,
+void compare( const pvt::ScalarPropertyAndDerivativesView< T > & actual,
               const pds::ScalarPropertyAndDerivatives< T > & expected,
               double eps )
 {
@@ -64,7 +64,7 @@ void compare( const pvt::ScalarPropertyAndDerivatives< T > & actual,
 }
 
 template< typename T >
-void compare( const pvt::VectorPropertyAndDerivatives< T > & actual,
+void compare( const pvt::VectorPropertyAndDerivativesView< T > & actual,
               const pds::VectorPropertyAndDerivatives< T > & expected,
               double eps )
 {
@@ -97,7 +97,8 @@ void compare( const pvt::VectorPropertyAndDerivatives< T > & actual,
     const std::size_t n = actual.dz.size();
     for( std::size_t i = 0; i < n; ++i )
     {
-      const std::vector< double > & ai = actual.dz[i], & ei = expected.dz[i];
+      const pvt::ArrayView< double > ai = actual.dz[i];
+      const std::vector< double > & ei = expected.dz[i];
       ASSERT_EQ( ai.size(), ei.size() );
       const bool test = std::equal( ai.cbegin(), ai.cend(),
                                     ei.cbegin(), ei.cend(), f );
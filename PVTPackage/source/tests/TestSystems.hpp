@@ -0,0 +1,105 @@
+/*	
+ * ------------------------------------------------------------------------------------------------------------	
+ * SPDX-License-Identifier: LGPL-2.1-only	
+ *	
+ * Copyright (c) 2018-2024 Lawrence Livermore National Security LLC	
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University	
+ * Copyright (c) 2018-2024 TotalEnergies	
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors	
+ * All right reserved	
+ *	
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.	
+ * ------------------------------------------------------------------------------------------------------------	
+ */
+
+#ifndef PVTPACKAGE_TESTSYSTEMS_HPP
+#define PVTPACKAGE_TESTSYSTEMS_HPP
+
+#include "./passiveDataStructures/MultiphaseSystemProperties.hpp"
+#include "./passiveDataStructures/PVTEnums.hpp"
+
+#include "pvt/pvt.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace PVTPackage
+{
+namespace tests
+{
+
+/**
+ * @brief Builds the multiphase system of a data line, or returns the one already built for the same inputs.
+ * @param j The json of the data line.
+ * @return The system, owned by the tests. nullptr for unknown flash types.
+ */
+pvt::MultiphaseSystem * getMultiphaseSystem( const nlohmann::json & j );
+
+/**
+ * @brief The parsed content of a data line, with its (shared) multiphase system.
+ */
+struct DataLine
+{
+  /// The json of the line.
+  nlohmann::json j;
+  pds::FLASH_TYPE flashType;
+  double pressure;
+  double temperature;
+  std::vector< double > feed;
+  /// The reference output.
+  pds::PDSMSP refMsp;
+  /// The phases of the reference output.
+  std::set< pds::PHASE_TYPE > refPhases;
+  /// The same phases, converted to the public API ones.
+  std::vector< pvt::PHASE_TYPE > phases;
+  /// The system of the line, see getMultiphaseSystem.
+  pvt::MultiphaseSystem * multiphaseSystem;
+};
+
+/**
+ * @brief Parses a data line and gets its multiphase system.
+ * @param json_string The json string of the line.
+ * @return The content of the line.
+ */
+DataLine readDataLine( const std::string & json_string );
+
+/**
+ * @brief Sets the derivatives type of a (shared) system for the lifetime of the instance,
+ * then sets the default finite differences back, even when a failed assertion returns early.
+ */
+class ScopedDerivativesType
+{
+public:
+  /**
+   * @param system The system.
+   * @param derivativesType The derivatives type to use meanwhile.
+   */
+  ScopedDerivativesType( pvt::MultiphaseSystem & system,
+                         pvt::DERIVATIVES_TYPE const & derivativesType );
+
+  ~ScopedDerivativesType();
+
+  ScopedDerivativesType( ScopedDerivativesType const & ) = delete;
+
+  ScopedDerivativesType & operator=( ScopedDerivativesType const & ) = delete;
+
+private:
+  pvt::MultiphaseSystem & m_system;
+};
+
+/**
+ * @brief Calls @p validate on each line of the data file, skipping the empty and the comment (starting with #) lines.
+ * @param validate The validation to run on the json string of the line.
+ * @param fileName The path of the data file.
+ */
+void forEachDataLine( std::function< void( const std::string & ) > const & validate,
+                      const std::string & fileName = "data/pvt_data.txt" );
+
+}
+}
+
+#endif //PVTPACKAGE_TESTSYSTEMS_HPP
@@ -0,0 +1,352 @@
+/*	
+ * ------------------------------------------------------------------------------------------------------------	
+ * SPDX-License-Identifier: LGPL-2.1-only	
+ *	
+ * Copyright (c) 2018-2024 Lawrence Livermore National Security LLC	
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University	
+ * Copyright (c) 2018-2024 TotalEnergies	
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors	
+ * All right reserved	
+ *	
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.	
+ * ------------------------------------------------------------------------------------------------------------	
+ */
+
+#include "./deserializers/PVTEnums.hpp"
+#include "./deserializers/CompositionalApiInputs.hpp"
+
+#include "./JsonKeys.hpp"
+
+#include "./TestFactor.hpp"
+#include "./TestSystems.hpp"
+
+#include "pvt/pvt.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// Timings of the updates, run by hand: they depend on the machine and its load, so they are not part of the tests.
+
+namespace PVTPackage
+{
+namespace tests
+{
+
+/**
+ * @brief Per update costs of the black-oil systems, for saturated and undersaturated oil.
+ */
+struct OilLookupBenchmark
+{
+  std::size_t nUpdates = 0;
+  double saturatedTime = 0.;
+  double undersaturatedTime = 0.;
+};
+
+void benchmarkUndersaturatedOil( const std::string & json_string,
+                                 OilLookupBenchmark & benchmark )
+{
+  const DataLine line = readDataLine( json_string );
+
+  if( line.flashType != pds::FLASH_TYPE::BLACK_OIL )
+  {
+    return;
+  }
+
+  pvt::MultiphaseSystemProperties const & msp = line.multiphaseSystem->getMultiphaseSystemProperties();
+
+  // Same water, almost no gas dissolved in the oil: the oil is undersaturated (unless the line is at a very low pressure).
+  const double hydrocarbons = line.feed[0] + line.feed[1];
+  const std::vector< double > undersaturatedFeed{ 0.999 * hydrocarbons, 0.001 * hydrocarbons, line.feed[2] };
+  line.multiphaseSystem->Update( line.pressure, line.temperature, line.feed );
+  const bool isSaturated = msp.getPhaseMoleFraction( pvt::PHASE_TYPE::GAS ).value > 0.;
+  line.multiphaseSystem->Update( line.pressure, line.temperature, undersaturatedFeed );
+  const bool isUndersaturated = msp.getPhaseMoleFraction( pvt::PHASE_TYPE::GAS ).value == 0.;
+  if( not isSaturated or not isUndersaturated )
+  {
+    return;
+  }
+
+  const std::size_t nUpdates = 200;
+  auto run = [&]( std::vector< double > const & z )
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for( std::size_t i = 0; i < nUpdates; ++i )
+    {
+      line.multiphaseSystem->Update( line.pressure, line.temperature, z );
+    }
+    const std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  };
+
+  benchmark.saturatedTime += run( line.feed );
+  benchmark.undersaturatedTime += run( undersaturatedFeed );
+  benchmark.nUpdates += nUpdates;
+}
+
+/**
+ * @brief Timings of the dead-oil batch updates, the phase models being evaluated cell by cell or over chunks of cells.
+ */
+struct DeadOilBatchBenchmark
+{
+  double cellByCellTime = 0.;
+  double chunkedTime = 0.;
+  std::size_t nCells = 0;
+};
+
+void benchmarkDeadOilBatch( const std::string & json_string,
+                            DeadOilBatchBenchmark & benchmark )
+{
+  const DataLine line = readDataLine( json_string );
+
+  if( line.flashType != pds::FLASH_TYPE::DEAD_OIL )
+  {
+    return;
+  }
+
+  // Pressures in no particular order, spanning several table intervals, and different feeds.
+  const std::size_t nCells = 1000;
+  const std::size_t nComponents = line.feed.size();
+  const std::size_t recordSize = pvt::MultiphaseSystemBatchProperties::recordSize( nComponents );
+
+  std::vector< double > pressures( nCells );
+  std::vector< std::vector< double > > cellFeeds( nCells );
+  std::vector< double > feeds;
+  for( std::size_t iCell = 0; iCell < nCells; ++iCell )
+  {
+    pressures[iCell] = line.pressure * ( 0.8 + 0.4 * static_cast< double >( ( iCell * 389 ) % nCells ) / nCells );
+    std::vector< double > z( line.feed );
+    z[0] += 0.01 * ( iCell % 7 );
+    const double sum = std::accumulate( z.cbegin(), z.cend(), 0. );
+    for( double & zi: z )
+    {
+      zi /= sum;
+    }
+    feeds.insert( feeds.end(), z.cbegin(), z.cend() );
+    cellFeeds[iCell] = z;
+  }
+  const std::vector< double > temperatures( nCells, line.temperature );
+
+  std::vector< double > massDensity( nCells * line.phases.size() * recordSize );
+  std::vector< double > viscosity( nCells * line.phases.size() * recordSize );
+  std::unique_ptr< bool[] > succeeded( new bool[nCells] );
+
+  pvt::MultiphaseSystemBatchProperties outputs;
+  outputs.phases = line.phases;
+  outputs.massDensity = massDensity.data();
+  outputs.viscosity = viscosity.data();
+  outputs.succeeded = succeeded.get();
+
+  // With analytical derivatives, the phase models are evaluated over chunks of cells.
+  line.multiphaseSystem->setDerivativesType( pvt::DERIVATIVES_TYPE::ANALYTICAL );
+
+  const auto chunkedStart = std::chrono::steady_clock::now();
+  line.multiphaseSystem->BatchUpdate( nCells, pressures.data(), temperatures.data(), feeds.data(), outputs );
+  const std::chrono::duration< double > chunkedTime = std::chrono::steady_clock::now() - chunkedStart;
+
+  const auto cellByCellStart = std::chrono::steady_clock::now();
+  for( std::size_t iCell = 0; iCell < nCells; ++iCell )
+  {
+    line.multiphaseSystem->Update( pressures[iCell], line.temperature, cellFeeds[iCell] );
+  }
+  const std::chrono::duration< double > cellByCellTime = std::chrono::steady_clock::now() - cellByCellStart;
+
+  line.multiphaseSystem->setDerivativesType( pvt::DERIVATIVES_TYPE::FINITE_DIFFERENCES );
+
+  benchmark.chunkedTime += chunkedTime.count();
+  benchmark.cellByCellTime += cellByCellTime.count();
+  benchmark.nCells += nCells;
+}
+
+/**
+ * @brief Timings and deviations of the mixed precision equation of state evaluations w.r.t. the double precision ones.
+ */
+struct PrecisionBenchmark
+{
+  std::size_t nCells = 0;
+  std::size_t nSuccessMismatches = 0;
+  double doubleTime = 0.;
+  double mixedTime = 0.;
+  double maxValueDeviation = 0.;
+  double maxDerivativeDeviation = 0.;
+};
+
+void benchmarkMixedPrecision( const std::string & json_string,
+                              PrecisionBenchmark & benchmark )
+{
+  const DataLine line = readDataLine( json_string );
+
+  if( line.flashType != pds::FLASH_TYPE::NEGATIVE_TWO_PHASE )
+  {
+    return;
+  }
+
+  const pds::CompositionalApiInputs apiInputs = line.j.at( PublicAPIKeys::INPUT ).at( PublicAPIKeys::API ).get< pds::CompositionalApiInputs >();
+
+  std::unique_ptr< pvt::MultiphaseSystem > multiphaseSystem =
+    pvt::MultiphaseSystemBuilder::buildCompositional( pvt::COMPOSITIONAL_FLASH_TYPE::NEGATIVE_OIL_GAS,
+                                                      convert( apiInputs.phases ),
+                                                      convert( apiInputs.eosTypes ),
+                                                      apiInputs.componentNames,
+                                                      apiInputs.componentMolarWeights,
+                                                      apiInputs.componentCriticalTemperatures,
+                                                      apiInputs.componentCriticalPressures,
+                                                      apiInputs.componentOmegas );
+
+  multiphaseSystem->setDerivativesType( pvt::DERIVATIVES_TYPE::ANALYTICAL );
+
+  // Isothermal cells spanning the pressures around the one of the line.
+  const std::size_t nCells = 256;
+  const std::size_t nComponents = line.feed.size();
+  const std::size_t recordSize = pvt::MultiphaseSystemBatchProperties::recordSize( nComponents );
+  const std::size_t bufferSize = nCells * line.phases.size() * recordSize;
+  std::vector< double > pressures( nCells ), feeds;
+  for( std::size_t iCell = 0; iCell < nCells; ++iCell )
+  {
+    pressures[iCell] = line.pressure * ( 0.5 + double( iCell ) / nCells );
+    feeds.insert( feeds.end(), line.feed.cbegin(), line.feed.cend() );
+  }
+  const std::vector< double > temperatures( nCells, line.temperature );
+
+  struct Buffers
+  {
+    std::vector< double > massDensity, moleDensity, phaseMoleFraction;
+    std::vector< char > succeeded;
+  };
+
+  auto solve = [&]( pvt::PRECISION_TYPE const & precisionType,
+                    Buffers & buffers )
+  {
+    buffers.massDensity.assign( bufferSize, 0. );
+    buffers.moleDensity.assign( bufferSize, 0. );
+    buffers.phaseMoleFraction.assign( bufferSize, 0. );
+    std::unique_ptr< bool[] > succeeded( new bool[nCells] );
+
+    pvt::MultiphaseSystemBatchProperties outputs;
+    outputs.phases = line.phases;
+    outputs.massDensity = buffers.massDensity.data();
+    outputs.moleDensity = buffers.moleDensity.data();
+    outputs.phaseMoleFraction = buffers.phaseMoleFraction.data();
+    outputs.succeeded = succeeded.get();
+
+    multiphaseSystem->setPrecisionType( precisionType );
+    const auto start = std::chrono::steady_clock::now();
+    multiphaseSystem->BatchUpdate( nCells, pressures.data(), temperatures.data(), feeds.data(), outputs );
+    const std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start;
+
+    buffers.succeeded.assign( succeeded.get(), succeeded.get() + nCells );
+    return elapsed.count();
+  };
+
+  Buffers reference, mixed;
+  benchmark.doubleTime += solve( pvt::PRECISION_TYPE::DOUBLE, reference );
+  benchmark.mixedTime += solve( pvt::PRECISION_TYPE::MIXED, mixed );
+  benchmark.nCells += nCells;
+
+  // Deviations relative to the values, or absolute for values below 1 (e.g. phase fractions).
+  auto deviation = []( double value,
+                       double referenceValue )
+  {
+    return std::fabs( value - referenceValue ) / std::max( std::fabs( referenceValue ), 1. );
+  };
+
+  for( std::size_t iCell = 0; iCell < nCells; ++iCell )
+  {
+    if( mixed.succeeded[iCell] != reference.succeeded[iCell] )
+    {
+      ++benchmark.nSuccessMismatches;
+    }
+    for( std::size_t iPhase = 0; iPhase < line.phases.size(); ++iPhase )
+    {
+      const std::size_t offset = ( iCell * line.phases.size() + iPhase ) * recordSize;
+      for( std::vector< double > Buffers::* property: { &Buffers::massDensity, &Buffers::moleDensity, &Buffers::phaseMoleFraction } )
+      {
+        double const * record = &( mixed.*property )[offset];
+        double const * referenceRecord = &( reference.*property )[offset];
+        benchmark.maxValueDeviation = std::max( benchmark.maxValueDeviation, deviation( record[0], referenceRecord[0] ) );
+        for( std::size_t i = 1; i < recordSize; ++i )
+        {
+          benchmark.maxDerivativeDeviation = std::max( benchmark.maxDerivativeDeviation, deviation( record[i], referenceRecord[i] ) );
+        }
+      }
+    }
+  }
+}
+
+void benchmarkUndersaturatedOil()
+{
+  OilLookupBenchmark benchmark;
+
+  forEachDataLine( [&]( const std::string & line )
+  {
+    benchmarkUndersaturatedOil( line, benchmark );
+  } );
+
+  if( benchmark.nUpdates == 0 )
+  {
+    std::cout << "Black-oil updates: no saturated line" << std::endl;
+    return;
+  }
+  std::cout << "Black-oil updates: "
+            << "saturated " << 1.e6 * benchmark.saturatedTime / benchmark.nUpdates << " us, "
+            << "undersaturated " << 1.e6 * benchmark.undersaturatedTime / benchmark.nUpdates << " us" << std::endl;
+}
+
+
+void benchmarkDeadOilBatch()
+{
+  DeadOilBatchBenchmark benchmark;
+
+  forEachDataLine( [&]( const std::string & line )
+  {
+    benchmarkDeadOilBatch( line, benchmark );
+  } );
+
+  if( benchmark.nCells == 0 )
+  {
+    std::cout << "Dead-oil batch updates: no dead-oil line" << std::endl;
+    return;
+  }
+  std::cout << "Dead-oil batch updates with analytical derivatives: "
+            << "cell by cell " << 1.e-6 * benchmark.nCells / benchmark.cellByCellTime << " M cells/s, "
+            << "chunked " << 1.e-6 * benchmark.nCells / benchmark.chunkedTime << " M cells/s" << std::endl;
+}
+
+void benchmarkMixedPrecision()
+{
+  PrecisionBenchmark benchmark;
+
+  forEachDataLine( [&]( const std::string & line )
+  {
+    benchmarkMixedPrecision( line, benchmark );
+  } );
+
+  if( benchmark.nCells == 0 )
+  {
+    std::cout << "Mixed precision updates: no negative two-phase line" << std::endl;
+    return;
+  }
+  std::cout << "Mixed precision updates over " << benchmark.nCells << " cells: "
+            << "speedup " << benchmark.doubleTime / benchmark.mixedTime
+            << ", max value deviation " << benchmark.maxValueDeviation
+            << ", max derivative deviation " << benchmark.maxDerivativeDeviation
+            << ", convergence mismatches " << benchmark.nSuccessMismatches << std::endl;
+}
+}
+}
+
+int main()
+{
+  PVTPackage::tests::benchmarkUndersaturatedOil();
+  PVTPackage::tests::benchmarkDeadOilBatch();
+  PVTPackage::tests::benchmarkMixedPrecision();
+
+  return 0;
+}
@@ -28,7 +28,13 @@ NLOHMANN_JSON_SERIALIZE_ENUM( pvt::PHASE_TYPE, {
 } )
 
 void to_json( nlohmann::json & j,
-              const ScalarPropertyAndDerivatives< double > & s )
+              const ArrayView< double > & s )
+{
+  j = std::vector< double >( s.begin(), s.end() );
+}
+
+void to_json( nlohmann::json & j,
+              const ScalarPropertyAndDerivativesView< double > & s )
 {
   using Keys = PVTPackage::tests::ScalarVectorPropertyAndDerivativesKeys;
   j = {
@@ -40,14 +46,19 @@ void to_json( nlohmann::json & j,
 }
 
 void to_json( nlohmann::json & j,
-              const VectorPropertyAndDerivatives< double > & s )
+              const VectorPropertyAndDerivativesView< double > & s )
 {
   using Keys = PVTPackage::tests::ScalarVectorPropertyAndDerivativesKeys;
+  nlohmann::json dz = nlohmann::json::array();
+  for( std::size_t i = 0; i < s.dz.size(); ++i )
+  {
+    dz.push_back( s.dz[i] );
+  }
   j = {
     { Keys::VALUE, s.value },
     { Keys::DP,    s.dP },
     { Keys::DT,    s.dT },
-    { Keys::DZ,    s.dz }
+    { Keys::DZ,    dz }
   };
 }
 
@@ -0,0 +1,277 @@
+/*	
+ * ------------------------------------------------------------------------------------------------------------	
+ * SPDX-License-Identifier: LGPL-2.1-only	
+ *	
+ * Copyright (c) 2018-2024 Lawrence Livermore National Security LLC	
+ * Copyright (c) 2018-2024 The Board of Trustees of the Leland Stanford Junior University	
+ * Copyright (c) 2018-2024 TotalEnergies	
+ * Copyright (c) 2019-     GEOS/GEOSX Contributors	
+ * All right reserved	
+ *	
+ * See top level LICENSE, COPYRIGHT, CONTRIBUTORS, NOTICE, and ACKNOWLEDGEMENTS files for details.	
+ * ------------------------------------------------------------------------------------------------------------	
+ */
+
+#include "./deserializers/CompositionalApiInputs.hpp"
+
+#include "./AllocationCounter.hpp"
+#include "./JsonKeys.hpp"
+#include "./TestFactor.hpp"
+#include "./TestSystems.hpp"
+
+#include "pvt/pvt.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace PVTPackage
+{
+namespace tests
+{
+
+void validateFlashIterationAllocations( const std::string & json_string,
+                                        pvt::DERIVATIVES_TYPE const & derivativesType,
+                                        pvt::SSI_ACCELERATION_TYPE const & accelerationType,
+                                        std::set< std::size_t > & iterations )
+{
+  const DataLine line = readDataLine( json_string );
+
+  if( line.flashType != pds::FLASH_TYPE::NEGATIVE_TWO_PHASE and line.flashType != pds::FLASH_TYPE::FREE_WATER )
+  {
+    return;
+  }
+
+  const ScopedDerivativesType derivatives( *line.multiphaseSystem, derivativesType );
+  line.multiphaseSystem->setSsiAccelerationType( accelerationType );
+  const std::vector< std::pair< double, double > > conditions{
+    { line.pressure, line.temperature }, { line.pressure / 5., line.temperature },
+    { line.pressure, line.temperature + 50. }, { line.pressure / 5., line.temperature + 50. }
+  };
+
+  // A first pass sizes the buffers reused by the flash.
+  for( auto const & pt: conditions )
+  {
+    line.multiphaseSystem->Update( pt.first, pt.second, line.feed );
+  }
+
+  // Once the buffers are sized, an update (finite differences flashes or analytical derivatives included) does not allocate,
+  // whatever the number of flash iterations, which varies with the conditions.
+  // The feed, taken by value, is moved in so that its copy is not counted.
+  for( auto const & pt: conditions )
+  {
+    std::vector< double > updateFeed( line.feed );
+    line.multiphaseSystem->resetFlashStatistics();
+    const std::size_t allocationsBefore = getAllocationCount();
+    line.multiphaseSystem->Update( pt.first, pt.second, std::move( updateFeed ) );
+    ASSERT_EQ( getAllocationCount() - allocationsBefore, 0u );
+    iterations.insert( line.multiphaseSystem->getFlashStatistics().nIterations );
+  }
+
+  line.multiphaseSystem->setSsiAccelerationType( pvt::SSI_ACCELERATION_TYPE::NONE );
+}
+
+/**
+ * @brief Checks that the updates of @p multiphaseSystem do not allocate, once its buffers are sized.
+ * @param name The name of the system, reported on failure.
+ * @param multiphaseSystem The system.
+ * @param pressure The pressure around which the system is updated.
+ * @param temperature The temperature.
+ * @param feed The feed.
+ */
+void validateUpdateAllocations( std::string const & name,
+                                pvt::MultiphaseSystem & multiphaseSystem,
+                                double pressure,
+                                double temperature,
+                                std::vector< double > const & feed )
+{
+  SCOPED_TRACE( name );
+
+  // Close pressures, which stay inside the black-oil and dead-oil tables.
+  const std::vector< double > pressures{ pressure, 1.01 * pressure, 0.99 * pressure };
+
+  for( const double & p: pressures )
+  {
+    multiphaseSystem.Update( p, temperature, feed );
+  }
+
+  for( const double & p: pressures )
+  {
+    std::vector< double > updateFeed( feed );
+    const std::size_t allocationsBefore = getAllocationCount();
+    multiphaseSystem.Update( p, temperature, std::move( updateFeed ) );
+    ASSERT_EQ( getAllocationCount() - allocationsBefore, 0u );
+    ASSERT_TRUE( multiphaseSystem.hasSucceeded() );
+  }
+}
+
+void validateSystemAllocations( const std::string & json_string,
+                                pvt::DERIVATIVES_TYPE const & derivativesType,
+                                std::set< std::string > & checkedSystems )
+{
+  const DataLine line = readDataLine( json_string );
+
+  {
+    const std::string name = line.j.at( PublicAPIKeys::INPUT ).at( PublicAPIKeys::API ).at( FlashKeys::TYPE ).get< std::string >();
+    const ScopedDerivativesType derivatives( *line.multiphaseSystem, derivativesType );
+    validateUpdateAllocations( name, *line.multiphaseSystem, line.pressure, line.temperature, line.feed );
+    checkedSystems.insert( name );
+  }
+
+  // The three-phase and tabulated K-values systems are built from the compositional lines.
+  if( line.flashType != pds::FLASH_TYPE::NEGATIVE_TWO_PHASE and line.flashType != pds::FLASH_TYPE::FREE_WATER )
+  {
+    return;
+  }
+
+  const pds::CompositionalApiInputs apiInputs = line.j.at( PublicAPIKeys::INPUT ).at( PublicAPIKeys::API ).get< pds::CompositionalApiInputs >();
+  std::string name;
+  std::unique_ptr< pvt::MultiphaseSystem > multiphaseSystem;
+  if( line.flashType == pds::FLASH_TYPE::FREE_WATER )
+  {
+    multiphaseSystem = pvt::MultiphaseSystemBuilder::buildCompositional( pvt::COMPOSITIONAL_FLASH_TYPE::THREE_PHASE,
+                                                                         convert( apiInputs.phases ),
+                                                                         convert( apiInputs.eosTypes ),
+                                                                         apiInputs.componentNames,
+                                                                         apiInputs.componentMolarWeights,
+                                                                         apiInputs.componentCriticalTemperatures,
+                                                                         apiInputs.componentCriticalPressures,
+                                                                         apiInputs.componentOmegas );
+    name = "THREE_PHASE";
+  }
+  else
+  {
+    line.multiphaseSystem->Update( line.pressure, line.temperature, line.feed );
+    pvt::KValueTable table;
+    table.minPressure = line.pressure;
+    table.nPressures = 1;
+    table.minTemperature = line.temperature;
+    table.nTemperatures = 1;
+    table.kValues = line.multiphaseSystem->getKValues();
+    multiphaseSystem = pvt::MultiphaseSystemBuilder::buildTabulatedKValues( convert( apiInputs.phases ),
+                                                                            convert( apiInputs.eosTypes ),
+                                                                            apiInputs.componentNames,
+                                                                            apiInputs.componentMolarWeights,
+                                                                            apiInputs.componentCriticalTemperatures,
+                                                                            apiInputs.componentCriticalPressures,
+                                                                            apiInputs.componentOmegas,
+                                                                            {},
+                                                                            {},
+                                                                            table );
+    name = "TABULATED_KVALUES";
+  }
+  ASSERT_NE( multiphaseSystem, nullptr );
+  multiphaseSystem->setDerivativesType( derivativesType );
+  validateUpdateAllocations( name, *multiphaseSystem, line.pressure, line.temperature, line.feed );
+  checkedSystems.insert( name );
+}
+
+void validateUndersaturatedOilAllocations( const std::string & json_string,
+                                           std::size_t & saturatedAllocations,
+                                           std::size_t & undersaturatedAllocations,
+                                           std::size_t & nLines )
+{
+  const DataLine line = readDataLine( json_string );
+
+  if( line.flashType != pds::FLASH_TYPE::BLACK_OIL )
+  {
+    return;
+  }
+
+  pvt::MultiphaseSystemProperties const & msp = line.multiphaseSystem->getMultiphaseSystemProperties();
+
+  // Same water, almost no gas dissolved in the oil: the oil is undersaturated (unless the line is at a very low pressure).
+  const double hydrocarbons = line.feed[0] + line.feed[1];
+  const std::vector< double > undersaturatedFeed{ 0.999 * hydrocarbons, 0.001 * hydrocarbons, line.feed[2] };
+  line.multiphaseSystem->Update( line.pressure, line.temperature, line.feed );
+  const bool isSaturated = msp.getPhaseMoleFraction( pvt::PHASE_TYPE::GAS ).value > 0.;
+  line.multiphaseSystem->Update( line.pressure, line.temperature, undersaturatedFeed );
+  const bool isUndersaturated = msp.getPhaseMoleFraction( pvt::PHASE_TYPE::GAS ).value == 0.;
+  if( not isSaturated or not isUndersaturated )
+  {
+    return;
+  }
+
+  // The feeds, taken by value, are moved in so that their copies are not counted.
+  std::vector< double > feed( line.feed );
+  std::size_t allocationsBefore = getAllocationCount();
+  line.multiphaseSystem->Update( line.pressure, line.temperature, std::move( feed ) );
+  saturatedAllocations += getAllocationCount() - allocationsBefore;
+
+  feed = undersaturatedFeed;
+  allocationsBefore = getAllocationCount();
+  line.multiphaseSystem->Update( line.pressure, line.temperature, std::move( feed ) );
+  undersaturatedAllocations += getAllocationCount() - allocationsBefore;
+  ++nLines;
+}
+
+TEST( pvt, flashIterationAllocations )
+{
+  // The Newton steps, taken close to convergence, do not allocate either.
+  for( pvt::DERIVATIVES_TYPE const & derivativesType: { pvt::DERIVATIVES_TYPE::FINITE_DIFFERENCES, pvt::DERIVATIVES_TYPE::ANALYTICAL } )
+  {
+    for( pvt::SSI_ACCELERATION_TYPE const & accelerationType: { pvt::SSI_ACCELERATION_TYPE::NONE, pvt::SSI_ACCELERATION_TYPE::NEWTON } )
+    {
+      std::set< std::size_t > iterations;
+
+      forEachDataLine( [&]( const std::string & line )
+      {
+        validateFlashIterationAllocations( line, derivativesType, accelerationType, iterations );
+      } );
+
+      // Otherwise the test proves nothing.
+      ASSERT_GT( iterations.size(), 1u );
+    }
+  }
+}
+
+TEST( pvt, updateAllocations )
+{
+  // Whatever the system, an update does not allocate once its buffers are sized.
+  for( pvt::DERIVATIVES_TYPE const & derivativesType: { pvt::DERIVATIVES_TYPE::FINITE_DIFFERENCES, pvt::DERIVATIVES_TYPE::ANALYTICAL } )
+  {
+    std::set< std::string > checkedSystems;
+
+    forEachDataLine( [&]( const std::string & line )
+    {
+      validateSystemAllocations( line, derivativesType, checkedSystems );
+    } );
+
+    const std::set< std::string > expected{ "BLACK_OIL", "DEAD_OIL", "FREE_WATER", "NEGATIVE_TWO_PHASE", "TRIVIAL", "THREE_PHASE", "TABULATED_KVALUES" };
+    ASSERT_EQ( checkedSystems, expected );
+  }
+}
+
+TEST( pvt, undersaturatedOilAllocations )
+{
+  std::size_t saturatedAllocations = 0;
+  std::size_t undersaturatedAllocations = 0;
+  std::size_t nLines = 0;
+
+  forEachDataLine( [&]( const std::string & line )
+  {
+    validateUndersaturatedOilAllocations( line, saturatedAllocations, undersaturatedAllocations, nLines );
+  } );
+
+  // Switching from the saturated flash to the undersaturated table lookups, and back, does not allocate either.
+  ASSERT_GT( nLines, 0u );
+  ASSERT_EQ( saturatedAllocations, 0u );
+  ASSERT_EQ( undersaturatedAllocations, 0u );
+}
+
+int main( int argc,
+          char ** argv )
+{
+  ::testing::InitGoogleTest( &argc, argv );
+
+  int const result = RUN_ALL_TESTS();
+
+  return result;
+}
+
+}
+}
@@ -15,7 +15,6 @@
 #include "./deserializers/PVTEnums.hpp"
 #include "./deserializers/BlackOilDeadOilApiInputs.hpp"
 #include "./deserializers/CompositionalApiInputs.hpp"
-#include "./deserializers/MultiphaseSystemProperties.hpp"
 
 #include "./serializers/MultiphaseSystemProperties.hpp"
 
@@ -26,6 +25,10 @@
 #include "./passiveDataStructures/MultiphaseSystemProperties.hpp"
 
 #include "./TestFactor.hpp"
+#include "./TestSystems.hpp"
+
+#include "MultiphaseSystem/ComponentProperties.hpp"
+#include "MultiphaseSystem/PhaseModel/CubicEOS/CubicEoSPhaseModel.hpp"
 
 #include "pvt/pvt.hpp"
 
@@ -33,9 +36,11 @@
 #include <nlohmann/json.hpp>
 
 #include <algorithm>
-#include <fstream>
-#include <list>
+#include <cmath>
+#include <limits>
 #include <memory>
+#include <numeric>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -46,194 +51,1040 @@ namespace tests
 
 using json = nlohmann::json;
 
-// FIXME Use tests setup
-class Holder
+void validatePublicApi( const std::string & json_string )
+{
+  const DataLine line = readDataLine( json_string );
+
+  line.multiphaseSystem->Update( line.pressure, line.temperature, line.feed );
+  pvt::MultiphaseSystemProperties const & actualMsp = line.multiphaseSystem->getMultiphaseSystemProperties();
+
+  compare( actualMsp, line.refMsp );
+
+  // Building new json reference, uncomment lines below to display computed values as json.
+//  auto newRef = json{
+//    { PublicAPIKeys::INPUT,  line.j.at( PublicAPIKeys::INPUT )},
+//    { PublicAPIKeys::OUTPUT, actualMsp }
+//  };
+//  std::cout << newRef << std::endl;
+}
+
+void checkBatchRecord( const pvt::ScalarPropertyAndDerivativesView< double > & expected,
+                       const double * record )
+{
+  ASSERT_EQ( record[0], expected.value );
+  ASSERT_EQ( record[1], expected.dP );
+  ASSERT_EQ( record[2], expected.dT );
+  for( std::size_t i = 0; i < expected.dz.size(); ++i )
+  {
+    ASSERT_EQ( record[3 + i], expected.dz[i] );
+  }
+}
+
+void validateBatchUpdate( const std::string & json_string )
 {
-private:
+  const DataLine line = readDataLine( json_string );
 
-  // FIXME Do not forget to clean
-  std::vector< std::string > tableFileNames;
+  // Two cells, the second one being perturbed, so we check that the cells do not overlap.
+  const std::size_t nCells = 2;
+  const std::size_t nComponents = line.feed.size();
+  const std::size_t nPhases = line.phases.size();
+  const std::size_t recordSize = pvt::MultiphaseSystemBatchProperties::recordSize( nComponents );
 
-  static std::vector< std::string > buildTableFileNames( const pds::BlackOilDeadOilApiInputs::TableDataType & tableData )
+  const std::vector< double > pressures{ line.pressure, 1.01 * line.pressure };
+  const std::vector< double > temperatures( nCells, line.temperature );
+  std::vector< double > feeds( line.feed );
+  feeds.insert( feeds.end(), line.feed.cbegin(), line.feed.cend() );
+
+  std::vector< double > massDensity( nCells * nPhases * recordSize );
+  std::vector< double > moleComposition( nCells * nPhases * nComponents * recordSize );
+  std::vector< double > moleDensity( nCells * nPhases * recordSize );
+  std::vector< double > viscosity( nCells * nPhases * recordSize );
+  std::vector< double > molecularWeight( nCells * nPhases * recordSize );
+  std::vector< double > phaseMoleFraction( nCells * nPhases * recordSize );
+  bool succeeded[nCells];
+
+  pvt::MultiphaseSystemBatchProperties outputs;
+  outputs.phases = line.phases;
+  outputs.massDensity = massDensity.data();
+  outputs.moleComposition = moleComposition.data();
+  outputs.moleDensity = moleDensity.data();
+  outputs.viscosity = viscosity.data();
+  outputs.molecularWeight = molecularWeight.data();
+  outputs.phaseMoleFraction = phaseMoleFraction.data();
+  outputs.succeeded = succeeded;
+
+  const bool batchSucceeded = line.multiphaseSystem->BatchUpdate( nCells, pressures.data(), temperatures.data(), feeds.data(), outputs );
+  ASSERT_EQ( batchSucceeded, succeeded[0] and succeeded[1] );
+
+  for( std::size_t iCell = 0; iCell < nCells; ++iCell )
   {
-    std::vector< std::string > tableFileNames;
-    for( const std::vector< std::vector< double > > & matrix: tableData )
+    line.multiphaseSystem->Update( pressures[iCell], temperatures[iCell], line.feed );
+    ASSERT_EQ( line.multiphaseSystem->hasSucceeded(), succeeded[iCell] );
+    pvt::MultiphaseSystemProperties const & msp = line.multiphaseSystem->getMultiphaseSystemProperties();
+
+    for( std::size_t iPhase = 0; iPhase < nPhases; ++iPhase )
     {
-      std::string outputFile = std::tmpnam( nullptr );
-//      std::cerr << outputFile << std::endl;
-      std::ofstream ofs( outputFile );
-      ofs << std::setprecision( std::numeric_limits< long double >::digits10 + 1 );
+      const pvt::PHASE_TYPE & phase = line.phases[iPhase];
+      const std::size_t offset = ( iCell * nPhases + iPhase ) * recordSize;
+
+      checkBatchRecord( msp.getMassDensity( phase ), &massDensity[offset] );
+      checkBatchRecord( msp.getMoleDensity( phase ), &moleDensity[offset] );
+      checkBatchRecord( msp.getViscosity( phase ), &viscosity[offset] );
+      checkBatchRecord( msp.getMolecularWeight( phase ), &molecularWeight[offset] );
+      checkBatchRecord( msp.getPhaseMoleFraction( phase ), &phaseMoleFraction[offset] );
 
-      for( const std::vector< double > & line: matrix )
+      const pvt::VectorPropertyAndDerivativesView< double > composition = msp.getMoleComposition( phase );
+      for( std::size_t ic = 0; ic < nComponents; ++ic )
       {
-        for( const double & value: line )
+        const double * record = &moleComposition[offset * nComponents + ic * recordSize];
+        ASSERT_EQ( record[0], composition.value[ic] );
+        ASSERT_EQ( record[1], composition.dP[ic] );
+        ASSERT_EQ( record[2], composition.dT[ic] );
+        for( std::size_t jc = 0; jc < nComponents; ++jc )
         {
-          ofs << value << " ";
+          ASSERT_EQ( record[3 + jc], composition.dz[ic][jc] );
         }
-        ofs << std::endl;
       }
-
-      tableFileNames.push_back( outputFile );
     }
-    return tableFileNames;
   }
+}
 
-  // FIXME unique_ptr??? who holds?
-  typedef std::pair< pds::CompositionalApiInputs, std::unique_ptr< pvt::MultiphaseSystem > > compInput2system;
-  typedef std::pair< pds::BlackOilDeadOilApiInputs, std::unique_ptr< pvt::MultiphaseSystem > > blackOilDeadOilInput2system;
-  std::list< compInput2system > compositionalSystems;
-  std::list< blackOilDeadOilInput2system > blackOilSystems;
-  std::list< blackOilDeadOilInput2system > deadOilSystems;
+void validateAnalyticalDerivatives( const std::string & json_string )
+{
+  const DataLine line = readDataLine( json_string );
 
-  // FIXME Return a ref??
-  pvt::MultiphaseSystem * getBlackOilSystem( const pds::BlackOilDeadOilApiInputs & apiBuildParams )
+  // Analytical derivatives are only available for the two-phase compositional flashes (the free water one included).
+  if( line.flashType != pds::FLASH_TYPE::NEGATIVE_TWO_PHASE and line.flashType != pds::FLASH_TYPE::FREE_WATER )
   {
-    auto predicate = [&apiBuildParams]( const blackOilDeadOilInput2system & pair )
-    {
-      return pair.first == apiBuildParams;
-    };
+    return;
+  }
 
-    auto iter = std::find_if( blackOilSystems.begin(), blackOilSystems.end(), predicate );
+  std::vector< double > feed = line.feed;
+  const std::size_t nComponents = feed.size();
 
-    if( iter != blackOilSystems.end() )
+  // The free water flash derivatives are only analytical when there is no free water, all of it being dissolved in the gas:
+  // the water feed of the line is lowered accordingly (the aqueous phase of the reference output is pure water).
+  const bool isFreeWater = line.flashType == pds::FLASH_TYPE::FREE_WATER;
+  if( isFreeWater )
+  {
+    const std::vector< double > & refWaterComposition = line.refMsp.getMoleComposition( pds::PHASE_TYPE::LIQUID_WATER_RICH ).value;
+    const std::size_t waterIndex = std::max_element( refWaterComposition.cbegin(), refWaterComposition.cend() ) - refWaterComposition.cbegin();
+    const double waterFeed = 0.005;
+    const double scale = ( 1. - waterFeed ) / ( 1. - feed[waterIndex] );
+    std::transform( feed.cbegin(), feed.cend(), feed.begin(), [scale]( double zi ) { return scale * zi; } );
+    feed[waterIndex] = waterFeed;
+  }
+
+  // Central differences (with a step much larger than the flash tolerance) are used as reference.
+  auto evaluate = [&]( double p, double t, std::vector< double > const & z )
+  {
+    line.multiphaseSystem->Update( p, t, z );
+    pvt::MultiphaseSystemProperties const & msp = line.multiphaseSystem->getMultiphaseSystemProperties();
+    std::vector< double > values;
+    for( const pvt::PHASE_TYPE & phase: line.phases )
     {
-      return iter->second.get();
+      values.push_back( msp.getMassDensity( phase ).value );
+      values.push_back( msp.getPhaseMoleFraction( phase ).value );
+      const pvt::ArrayView< double > moleComposition = msp.getMoleComposition( phase ).value;
+      values.insert( values.end(), moleComposition.cbegin(), moleComposition.cend() );
     }
-    else
+    return values;
+  };
+
+  const ScopedDerivativesType analytical( *line.multiphaseSystem, pvt::DERIVATIVES_TYPE::ANALYTICAL );
+  line.multiphaseSystem->Update( line.pressure, line.temperature, feed );
+  pvt::MultiphaseSystemProperties const & msp = line.multiphaseSystem->getMultiphaseSystemProperties();
+  if( isFreeWater )
+  {
+    ASSERT_EQ( msp.getPhaseMoleFraction( pvt::PHASE_TYPE::LIQUID_WATER_RICH ).value, 0. );
+  }
+  std::vector< std::vector< double > > derivatives( 2 + nComponents );
+  for( const pvt::PHASE_TYPE & phase: line.phases )
+  {
+    for( const pvt::ScalarPropertyAndDerivativesView< double > & property : { msp.getMassDensity( phase ), msp.getPhaseMoleFraction( phase ) } )
     {
-      tableFileNames = buildTableFileNames( apiBuildParams.tableData );
-      auto pair = std::make_pair( apiBuildParams,
-                                  pvt::MultiphaseSystemBuilder::buildLiveOil(
-                                    convert( apiBuildParams.phases ),
-                                    tableFileNames,
-                                    apiBuildParams.surfaceMassDensities,
-                                    apiBuildParams.molecularWeights
-                                  ) );
-      blackOilSystems.push_back( std::move( pair ) );
-      return blackOilSystems.back().second.get();
+      derivatives[0].push_back( property.dP );
+      derivatives[1].push_back( property.dT );
+      for( std::size_t ic = 0; ic < nComponents; ++ic )
+      {
+        derivatives[2 + ic].push_back( property.dz[ic] );
+      }
+    }
+    const pvt::VectorPropertyAndDerivativesView< double > moleComposition = msp.getMoleComposition( phase );
+    for( std::size_t ic = 0; ic < nComponents; ++ic )
+    {
+      derivatives[0].push_back( moleComposition.dP[ic] );
+      derivatives[1].push_back( moleComposition.dT[ic] );
+      for( std::size_t jc = 0; jc < nComponents; ++jc )
+      {
+        derivatives[2 + jc].push_back( moleComposition.dz[ic][jc] );
+      }
     }
   }
 
-  pvt::MultiphaseSystem * getDeadOilSystem( const pds::BlackOilDeadOilApiInputs & apiBuildParams )
+  for( std::size_t col = 0; col < derivatives.size(); ++col )
   {
-    auto predicate = [&apiBuildParams]( const blackOilDeadOilInput2system & pair )
+    const double step = col == 0 ? 1.e-5 * line.pressure : col == 1 ? 1.e-5 * line.temperature : 1.e-5;
+    auto perturbedFeed = [&]( double sign )
     {
-      return pair.first == apiBuildParams;
+      std::vector< double > z( feed );
+      if( col >= 2 )
+      {
+        z[col - 2] += sign * step;
+        const double sum = std::accumulate( z.cbegin(), z.cend(), 0. );
+        std::transform( z.cbegin(), z.cend(), z.begin(), [sum]( double zi ) { return zi / sum; } );
+      }
+      return z;
     };
+    // Absent components can only be perturbed forward.
+    const double backward = col >= 2 and feed[col - 2] < 2. * step ? 0. : -1.;
+    const std::vector< double > plus = evaluate( line.pressure + ( col == 0 ? step : 0. ), line.temperature + ( col == 1 ? step : 0. ), perturbedFeed( 1. ) );
+    const std::vector< double > minus = evaluate( line.pressure + ( col == 0 ? backward * step : 0. ), line.temperature + ( col == 1 ? backward * step : 0. ), perturbedFeed( backward ) );
+    for( std::size_t i = 0; i < plus.size(); ++i )
+    {
+      const double reference = ( plus[i] - minus[i] ) / ( ( 1. - backward ) * step );
+      ASSERT_NEAR( derivatives[col][i], reference, 1.e-3 * ( 1.e-3 + std::abs( reference ) ) );
+    }
+  }
+}
+
+void validateBlackOilDeadOilAnalyticalDerivatives( const std::string & json_string )
+{
+  const DataLine line = readDataLine( json_string );
+
+  if( line.flashType != pds::FLASH_TYPE::BLACK_OIL and line.flashType != pds::FLASH_TYPE::DEAD_OIL )
+  {
+    return;
+  }
+
+  // The pressures of the data lines are table nodes, where the interpolations have no derivative.
+  const double pressure = 1.001 * line.pressure;
+  const std::size_t nComponents = line.feed.size();
+
+  // The black-oil oil is also checked undersaturated, with almost no gas dissolved.
+  std::vector< std::vector< double > > feeds{ line.feed };
+  if( line.flashType == pds::FLASH_TYPE::BLACK_OIL )
+  {
+    const double hydrocarbons = line.feed[0] + line.feed[1];
+    feeds.push_back( { 0.999 * hydrocarbons, 0.001 * hydrocarbons, line.feed[2] } );
+  }
+
+  pvt::MultiphaseSystemProperties const & msp = line.multiphaseSystem->getMultiphaseSystemProperties();
 
-    auto iter = std::find_if( deadOilSystems.begin(), deadOilSystems.end(), predicate );
+  auto properties = [&]( pvt::PHASE_TYPE const & phase )
+  {
+    return std::vector< pvt::ScalarPropertyAndDerivativesView< double > >{ msp.getMassDensity( phase ),
+                                                                          msp.getMoleDensity( phase ),
+                                                                          msp.getViscosity( phase ),
+                                                                          msp.getMolecularWeight( phase ),
+                                                                          msp.getPhaseMoleFraction( phase ) };
+  };
 
-    if( iter != deadOilSystems.end() )
+  // Central differences of the (piecewise linear) tables are used as reference.
+  auto evaluate = [&]( double p, std::vector< double > const & z )
+  {
+    line.multiphaseSystem->Update( p, line.temperature, z );
+    std::vector< double > values;
+    for( const pvt::PHASE_TYPE & phase: line.phases )
     {
-      return iter->second.get();
+      for( const pvt::ScalarPropertyAndDerivativesView< double > & property : properties( phase ) )
+      {
+        values.push_back( property.value );
+      }
+      const pvt::ArrayView< double > moleComposition = msp.getMoleComposition( phase ).value;
+      values.insert( values.end(), moleComposition.cbegin(), moleComposition.cend() );
     }
-    else
+    return values;
+  };
+
+  const ScopedDerivativesType analytical( *line.multiphaseSystem, pvt::DERIVATIVES_TYPE::ANALYTICAL );
+  for( const std::vector< double > & z0: feeds )
+  {
+    line.multiphaseSystem->Update( pressure, line.temperature, z0 );
+    std::vector< std::vector< double > > derivatives( 1 + nComponents );
+    for( const pvt::PHASE_TYPE & phase: line.phases )
     {
-      tableFileNames = buildTableFileNames( apiBuildParams.tableData );
-      auto pair = std::make_pair( apiBuildParams,
-                                  pvt::MultiphaseSystemBuilder::buildDeadOil(
-                                    convert( apiBuildParams.phases ),
-                                    tableFileNames,
-                                    apiBuildParams.surfaceMassDensities,
-                                    apiBuildParams.molecularWeights
-                                  ) );
-      deadOilSystems.push_back( std::move( pair ) );
-      return deadOilSystems.back().second.get();
+      for( const pvt::ScalarPropertyAndDerivativesView< double > & property : properties( phase ) )
+      {
+        derivatives[0].push_back( property.dP );
+        for( std::size_t ic = 0; ic < nComponents; ++ic )
+        {
+          derivatives[1 + ic].push_back( property.dz[ic] );
+        }
+      }
+      const pvt::VectorPropertyAndDerivativesView< double > moleComposition = msp.getMoleComposition( phase );
+      for( std::size_t ic = 0; ic < nComponents; ++ic )
+      {
+        derivatives[0].push_back( moleComposition.dP[ic] );
+        for( std::size_t jc = 0; jc < nComponents; ++jc )
+        {
+          derivatives[1 + jc].push_back( moleComposition.dz[ic][jc] );
+        }
+      }
+    }
+
+    for( std::size_t col = 0; col < derivatives.size(); ++col )
+    {
+      const double step = col == 0 ? 1.e-6 * pressure : 1.e-7;
+      auto perturbedFeed = [&]( double sign )
+      {
+        std::vector< double > z( z0 );
+        if( col >= 1 )
+        {
+          z[col - 1] += sign * step;
+          const double sum = std::accumulate( z.cbegin(), z.cend(), 0. );
+          std::transform( z.cbegin(), z.cend(), z.begin(), [sum]( double zi ) { return zi / sum; } );
+        }
+        return z;
+      };
+      const std::vector< double > plus = evaluate( pressure + ( col == 0 ? step : 0. ), perturbedFeed( 1. ) );
+      const std::vector< double > minus = evaluate( pressure - ( col == 0 ? step : 0. ), perturbedFeed( -1. ) );
+      // The pressure derivatives are compared as relative sensitivities, the ones per pascal being tiny.
+      const double scale = col == 0 ? pressure : 1.;
+      for( std::size_t i = 0; i < plus.size(); ++i )
+      {
+        const double reference = scale * ( plus[i] - minus[i] ) / ( 2. * step );
+        ASSERT_NEAR( scale * derivatives[col][i], reference, 1.e-3 * ( 1.e-3 + std::abs( reference ) ) );
+      }
     }
   }
+}
 
-public:
+void validateInteractionCoefficientsAndVolumeShifts( const std::string & json_string )
+{
+  const DataLine line = readDataLine( json_string );
 
-  pvt::MultiphaseSystem * getDeadOilBlackOilSystem( pds::FLASH_TYPE flashType,
-                                                    const pds::BlackOilDeadOilApiInputs & apiBuildParams )
+  if( line.flashType != pds::FLASH_TYPE::NEGATIVE_TWO_PHASE )
   {
-    if( flashType == pds::FLASH_TYPE::BLACK_OIL )
+    return;
+  }
+
+  const pds::CompositionalApiInputs apiInputs = line.j.at( PublicAPIKeys::INPUT ).at( PublicAPIKeys::API ).get< pds::CompositionalApiInputs >();
+  const std::size_t nComponents = line.feed.size();
+
+  auto build = [&]( std::vector< std::vector< double > > const & bic, std::vector< std::vector< double > > const & volumeShifts )
+  {
+    return pvt::MultiphaseSystemBuilder::buildCompositional( convert( apiInputs.flashType ),
+                                                             convert( apiInputs.phases ),
+                                                             convert( apiInputs.eosTypes ),
+                                                             apiInputs.componentNames,
+                                                             apiInputs.componentMolarWeights,
+                                                             apiInputs.componentCriticalTemperatures,
+                                                             apiInputs.componentCriticalPressures,
+                                                             apiInputs.componentOmegas,
+                                                             bic,
+                                                             volumeShifts );
+  };
+
+  // Inconsistent sizes are rejected.
+  ASSERT_EQ( build( std::vector< std::vector< double > >( nComponents, std::vector< double >( nComponents + 1 ) ), {} ), nullptr );
+  ASSERT_EQ( build( {}, std::vector< std::vector< double > >( nComponents, std::vector< double >( 1 ) ) ), nullptr );
+
+  // So are asymmetric binary interaction coefficients.
+  std::vector< std::vector< double > > asymmetricBic( nComponents, std::vector< double >( nComponents, 0. ) );
+  asymmetricBic[0][1] = 0.1;
+  ASSERT_EQ( build( asymmetricBic, {} ), nullptr );
+
+  // Explicit zero coefficients must reproduce the default system.
+  pvt::MultiphaseSystem * defaultSystem = line.multiphaseSystem;
+  defaultSystem->Update( line.pressure, line.temperature, line.feed );
+  pvt::MultiphaseSystemProperties const & defaultMsp = defaultSystem->getMultiphaseSystemProperties();
+
+  std::unique_ptr< pvt::MultiphaseSystem > zeroSystem = build( std::vector< std::vector< double > >( nComponents, std::vector< double >( nComponents, 0. ) ),
+                                                                std::vector< std::vector< double > >( nComponents, std::vector< double >( 2, 0. ) ) );
+  zeroSystem->Update( line.pressure, line.temperature, line.feed );
+  pvt::MultiphaseSystemProperties const & zeroMsp = zeroSystem->getMultiphaseSystemProperties();
+
+  // Volume shifts do not change the equilibrium, only the molar volume v = v_EOS + sum_i x_i c_i(T).
+  std::vector< std::vector< double > > volumeShifts( nComponents );
+  for( std::size_t ic = 0; ic < nComponents; ++ic )
+  {
+    volumeShifts[ic] = { -1.e-6 * ( ic + 1 ), 1.e-9 };
+  }
+  std::unique_ptr< pvt::MultiphaseSystem > shiftedSystem = build( {}, volumeShifts );
+  shiftedSystem->Update( line.pressure, line.temperature, line.feed );
+  pvt::MultiphaseSystemProperties const & shiftedMsp = shiftedSystem->getMultiphaseSystemProperties();
+
+  for( const pds::PHASE_TYPE & refPhase: line.refPhases )
+  {
+    const pvt::PHASE_TYPE phase = convert( refPhase );
+    ASSERT_EQ( zeroMsp.getMoleDensity( phase ).value, defaultMsp.getMoleDensity( phase ).value );
+    ASSERT_EQ( zeroMsp.getPhaseMoleFraction( phase ).value, defaultMsp.getPhaseMoleFraction( phase ).value );
+
+    const pvt::ArrayView< double > composition = defaultMsp.getMoleComposition( phase ).value;
+    const pvt::ArrayView< double > shiftedComposition = shiftedMsp.getMoleComposition( phase ).value;
+    ASSERT_TRUE( std::equal( composition.begin(), composition.end(), shiftedComposition.begin() ) );
+    double shiftedVolume = 1. / defaultMsp.getMoleDensity( phase ).value;
+    for( std::size_t ic = 0; ic < nComponents; ++ic )
     {
-      return this->getBlackOilSystem( apiBuildParams );
+      shiftedVolume += composition[ic] * ( volumeShifts[ic][0] + volumeShifts[ic][1] * line.temperature );
     }
-    else if( flashType == pds::FLASH_TYPE::DEAD_OIL )
+    ASSERT_NEAR( shiftedMsp.getMoleDensity( phase ).value, 1. / shiftedVolume, 1.e-12 / shiftedVolume );
+  }
+
+  // Binary interaction coefficients do change the equilibrium.
+  std::vector< std::vector< double > > bic( nComponents, std::vector< double >( nComponents, 0. ) );
+  bic[0][1] = bic[1][0] = 0.1;
+  std::unique_ptr< pvt::MultiphaseSystem > interactingSystem = build( bic, {} );
+  interactingSystem->Update( line.pressure, line.temperature, line.feed );
+  ASSERT_TRUE( interactingSystem->hasSucceeded() );
+  const pvt::PHASE_TYPE phase = convert( *line.refPhases.cbegin() );
+  const pvt::ArrayView< double > interactingComposition = interactingSystem->getMultiphaseSystemProperties().getMoleComposition( phase ).value;
+  const pvt::ArrayView< double > defaultComposition = defaultMsp.getMoleComposition( phase ).value;
+  ASSERT_FALSE( std::equal( interactingComposition.begin(), interactingComposition.end(), defaultComposition.begin() ) );
+}
+
+void validateMixedPrecision( const std::string & json_string,
+                             std::set< pds::FLASH_TYPE > & mixedFlashTypes )
+{
+  const DataLine line = readDataLine( json_string );
+
+  if( line.flashType != pds::FLASH_TYPE::NEGATIVE_TWO_PHASE and line.flashType != pds::FLASH_TYPE::FREE_WATER and line.flashType != pds::FLASH_TYPE::TRIVIAL )
+  {
+    return;
+  }
+
+  pvt::MultiphaseSystemProperties const & msp = line.multiphaseSystem->getMultiphaseSystemProperties();
+  line.multiphaseSystem->Update( line.pressure, line.temperature, line.feed );
+  std::vector< double > massDensities;
+  for( const pvt::PHASE_TYPE & phase: line.phases )
+  {
+    massDensities.push_back( msp.getMassDensity( phase ).value );
+  }
+
+  // The mixed precision properties only deviate by about the single precision round-off.
+  line.multiphaseSystem->setPrecisionType( pvt::PRECISION_TYPE::MIXED );
+  line.multiphaseSystem->Update( line.pressure, line.temperature, line.feed );
+  line.multiphaseSystem->setPrecisionType( pvt::PRECISION_TYPE::DOUBLE );
+  ASSERT_TRUE( line.multiphaseSystem->hasSucceeded() );
+  for( std::size_t ip = 0; ip < line.phases.size(); ++ip )
+  {
+    const double massDensity = msp.getMassDensity( line.phases[ip] ).value;
+    ASSERT_NEAR( massDensity, massDensities[ip], 1.e-4 * massDensities[ip] );
+    if( massDensity != massDensities[ip] )
     {
-      return this->getDeadOilSystem( apiBuildParams );
+      mixedFlashTypes.insert( line.flashType );
     }
-    else
+  }
+}
+
+void validateWarmStart( const std::string & json_string )
+{
+  const DataLine line = readDataLine( json_string );
+
+  if( line.flashType != pds::FLASH_TYPE::NEGATIVE_TWO_PHASE )
+  {
+    return;
+  }
+
+  const std::size_t nComponents = line.feed.size();
+
+  pvt::MultiphaseSystemProperties const & msp = line.multiphaseSystem->getMultiphaseSystemProperties();
+
+  line.multiphaseSystem->resetFlashStatistics();
+  line.multiphaseSystem->Update( line.pressure, line.temperature, line.feed );
+  const std::size_t coldIterations = line.multiphaseSystem->getFlashStatistics().nIterations;
+  // The derivatives of the gas fraction, dP first, are copied out of the properties which the next updates overwrite.
+  auto gasFractionDerivatives = [&msp]()
+  {
+    const pvt::ScalarPropertyAndDerivativesView< double > gasFraction = msp.getPhaseMoleFraction( pvt::PHASE_TYPE::GAS );
+    std::vector< double > derivatives{ gasFraction.dP };
+    derivatives.insert( derivatives.end(), gasFraction.dz.begin(), gasFraction.dz.end() );
+    return derivatives;
+  };
+  const std::vector< double > coldGasFraction = gasFractionDerivatives();
+  const std::vector< double > kValues = line.multiphaseSystem->getKValues();
+  ASSERT_EQ( kValues.size(), nComponents );
+
+  std::vector< double > coldResults;
+  for( const pds::PHASE_TYPE & refPhase: line.refPhases )
+  {
+    const pvt::PHASE_TYPE phase = convert( refPhase );
+    coldResults.push_back( msp.getPhaseMoleFraction( phase ).value );
+    const pvt::ArrayView< double > composition = msp.getMoleComposition( phase ).value;
+    coldResults.insert( coldResults.end(), composition.cbegin(), composition.cend() );
+  }
+
+  // Restarting from the K-values converged at the same conditions, the base flash only tightens its convergence,
+  // and the finite differences flashes, which start from its solution, still follow the variations of the K-values.
+  line.multiphaseSystem->setInitialKValues( kValues );
+  line.multiphaseSystem->resetFlashStatistics();
+  line.multiphaseSystem->Update( line.pressure, line.temperature, line.feed );
+  ASSERT_TRUE( line.multiphaseSystem->hasSucceeded() );
+  ASSERT_LT( line.multiphaseSystem->getFlashStatistics().nIterations, coldIterations );
+  const std::vector< double > sameConditionsGasFraction = gasFractionDerivatives();
+
+  // Restarting from the K-values of the previous time step, when the pressure was a bit higher.
+  line.multiphaseSystem->Update( 1.02 * line.pressure, line.temperature, line.feed );
+  line.multiphaseSystem->setInitialKValues( line.multiphaseSystem->getKValues() );
+  line.multiphaseSystem->Update( line.pressure, line.temperature, line.feed );
+  ASSERT_TRUE( line.multiphaseSystem->hasSucceeded() );
+  const std::vector< double > warmGasFraction = gasFractionDerivatives();
+
+  line.multiphaseSystem->setDerivativesType( pvt::DERIVATIVES_TYPE::ANALYTICAL );
+  line.multiphaseSystem->Update( line.pressure, line.temperature, line.feed );
+  line.multiphaseSystem->setDerivativesType( pvt::DERIVATIVES_TYPE::FINITE_DIFFERENCES );
+  const pvt::ScalarPropertyAndDerivativesView< double > gasFraction = msp.getPhaseMoleFraction( pvt::PHASE_TYPE::GAS );
+  for( const std::vector< double > & finiteDifferences: { coldGasFraction, sameConditionsGasFraction, warmGasFraction } )
+  {
+    ASSERT_NEAR( finiteDifferences[0], gasFraction.dP, 1.e-3 * std::fabs( gasFraction.dP ) + 1.e-15 );
+    for( std::size_t ic = 0; ic < nComponents; ++ic )
     {
-      return nullptr;
+      ASSERT_NEAR( finiteDifferences[1 + ic], gasFraction.dz[ic], 1.e-2 * std::fabs( gasFraction.dz[ic] ) + 1.e-7 );
     }
   }
 
-  pvt::MultiphaseSystem * getCompositionalSystem( const pds::CompositionalApiInputs & apiBuildParams )
+  std::size_t i = 0;
+  for( const pds::PHASE_TYPE & refPhase: line.refPhases )
   {
-    auto predicate = [&apiBuildParams]( const compInput2system & pair )
+    const pvt::PHASE_TYPE phase = convert( refPhase );
+    ASSERT_NEAR( msp.getPhaseMoleFraction( phase ).value, coldResults[i++], 1.e-6 );
+    for( const double & x: msp.getMoleComposition( phase ).value )
     {
-      return pair.first == apiBuildParams;
-    };
+      ASSERT_NEAR( x, coldResults[i++], 1.e-6 );
+    }
+  }
+
+  // The batch K-values buffer acts as a per cell cache: zeros mean the default initialization.
+  std::vector< double > batchKValues( nComponents, 0. );
+  pvt::MultiphaseSystemBatchProperties outputs;
+  outputs.kValues = batchKValues.data();
+  line.multiphaseSystem->resetFlashStatistics();
+  line.multiphaseSystem->BatchUpdate( 1, &line.pressure, &line.temperature, line.feed.data(), outputs );
+  ASSERT_EQ( line.multiphaseSystem->getFlashStatistics().nIterations, coldIterations );
+  ASSERT_EQ( batchKValues, kValues );
 
-    auto iter = std::find_if( compositionalSystems.begin(), compositionalSystems.end(), predicate );
+  line.multiphaseSystem->resetFlashStatistics();
+  line.multiphaseSystem->BatchUpdate( 1, &line.pressure, &line.temperature, line.feed.data(), outputs );
+  ASSERT_LT( line.multiphaseSystem->getFlashStatistics().nIterations, coldIterations );
+}
 
-    if( iter != compositionalSystems.end() )
+/**
+ * @brief Builds a methane-propane system, which phase envelope closes at moderate pressures.
+ * @return The system.
+ */
+std::unique_ptr< pvt::MultiphaseSystem > buildMethanePropaneSystem()
+{
+  return pvt::MultiphaseSystemBuilder::buildCompositional( pvt::COMPOSITIONAL_FLASH_TYPE::NEGATIVE_OIL_GAS,
+                                                           { pvt::PHASE_TYPE::OIL, pvt::PHASE_TYPE::GAS },
+                                                           { pvt::EOS_TYPE::PENG_ROBINSON, pvt::EOS_TYPE::PENG_ROBINSON },
+                                                           { "C1", "C3" },
+                                                           { 0.016, 0.044 },
+                                                           { 190.6, 369.8 },
+                                                           { 4.6e6, 4.25e6 },
+                                                           { 0.008, 0.152 } );
+}
+
+void validateStabilityTest( const std::string & json_string,
+                            pvt::FlashStatistics & statistics )
+{
+  const DataLine line = readDataLine( json_string );
+
+  if( line.flashType != pds::FLASH_TYPE::NEGATIVE_TWO_PHASE )
+  {
+    return;
+  }
+
+  pvt::MultiphaseSystemProperties const & msp = line.multiphaseSystem->getMultiphaseSystemProperties();
+
+  // Lower and higher pressures, so that single phase cells are tested as well.
+  for( const double & pressureFactor: { 0.1, 1., 10. } )
+  {
+    line.multiphaseSystem->Update( pressureFactor * line.pressure, line.temperature, line.feed );
+    const double gasPhaseMoleFraction = msp.getPhaseMoleFraction( pvt::PHASE_TYPE::GAS ).value;
+    const pvt::PHASE_TYPE phase = gasPhaseMoleFraction >= 1. ? pvt::PHASE_TYPE::GAS : pvt::PHASE_TYPE::OIL;
+    const double massDensity = msp.getMassDensity( phase ).value;
+
+    line.multiphaseSystem->setStabilityTestEnabled( true );
+    line.multiphaseSystem->resetFlashStatistics();
+    line.multiphaseSystem->Update( pressureFactor * line.pressure, line.temperature, line.feed );
+    line.multiphaseSystem->setStabilityTestEnabled( false );
+
+    // The finite differences flashes start from the stability of the base flash, and are not counted.
+    const pvt::FlashStatistics & lineStatistics = line.multiphaseSystem->getFlashStatistics();
+    ASSERT_EQ( lineStatistics.nFlashes, 1u );
+    ASSERT_EQ( lineStatistics.nStabilityTests, 1u );
+    statistics.nFlashes += lineStatistics.nFlashes;
+    statistics.nSkippedFlashes += lineStatistics.nSkippedFlashes;
+
+    // Skipped flashes give the single phase of the full flash.
+    if( lineStatistics.nSkippedFlashes > 0 )
     {
-      return iter->second.get();
+      ASSERT_TRUE( line.multiphaseSystem->hasSucceeded() );
+      ASSERT_EQ( msp.getPhaseMoleFraction( pvt::PHASE_TYPE::GAS ).value, gasPhaseMoleFraction );
+      ASSERT_NEAR( msp.getMassDensity( phase ).value, massDensity, 1.e-6 * massDensity );
     }
-    else
+  }
+}
+
+void validateShadowRegionCache( const std::string & json_string,
+                                pvt::FlashStatistics & statistics )
+{
+  const DataLine line = readDataLine( json_string );
+
+  if( line.flashType != pds::FLASH_TYPE::NEGATIVE_TWO_PHASE )
+  {
+    return;
+  }
+
+  pvt::MultiphaseSystemProperties const & msp = line.multiphaseSystem->getMultiphaseSystemProperties();
+
+  // One cell per pressure, updated twice: the second update is close enough to the first one to be in its shadow region.
+  const std::vector< double > pressureFactors{ 0.1, 1., 10. };
+  std::unique_ptr< pvt::ShadowRegionCache > cache = pvt::MultiphaseSystemBuilder::buildShadowRegionCache( pressureFactors.size(), line.feed.size() );
+  ASSERT_EQ( cache->size(), pressureFactors.size() );
+
+  line.multiphaseSystem->setStabilityTestEnabled( true );
+  line.multiphaseSystem->setShadowRegionCache( cache.get() );
+  for( std::size_t cellIndex = 0; cellIndex < pressureFactors.size(); ++cellIndex )
+  {
+    line.multiphaseSystem->UpdateCell( cellIndex, pressureFactors[cellIndex] * line.pressure, line.temperature, line.feed );
+  }
+
+  for( std::size_t cellIndex = 0; cellIndex < pressureFactors.size(); ++cellIndex )
+  {
+    const double cellPressure = ( 1. + 1.e-4 ) * pressureFactors[cellIndex] * line.pressure;
+
+    line.multiphaseSystem->setShadowRegionCache( nullptr );
+    line.multiphaseSystem->Update( cellPressure, line.temperature, line.feed );
+    const double gasPhaseMoleFraction = msp.getPhaseMoleFraction( pvt::PHASE_TYPE::GAS ).value;
+    const pvt::PHASE_TYPE phase = gasPhaseMoleFraction >= 1. ? pvt::PHASE_TYPE::GAS : pvt::PHASE_TYPE::OIL;
+    const double massDensity = msp.getMassDensity( phase ).value;
+
+    line.multiphaseSystem->setShadowRegionCache( cache.get() );
+    line.multiphaseSystem->resetFlashStatistics();
+    line.multiphaseSystem->UpdateCell( cellIndex, cellPressure, line.temperature, line.feed );
+
+    const pvt::FlashStatistics & cellStatistics = line.multiphaseSystem->getFlashStatistics();
+    statistics.nFlashes += cellStatistics.nFlashes;
+    statistics.nShadowRegionHits += cellStatistics.nShadowRegionHits;
+    ASSERT_EQ( cellStatistics.nFlashes, 1u );
+    ASSERT_EQ( cellStatistics.nShadowRegionHits + cellStatistics.nStabilityTests, 1u );
+
+    ASSERT_TRUE( line.multiphaseSystem->hasSucceeded() );
+    ASSERT_NEAR( msp.getPhaseMoleFraction( pvt::PHASE_TYPE::GAS ).value, gasPhaseMoleFraction, 1.e-6 );
+    ASSERT_NEAR( msp.getMassDensity( phase ).value, massDensity, 1.e-6 * massDensity );
+  }
+
+  line.multiphaseSystem->setShadowRegionCache( nullptr );
+  line.multiphaseSystem->setStabilityTestEnabled( false );
+}
+
+void validateTabulatedKValues( const std::string & json_string )
+{
+  const DataLine line = readDataLine( json_string );
+
+  if( line.flashType != pds::FLASH_TYPE::NEGATIVE_TWO_PHASE )
+  {
+    return;
+  }
+
+  const pds::CompositionalApiInputs apiInputs = line.j.at( PublicAPIKeys::INPUT ).at( PublicAPIKeys::API ).get< pds::CompositionalApiInputs >();
+  const std::size_t nComponents = line.feed.size();
+
+  auto build = [&]( pvt::KValueTable const & table )
+  {
+    return pvt::MultiphaseSystemBuilder::buildTabulatedKValues( convert( apiInputs.phases ),
+                                                                convert( apiInputs.eosTypes ),
+                                                                apiInputs.componentNames,
+                                                                apiInputs.componentMolarWeights,
+                                                                apiInputs.componentCriticalTemperatures,
+                                                                apiInputs.componentCriticalPressures,
+                                                                apiInputs.componentOmegas,
+                                                                {},
+                                                                {},
+                                                                table );
+  };
+
+  pvt::MultiphaseSystem * negativeSystem = line.multiphaseSystem;
+  negativeSystem->Update( line.pressure, line.temperature, line.feed );
+  pvt::MultiphaseSystemProperties const & negativeMsp = negativeSystem->getMultiphaseSystemProperties();
+  const std::vector< double > kValues = negativeSystem->getKValues();
+
+  // Inconsistent tables are rejected.
+  pvt::KValueTable table;
+  table.nPressures = 2;
+  table.nTemperatures = 1;
+  table.kValues = kValues;
+  ASSERT_EQ( build( table ), nullptr );
+
+  // A single node table holding the converged K-values reproduces the negative flash.
+  table.minPressure = line.pressure;
+  table.nPressures = 1;
+  table.minTemperature = line.temperature;
+  std::unique_ptr< pvt::MultiphaseSystem > tabulatedSystem = build( table );
+  tabulatedSystem->Update( line.pressure, line.temperature, line.feed );
+  ASSERT_TRUE( tabulatedSystem->hasSucceeded() );
+  pvt::MultiphaseSystemProperties const & tabulatedMsp = tabulatedSystem->getMultiphaseSystemProperties();
+  ASSERT_EQ( tabulatedSystem->getFlashStatistics().nIterations, 0u );
+
+  for( const pds::PHASE_TYPE & refPhase: line.refPhases )
+  {
+    const pvt::PHASE_TYPE phase = convert( refPhase );
+    ASSERT_NEAR( tabulatedMsp.getPhaseMoleFraction( phase ).value, negativeMsp.getPhaseMoleFraction( phase ).value, 1.e-6 );
+    ASSERT_NEAR( tabulatedMsp.getMassDensity( phase ).value, negativeMsp.getMassDensity( phase ).value,
+                 1.e-6 * negativeMsp.getMassDensity( phase ).value );
+    for( std::size_t ic = 0; ic < nComponents; ++ic )
     {
-      auto pair = std::make_pair( apiBuildParams,
-                                  pvt::MultiphaseSystemBuilder::buildCompositional(
-                                    convert( apiBuildParams.flashType ),
-                                    convert( apiBuildParams.phases ),
-                                    convert( apiBuildParams.eosTypes ),
-                                    apiBuildParams.componentNames,
-                                    apiBuildParams.componentMolarWeights,
-                                    apiBuildParams.componentCriticalTemperatures,
-                                    apiBuildParams.componentCriticalPressures,
-                                    apiBuildParams.componentOmegas
-                                  ) );
-      compositionalSystems.push_back( std::move( pair ) );
-      return compositionalSystems.back().second.get();
+      ASSERT_NEAR( tabulatedMsp.getMoleComposition( phase ).value[ic], negativeMsp.getMoleComposition( phase ).value[ic], 1.e-6 );
     }
   }
-};
 
-static Holder holder;
+  // K-values are interpolated in ln K: the middle of two nodes gets the geometric mean.
+  table.pressureStep = line.pressure;
+  table.nPressures = 2;
+  table.kValues.insert( table.kValues.end(), kValues.cbegin(), kValues.cend() );
+  for( std::size_t ic = nComponents; ic < 2 * nComponents; ++ic )
+  {
+    table.kValues[ic] *= 4.;
+  }
+  tabulatedSystem = build( table );
+  tabulatedSystem->Update( 1.5 * line.pressure, line.temperature, line.feed );
+  for( std::size_t ic = 0; ic < nComponents; ++ic )
+  {
+    ASSERT_NEAR( tabulatedSystem->getKValues()[ic], 2. * kValues[ic], 1.e-12 * kValues[ic] );
+  }
+}
 
-void validatePublicApi( const std::string & json_string )
+void validateThreePhase( const std::string & json_string )
 {
-  const json j = json::parse( json_string );
+  const DataLine line = readDataLine( json_string );
+
+  if( line.flashType != pds::FLASH_TYPE::FREE_WATER )
+  {
+    return;
+  }
 
-  const auto refMsp = j.at( PublicAPIKeys::OUTPUT ).get< pds::PDSMSP >();
+  const pds::CompositionalApiInputs apiInputs = line.j.at( PublicAPIKeys::INPUT ).at( PublicAPIKeys::API ).get< pds::CompositionalApiInputs >();
+  const std::size_t nComponents = line.feed.size();
 
-  const json & computation = j.at( PublicAPIKeys::INPUT ).at( PublicAPIKeys::COMPUTATION );
-  const double pressure = computation.at( PublicAPIKeys::Computation::PRESSURE ).get< double >();
-  const double temperature = computation.at( PublicAPIKeys::Computation::TEMPERATURE ).get< double >();
-  const std::vector< double > feed = computation.at( PublicAPIKeys::Computation::FEED ).get< std::vector< double > >();
+  auto build = [&]( std::vector< pvt::PHASE_TYPE > const & phases )
+  {
+    return pvt::MultiphaseSystemBuilder::buildCompositional( pvt::COMPOSITIONAL_FLASH_TYPE::THREE_PHASE,
+                                                             phases,
+                                                             convert( apiInputs.eosTypes ),
+                                                             apiInputs.componentNames,
+                                                             apiInputs.componentMolarWeights,
+                                                             apiInputs.componentCriticalTemperatures,
+                                                             apiInputs.componentCriticalPressures,
+                                                             apiInputs.componentOmegas );
+  };
 
-  pds::FLASH_TYPE flashType = j.at( PublicAPIKeys::INPUT ).at( PublicAPIKeys::API ).at( FlashKeys::TYPE ).get< pds::FLASH_TYPE >();
+  // The aqueous phase is required.
+  ASSERT_EQ( build( { pvt::PHASE_TYPE::OIL, pvt::PHASE_TYPE::GAS } ), nullptr );
 
+  std::unique_ptr< pvt::MultiphaseSystem > multiphaseSystem = build( convert( apiInputs.phases ) );
+  multiphaseSystem->Update( line.pressure, line.temperature, line.feed );
+  ASSERT_TRUE( multiphaseSystem->hasSucceeded() );
+  pvt::MultiphaseSystemProperties const & msp = multiphaseSystem->getMultiphaseSystemProperties();
 
-  pvt::MultiphaseSystem * multiphaseSystem = nullptr;
-  if( flashType == pds::FLASH_TYPE::NEGATIVE_TWO_PHASE or
-      flashType == pds::FLASH_TYPE::FREE_WATER or
-      flashType == pds::FLASH_TYPE::TRIVIAL )
+  // All the phases are present, and the components are conserved.
+  std::vector< double > totals( nComponents, 0. );
+  double sumFractions = 0.;
+  for( const pvt::PHASE_TYPE phase: { pvt::PHASE_TYPE::OIL, pvt::PHASE_TYPE::GAS, pvt::PHASE_TYPE::LIQUID_WATER_RICH } )
   {
-    pds::CompositionalApiInputs const apiInputs = j.at( PublicAPIKeys::INPUT ).at( PublicAPIKeys::API ).get< pds::CompositionalApiInputs >();
-    multiphaseSystem = holder.getCompositionalSystem( apiInputs );
+    const double fraction = msp.getPhaseMoleFraction( phase ).value;
+    ASSERT_GT( fraction, 0. );
+    sumFractions += fraction;
+    for( std::size_t ic = 0; ic < nComponents; ++ic )
+    {
+      totals[ic] += fraction * msp.getMoleComposition( phase ).value[ic];
+    }
   }
-  if( flashType == pds::FLASH_TYPE::BLACK_OIL or flashType == pds::FLASH_TYPE::DEAD_OIL )
+  ASSERT_NEAR( sumFractions, 1., 1.e-12 );
+  for( std::size_t ic = 0; ic < nComponents; ++ic )
   {
-    pds::BlackOilDeadOilApiInputs const apiInputs = j.at( PublicAPIKeys::INPUT ).at( PublicAPIKeys::API ).get< pds::BlackOilDeadOilApiInputs >();
-    multiphaseSystem = holder.getDeadOilBlackOilSystem( flashType, apiInputs );
+    ASSERT_NEAR( totals[ic], line.feed[ic], 1.e-8 );
   }
 
-  multiphaseSystem->Update( pressure, temperature, feed );
-  pvt::MultiphaseSystemProperties const & actualMsp = multiphaseSystem->getMultiphaseSystemProperties();
+  // The aqueous phase is almost pure water.
+  const pvt::ArrayView< double > waterComposition = msp.getMoleComposition( pvt::PHASE_TYPE::LIQUID_WATER_RICH ).value;
+  ASSERT_GT( *std::max_element( waterComposition.cbegin(), waterComposition.cend() ), 0.999 );
 
-  compare( actualMsp, refMsp );
+  // The result is an equilibrium: the ln fugacities ln x_i + ln phi_i of the present components are equal in the three phases.
+  const ComponentProperties componentProperties( nComponents,
+                                                 apiInputs.componentNames,
+                                                 apiInputs.componentMolarWeights,
+                                                 apiInputs.componentCriticalTemperatures,
+                                                 apiInputs.componentCriticalPressures,
+                                                 apiInputs.componentOmegas );
+  const std::vector< pvt::PHASE_TYPE > phases = convert( apiInputs.phases );
+  const std::vector< pvt::EOS_TYPE > eosTypes = convert( apiInputs.eosTypes );
+  std::vector< std::vector< double > > lnFugacities;
+  for( std::size_t ip = 0; ip < phases.size(); ++ip )
+  {
+    const pvt::ArrayView< double > view = msp.getMoleComposition( phases[ip] ).value;
+    const std::vector< double > composition( view.cbegin(), view.cend() );
+    CubicEoSPhaseModel::Workspace workspace;
+    CubicEoSPhaseModel::Properties properties{};
+    CubicEoSPhaseModel( componentProperties, eosTypes[ip], phases[ip] ).computeAllProperties( line.pressure, line.temperature, composition, workspace, properties );
+    lnFugacities.push_back( properties.lnFugacityCoefficients );
+    for( std::size_t ic = 0; ic < nComponents; ++ic )
+    {
+      lnFugacities.back()[ic] += std::log( composition[ic] );
+    }
+  }
+  for( std::size_t ic = 0; ic < nComponents; ++ic )
+  {
+    if( line.feed[ic] > std::numeric_limits< double >::epsilon() )
+    {
+      for( std::size_t ip = 1; ip < phases.size(); ++ip )
+      {
+        ASSERT_NEAR( lnFugacities[ip][ic], lnFugacities[0][ic], 1.e-6 );
+      }
+    }
+  }
 
-  // Building new json reference, uncomment lines below to display computed values as json.
-//  auto newRef = json{
-//    { PublicAPIKeys::INPUT,  j.at( PublicAPIKeys::INPUT )},
-//    { PublicAPIKeys::OUTPUT, actualMsp }
-//  };
-//  std::cout << newRef << std::endl;
+  // The hydrocarbon split is the one of the free water flash on the same line, up to the water dissolved in the hydrocarbon phases:
+  // the water-free compositions of the oil and the gas, and the gas fraction, match the reference output.
+  // (The reference aqueous fraction, hence the oil one, follow the free water flash conventions and are not compared.)
+  const std::size_t waterIndex = componentProperties.WaterIndex;
+  for( const pvt::PHASE_TYPE phase: { pvt::PHASE_TYPE::OIL, pvt::PHASE_TYPE::GAS } )
+  {
+    const pds::PHASE_TYPE refPhase = phase == pvt::PHASE_TYPE::OIL ? pds::PHASE_TYPE::OIL : pds::PHASE_TYPE::GAS;
+    const pvt::ArrayView< double > composition = msp.getMoleComposition( phase ).value;
+    const std::vector< double > & refComposition = line.refMsp.getMoleComposition( refPhase ).value;
+    for( std::size_t ic = 0; ic < nComponents; ++ic )
+    {
+      if( ic != waterIndex )
+      {
+        ASSERT_NEAR( composition[ic] / ( 1. - composition[waterIndex] ), refComposition[ic] / ( 1. - refComposition[waterIndex] ), 1.e-4 );
+      }
+    }
+  }
+  ASSERT_NEAR( msp.getPhaseMoleFraction( pvt::PHASE_TYPE::GAS ).value, line.refMsp.getPhaseMoleFraction( pds::PHASE_TYPE::GAS ).value, 1.e-4 );
+}
+
+void validateFreeWater( const std::string & json_string )
+{
+  const DataLine line = readDataLine( json_string );
+
+  if( line.flashType != pds::FLASH_TYPE::FREE_WATER )
+  {
+    return;
+  }
+
+  const pds::CompositionalApiInputs apiInputs = line.j.at( PublicAPIKeys::INPUT ).at( PublicAPIKeys::API ).get< pds::CompositionalApiInputs >();
+
+  std::unique_ptr< pvt::MultiphaseSystem > multiphaseSystem =
+    pvt::MultiphaseSystemBuilder::buildCompositional( pvt::COMPOSITIONAL_FLASH_TYPE::FREE_WATER,
+                                                      convert( apiInputs.phases ),
+                                                      convert( apiInputs.eosTypes ),
+                                                      apiInputs.componentNames,
+                                                      apiInputs.componentMolarWeights,
+                                                      apiInputs.componentCriticalTemperatures,
+                                                      apiInputs.componentCriticalPressures,
+                                                      apiInputs.componentOmegas );
+  pvt::MultiphaseSystemProperties const & msp = multiphaseSystem->getMultiphaseSystemProperties();
+
+  // The phase split (three phase here, solved by the modified Rachford-Rice equation) reproduces the reference values.
+  multiphaseSystem->Update( line.pressure, line.temperature, line.feed );
+  ASSERT_TRUE( multiphaseSystem->hasSucceeded() );
+  std::vector< double > results;
+  for( const pds::PHASE_TYPE & refPhase: line.refMsp.getPhases() )
+  {
+    const pvt::PHASE_TYPE phase = convert( refPhase );
+    const double fraction = msp.getPhaseMoleFraction( phase ).value;
+    ASSERT_NEAR( fraction, line.refMsp.getPhaseMoleFraction( refPhase ).value, 1.e-14 );
+    results.push_back( fraction );
+    const pvt::ArrayView< double > composition = msp.getMoleComposition( phase ).value;
+    const std::vector< double > & refComposition = line.refMsp.getMoleComposition( refPhase ).value;
+    for( std::size_t ic = 0; ic < composition.size(); ++ic )
+    {
+      ASSERT_NEAR( composition[ic], refComposition[ic], 1.e-14 );
+    }
+    results.insert( results.end(), composition.cbegin(), composition.cend() );
+  }
+
+  // The solver buffers are reused from one flash to the other without altering the results.
+  multiphaseSystem->Update( line.pressure, line.temperature, line.feed );
+  std::size_t i = 0;
+  for( const pds::PHASE_TYPE & refPhase: line.refMsp.getPhases() )
+  {
+    const pvt::PHASE_TYPE phase = convert( refPhase );
+    ASSERT_EQ( msp.getPhaseMoleFraction( phase ).value, results[i++] );
+    for( const double & x: msp.getMoleComposition( phase ).value )
+    {
+      ASSERT_EQ( x, results[i++] );
+    }
+  }
+}
+
+void validateTableLookupOrder( const std::string & json_string )
+{
+  const DataLine line = readDataLine( json_string );
+
+  if( line.flashType != pds::FLASH_TYPE::BLACK_OIL and line.flashType != pds::FLASH_TYPE::DEAD_OIL )
+  {
+    return;
+  }
+
+  pvt::MultiphaseSystemProperties const & msp = line.multiphaseSystem->getMultiphaseSystemProperties();
+
+  // Pressures around the one of the line, the table lookups of each evaluation starting from the intervals of the previous one.
+  const std::size_t nPressures = 21;
+  auto solve = [&]( std::size_t iPressure )
+  {
+    line.multiphaseSystem->Update( line.pressure * ( 0.98 + 0.002 * iPressure ), line.temperature, line.feed );
+    std::vector< double > results;
+    for( const pds::PHASE_TYPE & refPhase: line.refPhases )
+    {
+      const pvt::PHASE_TYPE phase = convert( refPhase );
+      results.push_back( msp.getPhaseMoleFraction( phase ).value );
+      results.push_back( msp.getMassDensity( phase ).value );
+      results.push_back( msp.getMoleDensity( phase ).value );
+      results.push_back( msp.getViscosity( phase ).value );
+    }
+    return results;
+  };
+
+  std::vector< std::vector< double > > increasing;
+  for( std::size_t iPressure = 0; iPressure < nPressures; ++iPressure )
+  {
+    increasing.push_back( solve( iPressure ) );
+  }
+
+  // Same results whatever the order of the evaluations: decreasing, then scattered.
+  for( std::size_t iPressure = nPressures; iPressure-- > 0; )
+  {
+    ASSERT_EQ( solve( iPressure ), increasing[iPressure] );
+  }
+  for( std::size_t i = 0; i < nPressures; ++i )
+  {
+    const std::size_t iPressure = ( 8 * i ) % nPressures;
+    ASSERT_EQ( solve( iPressure ), increasing[iPressure] );
+  }
+}
+
+void validateDeadOilBatchEvaluation( const std::string & json_string,
+                                     std::size_t & nCheckedCells )
+{
+  const DataLine line = readDataLine( json_string );
+
+  if( line.flashType != pds::FLASH_TYPE::DEAD_OIL )
+  {
+    return;
+  }
+
+  // Pressures in no particular order, spanning several table intervals, and different feeds.
+  const std::size_t nCells = 1000;
+  const std::size_t nComponents = line.feed.size();
+  const std::size_t nPhases = line.phases.size();
+  const std::size_t recordSize = pvt::MultiphaseSystemBatchProperties::recordSize( nComponents );
+
+  std::vector< double > pressures( nCells );
+  std::vector< double > feeds;
+  for( std::size_t iCell = 0; iCell < nCells; ++iCell )
+  {
+    pressures[iCell] = line.pressure * ( 0.8 + 0.4 * static_cast< double >( ( iCell * 389 ) % nCells ) / nCells );
+    std::vector< double > z( line.feed );
+    z[0] += 0.01 * ( iCell % 7 );
+    const double sum = std::accumulate( z.cbegin(), z.cend(), 0. );
+    for( const double & zi: z )
+    {
+      feeds.push_back( zi / sum );
+    }
+  }
+  const std::vector< double > temperatures( nCells, line.temperature );
+#ifdef NDEBUG
+  // A cell below the tables, which are extrapolated (debug builds assert on it).
+  pressures[nCells / 2] = 1.e6;
+#endif
+
+  std::vector< double > massDensity( nCells * nPhases * recordSize );
+  std::vector< double > moleComposition( nCells * nPhases * nComponents * recordSize );
+  std::vector< double > moleDensity( nCells * nPhases * recordSize );
+  std::vector< double > viscosity( nCells * nPhases * recordSize );
+  std::vector< double > molecularWeight( nCells * nPhases * recordSize );
+  std::vector< double > phaseMoleFraction( nCells * nPhases * recordSize );
+  std::unique_ptr< bool[] > succeeded( new bool[nCells] );
+
+  pvt::MultiphaseSystemBatchProperties outputs;
+  outputs.phases = line.phases;
+  outputs.massDensity = massDensity.data();
+  outputs.moleComposition = moleComposition.data();
+  outputs.moleDensity = moleDensity.data();
+  outputs.viscosity = viscosity.data();
+  outputs.molecularWeight = molecularWeight.data();
+  outputs.phaseMoleFraction = phaseMoleFraction.data();
+  outputs.succeeded = succeeded.get();
+
+  // With analytical derivatives, the phase models are evaluated over chunks of cells.
+  const ScopedDerivativesType analytical( *line.multiphaseSystem, pvt::DERIVATIVES_TYPE::ANALYTICAL );
+  ASSERT_TRUE( line.multiphaseSystem->BatchUpdate( nCells, pressures.data(), temperatures.data(), feeds.data(), outputs ) );
+
+  // Which gives the same results as the cell by cell updates.
+  for( std::size_t iCell = 0; iCell < nCells; ++iCell )
+  {
+    line.multiphaseSystem->Update( pressures[iCell], line.temperature, std::vector< double >( feeds.cbegin() + iCell * nComponents, feeds.cbegin() + ( iCell + 1 ) * nComponents ) );
+    ASSERT_TRUE( line.multiphaseSystem->hasSucceeded() );
+    ASSERT_TRUE( succeeded[iCell] );
+    pvt::MultiphaseSystemProperties const & msp = line.multiphaseSystem->getMultiphaseSystemProperties();
+
+    for( std::size_t iPhase = 0; iPhase < nPhases; ++iPhase )
+    {
+      const pvt::PHASE_TYPE & phase = line.phases[iPhase];
+      const std::size_t offset = ( iCell * nPhases + iPhase ) * recordSize;
+
+      checkBatchRecord( msp.getMassDensity( phase ), &massDensity[offset] );
+      checkBatchRecord( msp.getMoleDensity( phase ), &moleDensity[offset] );
+      checkBatchRecord( msp.getViscosity( phase ), &viscosity[offset] );
+      checkBatchRecord( msp.getMolecularWeight( phase ), &molecularWeight[offset] );
+      checkBatchRecord( msp.getPhaseMoleFraction( phase ), &phaseMoleFraction[offset] );
+
+      const pvt::VectorPropertyAndDerivativesView< double > composition = msp.getMoleComposition( phase );
+      for( std::size_t ic = 0; ic < nComponents; ++ic )
+      {
+        const double * record = &moleComposition[offset * nComponents + ic * recordSize];
+        ASSERT_EQ( record[0], composition.value[ic] );
+        ASSERT_EQ( record[1], composition.dP[ic] );
+        for( std::size_t jc = 0; jc < nComponents; ++jc )
+        {
+          ASSERT_EQ( record[3 + jc], composition.dz[ic][jc] );
+        }
+      }
+    }
+  }
+
+  nCheckedCells += nCells;
+}
+
+std::pair< std::vector< double >, pvt::FlashStatistics > solveNegativeTwoPhaseLines( const std::string & dataFileName,
+                                                                                     pvt::SSI_ACCELERATION_TYPE const & accelerationType )
+{
+  std::vector< double > results;
+  pvt::FlashStatistics statistics;
+
+  forEachDataLine( [&]( const std::string & json_string )
+  {
+    const DataLine line = readDataLine( json_string );
+    if( line.flashType != pds::FLASH_TYPE::NEGATIVE_TWO_PHASE )
+    {
+      return;
+    }
+
+    line.multiphaseSystem->setSsiAccelerationType( accelerationType );
+    line.multiphaseSystem->resetFlashStatistics();
+    line.multiphaseSystem->Update( line.pressure, line.temperature, line.feed );
+    line.multiphaseSystem->setSsiAccelerationType( pvt::SSI_ACCELERATION_TYPE::NONE );
+
+    pvt::FlashStatistics const & lineStatistics = line.multiphaseSystem->getFlashStatistics();
+    statistics.nFlashes += lineStatistics.nFlashes;
+    statistics.nIterations += lineStatistics.nIterations;
+    statistics.maxIterations = std::max( statistics.maxIterations, lineStatistics.maxIterations );
+    statistics.nNotConverged += lineStatistics.nNotConverged;
+
+    pvt::MultiphaseSystemProperties const & msp = line.multiphaseSystem->getMultiphaseSystemProperties();
+    for( const pds::PHASE_TYPE & refPhase: line.refPhases )
+    {
+      const pvt::PHASE_TYPE phase = convert( refPhase );
+      results.push_back( msp.getPhaseMoleFraction( phase ).value );
+      const pvt::ArrayView< double > composition = msp.getMoleComposition( phase ).value;
+      results.insert( results.end(), composition.cbegin(), composition.cend() );
+    }
+  }, dataFileName );
+
+  return { results, statistics };
 }
 
 TEST( pvt, publicApi )
@@ -250,21 +1101,177 @@ TEST( pvt, publicApi )
   };
 
   // FIXME Fail if file is not found!
-  std::string line;
   for( const std::string & fileName: fileNames )
   {
-    std::ifstream dataFile( "data/" + fileName );
-    while( std::getline( dataFile, line ) )
+    forEachDataLine( validatePublicApi, "data/" + fileName );
+  }
+}
+
+TEST( pvt, batchUpdate )
+{
+  forEachDataLine( validateBatchUpdate );
+}
+
+TEST( pvt, analyticalDerivatives )
+{
+  forEachDataLine( validateAnalyticalDerivatives );
+}
+
+TEST( pvt, blackOilDeadOilAnalyticalDerivatives )
+{
+  forEachDataLine( validateBlackOilDeadOilAnalyticalDerivatives );
+}
+
+TEST( pvt, interactionCoefficientsAndVolumeShifts )
+{
+  forEachDataLine( validateInteractionCoefficientsAndVolumeShifts );
+}
+
+TEST( pvt, mixedPrecision )
+{
+  std::set< pds::FLASH_TYPE > mixedFlashTypes;
+
+  forEachDataLine( [&]( const std::string & line )
+  {
+    validateMixedPrecision( line, mixedFlashTypes );
+  } );
+
+  // The precision type reaches the equation of state of all the compositional systems.
+  const std::set< pds::FLASH_TYPE > expected{ pds::FLASH_TYPE::NEGATIVE_TWO_PHASE, pds::FLASH_TYPE::FREE_WATER, pds::FLASH_TYPE::TRIVIAL };
+  ASSERT_EQ( mixedFlashTypes, expected );
+}
+
+TEST( pvt, ssiAcceleration )
+{
+  const std::pair< std::vector< double >, pvt::FlashStatistics > plain = solveNegativeTwoPhaseLines( "data/pvt_data.txt", pvt::SSI_ACCELERATION_TYPE::NONE );
+  ASSERT_GT( plain.second.nFlashes, 0u );
+
+  // Same flashes, fewer iterations, same solutions up to the convergence tolerance.
+  for( pvt::SSI_ACCELERATION_TYPE const & accelerationType: { pvt::SSI_ACCELERATION_TYPE::GDEM, pvt::SSI_ACCELERATION_TYPE::NEWTON } )
+  {
+    const std::pair< std::vector< double >, pvt::FlashStatistics > accelerated = solveNegativeTwoPhaseLines( "data/pvt_data.txt", accelerationType );
+    ASSERT_EQ( accelerated.second.nFlashes, plain.second.nFlashes );
+    ASSERT_LT( accelerated.second.nIterations, plain.second.nIterations );
+    ASSERT_LE( accelerated.second.nNotConverged, plain.second.nNotConverged );
+    ASSERT_EQ( accelerated.first.size(), plain.first.size() );
+    for( std::size_t i = 0; i < plain.first.size(); ++i )
     {
-      const bool isComment = line.rfind( "#", 0 ) == 0;
-      if( not line.empty() and not isComment )
-      {
-        validatePublicApi( line );
-      }
+      ASSERT_NEAR( accelerated.first[i], plain.first[i], 1.e-6 );
     }
   }
 }
 
+TEST( pvt, warmStart )
+{
+  forEachDataLine( validateWarmStart );
+}
+
+TEST( pvt, stabilityTest )
+{
+  pvt::FlashStatistics statistics;
+
+  forEachDataLine( [&]( const std::string & line )
+  {
+    validateStabilityTest( line, statistics );
+  } );
+
+  ASSERT_GT( statistics.nSkippedFlashes, 0u );
+  ASSERT_LT( statistics.nSkippedFlashes, statistics.nFlashes );
+}
+
+TEST( pvt, stabilityTestPhaseLabel )
+{
+  // Methane-rich liquid, which the Wilson K-values would flash to mostly vapor.
+  std::unique_ptr< pvt::MultiphaseSystem > multiphaseSystem = buildMethanePropaneSystem();
+  pvt::MultiphaseSystemProperties const & msp = multiphaseSystem->getMultiphaseSystemProperties();
+  const double pressure = 11.e6, temperature = 280.;
+  const std::vector< double > feed{ 0.7, 0.3 };
+
+  // Without the stability test, the negative flash heads to the trivial solution without converging,
+  // and its result is brought back to the liquid feed.
+  multiphaseSystem->Update( pressure, temperature, feed );
+  ASSERT_FALSE( multiphaseSystem->hasSucceeded() );
+  ASSERT_EQ( multiphaseSystem->getFlashStatistics().nNotConverged, multiphaseSystem->getFlashStatistics().nFlashes );
+  ASSERT_EQ( msp.getPhaseMoleFraction( pvt::PHASE_TYPE::GAS ).value, 0. );
+  const double massDensity = msp.getMassDensity( pvt::PHASE_TYPE::OIL ).value;
+
+  // The stable feed is labelled from its own molar volume.
+  multiphaseSystem->setStabilityTestEnabled( true );
+  multiphaseSystem->Update( pressure, temperature, feed );
+  ASSERT_TRUE( multiphaseSystem->hasSucceeded() );
+  ASSERT_GT( multiphaseSystem->getFlashStatistics().nSkippedFlashes, 0u );
+  ASSERT_EQ( msp.getPhaseMoleFraction( pvt::PHASE_TYPE::GAS ).value, 0. );
+  ASSERT_NEAR( msp.getMassDensity( pvt::PHASE_TYPE::OIL ).value, massDensity, 1.e-6 * massDensity );
+}
+
+TEST( pvt, shadowRegionCache )
+{
+  pvt::FlashStatistics statistics;
+
+  forEachDataLine( [&]( const std::string & line )
+  {
+    validateShadowRegionCache( line, statistics );
+  } );
+
+  ASSERT_GT( statistics.nShadowRegionHits, 0u );
+}
+
+TEST( pvt, shadowRegionCacheNearCriticalPoint )
+{
+  // Methane-propane feed above its bubble point, close to the critical point of the mixture:
+  // both trial phases of the stability test collapse onto the feed, which proves nothing about its neighbourhood.
+  std::unique_ptr< pvt::MultiphaseSystem > multiphaseSystem = buildMethanePropaneSystem();
+  const double pressure = 8.e6, temperature = 330.;
+  const std::vector< double > feed{ 0.5, 0.5 };
+
+  std::unique_ptr< pvt::ShadowRegionCache > cache = pvt::MultiphaseSystemBuilder::buildShadowRegionCache( 1, feed.size() );
+  multiphaseSystem->setStabilityTestEnabled( true );
+  multiphaseSystem->setShadowRegionCache( cache.get() );
+  multiphaseSystem->UpdateCell( 0, pressure, temperature, feed );
+  ASSERT_TRUE( multiphaseSystem->hasSucceeded() );
+  ASSERT_GT( multiphaseSystem->getFlashStatistics().nSkippedFlashes, 0u );
+
+  // The stable feed gives no trust region: the next update of the cell runs the stability test again.
+  multiphaseSystem->resetFlashStatistics();
+  multiphaseSystem->UpdateCell( 0, ( 1. + 1.e-4 ) * pressure, temperature, feed );
+  const pvt::FlashStatistics & statistics = multiphaseSystem->getFlashStatistics();
+  ASSERT_TRUE( multiphaseSystem->hasSucceeded() );
+  ASSERT_EQ( statistics.nShadowRegionHits, 0u );
+  ASSERT_EQ( statistics.nStabilityTests, statistics.nFlashes );
+}
+
+TEST( pvt, tabulatedKValues )
+{
+  forEachDataLine( validateTabulatedKValues );
+}
+
+TEST( pvt, threePhase )
+{
+  forEachDataLine( validateThreePhase );
+}
+
+TEST( pvt, freeWater )
+{
+  forEachDataLine( validateFreeWater );
+}
+
+TEST( pvt, tableLookupOrder )
+{
+  forEachDataLine( validateTableLookupOrder );
+}
+
+TEST( pvt, deadOilBatchEvaluation )
+{
+  std::size_t nCheckedCells = 0;
+
+  forEachDataLine( [&]( const std::string & line )
+  {
+    validateDeadOilBatchEvaluation( line, nCheckedCells );
+  } );
+
+  ASSERT_GT( nCheckedCells, 0u );
+}
+
 int main( int argc,
           char ** argv )
 {